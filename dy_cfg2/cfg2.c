@@ -20,6 +20,10 @@ typedef struct {
         uint8_t val_u8;
         float val_float;
         char val_str[DY_CFG2_STR_MAX_LEN];
+        struct {
+            uint16_t len;
+            uint8_t data[DY_CFG2_BLOB_MAX_LEN];
+        } val_blob;
     };
     UT_hash_handle hh;
 } dy_cfg2_cache_item_t;
@@ -41,7 +45,8 @@ static dy_err_t commit_nvs() {
     return dy_ok();
 }
 
-static dy_err_t set_cache(int id, uint8_t type, void *src) {
+// `len` is used for blobs only.
+static dy_err_t set_cache(int id, uint8_t type, void *src, size_t len) {
     dy_cfg2_cache_item_t *item = NULL;
 
     HASH_FIND_INT(cache, &id, item);
@@ -70,6 +75,13 @@ static dy_err_t set_cache(int id, uint8_t type, void *src) {
             }
             strlcpy(item->val_str, src, DY_CFG2_STR_MAX_LEN);
             break;
+        case DY_CFG2_VALUE_TYPE_BLOB:
+            if (len > DY_CFG2_BLOB_MAX_LEN) {
+                return dy_err(DY_ERR_INVALID_ARG, "blob value is too long");
+            }
+            memcpy(item->val_blob.data, src, len);
+            item->val_blob.len = len;
+            break;
         default:
             return dy_err(DY_ERR_INVALID_ARG, "unexpected type %d", type);
     }
@@ -77,7 +89,8 @@ static dy_err_t set_cache(int id, uint8_t type, void *src) {
     return dy_ok();
 }
 
-static dy_err_t get_from_cache(int id, uint8_t type, void *value) {
+// `len` is used for blobs only: capacity of `value` on input, length of the blob on output.
+static dy_err_t get_from_cache(int id, uint8_t type, void *value, size_t *len) {
     dy_cfg2_cache_item_t *item = NULL;
     HASH_FIND_INT(cache, &id, item);
     if (item == NULL) {
@@ -97,6 +110,13 @@ static dy_err_t get_from_cache(int id, uint8_t type, void *value) {
         case DY_CFG2_VALUE_TYPE_STR:
             strlcpy(value, item->val_str, DY_CFG2_STR_MAX_LEN);
             break;
+        case DY_CFG2_VALUE_TYPE_BLOB:
+            if (*len < item->val_blob.len) {
+                return dy_err(DY_ERR_INVALID_ARG, "blob value is too long");
+            }
+            memcpy(value, item->val_blob.data, item->val_blob.len);
+            *len = item->val_blob.len;
+            break;
         default:
             return dy_err(DY_ERR_INVALID_ARG, "unexpected type %d", item->type);
     }
@@ -126,7 +146,7 @@ bool dy_cfg2_is_set(int id) {
     return false;
 }
 
-static dy_err_t get(int id, uint8_t type, void *dst) {
+static dy_err_t get(int id, uint8_t type, void *dst, size_t *len) {
     dy_err_t err;
     esp_err_t esp_err;
     uint32_t bits;
@@ -138,7 +158,11 @@ static dy_err_t get(int id, uint8_t type, void *dst) {
         return dy_err(DY_ERR_NOT_CONFIGURED, "dy_cfg2_init must be called first");
     }
 
-    if (!dy_is_err(err = get_from_cache(id, type, dst))) {
+    if (type == DY_CFG2_VALUE_TYPE_BLOB && len == NULL) {
+        return dy_err(DY_ERR_INVALID_ARG, "len is null");
+    }
+
+    if (!dy_is_err(err = get_from_cache(id, type, dst, len))) {
         return dy_ok();
     }
 
@@ -160,10 +184,13 @@ static dy_err_t get(int id, uint8_t type, void *dst) {
             }
             break;
         case DY_CFG2_VALUE_TYPE_STR: {
-            size_t len = DY_CFG2_STR_MAX_LEN;
-            esp_err = nvs_get_str(nvs_hdl, key, dst, &len);
+            size_t str_len = DY_CFG2_STR_MAX_LEN;
+            esp_err = nvs_get_str(nvs_hdl, key, dst, &str_len);
             break;
         }
+        case DY_CFG2_VALUE_TYPE_BLOB:
+            esp_err = nvs_get_blob(nvs_hdl, key, dst, len);
+            break;
         default:
             return dy_err(DY_ERR_INVALID_ARG, "unexpected type %d", type);
     }
@@ -175,14 +202,14 @@ static dy_err_t get(int id, uint8_t type, void *dst) {
         return dy_err(DY_ERR_FAILED, "nvs_get: %s", esp_err_to_name(esp_err));
     }
 
-    if (dy_is_err(err = set_cache(id, type, dst))) {
+    if (dy_is_err(err = set_cache(id, type, dst, len != NULL ? *len : 0))) {
         return dy_err_pfx("set_cache", err);
     }
 
     return err;
 }
 
-static dy_err_t set(int id, uint8_t type, void *src) {
+static dy_err_t set(int id, uint8_t type, void *src, size_t len) {
     esp_err_t esp_err;
     dy_err_t err;
     uint32_t bits;
@@ -205,6 +232,12 @@ static dy_err_t set(int id, uint8_t type, void *src) {
         case DY_CFG2_VALUE_TYPE_STR:
             esp_err = nvs_set_str(nvs_hdl, key, src);
             break;
+        case DY_CFG2_VALUE_TYPE_BLOB:
+            if (len > DY_CFG2_BLOB_MAX_LEN) {
+                return dy_err(DY_ERR_INVALID_ARG, "blob value is too long");
+            }
+            esp_err = nvs_set_blob(nvs_hdl, key, src, len);
+            break;
         default:
             return dy_err(DY_ERR_INVALID_ARG, "unexpected type %d", type);
     }
@@ -217,11 +250,11 @@ static dy_err_t set(int id, uint8_t type, void *src) {
         return dy_err_pfx("commit_nvs", err);
     }
 
-    if (dy_is_err(err = set_cache(id, type, src))) {
+    if (dy_is_err(err = set_cache(id, type, src, len))) {
         return dy_err_pfx("set_cache", err);
     }
 
-    dy_cfg2_evt_set_t evt = {.id = id, .type = type, .val = src};
+    dy_cfg2_evt_set_t evt = {.id = id, .type = type, .val = src, .len = len};
     if ((esp_err = esp_event_post(DY_CFG2_EVENT_BASE, DY_CFG2_EVENT_SET, &evt, sizeof(evt), 10)) != ESP_OK) {
         ESP_LOGE(LTAG, "%s: post set event failed: %s", __func__, esp_err_to_name(esp_err));
     }
@@ -230,11 +263,11 @@ static dy_err_t set(int id, uint8_t type, void *src) {
 }
 
 dy_err_t dy_cfg2_get_u8(int id, uint8_t *dst) {
-    return get(id, DY_CFG2_VALUE_TYPE_U8, dst);
+    return get(id, DY_CFG2_VALUE_TYPE_U8, dst, NULL);
 }
 
 dy_err_t dy_cfg2_get_u8_dft(int id, uint8_t *dst, uint8_t dft) {
-    dy_err_t err = get(id, DY_CFG2_VALUE_TYPE_U8, dst);
+    dy_err_t err = get(id, DY_CFG2_VALUE_TYPE_U8, dst, NULL);
     if (err->code == DY_ERR_NOT_FOUND) {
         *dst = dft;
         return dy_ok();
@@ -243,15 +276,15 @@ dy_err_t dy_cfg2_get_u8_dft(int id, uint8_t *dst, uint8_t dft) {
 }
 
 dy_err_t dy_cfg2_set_u8(int id, uint8_t val) {
-    return set(id, DY_CFG2_VALUE_TYPE_U8, &val);
+    return set(id, DY_CFG2_VALUE_TYPE_U8, &val, 0);
 }
 
 dy_err_t dy_cfg2_get_float(int id, float *dst) {
-    return get(id, DY_CFG2_VALUE_TYPE_FLOAT, dst);
+    return get(id, DY_CFG2_VALUE_TYPE_FLOAT, dst, NULL);
 }
 
 dy_err_t dy_cfg2_get_float_dft(int id, float *dst, float dft) {
-    dy_err_t err = get(id, DY_CFG2_VALUE_TYPE_FLOAT, dst);
+    dy_err_t err = get(id, DY_CFG2_VALUE_TYPE_FLOAT, dst, NULL);
     if (err->code == DY_ERR_NOT_FOUND) {
         *dst = dft;
         return dy_ok();
@@ -260,15 +293,15 @@ dy_err_t dy_cfg2_get_float_dft(int id, float *dst, float dft) {
 }
 
 dy_err_t dy_cfg2_set_float(int id, float val) {
-    return set(id, DY_CFG2_VALUE_TYPE_FLOAT, &val);
+    return set(id, DY_CFG2_VALUE_TYPE_FLOAT, &val, 0);
 }
 
 dy_err_t dy_cfg2_get_str(int id, char *dst) {
-    return get(id, DY_CFG2_VALUE_TYPE_STR, dst);
+    return get(id, DY_CFG2_VALUE_TYPE_STR, dst, NULL);
 }
 
 dy_err_t dy_cfg2_get_str_dft(int id, char *dst, const char *dft) {
-    dy_err_t err = get(id, DY_CFG2_VALUE_TYPE_STR, dst);
+    dy_err_t err = get(id, DY_CFG2_VALUE_TYPE_STR, dst, NULL);
     if (err->code == DY_ERR_NOT_FOUND) {
         strlcpy(dst, dft, DY_CFG2_STR_MAX_LEN);
         return dy_ok();
@@ -277,7 +310,15 @@ dy_err_t dy_cfg2_get_str_dft(int id, char *dst, const char *dft) {
 }
 
 dy_err_t dy_cfg2_set_str(int id, const char *val) {
-    return set(id, DY_CFG2_VALUE_TYPE_STR, (void *) val);
+    return set(id, DY_CFG2_VALUE_TYPE_STR, (void *) val, 0);
+}
+
+dy_err_t dy_cfg2_get_blob(int id, void *dst, size_t *len) {
+    return get(id, DY_CFG2_VALUE_TYPE_BLOB, dst, len);
+}
+
+dy_err_t dy_cfg2_set_blob(int id, const void *val, size_t len) {
+    return set(id, DY_CFG2_VALUE_TYPE_BLOB, (void *) val, len);
 }
 
 dy_err_t dy_cfg2_init() {
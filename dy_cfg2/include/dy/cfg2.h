@@ -15,14 +15,17 @@
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
 #include "dy/error.h"
 
 #define DY_CFG2_VALUE_TYPE_U8    0x01
 #define DY_CFG2_VALUE_TYPE_FLOAT 0x02
 #define DY_CFG2_VALUE_TYPE_STR   0x03
+#define DY_CFG2_VALUE_TYPE_BLOB  0x04
 
 #define DY_CFG2_EVENT_BASE "DY_CFG2_EVENT_BASE"
 #define DY_CFG2_STR_MAX_LEN 256
+#define DY_CFG2_BLOB_MAX_LEN 256
 
 enum {
     DY_CFG2_EVENT_SET,
@@ -32,6 +35,7 @@ typedef struct {
     int id;
     uint8_t type;
     void *val;
+    size_t len; // blob values only
 } dy_cfg2_evt_set_t;
 
 /**
@@ -123,6 +127,24 @@ dy_err_t dy_cfg2_get_str_dft(int id, char *dst, const char *dft);
  */
 dy_err_t dy_cfg2_set_str(int id, const char *val);
 
+/**
+ * @brief Gets a configuration value of type blob.
+ *
+ * @param id The configuration parameter ID.
+ * @param dst Pointer to store the retrieved blob.
+ * @param len Capacity of dst on input, length of the retrieved blob on output.
+ */
+dy_err_t dy_cfg2_get_blob(int id, void *dst, size_t *len);
+
+/**
+ * @brief Sets a configuration value of type blob.
+ *
+ * @param id The configuration parameter ID.
+ * @param val The blob to set.
+ * @param len Length of the blob, up to DY_CFG2_BLOB_MAX_LEN.
+ */
+dy_err_t dy_cfg2_set_blob(int id, const void *val, size_t len);
+
 /**
  * @brief Initializes the dy_cfg2 module.
  * @warning Ensure to call nvs_flash_init() before calling this function.
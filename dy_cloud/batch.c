@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <string.h>
+#include "dy/cloud.h"
+#include "http_client.h"
+#include "scheduler.h"
+
+#define BATCH_PATH "/batch"
+#define URL_MAX_LEN 768
+
+typedef struct {
+    dy_cloud_job_t **jobs;
+    uint8_t n;
+    bool found[DY_CLOUD_SCHED_MAX_JOBS];
+} batch_ctx_t;
+
+// Appends parameters to the query, skipping ones already present.
+static bool append_params(char *url, size_t *len, const char *params) {
+    while (*params != '\0') {
+        size_t p_len = strcspn(params, "&");
+        char *q = strchr(url, '?') + 1;
+
+        // Look for the same "key=value" among parameters already added
+        bool dup = false;
+        while (!dup && *q != '\0') {
+            size_t q_len = strcspn(q, "&");
+            dup = q_len == p_len && strncmp(q, params, p_len) == 0;
+            q += q[q_len] == '&' ? q_len + 1 : q_len;
+        }
+
+        if (!dup && p_len > 0) {
+            if (*len + p_len + 1 >= URL_MAX_LEN) {
+                return false;
+            }
+            url[(*len)++] = '&';
+            memcpy(url + *len, params, p_len);
+            *len += p_len;
+            url[*len] = '\0';
+        }
+
+        params += params[p_len] == '&' ? p_len + 1 : p_len;
+    }
+
+    return true;
+}
+
+// Dispatches values to jobs by the first path segment, e.g. "weather.temp" goes to the weather job as "temp".
+static void on_json_value(void *args, const char *path, dy_cloud_json_type_t type, const char *value) {
+    batch_ctx_t *ctx = args;
+
+    for (uint8_t i = 0; i < ctx->n; i++) {
+        const dy_cloud_batch_handler_t *h = ctx->jobs[i]->batch;
+        size_t len = strlen(ctx->jobs[i]->name);
+
+        if (strncmp(path, ctx->jobs[i]->name, len) != 0 || (path[len] != '.' && path[len] != '\0')) {
+            continue;
+        }
+
+        // A null resource is the same as a missing one
+        if (path[len] == '\0' && type == DY_CLOUD_JSON_NULL) {
+            return;
+        }
+
+        ctx->found[i] = true;
+        h->on_value(h->args, path[len] == '.' ? path + len + 1 : path + len, type, value);
+
+        return;
+    }
+}
+
+dy_err_t batch_run(dy_cloud_job_t **jobs, uint8_t n, dy_err_t *results) {
+    dy_err_t err;
+    char url[URL_MAX_LEN];
+
+    int len = snprintf(url, URL_MAX_LEN, "%s%s?include=", dy_cloud_get_api_url(), BATCH_PATH);
+    for (uint8_t i = 0; i < n && len > 0 && len < URL_MAX_LEN; i++) {
+        len += snprintf(url + len, URL_MAX_LEN - len, i > 0 ? ",%s" : "%s", jobs[i]->name);
+    }
+    if (len < 0 || len >= URL_MAX_LEN) {
+        return dy_err(DY_ERR_INVALID_ARG, "batch url is too long");
+    }
+
+    size_t url_len = len;
+    for (uint8_t i = 0; i < n; i++) {
+        if (!append_params(url, &url_len, jobs[i]->batch->query())) {
+            return dy_err(DY_ERR_INVALID_ARG, "batch url is too long");
+        }
+    }
+
+    batch_ctx_t ctx = {.jobs = jobs, .n = n};
+    for (uint8_t i = 0; i < n; i++) {
+        jobs[i]->batch->begin();
+    }
+
+    if (dy_is_err(err = http_get_json(url, NULL, on_json_value, &ctx))) {
+        return err;
+    }
+
+    for (uint8_t i = 0; i < n; i++) {
+        results[i] = jobs[i]->batch->end(ctx.found[i]);
+    }
+
+    return dy_ok();
+}
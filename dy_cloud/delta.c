@@ -0,0 +1,244 @@
+#include <stdlib.h>
+#include <string.h>
+#include "miniz.h"
+#include "delta.h"
+
+#define OP_COPY 0x01
+#define OP_ADD 0x02
+#define OP_INSERT 0x03
+
+enum {
+    ST_HEADER,
+    ST_OP,
+    ST_ARGS,
+    ST_DATA,
+};
+
+static uint32_t get_u32(const uint8_t *p) {
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+static dy_err_t parse_header(dy_cloud_delta_t *d) {
+    const uint8_t *p = d->hdr_buf;
+
+    if (memcmp(p, DY_CLOUD_DELTA_MAGIC, 4) != 0) {
+        return dy_err(DY_ERR_INVALID_VERSION, "not a DYD1 patch");
+    }
+
+    d->hdr.base_size = get_u32(p + 4);
+    memcpy(d->hdr.base_sha256, p + 8, 32);
+    d->hdr.target_size = get_u32(p + 40);
+    memcpy(d->hdr.target_sha256, p + 44, 32);
+
+    return d->io.begin(d->io.args, &d->hdr);
+}
+
+static dy_err_t write_target(dy_cloud_delta_t *d, const uint8_t *src, size_t len) {
+    d->written += len;
+    d->left -= len;
+
+    return d->io.write(d->io.args, src, len);
+}
+
+// Runs a COPY op, which has no data.
+static dy_err_t copy(dy_cloud_delta_t *d) {
+    dy_err_t err;
+
+    while (d->left > 0) {
+        size_t n = d->left < DY_CLOUD_DELTA_BUF_SIZE ? d->left : DY_CLOUD_DELTA_BUF_SIZE;
+        if (dy_is_err(err = d->io.read_base(d->io.args, d->offset, d->buf, n))) {
+            return err;
+        }
+        d->offset += n;
+        if (dy_is_err(err = write_target(d, d->buf, n))) {
+            return err;
+        }
+    }
+
+    return dy_ok();
+}
+
+// Takes the data of an ADD or INSERT op.
+static dy_err_t take_data(dy_cloud_delta_t *d, const uint8_t *data, size_t len) {
+    dy_err_t err;
+
+    if (d->op == OP_INSERT) {
+        return write_target(d, data, len);
+    }
+
+    while (len > 0) {
+        size_t n = len < DY_CLOUD_DELTA_BUF_SIZE ? len : DY_CLOUD_DELTA_BUF_SIZE;
+        if (dy_is_err(err = d->io.read_base(d->io.args, d->offset, d->buf, n))) {
+            return err;
+        }
+        for (size_t i = 0; i < n; i++) {
+            d->buf[i] += data[i];
+        }
+        d->offset += n;
+        if (dy_is_err(err = write_target(d, d->buf, n))) {
+            return err;
+        }
+        data += n;
+        len -= n;
+    }
+
+    return dy_ok();
+}
+
+// Starts an op once its arguments are read.
+static dy_err_t start_op(dy_cloud_delta_t *d) {
+    if (d->op == OP_INSERT) {
+        d->offset = 0;
+        d->left = get_u32(d->args);
+    } else {
+        d->offset = get_u32(d->args);
+        d->left = get_u32(d->args + 4);
+        if (d->offset > d->hdr.base_size || d->left > d->hdr.base_size - d->offset) {
+            return dy_err(DY_ERR_INVALID_SIZE, "op at %lu refers outside the base", d->written);
+        }
+    }
+
+    if (d->left > d->hdr.target_size - d->written) {
+        return dy_err(DY_ERR_INVALID_SIZE, "op at %lu exceeds the target", d->written);
+    }
+
+    d->state = ST_DATA;
+    if (d->op == OP_COPY) {
+        dy_err_t err = copy(d);
+        d->state = ST_OP;
+        return err;
+    }
+    if (d->left == 0) {
+        d->state = ST_OP;
+    }
+
+    return dy_ok();
+}
+
+// Runs ops from inflated bytes.
+static dy_err_t run_ops(dy_cloud_delta_t *d, const uint8_t *data, size_t len) {
+    dy_err_t err;
+
+    while (len > 0) {
+        switch (d->state) {
+            case ST_OP:
+                if (d->written == d->hdr.target_size) {
+                    return dy_err(DY_ERR_FAILED, "ops after the end of the target");
+                }
+                d->op = *data++;
+                len--;
+                if (d->op != OP_COPY && d->op != OP_ADD && d->op != OP_INSERT) {
+                    return dy_err(DY_ERR_FAILED, "unknown op 0x%02x at %lu", d->op, d->written);
+                }
+                d->args_len = 0;
+                d->state = ST_ARGS;
+                break;
+
+            case ST_ARGS: {
+                uint8_t need = d->op == OP_INSERT ? 4 : 8;
+                size_t n = need - d->args_len < len ? need - d->args_len : len;
+                memcpy(d->args + d->args_len, data, n);
+                d->args_len += n;
+                data += n;
+                len -= n;
+                if (d->args_len == need && dy_is_err(err = start_op(d))) {
+                    return err;
+                }
+                break;
+            }
+
+            case ST_DATA: {
+                size_t n = d->left < len ? d->left : len;
+                if (dy_is_err(err = take_data(d, data, n))) {
+                    return err;
+                }
+                data += n;
+                len -= n;
+                if (d->left == 0) {
+                    d->state = ST_OP;
+                }
+                break;
+            }
+
+            default:
+                return dy_err(DY_ERR_FAILED, "unexpected state %d", d->state);
+        }
+    }
+
+    return dy_ok();
+}
+
+dy_err_t delta_begin(dy_cloud_delta_t *d, const dy_cloud_delta_io_t *io) {
+    memset(d, 0, sizeof(*d));
+    d->io = *io;
+    d->state = ST_HEADER;
+
+    d->inflator = malloc(sizeof(tinfl_decompressor));
+    d->window = malloc(TINFL_LZ_DICT_SIZE);
+    if (d->inflator == NULL || d->window == NULL) {
+        delta_end(d);
+        return dy_err(DY_ERR_NO_MEM, "malloc failed");
+    }
+    tinfl_init((tinfl_decompressor *) d->inflator);
+
+    return dy_ok();
+}
+
+dy_err_t delta_feed(dy_cloud_delta_t *d, const uint8_t *data, size_t len) {
+    dy_err_t err;
+
+    if (d->state == ST_HEADER) {
+        size_t n = DY_CLOUD_DELTA_HEADER_LEN - d->hdr_len < len ? DY_CLOUD_DELTA_HEADER_LEN - d->hdr_len : len;
+        memcpy(d->hdr_buf + d->hdr_len, data, n);
+        d->hdr_len += n;
+        data += n;
+        len -= n;
+        if (d->hdr_len < DY_CLOUD_DELTA_HEADER_LEN) {
+            return dy_ok();
+        }
+        if (dy_is_err(err = parse_header(d))) {
+            return err;
+        }
+        d->state = ST_OP;
+    }
+
+    tinfl_status status = TINFL_STATUS_NEEDS_MORE_INPUT;
+    while (len > 0 || status == TINFL_STATUS_HAS_MORE_OUTPUT) {
+        if (d->inflated) {
+            return dy_err(DY_ERR_FAILED, "data after the end of the patch");
+        }
+
+        size_t in_len = len;
+        size_t out_len = TINFL_LZ_DICT_SIZE - d->window_pos;
+        status = tinfl_decompress(d->inflator, data, &in_len, d->window, d->window + d->window_pos, &out_len,
+                                  TINFL_FLAG_HAS_MORE_INPUT);
+        data += in_len;
+        len -= in_len;
+
+        if (status < TINFL_STATUS_DONE) {
+            return dy_err(DY_ERR_FAILED, "tinfl_decompress: %d", status);
+        }
+
+        if (dy_is_err(err = run_ops(d, d->window + d->window_pos, out_len))) {
+            return err;
+        }
+        d->window_pos = (d->window_pos + out_len) & (TINFL_LZ_DICT_SIZE - 1);
+
+        if (status == TINFL_STATUS_DONE) {
+            d->inflated = true;
+        }
+    }
+
+    return dy_ok();
+}
+
+bool delta_done(const dy_cloud_delta_t *d) {
+    return d->inflated && d->state == ST_OP && d->written == d->hdr.target_size;
+}
+
+void delta_end(dy_cloud_delta_t *d) {
+    free(d->inflator);
+    free(d->window);
+    d->inflator = NULL;
+    d->window = NULL;
+}
@@ -0,0 +1,89 @@
+/**
+ * @brief Streaming applier of DYD1 delta patches, internal to dy_cloud.
+ *
+ * A patch turns a base image into a target one. It starts with a header, followed by a raw deflate stream of ops:
+ *
+ *  - COPY  (0x01, u32 offset, u32 len): copies `len` bytes of the base at `offset`.
+ *  - ADD   (0x02, u32 offset, u32 len, len bytes): adds the bytes to ones of the base at `offset`, modulo 256, which
+ *          turns code shifted by a changed function into runs of zeros that compress well.
+ *  - INSERT(0x03, u32 len, len bytes): inserts the bytes as is.
+ *
+ * Integers are little endian. Ops run until the target is complete. Patches are made by tools/make_delta.py.
+ *
+ * RAM usage is bounded by the inflate state and its 32 KiB window, allocated for the time of the update.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "dy/error.h"
+
+#define DY_CLOUD_DELTA_MAGIC "DYD1"
+#define DY_CLOUD_DELTA_HEADER_LEN 76
+#define DY_CLOUD_DELTA_BUF_SIZE 256
+
+typedef struct {
+    uint32_t base_size;
+    uint8_t base_sha256[32];
+    uint32_t target_size;
+    uint8_t target_sha256[32];
+} dy_cloud_delta_header_t;
+
+typedef struct {
+    dy_err_t (*begin)(void *args, const dy_cloud_delta_header_t *hdr); // validates the header, e.g. the base hash
+    dy_err_t (*read_base)(void *args, uint32_t offset, void *dst, size_t len);
+    dy_err_t (*write)(void *args, const void *src, size_t len); // gets the target sequentially
+    void *args;
+} dy_cloud_delta_io_t;
+
+typedef struct {
+    dy_cloud_delta_io_t io;
+    void *inflator;   // tinfl_decompressor
+    uint8_t *window;  // inflate output, wrapping
+    size_t window_pos;
+    bool inflated;    // the deflate stream has ended
+    uint8_t state;
+    uint8_t hdr_buf[DY_CLOUD_DELTA_HEADER_LEN];
+    uint8_t hdr_len;
+    dy_cloud_delta_header_t hdr;
+    uint8_t op;
+    uint8_t args[8];
+    uint8_t args_len;
+    uint32_t offset;  // base offset of the current op
+    uint32_t left;    // bytes left of the current op
+    uint32_t written; // bytes of the target
+    uint8_t buf[DY_CLOUD_DELTA_BUF_SIZE];
+} dy_cloud_delta_t;
+
+/**
+ * Prepares a patch to be fed.
+ *
+ * @return
+ *  - DY_ERR_NO_MEM if the inflate state can't be allocated.
+ *  - DY_OK on success.
+ */
+dy_err_t delta_begin(dy_cloud_delta_t *d, const dy_cloud_delta_io_t *io);
+
+/**
+ * Applies the next part of the patch.
+ *
+ * @return
+ *  - DY_ERR_INVALID_VERSION if the patch is not a DYD1 one.
+ *  - DY_ERR_INVALID_SIZE if the patch refers outside the base or the target.
+ *  - DY_ERR_FAILED if the patch is malformed.
+ *  - Errors of io callbacks.
+ *  - DY_OK on success.
+ */
+dy_err_t delta_feed(dy_cloud_delta_t *d, const uint8_t *data, size_t len);
+
+/**
+ * Checks whether the patch is complete and the whole target is written.
+ */
+bool delta_done(const dy_cloud_delta_t *d);
+
+/**
+ * Frees the inflate state.
+ */
+void delta_end(dy_cloud_delta_t *d);
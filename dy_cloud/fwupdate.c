@@ -1,34 +1,97 @@
 #include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
 
 #include "freertos/FreeRTOS.h"
-#include "cJSON.h"
+#include "freertos/task.h"
 #include "esp_log.h"
+#include "esp_event.h"
+#include "esp_timer.h"
 #include "esp_crt_bundle.h"
+#include "esp_http_client.h"
+#include "esp_partition.h"
 #include "esp_ota_ops.h"
-#include "esp_https_ota.h"
+#include "mbedtls/sha256.h"
 
 #include "dy/error.h"
-#include "dy/net_cfg.h"
 #include "dy/appinfo.h"
+#include "dy/cloud.h"
+#include "delta.h"
+#include "http_client.h"
+#include "scheduler.h"
 
-#define API_URL "https://api.d5y.xyz/v2/firmware/update"
-#define CHECK_PERIOD 42949 // ~11 hours, limited by max value of uint32
+#define API_PATH "/firmware/update"
+#define CHECK_PERIOD 43200 // 12 hours
 #define URL_MAX_LEN 512 // URL can be really long, so we use 512 bytes
 #define HTTP_REQ_TIMEOUT 5000
+#define DOWNLOAD_BUF_SIZE 1024
+#define DOWNLOAD_ATTEMPTS 5       // connections per job run; each one resumes where the previous one stopped
+#define DOWNLOAD_RETRY_DELAY 2000 // ms
+#define PROGRESS_PERIOD 500       // ms
+#define SHA256_HEX_LEN 64
+#define CONTENT_RANGE_MAX_LEN 64
+#define INSTALL_STACK_SIZE 6144   // the install task exists only while an update is installed
 #define LTAG "DY_CLOUD"
 
-extern dy_err_t http_get_json(const char *url, cJSON **rsp_json);
-
-static char fwupdate_url[URL_MAX_LEN] = {0};
-static bool allow_alpha_versions = false;
-
 typedef struct {
     char url[URL_MAX_LEN];
     size_t size;
-    char sha256[65];
+    char sha256[SHA256_HEX_LEN + 1];
+    char delta_url[URL_MAX_LEN]; // optional; a patch turning the running image into the new one
+    size_t delta_size;
 } dy_cloud_resp_fw_update_t;
 
-static dy_err_t check(dy_cloud_resp_fw_update_t *res) {
+// Download in progress. It outlives a failed job run, so the next run resumes it rather than starts over, unless
+// another image is advertised by then.
+typedef struct {
+    bool active;
+    bool is_delta;
+    char sha256[SHA256_HEX_LEN + 1]; // of the image
+    uint32_t size;                   // of the image
+    const esp_partition_t *part;
+    const esp_partition_t *base; // patched by the delta
+    esp_ota_handle_t ota;
+    mbedtls_sha256_context sha; // of the image written so far
+    uint32_t received;          // bytes of the download, the image or the patch
+    uint32_t written;           // bytes of the image
+    dy_cloud_delta_t delta;
+} download_t;
+
+typedef struct {
+    int64_t started;   // us, esp_timer time
+    uint32_t received; // bytes received before the start
+    int64_t reported;  // us, esp_timer time
+} progress_t;
+
+static char fwupdate_url[URL_MAX_LEN] = {0};
+static const char *fwupdate_query = ""; // points into fwupdate_url
+static bool allow_alpha_versions = false;
+static dy_cloud_resp_fw_update_t result;
+static download_t dl;
+static progress_t progress;
+static uint8_t buf[DOWNLOAD_BUF_SIZE];
+static dy_cloud_job_t job;
+
+static void on_json_value(void *args, const char *path, dy_cloud_json_type_t type, const char *value) {
+    dy_cloud_resp_fw_update_t *res = args;
+
+    if (strcmp(path, "url") == 0 && type == DY_CLOUD_JSON_STRING) {
+        strlcpy(res->url, value, URL_MAX_LEN);
+    } else if (strcmp(path, "sha256") == 0 && type == DY_CLOUD_JSON_STRING) {
+        strlcpy(res->sha256, value, sizeof(res->sha256));
+    } else if (strcmp(path, "size") == 0 && type == DY_CLOUD_JSON_NUMBER) {
+        res->size = strtoul(value, NULL, 10);
+    } else if (strcmp(path, "delta.url") == 0 && type == DY_CLOUD_JSON_STRING) {
+        strlcpy(res->delta_url, value, URL_MAX_LEN);
+    } else if (strcmp(path, "delta.size") == 0 && type == DY_CLOUD_JSON_NUMBER) {
+        res->delta_size = strtoul(value, NULL, 10);
+    }
+}
+
+static dy_err_t build_url() {
     dy_err_t err;
 
     dy_appinfo_info_t ai;
@@ -36,53 +99,384 @@ static dy_err_t check(dy_cloud_resp_fw_update_t *res) {
         return dy_err_pfx("dy_appinfo_get", err);
     }
 
-    int n = snprintf(fwupdate_url, URL_MAX_LEN, "%s?app=%s&to_alpha=%d", API_URL, ai.id, allow_alpha_versions);
+    int n = snprintf(fwupdate_url, URL_MAX_LEN, "%s%s?app=%s&to_alpha=%d", dy_cloud_get_api_url(), API_PATH, ai.id,
+                     allow_alpha_versions);
     if (n < 0 || n >= URL_MAX_LEN) {
         return dy_err(DY_ERR_INVALID_ARG, "firmware update url is too long");
     }
+    fwupdate_query = strchr(fwupdate_url, '?') + 1;
 
-    cJSON *json;
-    err = http_get_json(fwupdate_url, &json);
-    if (err->code == DY_ERR_NOT_FOUND) {
-        return err;
-    } else if (dy_is_err(err)) {
-        return dy_err_pfx("http_get_json", err);
+    return dy_ok();
+}
+
+static dy_err_t print_part_info() {
+    const esp_partition_t *run_part = esp_ota_get_running_partition();
+    if (run_part == NULL) {
+        return dy_err(DY_ERR_FAILED, "esp_ota_get_running_partition returned null");
     }
+    ESP_LOGI(LTAG, "running partition: label=%s; size=%lu", run_part->label, run_part->size);
 
-    memset(res, 0, sizeof(*res));
+    const esp_partition_t *boot_part = esp_ota_get_boot_partition();
+    if (boot_part == NULL) {
+        return dy_err(DY_ERR_FAILED, "esp_ota_get_boot_partition returned null");
+    }
+    ESP_LOGI(LTAG, "boot partition: label=%s; size=%lu", boot_part->label, boot_part->size);
+
+    return dy_ok();
+}
+
+static bool is_sha256_hex(const char *s) {
+    size_t i = 0;
+    while (i < SHA256_HEX_LEN && isxdigit((unsigned char) s[i])) {
+        i++;
+    }
+
+    return i == SHA256_HEX_LEN && s[i] == '\0';
+}
 
-    cJSON *r_url = cJSON_GetObjectItem(json, "url");
-    if (r_url != NULL) {
-        strlcpy(res->url, cJSON_GetStringValue(r_url), URL_MAX_LEN);
+static void report_progress(uint32_t total, bool force) {
+    int64_t now = esp_timer_get_time();
+    if (!force && now - progress.reported < (int64_t) PROGRESS_PERIOD * 1000) {
+        return;
     }
+    progress.reported = now;
 
-    cJSON *sha256 = cJSON_GetObjectItem(json, "sha256");
-    if (sha256 != NULL) {
-        strlcpy(res->sha256, cJSON_GetStringValue(sha256), sizeof(res->sha256));
+    dy_cloud_fw_progress_t ev = {.received = dl.received, .total = total};
+    if (now > progress.started) {
+        ev.rate = (uint32_t) ((uint64_t) (dl.received - progress.received) * 1000000 / (now - progress.started));
     }
 
-    cJSON *size = cJSON_GetObjectItem(json, "size");
-    if (size != NULL) {
-        res->size = (int) cJSON_GetNumberValue(size);
+    // Don't hold the download up if the event queue is full
+    esp_event_post(DY_CLOUD_EV_BASE, DY_CLOUD_EV_FW_PROGRESS, &ev, sizeof(ev), 0);
+}
+
+static void sha256_hex(const uint8_t *digest, char *dst) {
+    for (uint8_t i = 0; i < 32; i++) {
+        snprintf(dst + i * 2, 3, "%02x", digest[i]);
     }
+}
 
-    cJSON_Delete(json);
+static dy_err_t write_image(const void *src, size_t len) {
+    esp_err_t esp_err;
+
+    if (len > dl.size - dl.written) {
+        return dy_err(DY_ERR_INVALID_SIZE, "image is bigger than %lu bytes", dl.size);
+    }
+
+    mbedtls_sha256_update(&dl.sha, src, len);
+    if ((esp_err = esp_ota_write(dl.ota, src, len)) != ESP_OK) {
+        return dy_err(DY_ERR_FAILED, "esp_ota_write: %s", esp_err_to_name(esp_err));
+    }
+    dl.written += len;
 
     return dy_ok();
 }
 
-static dy_err_t print_part_info() {
-    const esp_partition_t *run_part = esp_ota_get_running_partition();
-    if (run_part == NULL) {
-        return dy_err(DY_ERR_FAILED, "esp_ota_get_running_partition returned null");
+// Checks that the patch makes the advertised image of the running one.
+static dy_err_t delta_on_begin(void *args, const dy_cloud_delta_header_t *hdr) {
+    char hex[SHA256_HEX_LEN + 1];
+
+    sha256_hex(hdr->target_sha256, hex);
+    if (hdr->target_size != dl.size || strcasecmp(hex, dl.sha256) != 0) {
+        return dy_err(DY_ERR_INVALID_ARG, "patch makes another image: %s", hex);
     }
-    ESP_LOGI(LTAG, "running partition: label=%s; size=%lu", run_part->label, run_part->size);
 
-    const esp_partition_t *boot_part = esp_ota_get_boot_partition();
-    if (boot_part == NULL) {
-        return dy_err(DY_ERR_FAILED, "esp_ota_get_boot_partition returned null");
+    if (hdr->base_size > dl.base->size) {
+        return dy_err(DY_ERR_INVALID_SIZE, "patch base is bigger than the running partition");
+    }
+
+    uint8_t chunk[256], digest[32];
+    mbedtls_sha256_context sha;
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts(&sha, 0);
+    for (uint32_t off = 0; off < hdr->base_size; off += sizeof(chunk)) {
+        size_t n = hdr->base_size - off < sizeof(chunk) ? hdr->base_size - off : sizeof(chunk);
+        esp_err_t esp_err = esp_partition_read(dl.base, off, chunk, n);
+        if (esp_err != ESP_OK) {
+            mbedtls_sha256_free(&sha);
+            return dy_err(DY_ERR_FAILED, "esp_partition_read: %s", esp_err_to_name(esp_err));
+        }
+        mbedtls_sha256_update(&sha, chunk, n);
+    }
+    mbedtls_sha256_finish(&sha, digest);
+    mbedtls_sha256_free(&sha);
+
+    if (memcmp(digest, hdr->base_sha256, sizeof(digest)) != 0) {
+        return dy_err(DY_ERR_INVALID_ARG, "patch is made for another base image");
+    }
+
+    return dy_ok();
+}
+
+static dy_err_t delta_read_base(void *args, uint32_t offset, void *dst, size_t len) {
+    esp_err_t esp_err = esp_partition_read(dl.base, offset, dst, len);
+    if (esp_err != ESP_OK) {
+        return dy_err(DY_ERR_FAILED, "esp_partition_read: %s", esp_err_to_name(esp_err));
+    }
+
+    return dy_ok();
+}
+
+static dy_err_t delta_write(void *args, const void *src, size_t len) {
+    return write_image(src, len);
+}
+
+static const dy_cloud_delta_io_t delta_io = {
+        .begin = delta_on_begin,
+        .read_base = delta_read_base,
+        .write = delta_write,
+};
+
+static void download_abort() {
+    if (!dl.active) {
+        return;
+    }
+
+    if (dl.is_delta) {
+        delta_end(&dl.delta);
+    }
+    esp_ota_abort(dl.ota);
+    mbedtls_sha256_free(&dl.sha);
+    dl.active = false;
+}
+
+// Starts a download of the image or its patch, or keeps the one in progress if it's the same.
+static dy_err_t download_begin(const dy_cloud_resp_fw_update_t *res, bool delta) {
+    dy_err_t err;
+
+    if (dl.active && dl.is_delta == delta && strcasecmp(dl.sha256, res->sha256) == 0) {
+        ESP_LOGI(LTAG, "resuming firmware download at %lu bytes", dl.received);
+        return dy_ok();
+    }
+
+    download_abort();
+
+    const esp_partition_t *part = esp_ota_get_next_update_partition(NULL);
+    if (part == NULL) {
+        return dy_err(DY_ERR_FAILED, "esp_ota_get_next_update_partition returned null");
+    }
+    if (res->size > part->size) {
+        return dy_err(DY_ERR_INVALID_SIZE, "image size %u exceeds partition size %lu", res->size, part->size);
+    }
+
+    if (delta) {
+        if ((dl.base = esp_ota_get_running_partition()) == NULL) {
+            return dy_err(DY_ERR_FAILED, "esp_ota_get_running_partition returned null");
+        }
+        if (dy_is_err(err = delta_begin(&dl.delta, &delta_io))) {
+            return dy_err_pfx("delta_begin", err);
+        }
+    }
+
+    // Sequential writes erase sectors as they are reached rather than the whole partition at once, which would stall
+    // other tasks, including the display one, for seconds
+    esp_err_t esp_err = esp_ota_begin(part, OTA_WITH_SEQUENTIAL_WRITES, &dl.ota);
+    if (esp_err != ESP_OK) {
+        if (delta) {
+            delta_end(&dl.delta);
+        }
+        return dy_err(DY_ERR_FAILED, "esp_ota_begin: %s", esp_err_to_name(esp_err));
+    }
+
+    mbedtls_sha256_init(&dl.sha);
+    mbedtls_sha256_starts(&dl.sha, 0);
+    strlcpy(dl.sha256, res->sha256, sizeof(dl.sha256));
+    dl.size = res->size;
+    dl.part = part;
+    dl.is_delta = delta;
+    dl.received = 0;
+    dl.written = 0;
+    dl.active = true;
+
+    return dy_ok();
+}
+
+// Keeps the Content-Range of the response; esp_http_client_get_header() only looks up request headers.
+static esp_err_t download_ev_handler(esp_http_client_event_t *evt) {
+    if (evt->event_id == HTTP_EVENT_ON_HEADER && strcasecmp(evt->header_key, "Content-Range") == 0) {
+        strlcpy(evt->user_data, evt->header_value, CONTENT_RANGE_MAX_LEN);
+    }
+
+    return ESP_OK;
+}
+
+// Reads the response body into the partition, patching the base if it's a delta; `resumable` tells whether
+// a failure can be resumed by a new request.
+static dy_err_t download_body(esp_http_client_handle_t cli, const char *content_range, uint32_t total,
+                              bool *resumable) {
+    esp_err_t esp_err;
+    dy_err_t err;
+
+    *resumable = true;
+    esp_err = esp_http_client_open(cli, 0);
+    if (esp_err != ESP_OK) {
+        return dy_err(DY_ERR_FAILED, "esp_http_client_open: %s", esp_err_to_name(esp_err));
+    }
+
+    int64_t content_len = esp_http_client_fetch_headers(cli);
+    if (content_len < 0) {
+        return dy_err(DY_ERR_FAILED, "esp_http_client_fetch_headers: %lld", content_len);
+    }
+
+    *resumable = false;
+    int status = esp_http_client_get_status_code(cli);
+    uint32_t skip = 0; // bytes already received, in case the server ignores the range
+    if (status == 206) {
+        if (strncmp(content_range, "bytes ", 6) != 0 || strtoul(content_range + 6, NULL, 10) != dl.received) {
+            return dy_err(DY_ERR_FAILED, "unexpected content range: %s",
+                          content_range[0] != '\0' ? content_range : "none");
+        }
+    } else if (status == 200) {
+        skip = dl.received;
+    } else {
+        return dy_err(DY_ERR_FAILED, "unexpected response status: %d", status);
+    }
+
+    if (content_len > 0 && content_len + dl.received - skip != total) {
+        return dy_err(DY_ERR_INVALID_SIZE, "content length %lld doesn't match advertised %lu", content_len, total);
+    }
+
+    while (dl.received < total) {
+        int n = esp_http_client_read(cli, (char *) buf, DOWNLOAD_BUF_SIZE);
+        if (n <= 0) {
+            *resumable = true;
+            return dy_err(DY_ERR_FAILED, "connection lost at %lu of %lu bytes", dl.received, total);
+        }
+
+        uint8_t *data = buf;
+        if (skip > 0) {
+            uint32_t k = (uint32_t) n < skip ? (uint32_t) n : skip;
+            skip -= k;
+            data += k;
+            n -= (int) k;
+        }
+        if (n == 0) {
+            continue;
+        }
+
+        if (dl.received + n > total) {
+            return dy_err(DY_ERR_INVALID_SIZE, "download is bigger than %lu bytes", total);
+        }
+
+        err = dl.is_delta ? delta_feed(&dl.delta, data, n) : write_image(data, n);
+        if (dy_is_err(err)) {
+            return err;
+        }
+        dl.received += n;
+
+        report_progress(total, false);
+
+        // Higher priority tasks, like the display one, preempt the scheduler task anyway; let the idle task and other
+        // lowest priority ones run too, since the loop hardly ever blocks on a fast network
+        taskYIELD();
+    }
+
+    return dy_ok();
+}
+
+// Downloads the rest of the image or its patch over one connection.
+static dy_err_t download(const char *url, uint32_t total, const char *user_agent, bool *resumable) {
+    char content_range[CONTENT_RANGE_MAX_LEN] = {0};
+
+    esp_http_client_config_t http_cfg = {
+            .user_agent = user_agent,
+            .method = HTTP_METHOD_GET,
+            .url = url,
+            .timeout_ms = HTTP_REQ_TIMEOUT,
+            .keep_alive_enable = false,
+            .crt_bundle_attach = esp_crt_bundle_attach,
+            .buffer_size_tx = 2048,
+            .event_handler = download_ev_handler,
+            .user_data = content_range,
+    };
+
+    esp_http_client_handle_t cli = esp_http_client_init(&http_cfg);
+    if (cli == NULL) {
+        *resumable = true;
+        return dy_err(DY_ERR_FAILED, "esp_http_client_init returned null");
+    }
+
+    char range[32];
+    if (dl.received > 0) {
+        snprintf(range, sizeof(range), "bytes=%lu-", dl.received);
+        esp_http_client_set_header(cli, "Range", range);
+    }
+
+    dy_err_t err = download_body(cli, content_range, total, resumable);
+
+    esp_http_client_close(cli);
+    esp_http_client_cleanup(cli);
+
+    return err;
+}
+
+// Writes the image to the next partition, from the full image or a patch against the running one, and verifies it.
+static dy_err_t install(const dy_cloud_resp_fw_update_t *res, bool delta, const char *user_agent, bool *resumable) {
+    esp_err_t esp_err;
+    dy_err_t err;
+
+    *resumable = false;
+    if (dy_is_err(err = download_begin(res, delta))) {
+        return dy_err_pfx("download_begin", err);
+    }
+
+    const char *url = delta ? res->delta_url : res->url;
+    uint32_t total = delta ? res->delta_size : res->size;
+
+    progress.started = esp_timer_get_time();
+    progress.received = dl.received;
+    report_progress(total, true);
+
+    for (uint8_t attempt = 1;; attempt++) {
+        if (!dy_is_err(err = download(url, total, user_agent, resumable))) {
+            break;
+        }
+
+        if (!*resumable) {
+            download_abort();
+            return err;
+        }
+
+        // The download is kept, so the next job run resumes it
+        if (attempt == DOWNLOAD_ATTEMPTS) {
+            return err;
+        }
+
+        ESP_LOGW(LTAG, "firmware download: %s; resuming in %d ms", dy_err_str(err), DOWNLOAD_RETRY_DELAY);
+        vTaskDelay(pdMS_TO_TICKS(DOWNLOAD_RETRY_DELAY));
+    }
+
+    *resumable = false;
+    report_progress(total, true);
+
+    if (delta && !delta_done(&dl.delta)) {
+        download_abort();
+        return dy_err(DY_ERR_INVALID_SIZE, "patch ended at %lu of %lu image bytes", dl.written, dl.size);
+    }
+    if (dl.written != dl.size) {
+        download_abort();
+        return dy_err(DY_ERR_INVALID_SIZE, "image ended at %lu of %lu bytes", dl.written, dl.size);
+    }
+
+    uint8_t digest[32];
+    char digest_hex[SHA256_HEX_LEN + 1];
+    mbedtls_sha256_finish(&dl.sha, digest);
+    sha256_hex(digest, digest_hex);
+    if (strcasecmp(digest_hex, res->sha256) != 0) {
+        download_abort();
+        return dy_err(DY_ERR_FAILED, "sha256 mismatch: got %s", digest_hex);
+    }
+
+    if (delta) {
+        delta_end(&dl.delta);
+    }
+    mbedtls_sha256_free(&dl.sha);
+    dl.active = false;
+
+    // Validates the image as well
+    if ((esp_err = esp_ota_end(dl.ota)) != ESP_OK) {
+        return dy_err(DY_ERR_FAILED, "esp_ota_end: %s", esp_err_to_name(esp_err));
     }
-    ESP_LOGI(LTAG, "boot partition: label=%s; size=%lu", boot_part->label, boot_part->size);
 
     return dy_ok();
 }
@@ -91,6 +485,10 @@ static dy_err_t perform(dy_cloud_resp_fw_update_t *res) {
     esp_err_t esp_err;
     dy_err_t err;
 
+    if (res->size == 0 || !is_sha256_hex(res->sha256)) {
+        return dy_err(DY_ERR_INVALID_ARG, "no valid size and sha256 advertised; refusing to install unverified image");
+    }
+
     dy_appinfo_info_t ai;
     if (dy_is_err(err = dy_appinfo_get(&ai))) {
         return dy_err_pfx("dy_appinfo_get", err);
@@ -103,24 +501,30 @@ static dy_err_t perform(dy_cloud_resp_fw_update_t *res) {
 
     ESP_LOGI(LTAG, "starting firmware update");
 
-    esp_http_client_config_t http_cfg = {
-            .user_agent = ai.id,
-            .method = HTTP_METHOD_GET,
-            .url = res->url,
-            .timeout_ms = HTTP_REQ_TIMEOUT,
-            .keep_alive_enable = false,
-            .crt_bundle_attach = esp_crt_bundle_attach,
-            .buffer_size_tx = 2048,
-    };
+    // A full download in progress is finished rather than replaced by a delta one
+    bool delta = res->delta_url[0] != '\0' && res->delta_size > 0 &&
+                 !(dl.active && !dl.is_delta && strcasecmp(dl.sha256, res->sha256) == 0);
+
+    bool resumable = false;
+    err = dy_ok();
+    if (delta) {
+        ESP_LOGI(LTAG, "applying delta update: url=%s; size=%u", res->delta_url, res->delta_size);
+        if (dy_is_err(err = install(res, true, ai.id, &resumable))) {
+            if (resumable) {
+                return dy_err_pfx("delta update", err);
+            }
+            ESP_LOGW(LTAG, "delta update: %s; falling back to full image", dy_err_str(err));
+        }
+    }
 
-    esp_https_ota_config_t ota_cfg = {
-            .http_config = &http_cfg,
-            .partial_http_download = true,
-    };
+    if (!delta || dy_is_err(err)) {
+        if (dy_is_err(err = install(res, false, ai.id, &resumable))) {
+            return dy_err_pfx("full update", err);
+        }
+    }
 
-    esp_err = esp_https_ota(&ota_cfg);
-    if (esp_err != ESP_OK) {
-        return dy_err(DY_ERR_FAILED, "esp_https_ota: %s", esp_err_to_name(esp_err));
+    if ((esp_err = esp_ota_set_boot_partition(dl.part)) != ESP_OK) {
+        return dy_err(DY_ERR_FAILED, "esp_ota_set_boot_partition: %s", esp_err_to_name(esp_err));
     }
 
     ESP_LOGI(LTAG, "getting partition setup after update");
@@ -133,48 +537,87 @@ static dy_err_t perform(dy_cloud_resp_fw_update_t *res) {
     return dy_ok();
 }
 
-_Noreturn static void task() {
+static void begin() {
+    memset(&result, 0, sizeof(result));
+}
+
+// Installs the update found; doesn't return on success. Runs in a task of its own, so other jobs aren't held back by
+// the download.
+static dy_err_t install_update() {
     dy_err_t err;
-    dy_cloud_resp_fw_update_t upd;
 
-    while (1) {
-        if (!dy_net_cfg_net_connected()) {
-            vTaskDelay(pdMS_TO_TICKS(1000 * 10));
-            continue;
-        }
+    if (dy_is_err(err = perform(&result))) {
+        return dy_err_pfx("firmware update failed", err);
+    }
 
-        err = check(&upd);
+    ESP_LOGI(LTAG, "update succeeded");
+    ESP_LOGI(LTAG, "restarting...");
 
-        if (err->code == DY_ERR_NOT_FOUND) {
-            ESP_LOGI(LTAG, "no firmware update found");
-            vTaskDelay(pdMS_TO_TICKS(1000 * CHECK_PERIOD));
-            continue;
-        } else if (dy_is_err(err)) {
-            ESP_LOGE(LTAG, "firmware update check: %s", dy_err_str(err));
-            vTaskDelay(pdMS_TO_TICKS(1000 * 10));
-            continue;
-        }
+    esp_restart();
+}
 
-        ESP_LOGI(LTAG, "firmware update found: url=%s; size=%d; sha256=%s", upd.url, upd.size, upd.sha256);
+// Hands the update found, if any, over to the install task.
+static dy_err_t end(bool found) {
+    if (!found || result.url[0] == '\0') {
+        ESP_LOGI(LTAG, "no firmware update found");
+        download_abort(); // the update was withdrawn
+        return dy_ok();
+    }
 
-        if (dy_is_err(err = perform(&upd))) {
-            ESP_LOGE(LTAG, "firmware update failed: %s", dy_err_str(err));
-            continue;
-        }
+    ESP_LOGI(LTAG, "firmware update found: url=%s; size=%d; sha256=%s", result.url, result.size, result.sha256);
+
+    // The job isn't run again until the install ends, so the result stays intact meanwhile
+    scheduler_continue_in_task(&job, install_update, INSTALL_STACK_SIZE);
+
+    return dy_ok();
+}
 
-        ESP_LOGI(LTAG, "update succeeded");
-        ESP_LOGI(LTAG, "restarting...");
+static dy_err_t check_and_update() {
+    dy_err_t err;
 
-        esp_restart();
+    if (dy_is_err(err = build_url())) {
+        return err;
     }
+
+    begin();
+
+    err = http_get_json(fwupdate_url, NULL, on_json_value, &result);
+    if (err->code == DY_ERR_NOT_FOUND) {
+        return end(false);
+    } else if (dy_is_err(err)) {
+        return dy_err_pfx("firmware update check", err);
+    }
+
+    return end(true);
 }
 
-dy_err_t dy_cloud_fwupdate_scheduler_start(bool allow_alpha) {
-    allow_alpha_versions = allow_alpha;
+static const char *query() {
+    dy_err_t err;
 
-    if (xTaskCreate(task, "dy_cloud_fw_upd", 8192, NULL, tskIDLE_PRIORITY, NULL) != pdTRUE) {
-        return dy_err(DY_ERR_FAILED, "task create failed");
+    if (dy_is_err(err = build_url())) {
+        ESP_LOGE(LTAG, "build_url: %s", dy_err_str(err));
     }
 
-    return dy_ok();
+    return fwupdate_query;
+}
+
+static const dy_cloud_batch_handler_t batch_handler = {
+        .query = query,
+        .begin = begin,
+        .on_value = on_json_value,
+        .args = &result,
+        .end = end,
+};
+
+static dy_cloud_job_t job = {
+        .name = "firmware",
+        .period = CHECK_PERIOD,
+        .run = check_and_update,
+        .batch = &batch_handler,
+};
+
+dy_err_t dy_cloud_fwupdate_scheduler_start(bool allow_alpha) {
+    allow_alpha_versions = allow_alpha;
+
+    return scheduler_add_job(&job);
 }
\ No newline at end of file
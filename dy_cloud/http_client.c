@@ -1,53 +1,111 @@
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
-#include "cJSON.h"
 #include "esp_err.h"
 #include "esp_http_client.h"
 #include "esp_crt_bundle.h"
+#include "esp_timer.h"
 #include "esp_log.h"
 
 #include "dy/appinfo.h"
 #include "dy/error.h"
+#include "dy/cloud.h"
+#include "http_client.h"
 
 #define HTTP_REQ_TIMEOUT 5000
-#define HTTP_RSP_MAX_LEN 2048 // Should be enough for any reasonable response
 #define HTTP_AUTHORIZATION_MAX_LEN 128
+#define HTTP_HOST_MAX_LEN 64
+#define HTTP_POOL_SIZE 2 // requests in flight at once, and hosts kept connections to
+#define HTTP_POOL_IDLE_TIMEOUT 30000000 // us; idle connections are closed after it, but TLS sessions are kept
+#define LTAG "DY_CLOUD"
+
+// Consumes a chunk of response body.
+typedef dy_err_t (*dy_cloud_http_data_cb_t)(void *args, const char *data, size_t len);
 
 typedef struct {
     esp_http_client_method_t method;
     const char *url;
-    int *rsp_status;
-    int64_t *rsp_len;
-    char *rsp_body;
+    dy_cloud_http_data_cb_t on_data; // optional; called for bodies of 200 responses only
+    void *args;
+    int rsp_status;
+    int64_t rsp_len;
+    bool rsp_received; // some body has been passed to on_data
+    dy_err_t rsp_err;  // first error returned by on_data; the rest of the body is ignored after it
+    const dy_cloud_http_validators_t *validators; // optional; makes the request conditional
+    char rsp_etag[DY_CLOUD_HTTP_ETAG_MAX_LEN];
+    char rsp_last_modified[DY_CLOUD_HTTP_DATE_MAX_LEN];
 } dy_cloud_http_req_t;
 
-static char authorization[HTTP_AUTHORIZATION_MAX_LEN];
-static char response[HTTP_RSP_MAX_LEN];
-static QueueHandle_t mux = NULL;
-
-static dy_err_t json_err() {
-    dy_err_t err;
-
-    const char *error_ptr = cJSON_GetErrorPtr();
-    if (error_ptr != NULL) {
-        err = dy_err(DY_ERR_JSON_PARSE, "%s", error_ptr);
-    } else {
-        err = dy_err(DY_ERR_JSON_PARSE, "reason unknown");
-    }
+// Pooled client bound to a host. The client keeps its TCP connection alive between requests
+// and its TLS session ticket between connections, so reconnects use abbreviated handshakes.
+typedef struct {
+    char host[HTTP_HOST_MAX_LEN];
+    esp_http_client_handle_t cli;
+    bool in_use;       // taken by a request
+    bool connected;    // connection is possibly alive
+    int64_t last_used; // us
+    int64_t req_start; // us
+    dy_cloud_http_req_t *req;
+} dy_cloud_http_conn_t;
 
-    return err;
-}
+static SemaphoreHandle_t mux = NULL;   // guards the pool and stats; never held while a request is performed
+static SemaphoreHandle_t slots = NULL; // counts idle pooled connections; requests wait on it for one
+static dy_cloud_http_conn_t pool[HTTP_POOL_SIZE];
+static dy_cloud_stats_t stats;
 
 static esp_err_t http_cli_ev_handler(esp_http_client_event_t *evt) {
+    dy_cloud_http_conn_t *conn = evt->user_data;
+
     switch (evt->event_id) {
-        case HTTP_EVENT_ON_DATA:
-            if (evt->data_len >= HTTP_RSP_MAX_LEN) {
-                return ESP_ERR_NO_MEM;
+        case HTTP_EVENT_ON_CONNECTED: {
+            // Fired for new connections only, so it counts TCP and TLS handshakes
+            uint32_t ms = (esp_timer_get_time() - conn->req_start) / 1000;
+            conn->connected = true;
+            xSemaphoreTake(mux, portMAX_DELAY);
+            stats.handshakes++;
+            stats.handshake_ms_last = ms;
+            stats.handshake_ms_total += ms;
+            if (ms > stats.handshake_ms_max) {
+                stats.handshake_ms_max = ms;
             }
-            memcpy(response, evt->data, evt->data_len);
-            response[evt->data_len] = '\0';
+            xSemaphoreGive(mux);
+            break;
+        }
+
+        case HTTP_EVENT_DISCONNECTED:
+            conn->connected = false;
             break;
 
+        case HTTP_EVENT_ON_HEADER: {
+            dy_cloud_http_req_t *req = conn->req;
+            if (strcasecmp(evt->header_key, "ETag") == 0) {
+                strlcpy(req->rsp_etag, evt->header_value, DY_CLOUD_HTTP_ETAG_MAX_LEN);
+            } else if (strcasecmp(evt->header_key, "Last-Modified") == 0) {
+                strlcpy(req->rsp_last_modified, evt->header_value, DY_CLOUD_HTTP_DATE_MAX_LEN);
+            }
+            break;
+        }
+
+        case HTTP_EVENT_ON_DATA: {
+            // Chunks are passed through as they arrive, so the body is never buffered as a whole
+            dy_cloud_http_req_t *req = conn->req;
+
+            xSemaphoreTake(mux, portMAX_DELAY);
+            stats.bytes_rx += evt->data_len;
+            xSemaphoreGive(mux);
+
+            if (req->on_data == NULL || dy_is_err(req->rsp_err) ||
+                esp_http_client_get_status_code(evt->client) != HttpStatus_Ok) {
+                break;
+            }
+            req->rsp_received = true;
+            req->rsp_err = req->on_data(req->args, evt->data, evt->data_len);
+            break;
+        }
+
         default:
             break;
     }
@@ -55,110 +113,296 @@ static esp_err_t http_cli_ev_handler(esp_http_client_event_t *evt) {
     return ESP_OK;
 }
 
-dy_err_t http_request(dy_cloud_http_req_t *req) {
+// Extracts the host part of a URL.
+static dy_err_t url_host(const char *url, char *host) {
+    const char *start = strstr(url, "://");
+    start = start != NULL ? start + 3 : url;
+
+    size_t len = strcspn(start, "/?#");
+    if (len == 0 || len >= HTTP_HOST_MAX_LEN) {
+        return dy_err(DY_ERR_INVALID_ARG, "invalid url host: %s", url);
+    }
+
+    memcpy(host, start, len);
+    host[len] = '\0';
+
+    return dy_ok();
+}
+
+// Destroys the client of a taken connection; the slot stays taken.
+static void conn_free(dy_cloud_http_conn_t *conn) {
+    if (conn->cli != NULL) {
+        esp_http_client_cleanup(conn->cli);
+    }
+
+    conn->cli = NULL;
+    conn->host[0] = '\0';
+    conn->connected = false;
+    conn->req = NULL;
+}
+
+static void conn_release(dy_cloud_http_conn_t *conn) {
+    conn->req = NULL;
+
+    xSemaphoreTake(mux, portMAX_DELAY);
+    conn->in_use = false;
+    xSemaphoreGive(mux);
+
+    xSemaphoreGive(slots);
+}
+
+// Takes an idle pooled connection, preferring one to the host of the URL. Waits for one if all are taken;
+// waiting tasks get connections by priority, then in FIFO order.
+static dy_err_t conn_acquire(const char *url, const char *user_agent, dy_cloud_http_conn_t **conn) {
+    char host[HTTP_HOST_MAX_LEN];
     dy_err_t err;
-    esp_err_t esp_err;
-    esp_http_client_handle_t cli;
 
-    dy_appinfo_info_t ai;
-    if (dy_is_err(err = dy_appinfo_get(&ai))) {
-        return dy_err_pfx("dy_appinfo_get", err);
+    if (dy_is_err(err = url_host(url, host))) {
+        return err;
     }
 
-    if (mux == NULL) {
-        mux = xSemaphoreCreateMutex();
-        if (mux == NULL) {
-            return dy_err(DY_ERR_FAILED, "xSemaphoreCreateMutex returned null");
+    dy_cloud_http_conn_t *c = NULL, *lru = NULL;
+
+    // Taking a slot guarantees that the pool has an idle connection
+    xSemaphoreTake(slots, portMAX_DELAY);
+    xSemaphoreTake(mux, portMAX_DELAY);
+    for (uint8_t i = 0; i < HTTP_POOL_SIZE; i++) {
+        if (pool[i].in_use) {
+            continue;
+        }
+        if (pool[i].cli != NULL && strcmp(pool[i].host, host) == 0) {
+            c = &pool[i];
+            break;
         }
+        if (lru == NULL || pool[i].cli == NULL || (lru->cli != NULL && pool[i].last_used < lru->last_used)) {
+            lru = &pool[i];
+        }
+    }
+    if (c == NULL) {
+        c = lru;
     }
+    c->in_use = true;
+    xSemaphoreGive(mux);
 
-    if (xSemaphoreTake(mux, (TickType_t) 100) != pdTRUE) {
-        return dy_err(DY_ERR_FAILED, "xSemaphoreTake failed");
+    if (c->cli != NULL && strcmp(c->host, host) == 0) {
+        // Close connections idle for too long, as servers likely have dropped them already
+        if (c->connected && esp_timer_get_time() - c->last_used > HTTP_POOL_IDLE_TIMEOUT) {
+            esp_http_client_close(c->cli);
+            c->connected = false;
+        }
+
+        esp_http_client_set_url(c->cli, url);
+        *conn = c;
+
+        return dy_ok();
     }
 
+    // The slot is free or bound to another host
+    conn_free(c);
+
     esp_http_client_config_t cfg = {
-            .method = req->method,
-            .url = req->url,
-            .user_agent = ai.id,
+            .url = url,
+            .user_agent = user_agent,
             .timeout_ms = HTTP_REQ_TIMEOUT,
             .event_handler = http_cli_ev_handler,
-            .keep_alive_enable = false,
+            .user_data = c,
+            .keep_alive_enable = true,
+            .save_client_session = true, // requires CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
             .crt_bundle_attach = esp_crt_bundle_attach,
     };
 
-    cli = esp_http_client_init(&cfg);
-    if (cli == NULL) {
-        xSemaphoreGive(mux);
+    c->cli = esp_http_client_init(&cfg);
+    if (c->cli == NULL) {
+        conn_release(c);
         return dy_err(DY_ERR_NO_MEM, "esp_http_client_init failed");
     }
+    strcpy(c->host, host);
+    *conn = c;
 
+    return dy_ok();
+}
+
+static esp_err_t perform(dy_cloud_http_conn_t *conn) {
+    conn->req_start = esp_timer_get_time();
+
+    xSemaphoreTake(mux, portMAX_DELAY);
+    stats.requests++;
+    xSemaphoreGive(mux);
+
+    esp_err_t esp_err = esp_http_client_perform(conn->cli);
+
+    if (esp_err != ESP_OK) {
+        conn->connected = false;
+    }
+    conn->last_used = esp_timer_get_time();
+
+    return esp_err;
+}
+
+// Performs a request in the calling task.
+static dy_err_t http_request(dy_cloud_http_req_t *req) {
+    dy_err_t err;
+    esp_err_t esp_err;
+    dy_cloud_http_conn_t *conn;
+    char authorization[HTTP_AUTHORIZATION_MAX_LEN];
+
+    if (mux == NULL) {
+        return dy_err(DY_ERR_INVALID_STATE, "http client is not started");
+    }
+
+    dy_appinfo_info_t ai;
+    if (dy_is_err(err = dy_appinfo_get(&ai))) {
+        return dy_err_pfx("dy_appinfo_get", err);
+    }
+
+    if (dy_is_err(err = conn_acquire(req->url, ai.id, &conn))) {
+        return dy_err_pfx("conn_acquire", err);
+    }
+
+    esp_http_client_set_method(conn->cli, req->method);
+
+    // Pooled clients keep headers of previous requests
     if (strlen(ai.auth) > 0) {
         memset(authorization, 0, HTTP_AUTHORIZATION_MAX_LEN);
         strcpy(authorization, "Bearer ");
-        strncat(authorization, ai.auth, HTTP_AUTHORIZATION_MAX_LEN - strlen(authorization));
-        esp_http_client_set_header(cli, "Authorization", authorization);
+        strncat(authorization, ai.auth, HTTP_AUTHORIZATION_MAX_LEN - strlen(authorization) - 1);
+        esp_http_client_set_header(conn->cli, "Authorization", authorization);
+    } else {
+        esp_http_client_delete_header(conn->cli, "Authorization");
     }
 
-    if ((esp_err = esp_http_client_perform(cli)) != ESP_OK) {
-        esp_http_client_cleanup(cli);
-        xSemaphoreGive(mux);
-        return dy_err(DY_ERR_FAILED, "esp_http_client_perform failed: %d", esp_err_to_name(esp_err));
+    const dy_cloud_http_validators_t *v = req->validators;
+    if (v != NULL && v->etag[0] != '\0') {
+        esp_http_client_set_header(conn->cli, "If-None-Match", v->etag);
+    } else {
+        esp_http_client_delete_header(conn->cli, "If-None-Match");
+    }
+    if (v != NULL && v->last_modified[0] != '\0') {
+        esp_http_client_set_header(conn->cli, "If-Modified-Since", v->last_modified);
+    } else {
+        esp_http_client_delete_header(conn->cli, "If-Modified-Since");
     }
 
-    *req->rsp_status = esp_http_client_get_status_code(cli);
-    *req->rsp_len = esp_http_client_get_content_length(cli);
+    conn->req = req;
+    req->rsp_received = false;
+    req->rsp_err = dy_ok();
+    req->rsp_etag[0] = '\0';
+    req->rsp_last_modified[0] = '\0';
 
-    memset(req->rsp_body, 0, HTTP_RSP_MAX_LEN);
-    strlcpy(req->rsp_body, response, HTTP_RSP_MAX_LEN);
+    bool reused = conn->connected;
+    if ((esp_err = perform(conn)) != ESP_OK && reused && !req->rsp_received) {
+        // The server may have closed the kept-alive connection meanwhile; retry over a new one
+        ESP_LOGW(LTAG, "request over kept-alive connection failed: %s; reconnecting", esp_err_to_name(esp_err));
+        esp_http_client_close(conn->cli);
+        esp_err = perform(conn);
+    }
 
-    if ((esp_err = esp_http_client_cleanup(cli)) != ESP_OK) {
+    if (esp_err != ESP_OK) {
+        xSemaphoreTake(mux, portMAX_DELAY);
+        stats.failures++;
         xSemaphoreGive(mux);
-        return dy_err(DY_ERR_FAILED, "esp_http_client_cleanup failed: %d", esp_err_to_name(esp_err));
+
+        conn_free(conn);
+        conn_release(conn);
+        return dy_err(DY_ERR_FAILED, "esp_http_client_perform failed: %s", esp_err_to_name(esp_err));
     }
 
-    xSemaphoreGive(mux);
+    req->rsp_status = esp_http_client_get_status_code(conn->cli);
+    req->rsp_len = esp_http_client_get_content_length(conn->cli);
+    conn_release(conn);
 
     return dy_ok();
 }
 
-dy_err_t http_get_json(const char *url, cJSON **rsp_json) {
-    int rsp_status = 0;
-    int64_t rsp_len = 0;
+dy_err_t http_client_start() {
+    if (mux != NULL) {
+        return dy_ok();
+    }
+
+    if (slots == NULL && (slots = xSemaphoreCreateCounting(HTTP_POOL_SIZE, HTTP_POOL_SIZE)) == NULL) {
+        return dy_err(DY_ERR_NO_MEM, "xSemaphoreCreateCounting returned null");
+    }
+
+    if ((mux = xSemaphoreCreateMutex()) == NULL) {
+        return dy_err(DY_ERR_NO_MEM, "xSemaphoreCreateMutex returned null");
+    }
+
+    return dy_ok();
+}
+
+void dy_cloud_get_stats(dy_cloud_stats_t *dst) {
+    if (mux == NULL) {
+        memset(dst, 0, sizeof(dy_cloud_stats_t));
+        return;
+    }
+
+    xSemaphoreTake(mux, portMAX_DELAY);
+    *dst = stats;
+    xSemaphoreGive(mux);
+}
+
+static dy_err_t json_feed(void *args, const char *data, size_t len) {
+    return dy_cloud_json_feed(args, data, len);
+}
+
+void http_count_suppressed_event() {
+    xSemaphoreTake(mux, portMAX_DELAY);
+    stats.events_suppressed++;
+    xSemaphoreGive(mux);
+}
+
+dy_err_t http_get_json(const char *url, dy_cloud_http_validators_t *validators, dy_cloud_json_cb_t cb, void *args) {
+    dy_err_t err;
 
-    char *rsp_body = malloc(HTTP_RSP_MAX_LEN);
-    if (rsp_body == NULL) {
-        return dy_err(DY_ERR_NO_MEM, "response buffer allocation failed");
+    // The extractor has fixed size, whatever the size of the response is
+    dy_cloud_json_t *parser = malloc(sizeof(dy_cloud_json_t));
+    if (parser == NULL) {
+        return dy_err(DY_ERR_NO_MEM, "json parser allocation failed");
     }
+    dy_cloud_json_init(parser, cb, args);
+
     dy_cloud_http_req_t req = {
             .method = HTTP_METHOD_GET,
             .url = url,
-            .rsp_status = &rsp_status,
-            .rsp_len = &rsp_len,
-            .rsp_body = rsp_body,
+            .on_data = json_feed,
+            .args = parser,
+            .validators = validators,
     };
 
-    dy_err_t err = http_request(&req);
-    if (dy_is_err(err)) {
-        free(rsp_body);
+    if (dy_is_err(err = http_request(&req))) {
+        free(parser);
         return dy_err_pfx("http request failed", err);
     }
 
-    if (rsp_status == 204) {
-        free(rsp_body);
-        return dy_err(DY_ERR_NO_CONTENT, "no content");
-    } else if (rsp_status == HttpStatus_NotFound) {
-        free(rsp_body);
-        return dy_err(DY_ERR_NOT_FOUND, "not found");
-    } else if (rsp_status > HttpStatus_BadRequest) {
-        free(rsp_body);
-        return dy_err(DY_ERR_FAILED, "bad http response status: %d", rsp_status);
+    if (req.rsp_status == 304 && validators != NULL) {
+        validators->not_modified = true;
+        free(parser);
+
+        xSemaphoreTake(mux, portMAX_DELAY);
+        stats.not_modified++;
+        xSemaphoreGive(mux);
+
+        return dy_ok();
+    } else if (req.rsp_status == 204) {
+        err = dy_err(DY_ERR_NO_CONTENT, "no content");
+    } else if (req.rsp_status == HttpStatus_NotFound) {
+        err = dy_err(DY_ERR_NOT_FOUND, "not found");
+    } else if (req.rsp_status != HttpStatus_Ok) {
+        err = dy_err(DY_ERR_FAILED, "bad http response status: %d", req.rsp_status);
+    } else if (dy_is_err(req.rsp_err)) {
+        err = req.rsp_err;
+    } else {
+        err = dy_cloud_json_done(parser);
     }
 
-    *rsp_json = cJSON_ParseWithLength(rsp_body, rsp_len);
-    free(rsp_body);
-    if (*rsp_json == NULL) {
-        return json_err();
+    free(parser);
+
+    // Keep validators of the last response which was processed completely
+    if (validators != NULL && !dy_is_err(err)) {
+        strlcpy(validators->etag, req.rsp_etag, DY_CLOUD_HTTP_ETAG_MAX_LEN);
+        strlcpy(validators->last_modified, req.rsp_last_modified, DY_CLOUD_HTTP_DATE_MAX_LEN);
+        validators->not_modified = false;
     }
 
-    return dy_ok();
+    return err;
 }
@@ -0,0 +1,50 @@
+/**
+ * @brief HTTP client, internal to dy_cloud.
+ *
+ * Requests are performed in the calling task over a small pool of kept-alive connections.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include "dy/error.h"
+#include "json.h"
+
+#define DY_CLOUD_HTTP_ETAG_MAX_LEN 64
+#define DY_CLOUD_HTTP_DATE_MAX_LEN 32
+
+/**
+ * Cache validators of a resource. If set, requests are conditional and the server may respond 304 Not Modified.
+ */
+typedef struct {
+    char etag[DY_CLOUD_HTTP_ETAG_MAX_LEN];          // sent as If-None-Match
+    char last_modified[DY_CLOUD_HTTP_DATE_MAX_LEN]; // sent as If-Modified-Since
+    bool not_modified;                              // the last response was 304, so the resource is unchanged
+} dy_cloud_http_validators_t;
+
+/**
+ * Prepares the connection pool; subsequent calls do nothing.
+ */
+dy_err_t http_client_start();
+
+/**
+ * @brief Fetches a JSON document, passing its values to a callback while it streams in.
+ *
+ * @param url           URL.
+ * @param validators    Optional; validators of the previous response, updated on success.
+ * @param cb            Callback.
+ * @param args          Callback's arguments.
+ *
+ * @return
+ *  - DY_ERR_NO_CONTENT on 204 responses.
+ *  - DY_ERR_NOT_FOUND on 404 responses.
+ *  - DY_ERR_JSON_PARSE if the document is malformed.
+ *  - DY_ERR_FAILED on other errors.
+ *  - DY_OK on success, including 304 responses, which set `validators->not_modified`.
+ */
+dy_err_t http_get_json(const char *url, dy_cloud_http_validators_t *validators, dy_cloud_json_cb_t cb, void *args);
+
+/**
+ * Counts an update event which was not posted because the data hasn't changed.
+ */
+void http_count_suppressed_event();
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <time.h>
+#include <stdint.h>
 #include <stdbool.h>
 #include "dy/error.h"
 
@@ -9,6 +10,7 @@
 #define DY_CLOUD_TIME_TZ_DATA_LEN 32
 
 #define DY_CLOUD_EV_BASE "DY_CLOUD"
+#define DY_CLOUD_API_URL_DEFAULT "https://api.d5y.xyz/v2"
 
 #define DY_CLOUD_WEATHER_ID_UNKNOWN 0
 #define DY_CLOUD_WEATHER_ID_CLEAR 1
@@ -32,12 +34,14 @@
 typedef enum {
     DY_CLOUD_EV_TIME_UPDATED,
     DY_CLOUD_EV_WEATHER_UPDATED,
+    DY_CLOUD_EV_FW_PROGRESS,
 } dy_cloud_event_id_t;
 
 typedef struct {
     char tz[DY_CLOUD_TIME_TZ_LEN];       // timezone
     char tzd[DY_CLOUD_TIME_TZ_DATA_LEN]; // timezone data in POSIX format
     unsigned long int ts;                // timestamp
+    bool stale;                          // replayed from storage at startup; `ts` is the time of the last fetch
 } dy_cloud_time_t;
 
 typedef struct {
@@ -46,9 +50,73 @@ typedef struct {
     bool is_day;
     int8_t temp;
     int8_t feels;
-    time_t ts;
+    time_t ts;  // time of the fetch
+    bool stale; // replayed from storage at startup
 } dy_cloud_weather_t;
 
+/**
+ * Firmware download progress.
+ */
+typedef struct {
+    uint32_t received; // bytes
+    uint32_t total;    // bytes
+    uint32_t rate;     // bytes/s
+} dy_cloud_fw_progress_t;
+
+/**
+ * Retry policy of a sync job.
+ *
+ * After a failure, the job is retried after a random delay between 0 and `base * 2^(failures - 1)` seconds, capped
+ * by `max` ("full jitter"), so devices failed together don't retry in lockstep. After `breaker_threshold` consecutive
+ * failures the circuit breaker opens and the job is suspended for `breaker_timeout` seconds, randomized down to a half
+ * of it. Then a single trial run closes the breaker on success or opens it again on failure.
+ */
+typedef struct {
+    uint32_t base;              // s
+    uint32_t max;               // s
+    uint32_t breaker_threshold; // 0 disables the breaker
+    uint32_t breaker_timeout;   // s
+} dy_cloud_retry_policy_t;
+
+#define DY_CLOUD_RETRY_POLICY_DEFAULT ((dy_cloud_retry_policy_t) { \
+    .base = 10,                                                    \
+    .max = 900,                                                    \
+    .breaker_threshold = 8,                                        \
+    .breaker_timeout = 3600,                                       \
+})
+
+typedef enum {
+    DY_CLOUD_BREAKER_CLOSED,    // the job runs normally
+    DY_CLOUD_BREAKER_OPEN,      // the job is suspended after too many failures
+    DY_CLOUD_BREAKER_HALF_OPEN, // a trial run is in progress
+} dy_cloud_breaker_t;
+
+/**
+ * Retry state of a sync job.
+ */
+typedef struct {
+    dy_cloud_breaker_t breaker;
+    uint32_t failures; // consecutive failures
+    uint32_t runs;     // total runs
+    uint32_t delay;    // ms; the last retry delay, 0 after a success
+    int64_t next_due;  // us, esp_timer time of the next run
+} dy_cloud_retry_state_t;
+
+/**
+ * HTTP client statistics.
+ */
+typedef struct {
+    uint32_t requests;           // performed requests, including retries
+    uint32_t failures;           // requests failed at the transport level
+    uint32_t handshakes;         // new connections; requests minus handshakes were served over kept-alive ones
+    uint32_t handshake_ms_last;  // duration of the last connection setup, including TLS handshake
+    uint32_t handshake_ms_max;
+    uint32_t handshake_ms_total; // divide by `handshakes` to get the average
+    uint32_t bytes_rx;           // response body bytes received
+    uint32_t not_modified;       // conditional requests answered 304 Not Modified
+    uint32_t events_suppressed;  // update events not posted because the data hasn't changed
+} dy_cloud_stats_t;
+
 /**
  * @brief Sets the location for weather and time fetching.
  *
@@ -71,6 +139,22 @@ float dy_cloud_get_location_lat();
  */
 float dy_cloud_get_location_lng();
 
+/**
+ * @brief Sets the base URL of the cloud API, e.g. to point the device to a local mock server.
+ *
+ * Must be called before the schedulers are started.
+ *
+ * @param url Base URL without trailing slash; DY_CLOUD_API_URL_DEFAULT by default.
+ */
+void dy_cloud_set_api_url(const char *url);
+
+/**
+ * @brief Gets the base URL of the cloud API.
+ *
+ * @return Base URL.
+ */
+const char *dy_cloud_get_api_url();
+
 /**
  * @brief Starts the current time fetcher.
  *
@@ -102,3 +186,37 @@ dy_err_t dy_cloud_weather_scheduler_start();
  *  - DY_OK on success.
  */
 dy_err_t dy_cloud_fwupdate_scheduler_start(bool allow_alpha);
+
+/**
+ * @brief Sets the retry policy of a sync job.
+ *
+ * @param job       Job name: "time", "weather" or "firmware"; NULL sets the policy of all jobs, including ones
+ *                  started later.
+ * @param policy    Policy.
+ * @return
+ *  - DY_ERR_INVALID_ARG if the policy is invalid.
+ *  - DY_ERR_NOT_FOUND if there is no such job.
+ *  - DY_OK on success.
+ */
+dy_err_t dy_cloud_set_retry_policy(const char *job, dy_cloud_retry_policy_t policy);
+
+/**
+ * @brief Gets the retry state of a sync job.
+ *
+ * @param job   Job name: "time", "weather" or "firmware".
+ * @param dst   Where to store the state.
+ * @return
+ *  - DY_ERR_NOT_FOUND if the job is not started.
+ *  - DY_OK on success.
+ */
+dy_err_t dy_cloud_get_retry_state(const char *job, dy_cloud_retry_state_t *dst);
+
+/**
+ * @brief Gets HTTP client statistics.
+ *
+ * Connections are pooled per host and kept alive between requests; TLS session tickets are reused
+ * on reconnects if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS is enabled.
+ *
+ * @param dst Where to store the statistics.
+ */
+void dy_cloud_get_stats(dy_cloud_stats_t *dst);
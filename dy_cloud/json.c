@@ -0,0 +1,332 @@
+#include <stdio.h>
+#include <string.h>
+#include "json.h"
+
+typedef enum {
+    ST_VALUE,        // expecting a value
+    ST_VALUE_OR_END, // after '['
+    ST_KEY_OR_END,   // after '{'
+    ST_KEY,          // after ',' in an object
+    ST_COLON,        // after a key
+    ST_AFTER,        // after a value inside a container
+    ST_STRING,
+    ST_ESC,
+    ST_U_ESC,
+    ST_NUMBER,
+    ST_LITERAL,
+    ST_DONE,         // after the top level value
+} state_t;
+
+typedef enum {
+    CONSUMED,
+    REPEAT, // the character terminated a token and must be processed again
+    FAILED,
+} result_t;
+
+static inline bool is_ws(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static inline void val_append(dy_cloud_json_t *p, char c) {
+    if (p->val_len < DY_CLOUD_JSON_VALUE_MAX_LEN - 1) {
+        p->val[p->val_len++] = c;
+    }
+}
+
+// Appends a code point in UTF-8; unpaired surrogates are replaced by '?'.
+static void val_append_utf8(dy_cloud_json_t *p, uint16_t cp) {
+    if (cp < 0x80) {
+        val_append(p, (char) cp);
+    } else if (cp < 0x800) {
+        val_append(p, (char) (0xC0 | cp >> 6));
+        val_append(p, (char) (0x80 | (cp & 0x3F)));
+    } else if (cp >= 0xD800 && cp <= 0xDFFF) {
+        val_append(p, '?');
+    } else {
+        val_append(p, (char) (0xE0 | cp >> 12));
+        val_append(p, (char) (0x80 | (cp >> 6 & 0x3F)));
+        val_append(p, (char) (0x80 | (cp & 0x3F)));
+    }
+}
+
+// Sets the name of the current member of the innermost container.
+static void set_member(dy_cloud_json_t *p, const char *name) {
+    dy_cloud_json_level_t *l = &p->levels[p->depth];
+    size_t name_len = strlen(name);
+    size_t sep_len = l->path_len > 0 ? 1 : 0;
+
+    p->path_len = l->path_len;
+    l->path_ok = l->container_ok && p->path_len + sep_len + name_len < DY_CLOUD_JSON_PATH_MAX_LEN;
+
+    if (l->path_ok) {
+        if (sep_len > 0) {
+            p->path[p->path_len++] = '.';
+        }
+        memcpy(p->path + p->path_len, name, name_len);
+        p->path_len += name_len;
+    }
+
+    p->path[p->path_len] = '\0';
+}
+
+static void set_index(dy_cloud_json_t *p) {
+    char idx[11];
+    snprintf(idx, sizeof(idx), "%lu", (unsigned long) p->levels[p->depth].index);
+    set_member(p, idx);
+}
+
+static bool push(dy_cloud_json_t *p, bool is_array) {
+    if (p->depth == DY_CLOUD_JSON_MAX_DEPTH) {
+        return false;
+    }
+
+    bool ok = p->levels[p->depth].path_ok;
+    p->levels[++p->depth] = (dy_cloud_json_level_t) {
+            .is_array = is_array,
+            .container_ok = ok,
+            .path_len = p->path_len,
+    };
+
+    if (is_array) {
+        set_index(p);
+        p->state = ST_VALUE_OR_END;
+    } else {
+        p->state = ST_KEY_OR_END;
+    }
+
+    return true;
+}
+
+static bool pop(dy_cloud_json_t *p, bool is_array) {
+    if (p->depth == 0 || p->levels[p->depth].is_array != is_array) {
+        return false;
+    }
+
+    p->path_len = p->levels[p->depth--].path_len;
+    p->path[p->path_len] = '\0';
+    p->state = p->depth == 0 ? ST_DONE : ST_AFTER;
+
+    return true;
+}
+
+static void emit(dy_cloud_json_t *p, dy_cloud_json_type_t type) {
+    p->val[p->val_len] = '\0';
+
+    if (p->levels[p->depth].path_ok) {
+        p->cb(p->args, p->path, type, p->val);
+    }
+
+    p->state = p->depth == 0 ? ST_DONE : ST_AFTER;
+}
+
+static result_t end_literal(dy_cloud_json_t *p) {
+    p->val[p->val_len] = '\0';
+
+    if (strcmp(p->val, "true") == 0 || strcmp(p->val, "false") == 0) {
+        emit(p, DY_CLOUD_JSON_BOOL);
+    } else if (strcmp(p->val, "null") == 0) {
+        emit(p, DY_CLOUD_JSON_NULL);
+    } else {
+        return FAILED;
+    }
+
+    return REPEAT;
+}
+
+static result_t start_value(dy_cloud_json_t *p, char c) {
+    p->val_len = 0;
+
+    if (c == '{') {
+        return push(p, false) ? CONSUMED : FAILED;
+    } else if (c == '[') {
+        return push(p, true) ? CONSUMED : FAILED;
+    } else if (c == '"') {
+        p->is_key = false;
+        p->state = ST_STRING;
+    } else if (c == '-' || (c >= '0' && c <= '9')) {
+        val_append(p, c);
+        p->state = ST_NUMBER;
+    } else if (c == 't' || c == 'f' || c == 'n') {
+        val_append(p, c);
+        p->state = ST_LITERAL;
+    } else {
+        return FAILED;
+    }
+
+    return CONSUMED;
+}
+
+static result_t consume(dy_cloud_json_t *p, char c) {
+    switch (p->state) {
+        case ST_VALUE_OR_END:
+            if (c == ']') {
+                return pop(p, true) ? CONSUMED : FAILED;
+            }
+            // fall through
+        case ST_VALUE:
+            return is_ws(c) ? CONSUMED : start_value(p, c);
+
+        case ST_KEY_OR_END:
+            if (c == '}') {
+                return pop(p, false) ? CONSUMED : FAILED;
+            }
+            // fall through
+        case ST_KEY:
+            if (is_ws(c)) {
+                return CONSUMED;
+            } else if (c != '"') {
+                return FAILED;
+            }
+            p->val_len = 0;
+            p->is_key = true;
+            p->state = ST_STRING;
+            return CONSUMED;
+
+        case ST_COLON:
+            if (is_ws(c)) {
+                return CONSUMED;
+            } else if (c != ':') {
+                return FAILED;
+            }
+            p->state = ST_VALUE;
+            return CONSUMED;
+
+        case ST_AFTER:
+            if (is_ws(c)) {
+                return CONSUMED;
+            } else if (c == '}' || c == ']') {
+                return pop(p, c == ']') ? CONSUMED : FAILED;
+            } else if (c != ',') {
+                return FAILED;
+            }
+            if (p->levels[p->depth].is_array) {
+                p->levels[p->depth].index++;
+                set_index(p);
+                p->state = ST_VALUE;
+            } else {
+                p->state = ST_KEY;
+            }
+            return CONSUMED;
+
+        case ST_STRING:
+            if (c == '\\') {
+                p->state = ST_ESC;
+            } else if (c == '"') {
+                p->val[p->val_len] = '\0';
+                if (p->is_key) {
+                    set_member(p, p->val);
+                    p->state = ST_COLON;
+                } else {
+                    emit(p, DY_CLOUD_JSON_STRING);
+                }
+            } else if ((unsigned char) c < 0x20) {
+                return FAILED;
+            } else {
+                val_append(p, c);
+            }
+            return CONSUMED;
+
+        case ST_ESC: {
+            const char *esc = strchr("\"\\/bfnrtu", c);
+            if (c == '\0' || esc == NULL) {
+                return FAILED;
+            } else if (c == 'u') {
+                p->u_esc = 0;
+                p->u_esc_len = 0;
+                p->state = ST_U_ESC;
+                return CONSUMED;
+            }
+            val_append(p, "\"\\/\b\f\n\r\t"[esc - "\"\\/bfnrtu"]);
+            p->state = ST_STRING;
+            return CONSUMED;
+        }
+
+        case ST_U_ESC:
+            if (c >= '0' && c <= '9') {
+                p->u_esc = p->u_esc << 4 | (c - '0');
+            } else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+                p->u_esc = p->u_esc << 4 | ((c | 0x20) - 'a' + 10);
+            } else {
+                return FAILED;
+            }
+            if (++p->u_esc_len == 4) {
+                val_append_utf8(p, p->u_esc);
+                p->state = ST_STRING;
+            }
+            return CONSUMED;
+
+        case ST_NUMBER:
+            if ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') {
+                val_append(p, c);
+                return CONSUMED;
+            }
+            emit(p, DY_CLOUD_JSON_NUMBER);
+            return REPEAT;
+
+        case ST_LITERAL:
+            if (c >= 'a' && c <= 'z') {
+                if (p->val_len == 5) {
+                    return FAILED;
+                }
+                val_append(p, c);
+                return CONSUMED;
+            }
+            return end_literal(p);
+
+        case ST_DONE:
+            return is_ws(c) ? CONSUMED : FAILED;
+
+        default:
+            return FAILED;
+    }
+}
+
+void dy_cloud_json_init(dy_cloud_json_t *p, dy_cloud_json_cb_t cb, void *args) {
+    memset(p, 0, sizeof(dy_cloud_json_t));
+
+    p->cb = cb;
+    p->args = args;
+    p->state = ST_VALUE;
+    p->levels[0].container_ok = true;
+    p->levels[0].path_ok = true;
+}
+
+dy_err_t dy_cloud_json_feed(dy_cloud_json_t *p, const char *data, size_t len) {
+    if (p->error) {
+        return dy_err(DY_ERR_JSON_PARSE, "previous chunk was malformed");
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        result_t res;
+        while ((res = consume(p, data[i])) == REPEAT) {}
+
+        if (res == FAILED) {
+            p->error = true;
+            if (p->depth == DY_CLOUD_JSON_MAX_DEPTH && (data[i] == '{' || data[i] == '[')) {
+                return dy_err(DY_ERR_JSON_PARSE, "nesting is too deep");
+            }
+            return dy_err(DY_ERR_JSON_PARSE, "unexpected character 0x%02x at %s", (unsigned char) data[i], p->path);
+        }
+    }
+
+    return dy_ok();
+}
+
+dy_err_t dy_cloud_json_done(dy_cloud_json_t *p) {
+    if (p->error) {
+        return dy_err(DY_ERR_JSON_PARSE, "document is malformed");
+    }
+
+    // A top level number or literal is terminated by the end of input only
+    if (p->depth == 0 && p->state == ST_NUMBER) {
+        emit(p, DY_CLOUD_JSON_NUMBER);
+    } else if (p->depth == 0 && p->state == ST_LITERAL && end_literal(p) == FAILED) {
+        return dy_err(DY_ERR_JSON_PARSE, "invalid literal");
+    }
+
+    if (p->state != ST_DONE) {
+        return dy_err(DY_ERR_JSON_PARSE, "document is incomplete");
+    }
+
+    return dy_ok();
+}
@@ -0,0 +1,79 @@
+/**
+ * @brief Streaming JSON extractor, internal to dy_cloud.
+ *
+ * Input is consumed in chunks of any size as they arrive from the network, and a callback is called for every
+ * scalar value with its dotted path, e.g. `weather.temp` or `items.0.id`; the top level value has an empty path.
+ * Memory use is fixed and does not depend on the size of the document. Strings longer than
+ * DY_CLOUD_JSON_VALUE_MAX_LEN - 1 bytes are truncated; values whose path is longer than DY_CLOUD_JSON_PATH_MAX_LEN - 1
+ * bytes are skipped.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "dy/error.h"
+
+#define DY_CLOUD_JSON_MAX_DEPTH 8
+#define DY_CLOUD_JSON_PATH_MAX_LEN 96
+#define DY_CLOUD_JSON_VALUE_MAX_LEN 512 // fits firmware update URLs
+
+typedef enum {
+    DY_CLOUD_JSON_STRING,
+    DY_CLOUD_JSON_NUMBER, // value is the number as it appears in the document
+    DY_CLOUD_JSON_BOOL,   // value is "true" or "false"
+    DY_CLOUD_JSON_NULL,
+} dy_cloud_json_type_t;
+
+/**
+ * Called for every scalar value; `path` and `value` are valid during the call only.
+ */
+typedef void (*dy_cloud_json_cb_t)(void *args, const char *path, dy_cloud_json_type_t type, const char *value);
+
+typedef struct {
+    bool is_array;
+    bool container_ok; // path of the container fits into the buffer
+    bool path_ok;      // path of the current member fits into the buffer
+    uint16_t path_len; // path length of the container
+    uint32_t index;    // index of the current array element
+} dy_cloud_json_level_t;
+
+typedef struct {
+    dy_cloud_json_cb_t cb;
+    void *args;
+    uint8_t state;
+    uint8_t depth;
+    bool is_key;       // string being read is an object key
+    bool error;
+    uint16_t u_esc;    // \uXXXX escape being read
+    uint8_t u_esc_len;
+    uint16_t val_len;
+    uint16_t path_len;
+    dy_cloud_json_level_t levels[DY_CLOUD_JSON_MAX_DEPTH + 1];
+    char path[DY_CLOUD_JSON_PATH_MAX_LEN];
+    char val[DY_CLOUD_JSON_VALUE_MAX_LEN];
+} dy_cloud_json_t;
+
+/**
+ * Initializes an extractor.
+ */
+void dy_cloud_json_init(dy_cloud_json_t *p, dy_cloud_json_cb_t cb, void *args);
+
+/**
+ * @brief Consumes next chunk of a document.
+ *
+ * @return
+ *  - DY_ERR_JSON_PARSE if the document is malformed or nested too deep.
+ *  - DY_OK on success.
+ */
+dy_err_t dy_cloud_json_feed(dy_cloud_json_t *p, const char *data, size_t len);
+
+/**
+ * @brief Finishes a document.
+ *
+ * @return
+ *  - DY_ERR_JSON_PARSE if the document is malformed or incomplete.
+ *  - DY_OK on success.
+ */
+dy_err_t dy_cloud_json_done(dy_cloud_json_t *p);
@@ -1,3 +1,9 @@
+#include <string.h>
+#include "dy/cloud.h"
+
+#define API_URL_MAX_LEN 64
+
+static char api_url[API_URL_MAX_LEN] = DY_CLOUD_API_URL_DEFAULT;
 static float lat = 0;
 static float lng = 0;
 
@@ -13,3 +19,11 @@ float dy_cloud_get_location_lat() {
 float dy_cloud_get_location_lng() {
     return lng;
 }
+
+void dy_cloud_set_api_url(const char *url) {
+    strlcpy(api_url, url, API_URL_MAX_LEN);
+}
+
+const char *dy_cloud_get_api_url() {
+    return api_url;
+}
@@ -0,0 +1,58 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "retry.h"
+
+#define RETRY_DELAY_MIN 1000 // ms; keeps a zero jitter from turning into a busy loop
+
+bool retry_policy_valid(const dy_cloud_retry_policy_t *policy) {
+    // Delays are computed in ms as uint32_t
+    return policy->base > 0 && policy->max >= policy->base && policy->max <= UINT32_MAX / 1000 &&
+           policy->breaker_timeout <= UINT32_MAX / 1000;
+}
+
+void retry_on_run(dy_cloud_retry_state_t *st) {
+    st->runs++;
+    if (st->breaker == DY_CLOUD_BREAKER_OPEN) {
+        st->breaker = DY_CLOUD_BREAKER_HALF_OPEN;
+    }
+}
+
+void retry_on_success(dy_cloud_retry_state_t *st, uint32_t period, int64_t now) {
+    st->breaker = DY_CLOUD_BREAKER_CLOSED;
+    st->failures = 0;
+    st->delay = 0;
+    st->next_due = now + (int64_t) period * 1000000;
+}
+
+void retry_on_failure(dy_cloud_retry_state_t *st, const dy_cloud_retry_policy_t *policy, int64_t now,
+                      dy_cloud_rand_t rnd) {
+    if (st->failures < UINT32_MAX) {
+        st->failures++;
+    }
+
+    uint32_t delay; // ms
+    if (st->breaker == DY_CLOUD_BREAKER_HALF_OPEN ||
+        (policy->breaker_threshold > 0 && st->failures >= policy->breaker_threshold)) {
+        // Open for the timeout randomized down to a half of it, so a fleet doesn't come back at once
+        uint32_t timeout = policy->breaker_timeout * 1000;
+        st->breaker = DY_CLOUD_BREAKER_OPEN;
+        delay = timeout - rnd() % (timeout / 2 + 1);
+    } else {
+        // Full jitter: a random delay up to the exponentially growing cap
+        uint32_t cap = policy->base;
+        for (uint32_t i = 1; i < st->failures && cap < policy->max; i++) {
+            cap = cap > policy->max / 2 ? policy->max : cap * 2;
+        }
+        if (cap > policy->max) {
+            cap = policy->max;
+        }
+        delay = rnd() % (cap * 1000 + 1);
+    }
+
+    if (delay < RETRY_DELAY_MIN) {
+        delay = RETRY_DELAY_MIN;
+    }
+
+    st->delay = delay;
+    st->next_due = now + (int64_t) delay * 1000;
+}
@@ -0,0 +1,43 @@
+/**
+ * @brief Retry logic of sync jobs, internal to dy_cloud.
+ *
+ * Pure functions of the current time and a random source, so the schedule can be checked with a fake clock.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dy/cloud.h"
+
+typedef uint32_t (*dy_cloud_rand_t)();
+
+/**
+ * Checks whether a policy is usable.
+ */
+bool retry_policy_valid(const dy_cloud_retry_policy_t *policy);
+
+/**
+ * Marks the start of a run; a run of a job with an open breaker is the trial one.
+ */
+void retry_on_run(dy_cloud_retry_state_t *st);
+
+/**
+ * Schedules the next regular run after a successful one and closes the breaker.
+ *
+ * @param st        State.
+ * @param period    Job's period, s.
+ * @param now       Current time, us.
+ */
+void retry_on_success(dy_cloud_retry_state_t *st, uint32_t period, int64_t now);
+
+/**
+ * Schedules a retry after a failed run, opening the breaker once the policy's threshold is reached.
+ *
+ * @param st        State.
+ * @param policy    Policy.
+ * @param now       Current time, us.
+ * @param rnd       Random source.
+ */
+void retry_on_failure(dy_cloud_retry_state_t *st, const dy_cloud_retry_policy_t *policy, int64_t now,
+                      dy_cloud_rand_t rnd);
@@ -0,0 +1,353 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+#include "dy/error.h"
+#include "dy/net_cfg.h"
+#include "http_client.h"
+#include "retry.h"
+#include "scheduler.h"
+
+#define SCHED_STACK_SIZE 5120 // HTTP requests are performed in the scheduler task
+#define SCHED_BATCH_WINDOW 60 // s; batchable jobs due within it are pulled forward to join a batch
+#define LTAG "DY_CLOUD"
+
+static dy_cloud_job_t *jobs[DY_CLOUD_SCHED_MAX_JOBS];
+static uint8_t n_jobs = 0;
+static SemaphoreHandle_t mux = NULL;
+static TaskHandle_t task_hdl = NULL;
+static volatile bool net_up = false;
+static volatile bool net_changed = false;
+static bool batch_supported = true;
+static dy_cloud_retry_policy_t default_retry;
+static bool default_retry_set = false;
+
+static void ip_ev_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *data) {
+    net_up = event_id == IP_EVENT_STA_GOT_IP;
+    net_changed = true;
+    xTaskNotifyGive(task_hdl);
+}
+
+// Updates retry state of a job by the result of its run.
+static void job_result(dy_cloud_job_t *job, dy_err_t err) {
+    int64_t now = esp_timer_get_time();
+
+    xSemaphoreTake(mux, portMAX_DELAY);
+    dy_cloud_breaker_t was = job->state.breaker;
+    if (dy_is_err(err)) {
+        retry_on_failure(&job->state, &job->retry, now, esp_random);
+    } else {
+        retry_on_success(&job->state, job->period, now);
+    }
+    dy_cloud_retry_state_t st = job->state;
+    xSemaphoreGive(mux);
+
+    if (dy_is_err(err)) {
+        ESP_LOGE(LTAG, "%s: %s; retry in %lu ms", job->name, dy_err_str(err), st.delay);
+    }
+    if (st.breaker == DY_CLOUD_BREAKER_OPEN && was != DY_CLOUD_BREAKER_OPEN) {
+        ESP_LOGW(LTAG, "%s: circuit breaker opened after %lu failures", job->name, st.failures);
+    } else if (st.breaker == DY_CLOUD_BREAKER_CLOSED && was != DY_CLOUD_BREAKER_CLOSED) {
+        ESP_LOGI(LTAG, "%s: circuit breaker closed", job->name);
+    }
+}
+
+static void cont_task(void *args) {
+    dy_cloud_job_t *job = args;
+
+    dy_err_t err = job->cont();
+    job->cont = NULL;
+    job_result(job, err);
+
+    xSemaphoreTake(mux, portMAX_DELAY);
+    job->cont_running = false;
+    xSemaphoreGive(mux);
+
+    xTaskNotifyGive(task_hdl);
+    vTaskDelete(NULL);
+}
+
+static void job_done(dy_cloud_job_t *job, dy_err_t err) {
+    if (job->cont == NULL) {
+        job_result(job, err);
+        return;
+    }
+
+    if (dy_is_err(err)) {
+        job->cont = NULL;
+        job_result(job, err);
+        return;
+    }
+
+    // The job is not due until the task reports the result
+    xSemaphoreTake(mux, portMAX_DELAY);
+    job->cont_running = true;
+    job->state.next_due = INT64_MAX;
+    xSemaphoreGive(mux);
+
+    if (xTaskCreate(cont_task, job->name, job->cont_stack_size, job, tskIDLE_PRIORITY, NULL) != pdPASS) {
+        xSemaphoreTake(mux, portMAX_DELAY);
+        job->cont_running = false;
+        xSemaphoreGive(mux);
+        job->cont = NULL;
+        job_result(job, dy_err(DY_ERR_NO_MEM, "xTaskCreate failed"));
+    }
+}
+
+static void job_start(dy_cloud_job_t *job) {
+    xSemaphoreTake(mux, portMAX_DELAY);
+    retry_on_run(&job->state);
+    xSemaphoreGive(mux);
+}
+
+static void run_job(dy_cloud_job_t *job) {
+    job_start(job);
+    job_done(job, job->run());
+}
+
+// Fetches resources of several jobs in one round trip; falls back to separate requests if the batch fails.
+static void run_batch(dy_cloud_job_t **due, uint8_t n) {
+    dy_err_t results[DY_CLOUD_SCHED_MAX_JOBS];
+
+    for (uint8_t i = 0; i < n; i++) {
+        job_start(due[i]);
+    }
+
+    dy_err_t err = batch_run(due, n, results);
+    if (err->code == DY_ERR_NOT_FOUND) {
+        ESP_LOGW(LTAG, "batch endpoint is not supported by the server");
+        batch_supported = false;
+    }
+
+    if (dy_is_err(err)) {
+        ESP_LOGW(LTAG, "batch request: %s; running jobs separately", dy_err_str(err));
+        for (uint8_t i = 0; i < n; i++) {
+            job_done(due[i], due[i]->run());
+        }
+        return;
+    }
+
+    for (uint8_t i = 0; i < n; i++) {
+        job_done(due[i], results[i]);
+    }
+}
+
+_Noreturn static void task() {
+    while (true) {
+        if (net_changed) {
+            net_changed = false;
+
+            // Don't wait for backoffs to expire once the network is back; open breakers keep waiting, since their
+            // failures are not likely caused by the network
+            if (net_up) {
+                xSemaphoreTake(mux, portMAX_DELAY);
+                for (uint8_t i = 0; i < n_jobs; i++) {
+                    if (jobs[i]->state.failures > 0 && jobs[i]->state.breaker == DY_CLOUD_BREAKER_CLOSED &&
+                        !jobs[i]->cont_running) {
+                        jobs[i]->state.next_due = 0;
+                    }
+                }
+                xSemaphoreGive(mux);
+            }
+        }
+
+        if (!net_up) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        xSemaphoreTake(mux, portMAX_DELAY);
+        uint8_t n = n_jobs;
+        xSemaphoreGive(mux);
+
+        // Collect due jobs; batchable ones are fetched together, the rest run back to back and share
+        // a kept-alive connection
+        dy_cloud_job_t *due[DY_CLOUD_SCHED_MAX_JOBS];
+        uint8_t n_due = 0, n_batch = 0;
+        int64_t now = esp_timer_get_time();
+
+        xSemaphoreTake(mux, portMAX_DELAY);
+        for (uint8_t i = 0; i < n; i++) {
+            if (jobs[i]->state.next_due <= now) {
+                due[n_due++] = jobs[i];
+                n_batch += jobs[i]->batch != NULL;
+            }
+        }
+
+        if (batch_supported && n_batch > 0) {
+            // Pull forward batchable jobs which are due soon anyway
+            for (uint8_t i = 0; i < n; i++) {
+                dy_cloud_job_t *job = jobs[i];
+                if (job->state.next_due > now && job->batch != NULL && job->state.failures == 0 &&
+                    job->state.next_due <= now + (int64_t) SCHED_BATCH_WINDOW * 1000000) {
+                    due[n_due++] = job;
+                    n_batch++;
+                }
+            }
+        }
+        xSemaphoreGive(mux);
+
+        dy_cloud_job_t *batch[DY_CLOUD_SCHED_MAX_JOBS];
+        uint8_t n_b = 0;
+        for (uint8_t i = 0; i < n_due; i++) {
+            if (batch_supported && n_batch > 1 && due[i]->batch != NULL) {
+                batch[n_b++] = due[i];
+            } else {
+                run_job(due[i]);
+            }
+        }
+        if (n_b > 0) {
+            run_batch(batch, n_b);
+        }
+
+        int64_t next_due = INT64_MAX;
+        xSemaphoreTake(mux, portMAX_DELAY);
+        for (uint8_t i = 0; i < n; i++) {
+            if (jobs[i]->state.next_due < next_due) {
+                next_due = jobs[i]->state.next_due;
+            }
+        }
+        xSemaphoreGive(mux);
+
+        // Sleep until the next job is due, a job is added or the network state changes
+        int64_t delay = next_due - esp_timer_get_time();
+        if (next_due == INT64_MAX) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        } else if (delay > 0) {
+            ulTaskNotifyTake(pdTRUE, (TickType_t) (delay / 1000 / portTICK_PERIOD_MS + 1));
+        }
+    }
+}
+
+static dy_err_t start() {
+    dy_err_t err;
+
+    if (dy_is_err(err = http_client_start())) {
+        return dy_err_pfx("http_client_start", err);
+    }
+
+    if ((mux = xSemaphoreCreateMutex()) == NULL) {
+        return dy_err(DY_ERR_NO_MEM, "xSemaphoreCreateMutex returned null");
+    }
+
+    if (xTaskCreate(task, "dy_cloud", SCHED_STACK_SIZE, NULL, tskIDLE_PRIORITY, &task_hdl) != pdPASS) {
+        return dy_err(DY_ERR_FAILED, "xTaskCreate failed");
+    }
+
+    esp_err_t esp_err = esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, ip_ev_handler, NULL);
+    if (esp_err == ESP_OK) {
+        esp_err = esp_event_handler_register(IP_EVENT, IP_EVENT_STA_LOST_IP, ip_ev_handler, NULL);
+    }
+    if (esp_err != ESP_OK) {
+        return dy_err(DY_ERR_FAILED, "esp_event_handler_register: %s", esp_err_to_name(esp_err));
+    }
+
+    // The address may have been obtained before the scheduler started
+    net_up = dy_net_cfg_net_connected();
+    net_changed = true;
+    xTaskNotifyGive(task_hdl);
+
+    return dy_ok();
+}
+
+dy_err_t scheduler_add_job(dy_cloud_job_t *job) {
+    dy_err_t err;
+
+    if (task_hdl == NULL && dy_is_err(err = start())) {
+        return err;
+    }
+
+    xSemaphoreTake(mux, portMAX_DELAY);
+    if (n_jobs == DY_CLOUD_SCHED_MAX_JOBS) {
+        xSemaphoreGive(mux);
+        return dy_err(DY_ERR_NO_MEM, "too many jobs");
+    }
+    job->retry = default_retry_set ? default_retry : DY_CLOUD_RETRY_POLICY_DEFAULT;
+    memset(&job->state, 0, sizeof(job->state));
+    job->cont = NULL;
+    job->cont_running = false;
+    jobs[n_jobs] = job;
+    n_jobs++;
+    xSemaphoreGive(mux);
+
+    xTaskNotifyGive(task_hdl);
+
+    return dy_ok();
+}
+
+void scheduler_continue_in_task(dy_cloud_job_t *job, dy_err_t (*fn)(), uint32_t stack_size) {
+    job->cont = fn;
+    job->cont_stack_size = stack_size;
+}
+
+// Looks a job up by name; must be called with the mutex taken.
+static dy_cloud_job_t *find_job(const char *name) {
+    for (uint8_t i = 0; i < n_jobs; i++) {
+        if (strcmp(jobs[i]->name, name) == 0) {
+            return jobs[i];
+        }
+    }
+
+    return NULL;
+}
+
+dy_err_t dy_cloud_set_retry_policy(const char *job, dy_cloud_retry_policy_t policy) {
+    if (!retry_policy_valid(&policy)) {
+        return dy_err(DY_ERR_INVALID_ARG, "invalid retry policy");
+    }
+
+    if (job == NULL) {
+        // The scheduler may not be started yet, so there is no mutex to take
+        default_retry = policy;
+        default_retry_set = true;
+    }
+
+    if (mux == NULL) {
+        return job == NULL ? dy_ok() : dy_err(DY_ERR_NOT_FOUND, "job %s is not started", job);
+    }
+
+    xSemaphoreTake(mux, portMAX_DELAY);
+    if (job == NULL) {
+        for (uint8_t i = 0; i < n_jobs; i++) {
+            jobs[i]->retry = policy;
+        }
+    } else {
+        dy_cloud_job_t *j = find_job(job);
+        if (j == NULL) {
+            xSemaphoreGive(mux);
+            return dy_err(DY_ERR_NOT_FOUND, "job %s is not started", job);
+        }
+        j->retry = policy;
+    }
+    xSemaphoreGive(mux);
+
+    return dy_ok();
+}
+
+dy_err_t dy_cloud_get_retry_state(const char *job, dy_cloud_retry_state_t *dst) {
+    if (mux == NULL) {
+        return dy_err(DY_ERR_NOT_FOUND, "job %s is not started", job);
+    }
+
+    xSemaphoreTake(mux, portMAX_DELAY);
+    dy_cloud_job_t *j = find_job(job);
+    if (j != NULL) {
+        *dst = j->state;
+    }
+    xSemaphoreGive(mux);
+
+    if (j == NULL) {
+        return dy_err(DY_ERR_NOT_FOUND, "job %s is not started", job);
+    }
+
+    return dy_ok();
+}
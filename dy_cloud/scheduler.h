@@ -0,0 +1,75 @@
+/**
+ * @brief Cloud sync scheduler, internal to dy_cloud.
+ *
+ * Jobs run one after another in a single task. A job with long work to do, i.e. a firmware download, continues it in
+ * a task of its own, so other jobs keep running meanwhile. Jobs which provide a batch handler are fetched together by one
+ * request to the batch endpoint when several of them are due; the response holds each job's resource under the
+ * job's name and is dispatched to the handlers by path prefix.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dy/error.h"
+#include "dy/cloud.h"
+#include "json.h"
+
+#define DY_CLOUD_SCHED_MAX_JOBS 4
+
+/**
+ * Batch handler of a job.
+ */
+typedef struct {
+    const char *(*query)();      // returns job's request parameters, e.g. "lat=1.0&lng=2.0"
+    void (*begin)();             // called before a batch request
+    dy_cloud_json_cb_t on_value; // gets values of job's resource with paths relative to it
+    void *args;
+    dy_err_t (*end)(bool found); // called after a successful request; `found` tells whether it had the resource
+} dy_cloud_batch_handler_t;
+
+/**
+ * Job; must live as long as the scheduler.
+ */
+typedef struct {
+    const char *name;                      // also the key of job's resource in batch responses
+    uint32_t period;                       // s
+    dy_err_t (*run)();                     // fetches job's resource on its own
+    const dy_cloud_batch_handler_t *batch; // optional
+    dy_cloud_retry_policy_t retry;         // set by the scheduler
+    dy_cloud_retry_state_t state;
+    dy_err_t (*cont)();                    // set by scheduler_continue_in_task()
+    uint32_t cont_stack_size;
+    bool cont_running;
+} dy_cloud_job_t;
+
+/**
+ * Adds a job to run once the network is up and then every `period` seconds.
+ */
+dy_err_t scheduler_add_job(dy_cloud_job_t *job);
+
+/**
+ * @brief Continues the current run of a job in a task of its own.
+ *
+ * Called from job's `run` or batch `end` handler. If the handler succeeds, `fn` is then run by a new task and its
+ * result is taken as the result of the run; the job isn't run again until `fn` returns.
+ *
+ * @param job           Job.
+ * @param fn            Rest of the run.
+ * @param stack_size    Stack size of the task; the stack is only allocated while `fn` runs.
+ */
+void scheduler_continue_in_task(dy_cloud_job_t *job, dy_err_t (*fn)(), uint32_t stack_size);
+
+/**
+ * @brief Fetches resources of several jobs by one request.
+ *
+ * @param jobs      Jobs with batch handlers.
+ * @param n         Number of jobs.
+ * @param results   Where to store results of the jobs' `end` handlers.
+ *
+ * @return
+ *  - DY_ERR_NOT_FOUND if the server has no batch endpoint.
+ *  - Other errors if the request failed; no `end` handlers are called then.
+ *  - DY_OK on success.
+ */
+dy_err_t batch_run(dy_cloud_job_t **jobs, uint8_t n, dy_err_t *results);
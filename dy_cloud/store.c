@@ -0,0 +1,47 @@
+#include <string.h>
+#include "esp_log.h"
+#include "dy/error.h"
+#include "dy/cfg2.h"
+#include "store.h"
+
+#define LTAG "DY_CLOUD"
+
+bool store_load(int id, uint8_t version, void *dst, size_t size) {
+    dy_err_t err;
+    uint8_t buf[DY_CFG2_BLOB_MAX_LEN];
+    size_t len = sizeof(buf);
+
+    if (dy_is_err(err = dy_cfg2_get_blob(id, buf, &len))) {
+        if (err->code != DY_ERR_NOT_FOUND) {
+            ESP_LOGW(LTAG, "load record %04x: %s", id, dy_err_str(err));
+        }
+        return false;
+    }
+
+    // Records saved by another firmware version may have a different layout
+    if (len != size + 1 || buf[0] != version) {
+        ESP_LOGW(LTAG, "record %04x has unexpected version or size; ignored", id);
+        return false;
+    }
+
+    memcpy(dst, buf + 1, size);
+
+    return true;
+}
+
+void store_save(int id, uint8_t version, const void *src, size_t size) {
+    dy_err_t err;
+    uint8_t buf[DY_CFG2_BLOB_MAX_LEN];
+
+    if (size + 1 > sizeof(buf)) {
+        ESP_LOGE(LTAG, "record %04x is too long: %zu", id, size);
+        return;
+    }
+
+    buf[0] = version;
+    memcpy(buf + 1, src, size);
+
+    if (dy_is_err(err = dy_cfg2_set_blob(id, buf, size + 1))) {
+        ESP_LOGW(LTAG, "save record %04x: %s", id, dy_err_str(err));
+    }
+}
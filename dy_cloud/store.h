@@ -0,0 +1,35 @@
+/**
+ * @brief Storage of the last fetched resources, internal to dy_cloud.
+ *
+ * Records are kept in dy_cfg2 as blobs, so the last known data can be shown right after a reboot while fresh data
+ * is being fetched. A record is only loaded back if its version and size match, so changing the layout of a record
+ * only requires bumping its version.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Loads a record.
+ *
+ * @param id        dy_cfg2 ID.
+ * @param version   Expected version of the record.
+ * @param dst       Where to store the record.
+ * @param size      Size of the record.
+ *
+ * @return true if the record was found and matches the version and the size.
+ */
+bool store_load(int id, uint8_t version, void *dst, size_t size);
+
+/**
+ * @brief Saves a record; failures are only logged, since the record is an optimization.
+ *
+ * @param id        dy_cfg2 ID.
+ * @param version   Version of the record.
+ * @param src       Record.
+ * @param size      Size of the record.
+ */
+void store_save(int id, uint8_t version, const void *src, size_t size);
@@ -1,89 +1,130 @@
 #include "dy/cloud.h"
+#include <stdlib.h>
 #include <string.h>
 #include "esp_log.h"
 #include "esp_event.h"
-#include "cJSON.h"
 #include "dy/error.h"
-#include "dy/net_cfg.h"
+#include "dy/internal.h"
+#include "http_client.h"
+#include "scheduler.h"
+#include "store.h"
 
-#define SYNC_PERIOD 42949 // ~11 hours, limited by max value of uint32
-#define API_URL "https://api.d5y.xyz/v2/time"
+#define SYNC_PERIOD 43200 // 12 hours
+#define API_PATH "/time"
 #define URL_MAX_LEN 128
+#define STORE_VERSION 1
 #define LTAG "DY_CLOUD"
 
 ESP_EVENT_DEFINE_BASE(DY_CLOUD_EVENT_BASE);
 
-extern dy_err_t http_get_json(const char *url, cJSON **rsp_json);
 static char time_url[URL_MAX_LEN] = {0};
+static const char *time_query; // points into time_url
+static dy_cloud_time_t result;
+static dy_cloud_http_validators_t validators;
+static dy_cloud_time_t stored; // the timezone is only saved when it changes
+
+static void on_json_value(void *args, const char *path, dy_cloud_json_type_t type, const char *value) {
+    dy_cloud_time_t *res = args;
+
+    if (strcmp(path, "tz") == 0 && type == DY_CLOUD_JSON_STRING) {
+        strlcpy(res->tz, value, DY_CLOUD_TIME_TZ_LEN);
+    } else if (strcmp(path, "tz_data") == 0 && type == DY_CLOUD_JSON_STRING) {
+        strlcpy(res->tzd, value, DY_CLOUD_TIME_TZ_DATA_LEN);
+    } else if (strcmp(path, "value") == 0 && type == DY_CLOUD_JSON_NUMBER) {
+        res->ts = strtoul(value, NULL, 10);
+    }
+}
 
-static dy_err_t get_cloud_time() {
-    dy_err_t err;
-    cJSON *json;
-
-    dy_cloud_time_t res;
-    memset(&res, 0, sizeof(res));
+static void begin() {
+    memset(&result, 0, sizeof(result));
+}
 
-    err = http_get_json(time_url, &json);
-    if (dy_is_err(err)) {
-        return dy_err_pfx("http_get_json", err);
+static dy_err_t end(bool found) {
+    if (!found) {
+        return dy_err(DY_ERR_NO_CONTENT, "no time in response");
     }
 
-    cJSON *tz = cJSON_GetObjectItem(json, "tz");
-    if (tz != NULL) {
-        strlcpy(res.tz, cJSON_GetStringValue(tz), DY_CLOUD_TIME_TZ_LEN);
-    }
+    ESP_LOGI(LTAG, "got time: %lu; %s; %s", result.ts, result.tz, result.tzd);
 
-    cJSON *tz_data = cJSON_GetObjectItem(json, "tz_data");
-    if (tz_data != NULL) {
-        strlcpy(res.tzd, cJSON_GetStringValue(tz_data), DY_CLOUD_TIME_TZ_DATA_LEN);
+    esp_err_t esp_err = esp_event_post(DY_CLOUD_EV_BASE, DY_CLOUD_EV_TIME_UPDATED, &result, sizeof(result), 10);
+    if (esp_err != ESP_OK) {
+        return dy_err(DY_ERR_FAILED, "esp_event_post: %s", esp_err_to_name(esp_err));
     }
 
-    cJSON *ts = cJSON_GetObjectItem(json, "value");
-    if (ts != NULL) {
-        res.ts = (int) cJSON_GetNumberValue(ts);
+    // Validators are not stored: the first request after a reboot must not get a 304, since the clock needs the time
+    if (strcmp(result.tz, stored.tz) != 0 || strcmp(result.tzd, stored.tzd) != 0) {
+        store_save(DY_INTERNAL_CFG_ID_CLOUD_TIME, STORE_VERSION, &result, sizeof(result));
+        stored = result;
     }
 
-    cJSON_Delete(json);
-
-    ESP_LOGI(LTAG, "got time: %lu; %s; %s", res.ts, res.tz, res.tzd);
+    return dy_ok();
+}
 
-    esp_err_t esp_err = esp_event_post(DY_CLOUD_EV_BASE, DY_CLOUD_EV_TIME_UPDATED, &res, sizeof(res), 10);
-    if (esp_err != ESP_OK) {
-        return dy_err(DY_ERR_FAILED, "esp_event_post: %s", esp_err_to_name(esp_err));
+// Batch responses carry no validators, so the ones of the previous response no longer match the data.
+static dy_err_t batch_end(bool found) {
+    if (found) {
+        memset(&validators, 0, sizeof(validators));
     }
 
-    return dy_ok();
+    return end(found);
 }
 
-_Noreturn static void task() {
+static dy_err_t get_cloud_time() {
     dy_err_t err;
-    int delay_sec;
-
-    while (true) {
-        if (!dy_net_cfg_net_connected()) {
-            delay_sec = 10;
-        } else if (dy_is_err(err = get_cloud_time())) {
-            ESP_LOGE(LTAG, "set_localtime_from_cloud: %s", dy_err_str(err));
-            delay_sec = 10;
-        } else {
-            delay_sec = SYNC_PERIOD;
-        }
 
-        vTaskDelay(pdMS_TO_TICKS(1000 * delay_sec));
+    begin();
+
+    err = http_get_json(time_url, &validators, on_json_value, &result);
+    if (dy_is_err(err)) {
+        return dy_err_pfx("http_get_json", err);
+    }
+
+    if (validators.not_modified) {
+        ESP_LOGI(LTAG, "time not modified");
+        http_count_suppressed_event();
+        return dy_ok();
     }
+
+    return end(true);
+}
+
+static const char *query() {
+    return time_query;
 }
 
+static const dy_cloud_batch_handler_t batch_handler = {
+        .query = query,
+        .begin = begin,
+        .on_value = on_json_value,
+        .args = &result,
+        .end = batch_end,
+};
+
+static dy_cloud_job_t job = {
+        .name = "time",
+        .period = SYNC_PERIOD,
+        .run = get_cloud_time,
+        .batch = &batch_handler,
+};
+
 dy_err_t dy_cloud_time_scheduler_start() {
-    int n = snprintf(time_url, URL_MAX_LEN, "%s?lat=%.5f&lng=%.5f", API_URL,
+    int n = snprintf(time_url, URL_MAX_LEN, "%s%s?lat=%.5f&lng=%.5f", dy_cloud_get_api_url(), API_PATH,
                      dy_cloud_get_location_lat(), dy_cloud_get_location_lng());
     if (n < 0 || n >= URL_MAX_LEN) {
         return dy_err(DY_ERR_FAILED, "api url is too long");
     }
+    time_query = strchr(time_url, '?') + 1;
 
-    BaseType_t res = xTaskCreate(task, "dy_cloud_time", 4096, NULL, tskIDLE_PRIORITY, NULL);
-    if (res != pdPASS) {
-        return dy_err(DY_ERR_FAILED, "xTaskCreate");
+    // Let the local time be shown in the right timezone until the fresh time is fetched
+    if (store_load(DY_INTERNAL_CFG_ID_CLOUD_TIME, STORE_VERSION, &stored, sizeof(stored))) {
+        dy_cloud_time_t ev = stored;
+        ev.stale = true;
+
+        esp_err_t esp_err = esp_event_post(DY_CLOUD_EV_BASE, DY_CLOUD_EV_TIME_UPDATED, &ev, sizeof(ev), 10);
+        if (esp_err != ESP_OK) {
+            ESP_LOGW(LTAG, "post stored time: %s", esp_err_to_name(esp_err));
+        }
     }
 
-    return dy_ok();
+    return scheduler_add_job(&job);
 }
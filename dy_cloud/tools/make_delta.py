@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+"""
+Makes DYD1 delta patches between firmware images, and applies them to check the result.
+
+Usage:
+    make_delta.py make BASE TARGET PATCH
+    make_delta.py apply BASE PATCH TARGET
+
+BASE is the image the device runs, TARGET is the new one. See delta.h for the format.
+
+Matches are found with an index of BLOCK-byte strings of the base. Each exact match is extended forward while the
+bytes mostly match, like bsdiff does, and emitted as ADD, so addresses changed by shifted code become small
+differences among runs of zeros. Bytes with no match are emitted as INSERT. The op stream is then deflated.
+"""
+
+import argparse
+import hashlib
+import struct
+import sys
+import zlib
+
+MAGIC = b'DYD1'
+OP_COPY = 0x01
+OP_ADD = 0x02
+OP_INSERT = 0x03
+BLOCK = 16
+MAX_CANDIDATES = 8
+
+
+def index_base(base):
+    idx = {}
+    for i in range(len(base) - BLOCK + 1):
+        cands = idx.setdefault(base[i:i + BLOCK], [])
+        if len(cands) < MAX_CANDIDATES:
+            cands.append(i)
+    return idx
+
+
+def exact_len(base, b_pos, target, t_pos):
+    n = 0
+    limit = min(len(base) - b_pos, len(target) - t_pos)
+    while n < limit and base[b_pos + n] == target[t_pos + n]:
+        n += 1
+    return n
+
+
+def approx_len(base, b_pos, target, t_pos):
+    """Returns the length over which the bytes match by more than a half, maximizing 2 * matches - length."""
+    limit = min(len(base) - b_pos, len(target) - t_pos)
+    matches = best_score = best_len = 0
+    for i in range(limit):
+        if base[b_pos + i] == target[t_pos + i]:
+            matches += 1
+        score = matches * 2 - (i + 1)
+        if score > best_score:
+            best_score, best_len = score, i + 1
+        elif score < best_score - 2 * BLOCK:
+            break
+    return best_len
+
+
+def make_ops(base, target):
+    idx = index_base(base)
+    ops = bytearray()
+    literal = bytearray()
+    pos = 0
+
+    def flush_literal():
+        if literal:
+            ops.extend(struct.pack('<BI', OP_INSERT, len(literal)))
+            ops.extend(literal)
+            literal.clear()
+
+    while pos < len(target):
+        best_pos, best_len = 0, 0
+        for cand in idx.get(bytes(target[pos:pos + BLOCK]), ()):
+            n = exact_len(base, cand, target, pos)
+            if n > best_len:
+                best_pos, best_len = cand, n
+
+        if best_len < BLOCK:
+            literal.append(target[pos])
+            pos += 1
+            continue
+
+        flush_literal()
+        n = best_len + approx_len(base, best_pos + best_len, target, pos + best_len)
+        diff = bytes((target[pos + i] - base[best_pos + i]) & 0xff for i in range(n))
+        if diff.count(0) == n:
+            ops.extend(struct.pack('<BII', OP_COPY, best_pos, n))
+        else:
+            ops.extend(struct.pack('<BII', OP_ADD, best_pos, n))
+            ops.extend(diff)
+        pos += n
+
+    flush_literal()
+    return bytes(ops)
+
+
+def make(base, target):
+    header = MAGIC + struct.pack('<I', len(base)) + hashlib.sha256(base).digest() + \
+             struct.pack('<I', len(target)) + hashlib.sha256(target).digest()
+    deflate = zlib.compressobj(9, zlib.DEFLATED, -15)  # raw deflate, as inflated by the ROM of the chip
+    return header + deflate.compress(make_ops(base, target)) + deflate.flush()
+
+
+def apply(base, patch):
+    if patch[:4] != MAGIC:
+        raise ValueError('not a DYD1 patch')
+    base_size, base_sha, target_size, target_sha = struct.unpack('<I32sI32s', patch[4:76])
+    if base_size != len(base) or hashlib.sha256(base).digest() != base_sha:
+        raise ValueError('patch is made for another base')
+
+    ops = zlib.decompress(patch[76:], -15)
+    out = bytearray()
+    i = 0
+    while i < len(ops):
+        op = ops[i]
+        if op == OP_INSERT:
+            n, = struct.unpack_from('<I', ops, i + 1)
+            out += ops[i + 5:i + 5 + n]
+            i += 5 + n
+        elif op in (OP_COPY, OP_ADD):
+            off, n = struct.unpack_from('<II', ops, i + 1)
+            if op == OP_COPY:
+                out += base[off:off + n]
+                i += 9
+            else:
+                out += bytes((base[off + k] + ops[i + 9 + k]) & 0xff for k in range(n))
+                i += 9 + n
+        else:
+            raise ValueError('unknown op 0x%02x' % op)
+
+    if len(out) != target_size or hashlib.sha256(out).digest() != target_sha:
+        raise ValueError('target mismatch')
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Make or apply DYD1 delta patches.')
+    sub = parser.add_subparsers(dest='cmd', required=True)
+    p = sub.add_parser('make')
+    p.add_argument('base')
+    p.add_argument('target')
+    p.add_argument('patch')
+    p = sub.add_parser('apply')
+    p.add_argument('base')
+    p.add_argument('patch')
+    p.add_argument('target')
+    args = parser.parse_args()
+
+    with open(args.base, 'rb') as f:
+        base = f.read()
+
+    if args.cmd == 'make':
+        with open(args.target, 'rb') as f:
+            target = f.read()
+        patch = make(base, target)
+        if apply(base, patch) != target:
+            sys.exit('patch check failed')
+        with open(args.patch, 'wb') as f:
+            f.write(patch)
+        print('%s: %d bytes, %.1fx smaller than the image' % (args.patch, len(patch), len(target) / len(patch)))
+    else:
+        with open(args.patch, 'rb') as f:
+            patch = f.read()
+        with open(args.target, 'wb') as f:
+            f.write(apply(base, patch))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+"""
+Serves a mock of the cloud API over plain HTTP for testing dy_cloud on the host or on a device in the local network.
+
+Usage:
+    mock_cloud.py [--port PORT] [--no-batch] [--chunk BYTES] [--firmware-url URL --firmware-sha256 HEX
+                  --firmware-size BYTES] [--firmware-file PATH [--firmware-delta PATH] [--drop-after BYTES]
+                  [--no-range]]
+
+Point the device to it by calling `dy_cloud_set_api_url("http://HOST:PORT/v2")` before starting the schedulers.
+
+Endpoints:
+    /v2/time, /v2/weather      fixed responses
+    /v2/firmware/update        404 unless --firmware-url or --firmware-file is given
+    /firmware.bin              the --firmware-file, which is advertised with its size and sha256 then.
+    /firmware.dyd              the --firmware-delta, a patch made by make_delta.py, advertised along with the image.
+                               Both support Range requests unless --no-range is given. With --drop-after, each
+                               response is cut after the given number of bytes, to test resumed downloads.
+    /v2/batch?include=a,b      the resources above in one object keyed by name; a missing update is null.
+                               Responds 404 with --no-batch, to test the fallback to separate requests.
+
+200 responses carry an ETag; requests with a matching If-None-Match get 304 Not Modified.
+
+With --chunk, bodies are sent with chunked transfer encoding in chunks of the given size, to exercise
+streaming parsing.
+"""
+
+import argparse
+import hashlib
+import json
+import re
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import urlparse, parse_qs
+
+args = None
+firmware = None
+delta = None
+
+
+def get_time(q):
+    return {'tz': 'Europe/Amsterdam', 'tz_data': 'CET-1CEST,M3.5.0,M10.5.0/3', 'value': int(time.time())}
+
+
+def get_weather(q):
+    return {'id': 2, 'title': 'Partly cloudy', 'is_day': True, 'temp': 17, 'feels_like': 15,
+            'lat': float(q.get('lat', ['0'])[0]), 'lng': float(q.get('lng', ['0'])[0])}
+
+
+def get_firmware(q):
+    if firmware is not None:
+        res = {'url': 'http://%s/firmware.bin' % q['host'][0], 'sha256': hashlib.sha256(firmware).hexdigest(),
+               'size': len(firmware)}
+        if delta is not None:
+            res['delta'] = {'url': 'http://%s/firmware.dyd' % q['host'][0], 'size': len(delta)}
+        return res
+    if not args.firmware_url:
+        return None
+    return {'url': args.firmware_url, 'sha256': args.firmware_sha256, 'size': args.firmware_size}
+
+
+RESOURCES = {
+    'time': get_time,
+    'weather': get_weather,
+    'firmware': get_firmware,
+}
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'  # keep-alive
+
+    def do_GET(self):
+        url = urlparse(self.path)
+        q = parse_qs(url.query)
+        q['host'] = [self.headers.get('Host', 'localhost:%d' % args.port)]  # for URLs pointing back to the server
+        path = url.path.rstrip('/')
+
+        if path == '/v2/batch' and not args.no_batch:
+            names = [n for n in q.get('include', [''])[0].split(',') if n in RESOURCES]
+            self.send_json(200, {n: RESOURCES[n](q) for n in names})
+        elif path == '/v2/time':
+            self.send_json(200, get_time(q))
+        elif path == '/v2/weather':
+            self.send_json(200, get_weather(q))
+        elif path == '/v2/firmware/update' and get_firmware(q) is not None:
+            self.send_json(200, get_firmware(q))
+        elif path == '/firmware.bin' and firmware is not None:
+            self.send_file(firmware)
+        elif path == '/firmware.dyd' and delta is not None:
+            self.send_file(delta)
+        else:
+            self.send_json(404, {'error': 'not found'})
+
+    def send_file(self, data):
+        start = 0
+        m = re.fullmatch(r'bytes=(\d+)-', self.headers.get('Range', ''))
+        if m and not args.no_range and int(m.group(1)) < len(data):
+            start = int(m.group(1))
+            self.send_response(206)
+            self.send_header('Content-Range', 'bytes %d-%d/%d' % (start, len(data) - 1, len(data)))
+        else:
+            self.send_response(200)
+        self.send_header('Content-Type', 'application/octet-stream')
+        self.send_header('Content-Length', str(len(data) - start))
+        self.end_headers()
+
+        body = data[start:]
+        if args.drop_after:
+            body = body[:args.drop_after]
+            self.close_connection = True
+        self.wfile.write(body)
+
+    def send_json(self, status, obj):
+        body = json.dumps(obj).encode()
+        etag = '"%s"' % hashlib.sha1(body).hexdigest()[:16]
+
+        if status == 200 and self.headers.get('If-None-Match') == etag:
+            self.send_response(304)
+            self.send_header('ETag', etag)
+            self.send_header('Content-Length', '0')
+            self.end_headers()
+            return
+
+        self.send_response(status)
+        if status == 200:
+            self.send_header('ETag', etag)
+        self.send_header('Content-Type', 'application/json')
+        if args.chunk:
+            self.send_header('Transfer-Encoding', 'chunked')
+            self.end_headers()
+            for i in range(0, len(body), args.chunk):
+                part = body[i:i + args.chunk]
+                self.wfile.write(b'%x\r\n%s\r\n' % (len(part), part))
+            self.wfile.write(b'0\r\n\r\n')
+        else:
+            self.send_header('Content-Length', str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+
+
+def main():
+    global args, firmware, delta
+
+    parser = argparse.ArgumentParser(description='Mock cloud API server.')
+    parser.add_argument('--port', type=int, default=8080)
+    parser.add_argument('--no-batch', action='store_true', help='respond 404 to batch requests')
+    parser.add_argument('--chunk', type=int, default=0, help='send bodies in chunks of this size')
+    parser.add_argument('--firmware-url')
+    parser.add_argument('--firmware-sha256', default='')
+    parser.add_argument('--firmware-size', type=int, default=0)
+    parser.add_argument('--firmware-file', help='serve this image as the update')
+    parser.add_argument('--firmware-delta', help='serve this patch against the running image along with the image')
+    parser.add_argument('--drop-after', type=int, default=0, help='cut firmware responses after this many bytes')
+    parser.add_argument('--no-range', action='store_true', help='ignore Range headers of firmware requests')
+    args = parser.parse_args()
+
+    if args.firmware_file:
+        with open(args.firmware_file, 'rb') as f:
+            firmware = f.read()
+    if args.firmware_file and args.firmware_delta:
+        with open(args.firmware_delta, 'rb') as f:
+            delta = f.read()
+
+    server = ThreadingHTTPServer(('', args.port), Handler)
+    print(f'serving on port {args.port}')
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    main()
@@ -1,103 +1,179 @@
 #include "dy/cloud.h"
 #include <string.h>
+#include <stdlib.h>
 #include <math.h>
 #include <stdbool.h>
 #include "esp_log.h"
 #include "esp_event.h"
-#include "cJSON.h"
+#include "esp_timer.h"
 #include "dy/error.h"
-#include "dy/net_cfg.h"
+#include "dy/internal.h"
+#include "http_client.h"
+#include "scheduler.h"
+#include "store.h"
 
-#define API_URL "https://api.d5y.xyz/v2/weather"
+#define API_PATH "/weather"
 #define SYNC_PERIOD 900 // 15 min
 #define URL_MAX_LEN 128
+#define STORE_VERSION 1
+#define STORE_PERIOD 3600 // s; min interval between saves, to spare the flash
 #define LTAG "DY_CLOUD"
 
-extern dy_err_t http_get_json(const char *url, cJSON **rsp_json);
+typedef struct {
+    dy_cloud_weather_t weather;
+    dy_cloud_http_validators_t validators; // of the weather, so they can be sent right after a reboot
+} stored_t;
 
 static char weather_url[URL_MAX_LEN] = {0};
+static const char *weather_query; // points into weather_url
+static dy_cloud_weather_t result;
+static dy_cloud_weather_t published; // last posted result
+static bool is_published = false;
+static dy_cloud_http_validators_t validators;
+static int64_t saved_at = -1; // us, esp_timer time
+
+static void on_json_value(void *args, const char *path, dy_cloud_json_type_t type, const char *value) {
+    dy_cloud_weather_t *res = args;
+
+    if (strcmp(path, "title") == 0 && type == DY_CLOUD_JSON_STRING) {
+        strlcpy(res->title, value, DY_CLOUD_WEATHER_TITLE_LEN);
+    } else if (strcmp(path, "is_day") == 0) {
+        res->is_day = type == DY_CLOUD_JSON_BOOL ? value[0] == 't' : strtod(value, NULL) != 0;
+    } else if (type != DY_CLOUD_JSON_NUMBER) {
+        return;
+    } else if (strcmp(path, "id") == 0) {
+        res->id = (int8_t) round(strtod(value, NULL));
+    } else if (strcmp(path, "temp") == 0) {
+        res->temp = (int8_t) round(strtod(value, NULL));
+    } else if (strcmp(path, "feels_like") == 0) {
+        res->feels = (int8_t) round(strtod(value, NULL));
+    }
+}
 
-static dy_err_t get_weather() {
-    dy_err_t err;
-    cJSON *json;
+static dy_err_t publish() {
+    esp_err_t esp_err = esp_event_post(DY_CLOUD_EV_BASE, DY_CLOUD_EV_WEATHER_UPDATED, &result, sizeof(result), 10);
+    if (esp_err != ESP_OK) {
+        return dy_err(DY_ERR_FAILED, "esp_event_post: %s", esp_err_to_name(esp_err));
+    }
 
-    dy_cloud_weather_t res;
-    memset(&res, 0, sizeof(res));
+    published = result;
+    is_published = true;
 
-    err = http_get_json(weather_url, &json);
-    if (dy_is_err(err)) {
-        return dy_err_pfx("http_get_json", err);
+    int64_t now = esp_timer_get_time();
+    if (saved_at < 0 || now - saved_at >= (int64_t) STORE_PERIOD * 1000000) {
+        stored_t rec = {.weather = result, .validators = validators};
+        rec.validators.not_modified = false;
+        store_save(DY_INTERNAL_CFG_ID_CLOUD_WEATHER, STORE_VERSION, &rec, sizeof(rec));
+        saved_at = now;
     }
 
-    cJSON *id = cJSON_GetObjectItem(json, "id");
-    if (id != NULL) {
-        res.id = (int8_t) round(cJSON_GetNumberValue(id));
-    }
+    return dy_ok();
+}
 
-    cJSON *title = cJSON_GetObjectItem(json, "title");
-    if (title != NULL) {
-        strlcpy(res.title, cJSON_GetStringValue(title), DY_CLOUD_WEATHER_TITLE_LEN);
-    }
+static void begin() {
+    memset(&result, 0, sizeof(result));
+}
 
-    cJSON *is_day = cJSON_GetObjectItem(json, "is_day");
-    if (is_day != NULL) {
-        res.is_day = (bool) cJSON_GetNumberValue(is_day);
+static dy_err_t end(bool found) {
+    if (!found) {
+        return dy_err(DY_ERR_NO_CONTENT, "no weather in response");
     }
 
-    cJSON *temp = cJSON_GetObjectItem(json, "temp");
-    if (temp != NULL) {
-        res.temp = (int8_t) round(cJSON_GetNumberValue(temp));
+    ESP_LOGI(LTAG, "got weather: id=%d, title=%s; is_day=%d; temp=%d; feels=%d",
+             result.id, result.title, result.is_day, result.temp, result.feels);
+
+    result.ts = time(NULL);
+
+    // Unchanged weather would only cause a redraw, unless the shown one is stale
+    if (is_published && !published.stale && result.id == published.id && strcmp(result.title, published.title) == 0 &&
+        result.is_day == published.is_day && result.temp == published.temp && result.feels == published.feels) {
+        http_count_suppressed_event();
+        return dy_ok();
     }
 
-    cJSON *feels = cJSON_GetObjectItem(json, "feels_like");
-    if (feels != NULL) {
-        res.feels = (int8_t) round(cJSON_GetNumberValue(feels));
+    return publish();
+}
+
+// Batch responses carry no validators, so the ones of the previous response no longer match the data.
+static dy_err_t batch_end(bool found) {
+    if (found) {
+        memset(&validators, 0, sizeof(validators));
     }
 
-    cJSON_Delete(json);
+    return end(found);
+}
 
-    ESP_LOGI(LTAG, "got weather: id=%d, title=%s; is_day=%d; temp=%d; feels=%d",
-             res.id, res.title, res.is_day, res.temp, res.feels);
+static dy_err_t get_weather() {
+    dy_err_t err;
 
-    res.ts = time(NULL);
+    begin();
 
-    esp_err_t esp_err = esp_event_post(DY_CLOUD_EV_BASE, DY_CLOUD_EV_WEATHER_UPDATED, &res, sizeof(res), 10);
-    if (esp_err != ESP_OK) {
-        return dy_err(DY_ERR_FAILED, "esp_event_post: %s", esp_err_to_name(esp_err));
+    err = http_get_json(weather_url, &validators, on_json_value, &result);
+    if (dy_is_err(err)) {
+        return dy_err_pfx("http_get_json", err);
     }
 
-    return dy_ok();
-}
+    if (validators.not_modified) {
+        ESP_LOGI(LTAG, "weather not modified");
 
-_Noreturn static void task() {
-    dy_err_t err;
-    int delay_sec;
-
-    while (true) {
-        if (!dy_net_cfg_net_connected()) {
-            delay_sec = 10;
-        } else if (dy_is_err(err = get_weather())) {
-            ESP_LOGE(LTAG, "get_weather: %s", dy_err_str(err));
-            delay_sec = 10;
-        } else {
-            delay_sec = SYNC_PERIOD;
+        // The stored weather is confirmed by the server, so it's not stale anymore
+        if (is_published && published.stale) {
+            result = published;
+            result.ts = time(NULL);
+            result.stale = false;
+            return publish();
         }
 
-        vTaskDelay(pdMS_TO_TICKS(1000 * delay_sec));
+        http_count_suppressed_event();
+        return dy_ok();
     }
+
+    return end(true);
 }
 
+static const char *query() {
+    return weather_query;
+}
+
+static const dy_cloud_batch_handler_t batch_handler = {
+        .query = query,
+        .begin = begin,
+        .on_value = on_json_value,
+        .args = &result,
+        .end = batch_end,
+};
+
+static dy_cloud_job_t job = {
+        .name = "weather",
+        .period = SYNC_PERIOD,
+        .run = get_weather,
+        .batch = &batch_handler,
+};
+
 dy_err_t dy_cloud_weather_scheduler_start() {
-    int n = snprintf(weather_url, URL_MAX_LEN, "%s?lat=%.5f&lng=%.5f", API_URL,
+    int n = snprintf(weather_url, URL_MAX_LEN, "%s%s?lat=%.5f&lng=%.5f", dy_cloud_get_api_url(), API_PATH,
                      dy_cloud_get_location_lat(), dy_cloud_get_location_lng());
     if (n < 0 || n >= URL_MAX_LEN) {
         return dy_err(DY_ERR_FAILED, "api url is too long");
     }
-
-    BaseType_t res = xTaskCreate(task, "dy_cloud_weather", 4096, NULL, tskIDLE_PRIORITY, NULL);
-    if (res != pdPASS) {
-        return dy_err(DY_ERR_FAILED, "xTaskCreate");
+    weather_query = strchr(weather_url, '?') + 1;
+
+    // Show the last known weather until the fresh one is fetched
+    stored_t rec;
+    if (!is_published && store_load(DY_INTERNAL_CFG_ID_CLOUD_WEATHER, STORE_VERSION, &rec, sizeof(rec))) {
+        result = rec.weather;
+        result.stale = true;
+
+        esp_err_t esp_err = esp_event_post(DY_CLOUD_EV_BASE, DY_CLOUD_EV_WEATHER_UPDATED, &result, sizeof(result), 10);
+        if (esp_err == ESP_OK) {
+            // Validators are only useful along with the shown weather, since a 304 won't post it again
+            validators = rec.validators;
+            published = result;
+            is_published = true;
+        } else {
+            ESP_LOGW(LTAG, "post stored weather: %s", esp_err_to_name(esp_err));
+        }
     }
 
-    return dy_ok();
+    return scheduler_add_job(&job);
 }
@@ -1,9 +1,13 @@
+#include <stddef.h>
+#include <stdbool.h>
 #include "dy/error.h"
 #include "dy/gfx/gfx.h"
 #include "dy/display.h"
 
 static dy_display_driver_t drivers[DY_DISPLAY_ID_MAX];
 static uint8_t brightness[DY_DISPLAY_ID_MAX] = {0};
+static dy_gfx_damage_t damage[DY_DISPLAY_ID_MAX];
+static bool full_write[DY_DISPLAY_ID_MAX];
 
 dy_err_t dy_display_set_driver(uint8_t id, dy_display_driver_t drv) {
     if (id >= DY_DISPLAY_ID_MAX) {
@@ -12,9 +16,13 @@ dy_err_t dy_display_set_driver(uint8_t id, dy_display_driver_t drv) {
 
     drivers[id].cfg = drv.cfg;
     drivers[id].write = drv.write;
+    drivers[id].write_region = drv.write_region;
     drivers[id].set_brightness = drv.set_brightness;
     drivers[id].refresh = drv.refresh;
 
+    dy_gfx_damage_reset(&damage[id]);
+    full_write[id] = true;
+
     return dy_ok();
 }
 
@@ -34,6 +42,75 @@ dy_err_t dy_display_write(uint8_t id, dy_gfx_buf_t *buf) {
     return drivers[id].write(drivers[id].cfg, buf);
 }
 
+dy_err_t dy_display_write_region(uint8_t id, dy_gfx_buf_t *buf, const dy_gfx_damage_t *dmg) {
+    if (id >= DY_DISPLAY_ID_MAX) {
+        return dy_err(DY_ERR_INVALID_ARG, "display id must not be greater than %d", DY_DISPLAY_ID_MAX);
+    }
+
+    if (buf == NULL || dmg == NULL) {
+        return dy_err(DY_ERR_INVALID_ARG, "null buffer or damage list");
+    }
+
+    if (drivers[id].write == NULL || drivers[id].cfg == NULL) {
+        return dy_err(DY_ERR_INVALID_ARG, "display driver is not initialized");
+    }
+
+    if (dy_gfx_damage_is_empty(dmg)) {
+        return dy_ok();
+    }
+
+    if (drivers[id].write_region == NULL) {
+        return drivers[id].write(drivers[id].cfg, buf);
+    }
+
+    return drivers[id].write_region(drivers[id].cfg, buf, dmg);
+}
+
+dy_err_t dy_display_damage(uint8_t id, dy_gfx_area_t area) {
+    if (id >= DY_DISPLAY_ID_MAX) {
+        return dy_err(DY_ERR_INVALID_ARG, "display id must not be greater than %d", DY_DISPLAY_ID_MAX);
+    }
+
+    dy_gfx_damage_add(&damage[id], area);
+
+    return dy_ok();
+}
+
+dy_err_t dy_display_damage_list(uint8_t id, const dy_gfx_damage_t *dmg) {
+    if (id >= DY_DISPLAY_ID_MAX) {
+        return dy_err(DY_ERR_INVALID_ARG, "display id must not be greater than %d", DY_DISPLAY_ID_MAX);
+    }
+
+    if (dmg == NULL) {
+        return dy_err(DY_ERR_INVALID_ARG, "null damage list");
+    }
+
+    dy_gfx_damage_add_all(&damage[id], dmg);
+
+    return dy_ok();
+}
+
+dy_err_t dy_display_flush(uint8_t id, dy_gfx_buf_t *buf) {
+    dy_err_t err;
+
+    if (id >= DY_DISPLAY_ID_MAX) {
+        return dy_err(DY_ERR_INVALID_ARG, "display id must not be greater than %d", DY_DISPLAY_ID_MAX);
+    }
+
+    if (full_write[id]) {
+        err = dy_display_write(id, buf);
+    } else {
+        err = dy_display_write_region(id, buf, &damage[id]);
+    }
+
+    if (!dy_is_err(err)) {
+        dy_gfx_damage_reset(&damage[id]);
+        full_write[id] = false;
+    }
+
+    return err;
+}
+
 dy_err_t dy_display_set_brightness(uint8_t id, uint8_t value) {
     if (id >= DY_DISPLAY_ID_MAX) {
         return dy_err(DY_ERR_INVALID_ARG, "id must not be greater than %d", DY_DISPLAY_ID_MAX);
@@ -50,6 +127,7 @@ dy_err_t dy_display_set_brightness(uint8_t id, uint8_t value) {
     dy_err_t err = drivers[id].set_brightness(drivers[id].cfg, value);
     if (!dy_is_err(err)) {
         brightness[id] = value;
+        full_write[id] = true; // some drivers apply brightness to pixels while writing them
     }
 
     return err;
@@ -7,16 +7,20 @@
 
 #include "dy/error.h"
 #include "dy/gfx/gfx.h"
+#include "dy/gfx/damage.h"
 
 #define DY_DISPLAY_ID_MAX 4
 #define DY_DISPLAY_BRI_MAX 15
 
 /**
  * @brief Display driver configuration structure.
+ *
+ * The `write_region` callback is optional; drivers lacking it receive full writes.
  */
 typedef struct {
     void *cfg;
     dy_err_t (*write)(void *cfg, dy_gfx_buf_t *buf);
+    dy_err_t (*write_region)(void *cfg, dy_gfx_buf_t *buf, const dy_gfx_damage_t *damage);
     dy_err_t (*set_brightness)(void *cfg, uint8_t value);
     dy_err_t (*refresh)(void *cfg);
 } dy_display_driver_t;
@@ -28,6 +32,39 @@ dy_err_t dy_display_set_driver(uint8_t id, dy_display_driver_t drv);
  */
 dy_err_t dy_display_write(uint8_t id, dy_gfx_buf_t *buf);
 
+/**
+ * @brief Writes changed areas of a graphics buffer to the display.
+ *
+ * Falls back to a full write if the driver does not support partial updates.
+ */
+dy_err_t dy_display_write_region(uint8_t id, dy_gfx_buf_t *buf, const dy_gfx_damage_t *damage);
+
+/**
+ * @brief Marks an area of the display as changed.
+ *
+ * Changed areas are accumulated until the next `dy_display_flush()` call.
+ *
+ * @note Damage is NOT collected from dy_gfx drawing calls, since they know nothing about displays: whoever draws
+ * into the buffer reports what has changed, either by this call or by passing the damage list made by
+ * `dy_gfx_comp_render()` to `dy_display_damage_list()`. Changes which are not reported are not written by the next
+ * flush.
+ */
+dy_err_t dy_display_damage(uint8_t id, dy_gfx_area_t area);
+
+/**
+ * @brief Marks a list of areas of the display as changed.
+ */
+dy_err_t dy_display_damage_list(uint8_t id, const dy_gfx_damage_t *damage);
+
+/**
+ * @brief Writes the areas marked as changed since the previous flush.
+ *
+ * Only the areas reported by `dy_display_damage()` and `dy_display_damage_list()` are written, so the display keeps
+ * showing old content wherever unreported changes were drawn. The whole buffer is written on the first flush and
+ * after the brightness change.
+ */
+dy_err_t dy_display_flush(uint8_t id, dy_gfx_buf_t *buf);
+
 /**
  * @brief Sets the brightness of the display.
  */
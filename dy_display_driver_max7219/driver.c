@@ -4,53 +4,87 @@
 #include "dy/display.h"
 #include "dy/_max7219.h"
 
-static dy_err_t write(void *cfg, dy_gfx_buf_t *buf) {
-    dy_err_t err;
-    dy_gfx_px_t px;
-    uint8_t px_val;
-    max7219_config_t *cfg_t = (max7219_config_t *) cfg;
-
-    if (dy_is_err(err = max7219_refresh(cfg_t))) {
-        return dy_err_pfx("max7219_refresh", err);
+// Returns the data of a device's row; devices are mapped to 8x8 chunks of the buffer in row-major order.
+static uint8_t device_row(const dy_gfx_buf_t *buf, uint16_t dev_n, uint8_t row_n) {
+    uint16_t nx = buf->width / 8;
+    const dy_gfx_px_t *px = &buf->content[dy_gfx_get_px_pos(buf, (dev_n % nx) * 8, (dev_n / nx) * 8 + row_n)];
+    uint8_t row_data = 0;
+
+    // Each row has 8-pixel width
+    for (uint8_t x = 0; x < 8; x++, px++) {
+        row_data |= (px->r || px->g || px->b) << (7 - x);
     }
 
-    // Split the buffer into 8x8 chunks; each chunk contains data for a single device
-    dy_gfx_buf_array_t *chunks = dy_gfx_split(buf, 8, 8);
-    if (chunks == NULL) {
-        return dy_err(DY_ERR_UNKNOWN, "dy_gfx_split failed");
+    return row_data;
+}
+
+// Checks whether a device's row intersects any damaged area.
+static bool device_row_damaged(const dy_gfx_buf_t *buf, uint16_t dev_n, uint8_t row_n, const dy_gfx_damage_t *dmg) {
+    uint16_t nx = buf->width / 8;
+    dy_gfx_area_t row = {(dev_n % nx) * 8, (dev_n / nx) * 8 + row_n, 8, 1};
+
+    for (uint8_t i = 0; i < dmg->len; i++) {
+        if (dy_gfx_area_intersect(row, dmg->areas[i]).width > 0) {
+            return true;
+        }
     }
 
+    return false;
+}
+
+// Sends rows to devices; if dmg is not NULL, only damaged rows are sent and other devices receive NOPs.
+static dy_err_t send_rows(max7219_config_t *cfg, const dy_gfx_buf_t *buf, const dy_gfx_damage_t *dmg) {
+    dy_err_t err;
+    int n_devs = (buf->width / 8) * (buf->height / 8);
+
     for (uint8_t row_n = 0; row_n <= 7; row_n++) {
-        int dev_start = cfg_t->reverse ? 0 : chunks->len - 1;
-        int dev_stop = cfg_t->reverse ? chunks->len : -1;
-        int dev_step = cfg_t->reverse ? 1 : -1;
+        bool row_damaged = dmg == NULL;
+        for (int dev_n = 0; dev_n < n_devs && !row_damaged; dev_n++) {
+            row_damaged = device_row_damaged(buf, dev_n, row_n, dmg);
+        }
+        if (!row_damaged) {
+            continue;
+        }
+
+        int dev_start = cfg->reverse ? 0 : n_devs - 1;
+        int dev_stop = cfg->reverse ? n_devs : -1;
+        int dev_step = cfg->reverse ? 1 : -1;
 
         for (int dev_n = dev_start; dev_n != dev_stop; dev_n = dev_n + dev_step) {
-            uint8_t row_data = 0;
-            dy_gfx_buf_t *dev_buf = chunks->buffers[dev_n];
-
-            // Each row has 8-pixel width
-            for (uint16_t x = 0; x < 8; x++) {
-                px = dy_gfx_get_px(dev_buf, x, row_n);
-                px_val = px.r || px.g || px.b;
-                row_data |= px_val << (7 - x);
+            if (dmg != NULL && !device_row_damaged(buf, dev_n, row_n, dmg)) {
+                err = max7219_send(cfg, DY_MAX7219_ADDR_NOP, 0);
+            } else {
+                err = max7219_send(cfg, row_n + 1, device_row(buf, dev_n, row_n));
             }
-
-            if (dy_is_err(err = max7219_send(cfg_t, row_n + 1, row_data))) {
+            if (dy_is_err(err)) {
                 return dy_err_pfx("dy_max7219_send", err);
             }
         }
 
-        if (dy_is_err(err = max7219_latch(cfg_t))) {
+        if (dy_is_err(err = max7219_latch(cfg))) {
             return dy_err_pfx("max7219_latch", err);
         }
     }
 
-    dy_gfx_free_buf_array(chunks);
-
     return dy_ok();
 }
 
+static dy_err_t write(void *cfg, dy_gfx_buf_t *buf) {
+    dy_err_t err;
+    max7219_config_t *cfg_t = (max7219_config_t *) cfg;
+
+    if (dy_is_err(err = max7219_refresh(cfg_t))) {
+        return dy_err_pfx("max7219_refresh", err);
+    }
+
+    return send_rows(cfg_t, buf, NULL);
+}
+
+// Unlike write(), does not refresh device registers; use dy_display_refresh() periodically for that.
+static dy_err_t write_region(void *cfg, dy_gfx_buf_t *buf, const dy_gfx_damage_t *dmg) {
+    return send_rows((max7219_config_t *) cfg, buf, dmg);
+}
+
 static dy_err_t set_brightness(void *cfg, uint8_t value) {
     if (value > DY_MAX7219_INTENSITY_MAX) {
         return dy_err(DY_ERR_INVALID_ARG, "value must not be greater than %d", DY_MAX7219_INTENSITY_MAX);
@@ -83,6 +117,7 @@ dy_err_t dy_display_driver_max7219_init(uint8_t id, gpio_num_t cs, gpio_num_t cl
     dy_display_driver_t driver = {
             .cfg = cfg,
             .write = write,
+            .write_region = write_region,
             .set_brightness = set_brightness,
             .refresh = refresh,
     };
@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <string.h>
+#include "dy/error.h"
+#include "dy/gfx/gfx.h"
+#include "dy/display.h"
+#include "dy/display_driver_vfb.h"
+
+#define PATH_MAX_LEN 256
+
+typedef struct {
+    dy_gfx_buf_t *fb;
+    const char *path_fmt;
+    uint32_t frame_n;
+    uint8_t brightness;
+    dy_display_driver_vfb_stats_t stats;
+} dy_vfb_config_t;
+
+static dy_vfb_config_t configs[DY_DISPLAY_ID_MAX];
+
+static inline uint8_t scale(uint8_t v, uint8_t level) {
+    return v * level / DY_DISPLAY_BRI_MAX;
+}
+
+// Copies an area of a buffer into the framebuffer; the area must lie within both buffers.
+static void set_area(dy_vfb_config_t *cfg, const dy_gfx_buf_t *buf, dy_gfx_area_t area) {
+    for (int32_t y = area.y; y < area.y + area.height; y++) {
+        for (int32_t x = area.x; x < area.x + area.width; x++) {
+            dy_gfx_px_t px = dy_gfx_get_px(buf, x, y);
+            px.r = scale(px.r, cfg->brightness);
+            px.g = scale(px.g, cfg->brightness);
+            px.b = scale(px.b, cfg->brightness);
+            dy_gfx_set_px(cfg->fb, x, y, px);
+        }
+    }
+
+    cfg->stats.n_px_written += area.width * area.height;
+}
+
+static dy_err_t dump(dy_vfb_config_t *cfg) {
+    char path[PATH_MAX_LEN];
+
+    if (cfg->path_fmt == NULL) {
+        return dy_ok();
+    }
+
+    snprintf(path, sizeof(path), cfg->path_fmt, cfg->frame_n++);
+
+    return dy_display_driver_vfb_write_ppm(cfg->fb, path);
+}
+
+static dy_err_t write(void *cf, dy_gfx_buf_t *buf) {
+    dy_vfb_config_t *cfg = cf;
+    dy_gfx_area_t bounds = {0, 0, cfg->fb->width, cfg->fb->height};
+
+    set_area(cfg, buf, dy_gfx_area_intersect(bounds, (dy_gfx_area_t) {0, 0, buf->width, buf->height}));
+    cfg->stats.n_writes++;
+
+    return dump(cfg);
+}
+
+static dy_err_t write_region(void *cf, dy_gfx_buf_t *buf, const dy_gfx_damage_t *dmg) {
+    dy_vfb_config_t *cfg = cf;
+    dy_gfx_area_t bounds = dy_gfx_area_intersect((dy_gfx_area_t) {0, 0, cfg->fb->width, cfg->fb->height},
+                                                 (dy_gfx_area_t) {0, 0, buf->width, buf->height});
+
+    for (uint8_t i = 0; i < dmg->len; i++) {
+        set_area(cfg, buf, dy_gfx_area_intersect(dmg->areas[i], bounds));
+    }
+    cfg->stats.n_region_writes++;
+
+    return dump(cfg);
+}
+
+static dy_err_t set_brightness(void *cf, uint8_t value) {
+    if (value > DY_DISPLAY_BRI_MAX) {
+        return dy_err(DY_ERR_INVALID_ARG, "value must not be greater than %d", DY_DISPLAY_BRI_MAX);
+    }
+
+    dy_vfb_config_t *cfg = cf;
+    cfg->brightness = value;
+
+    return dy_ok();
+}
+
+static dy_err_t refresh(void *cfg) {
+    // nothing to refresh
+    return dy_ok();
+}
+
+dy_err_t dy_display_driver_vfb_init(uint8_t id, uint16_t width, uint16_t height, const char *path_fmt) {
+    if (id >= DY_DISPLAY_ID_MAX) {
+        return dy_err(DY_ERR_INVALID_ARG, "display id must be lower than %d", DY_DISPLAY_ID_MAX);
+    }
+
+    dy_vfb_config_t *cfg = &configs[id];
+    if (cfg->fb != NULL) {
+        dy_gfx_free_buf(cfg->fb);
+    }
+
+    memset(cfg, 0, sizeof(dy_vfb_config_t));
+    cfg->fb = dy_gfx_new_buf(width, height);
+    if (cfg->fb == NULL) {
+        return dy_err(DY_ERR_NO_MEM, "dy_gfx_new_buf failed");
+    }
+    cfg->path_fmt = path_fmt;
+    cfg->brightness = DY_DISPLAY_BRI_MAX;
+
+    dy_display_driver_t drv = {
+        .cfg = cfg,
+        .write = write,
+        .write_region = write_region,
+        .set_brightness = set_brightness,
+        .refresh = refresh,
+    };
+
+    return dy_display_set_driver(id, drv);
+}
+
+const dy_gfx_buf_t *dy_display_driver_vfb_get_frame(uint8_t id) {
+    if (id >= DY_DISPLAY_ID_MAX) {
+        return NULL;
+    }
+
+    return configs[id].fb;
+}
+
+dy_display_driver_vfb_stats_t dy_display_driver_vfb_get_stats(uint8_t id) {
+    if (id >= DY_DISPLAY_ID_MAX) {
+        return (dy_display_driver_vfb_stats_t) {0};
+    }
+
+    return configs[id].stats;
+}
+
+dy_err_t dy_display_driver_vfb_write_ppm(const dy_gfx_buf_t *buf, const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        return dy_err(DY_ERR_FAILED, "unable to open %s", path);
+    }
+
+    // dy_gfx_px_t is packed RGB888, which is exactly the P6 pixel layout
+    size_t n_px = buf->width * buf->height;
+    bool ok = fprintf(f, "P6\n%u %u\n255\n", buf->width, buf->height) > 0 &&
+              fwrite(buf->content, sizeof(dy_gfx_px_t), n_px, f) == n_px;
+
+    if (fclose(f) != 0 || !ok) {
+        return dy_err(DY_ERR_FAILED, "unable to write %s", path);
+    }
+
+    return dy_ok();
+}
@@ -0,0 +1,59 @@
+/**
+ * @brief Virtual framebuffer display driver.
+ *
+ * Keeps an in-memory copy of what a physical display would show and optionally dumps every written frame
+ * into a PPM file. Partial writes update damaged areas only, so missed damage shows up as stale pixels.
+ * Intended for host builds, e.g. with the ESP-IDF linux target.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "dy/error.h"
+#include "dy/gfx/gfx.h"
+
+/**
+ * Driver statistics.
+ */
+typedef struct {
+    uint32_t n_writes;        // full writes
+    uint32_t n_region_writes; // partial writes
+    uint64_t n_px_written;    // pixels transferred by all writes
+} dy_display_driver_vfb_stats_t;
+
+/**
+ * @brief Initializes a virtual display and registers it as the display `id`.
+ *
+ * @param id        Display ID.
+ * @param width     Display width.
+ * @param height    Display height.
+ * @param path_fmt  printf-style path of frame dumps with a single `%u` for the frame number,
+ *                  e.g. "/tmp/frame-%05u.ppm"; NULL disables dumping.
+ *
+ * @return
+ *  - DY_ERR_INVALID_ARG if the ID is invalid.
+ *  - DY_ERR_NO_MEM if there is no memory for the framebuffer.
+ *  - DY_OK on success.
+ */
+dy_err_t dy_display_driver_vfb_init(uint8_t id, uint16_t width, uint16_t height, const char *path_fmt);
+
+/**
+ * @brief Returns current content of a virtual display, with brightness applied.
+ *
+ * @return Framebuffer or NULL if the ID is invalid or the display is not initialized.
+ */
+const dy_gfx_buf_t *dy_display_driver_vfb_get_frame(uint8_t id);
+
+/**
+ * @brief Returns statistics of a virtual display; zeroes if the ID is invalid.
+ */
+dy_display_driver_vfb_stats_t dy_display_driver_vfb_get_stats(uint8_t id);
+
+/**
+ * @brief Writes a buffer into a binary PPM (P6) file.
+ *
+ * @return
+ *  - DY_ERR_FAILED if the file cannot be written.
+ *  - DY_OK on success.
+ */
+dy_err_t dy_display_driver_vfb_write_ppm(const dy_gfx_buf_t *buf, const char *path);
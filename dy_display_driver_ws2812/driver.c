@@ -37,16 +37,38 @@ static dy_gfx_px_t set_px_brightness(dy_gfx_px_t px, uint8_t level) {
     return px;
 }
 
-static dy_err_t write(void *cf, dy_gfx_buf_t *buf) {
-    dy_ws2812_config_t *cfg = cf;
-
-    for (uint16_t y = 0; y < buf->height; y++) {
-        for (uint16_t x = 0; x < buf->width; x++) {
+// Encodes pixels of an area into the strip's buffer; the area must lie within the buffer.
+static void set_area(dy_ws2812_config_t *cfg, const dy_gfx_buf_t *buf, dy_gfx_area_t area) {
+    for (int32_t y = area.y; y < area.y + area.height; y++) {
+        for (int32_t x = area.x; x < area.x + area.width; x++) {
             dy_gfx_px_t px = dy_gfx_get_px(buf, x, y);
             px = set_px_brightness(px, cfg->brightness);
             led_strip_set_pixel(cfg->handle, px_offset(cfg, x, y), px.r, px.g, px.b);
         }
     }
+}
+
+static dy_err_t write(void *cf, dy_gfx_buf_t *buf) {
+    dy_ws2812_config_t *cfg = cf;
+
+    set_area(cfg, buf, (dy_gfx_area_t) {0, 0, buf->width, buf->height});
+
+    esp_err_t esp_err = led_strip_refresh(cfg->handle);
+    if (esp_err != ESP_OK) {
+        return dy_err(DY_ERR_INVALID_ARG, esp_err_to_name(esp_err));
+    }
+
+    return dy_ok();
+}
+
+// The strip keeps pixels which were not changed, so only damaged areas are re-encoded.
+static dy_err_t write_region(void *cf, dy_gfx_buf_t *buf, const dy_gfx_damage_t *dmg) {
+    dy_ws2812_config_t *cfg = cf;
+    dy_gfx_area_t bounds = {0, 0, buf->width, buf->height};
+
+    for (uint8_t i = 0; i < dmg->len; i++) {
+        set_area(cfg, buf, dy_gfx_area_intersect(dmg->areas[i], bounds));
+    }
 
     esp_err_t esp_err = led_strip_refresh(cfg->handle);
     if (esp_err != ESP_OK) {
@@ -111,6 +133,7 @@ dy_err_t dy_display_driver_ws2812_init(
     dy_display_driver_t drv = {
         .cfg = cfg,
         .write = write,
+        .write_region = write_region,
         .set_brightness = set_brightness,
         .refresh = refresh,
     };
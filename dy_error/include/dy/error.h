@@ -1,7 +1,10 @@
 #pragma once
 
 #include <stdbool.h>
+
+#ifdef ESP_PLATFORM
 #include "esp_err.h"
+#endif
 
 #define DY_ERROR_DESC_MAX_LEN 128
 
@@ -0,0 +1,144 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "dy/gfx/alloc.h"
+
+// Every allocation starts at a pointer-aligned offset, so buffer structs are properly aligned
+#define ALIGN(n) (((n) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+static void update_used(dy_gfx_alloc_stats_t *stats, size_t used) {
+    stats->used = used;
+    if (used > stats->high_water) {
+        stats->high_water = used;
+    }
+}
+
+dy_gfx_arena_t *dy_gfx_arena_new(size_t size) {
+    size = ALIGN(size);
+
+    dy_gfx_arena_t *arena = malloc(ALIGN(sizeof(dy_gfx_arena_t)) + size);
+    if (arena == NULL) {
+        return NULL;
+    }
+
+    memset(arena, 0, sizeof(dy_gfx_arena_t));
+    arena->mem = (uint8_t *) arena + ALIGN(sizeof(dy_gfx_arena_t));
+    arena->stats.capacity = size;
+
+    return arena;
+}
+
+void dy_gfx_arena_free(dy_gfx_arena_t *arena) {
+    free(arena);
+}
+
+dy_gfx_buf_t *dy_gfx_arena_new_buf(dy_gfx_arena_t *arena, uint16_t width, uint16_t height) {
+    size_t px_size = width * height * sizeof(dy_gfx_px_t);
+    size_t size = ALIGN(sizeof(dy_gfx_buf_t) + px_size);
+
+    if (arena->stats.capacity - arena->stats.used < size) {
+        arena->stats.n_fails++;
+        return NULL;
+    }
+
+    dy_gfx_buf_t *buf = (dy_gfx_buf_t *) (arena->mem + arena->stats.used);
+    buf->width = width;
+    buf->height = height;
+    buf->content = (dy_gfx_px_t *) (buf + 1);
+    memset(buf->content, 0, px_size);
+
+    arena->stats.n_allocs++;
+    update_used(&arena->stats, arena->stats.used + size);
+
+    return buf;
+}
+
+void dy_gfx_arena_reset(dy_gfx_arena_t *arena) {
+    arena->stats.used = 0;
+}
+
+dy_gfx_alloc_stats_t dy_gfx_arena_stats(const dy_gfx_arena_t *arena) {
+    return arena->stats;
+}
+
+dy_gfx_pool_t *dy_gfx_pool_new(uint16_t n_blocks, uint16_t max_width, uint16_t max_height) {
+    uint32_t max_px = max_width * max_height;
+    size_t block_size = ALIGN(sizeof(dy_gfx_buf_t) + max_px * sizeof(dy_gfx_px_t));
+    size_t map_size = ALIGN((n_blocks + 7) / 8);
+
+    // Layout: pool struct, free map, blocks
+    dy_gfx_pool_t *pool = malloc(ALIGN(sizeof(dy_gfx_pool_t)) + map_size + n_blocks * block_size);
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    memset(pool, 0, sizeof(dy_gfx_pool_t));
+    pool->free_map = (uint8_t *) pool + ALIGN(sizeof(dy_gfx_pool_t));
+    pool->mem = pool->free_map + map_size;
+    pool->block_size = block_size;
+    pool->max_px = max_px;
+    pool->stats.capacity = n_blocks;
+
+    memset(pool->free_map, 0, map_size);
+    for (uint16_t i = 0; i < n_blocks; i++) {
+        pool->free_map[i / 8] |= 1 << (i % 8);
+    }
+
+    return pool;
+}
+
+void dy_gfx_pool_free(dy_gfx_pool_t *pool) {
+    free(pool);
+}
+
+dy_gfx_buf_t *dy_gfx_pool_new_buf(dy_gfx_pool_t *pool, uint16_t width, uint16_t height) {
+    if (width * height > pool->max_px) {
+        pool->stats.n_fails++;
+        return NULL;
+    }
+
+    for (size_t i = 0; i < pool->stats.capacity; i++) {
+        if (pool->free_map[i / 8] == 0) {
+            i |= 7; // skip the rest of a byte of busy blocks
+            continue;
+        }
+        if (!(pool->free_map[i / 8] & (1 << (i % 8)))) {
+            continue;
+        }
+
+        pool->free_map[i / 8] &= ~(1 << (i % 8));
+
+        dy_gfx_buf_t *buf = (dy_gfx_buf_t *) (pool->mem + i * pool->block_size);
+        buf->width = width;
+        buf->height = height;
+        buf->content = (dy_gfx_px_t *) (buf + 1);
+        memset(buf->content, 0, width * height * sizeof(dy_gfx_px_t));
+
+        pool->stats.n_allocs++;
+        update_used(&pool->stats, pool->stats.used + 1);
+
+        return buf;
+    }
+
+    pool->stats.n_fails++;
+
+    return NULL;
+}
+
+void dy_gfx_pool_free_buf(dy_gfx_pool_t *pool, dy_gfx_buf_t *buf) {
+    if (buf == NULL) {
+        return;
+    }
+
+    size_t i = ((uint8_t *) buf - pool->mem) / pool->block_size;
+    if ((uint8_t *) buf < pool->mem || i >= pool->stats.capacity || pool->free_map[i / 8] & (1 << (i % 8))) {
+        return; // not from this pool or already free
+    }
+
+    pool->free_map[i / 8] |= 1 << (i % 8);
+    pool->stats.used--;
+}
+
+dy_gfx_alloc_stats_t dy_gfx_pool_stats(const dy_gfx_pool_t *pool) {
+    return pool->stats;
+}
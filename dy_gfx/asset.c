@@ -0,0 +1,281 @@
+#include <string.h>
+#include "dy/gfx/asset.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_partition.h"
+#endif
+
+#if !defined(ESP_PLATFORM) || defined(CONFIG_IDF_TARGET_LINUX)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define HEADER_LEN 16
+
+static inline uint16_t read_u16(const uint8_t *p) {
+    return p[0] | p[1] << 8;
+}
+
+static inline uint32_t read_u32(const uint8_t *p) {
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+// Checks whether asset's size matches its type-specific properties; sizes are computed in 64 bits, since a sheet's
+// properties may describe more than 4 GiB.
+static bool check_size(const dy_gfx_asset_entry_t *e) {
+    const uint8_t *m = e->meta;
+
+    switch (e->type) {
+        case DY_GFX_ASSET_FONT:
+            if (m[2] != DY_GFX_FONT_SYMBOL_WIDTH_8 && m[2] != DY_GFX_FONT_SYMBOL_WIDTH_16) {
+                return false;
+            }
+            return e->size >= (uint64_t) m[1] * (m[3] + 1) * (m[2] / 8);
+        case DY_GFX_ASSET_SPRITE:
+            return e->size >= (uint64_t) read_u16(m) * read_u16(m + 2) * sizeof(dy_gfx_px_t);
+        case DY_GFX_ASSET_SPRITE_SHEET:
+            if (read_u16(m + 4) == 0) {
+                return false;
+            }
+            return e->size >= (uint64_t) read_u16(m) * read_u16(m + 2) * read_u16(m + 4) * sizeof(dy_gfx_px_t);
+        case DY_GFX_ASSET_CSPRITE:
+            return e->size >= (uint64_t) read_u16(m + 4) * sizeof(dy_gfx_px_t);
+        default:
+            return true;
+    }
+}
+
+static dy_err_t make_asset(const dy_gfx_asset_store_t *store, const dy_gfx_asset_entry_t *e, dy_gfx_asset_type_t type,
+                           dy_gfx_asset_t *asset) {
+    if (e->type != type) {
+        return dy_err(DY_ERR_INVALID_ARG, "asset %d has type %d, expected %d", e->id, e->type, type);
+    }
+
+    if (!check_size(e)) {
+        return dy_err(DY_ERR_INVALID_ARG, "asset %d is too short", e->id);
+    }
+
+    asset->entry = e;
+    asset->data = store->data + e->offset;
+
+    return dy_ok();
+}
+
+dy_err_t dy_gfx_asset_open_mem(dy_gfx_asset_store_t *store, const void *data, size_t size) {
+    const uint8_t *d = data;
+
+    memset(store, 0, sizeof(dy_gfx_asset_store_t));
+
+    if (size < HEADER_LEN) {
+        return dy_err(DY_ERR_INVALID_ARG, "container is too short");
+    }
+
+    if (memcmp(d, "DYA1", 4) != 0) {
+        return dy_err(DY_ERR_INVALID_VERSION, "unknown container magic");
+    }
+
+    uint32_t n_entries = read_u32(d + 4);
+    uint32_t total = read_u32(d + 8);
+    if (total > size || n_entries > (total - HEADER_LEN) / sizeof(dy_gfx_asset_entry_t)) {
+        return dy_err(DY_ERR_INVALID_ARG, "container is truncated");
+    }
+
+    const dy_gfx_asset_entry_t *entries = (const dy_gfx_asset_entry_t *) (d + HEADER_LEN);
+    for (uint32_t i = 0; i < n_entries; i++) {
+        const dy_gfx_asset_entry_t *e = &entries[i];
+        if (e->offset % 4 != 0 || e->offset > total || e->size > total - e->offset) {
+            return dy_err(DY_ERR_INVALID_ARG, "asset %d is out of container's bounds", e->id);
+        }
+        if (i > 0 && e->id <= entries[i - 1].id) {
+            return dy_err(DY_ERR_INVALID_ARG, "index is not sorted by id");
+        }
+    }
+
+    store->data = d;
+    store->size = total;
+    store->n_entries = n_entries;
+    store->entries = entries;
+
+    return dy_ok();
+}
+
+#if !defined(ESP_PLATFORM) || defined(CONFIG_IDF_TARGET_LINUX)
+
+dy_err_t dy_gfx_asset_open_file(dy_gfx_asset_store_t *store, const char *path) {
+    dy_err_t err;
+    struct stat st;
+
+    memset(store, 0, sizeof(dy_gfx_asset_store_t));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return dy_err(DY_ERR_NOT_FOUND, "unable to open %s", path);
+    }
+
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return dy_err(DY_ERR_FAILED, "unable to stat %s", path);
+    }
+
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return dy_err(DY_ERR_FAILED, "unable to map %s", path);
+    }
+
+    if (dy_is_err(err = dy_gfx_asset_open_mem(store, data, st.st_size))) {
+        munmap(data, st.st_size);
+        return err;
+    }
+
+    // Keep size of the mapping, it may differ from the container's one
+    store->mmap_handle = st.st_size;
+    store->is_file = true;
+
+    return dy_ok();
+}
+
+#endif
+
+dy_err_t dy_gfx_asset_open(dy_gfx_asset_store_t *store, const char *label) {
+#ifdef ESP_PLATFORM
+    dy_err_t err;
+    const void *data;
+    esp_partition_mmap_handle_t handle;
+
+    memset(store, 0, sizeof(dy_gfx_asset_store_t));
+
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (part == NULL) {
+        return dy_err(DY_ERR_NOT_FOUND, "partition %s not found", label);
+    }
+
+    esp_err_t esp_err = esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA, &data, &handle);
+    if (esp_err != ESP_OK) {
+        return dy_err(DY_ERR_FAILED, "esp_partition_mmap failed: %s", esp_err_to_name(esp_err));
+    }
+
+    if (dy_is_err(err = dy_gfx_asset_open_mem(store, data, part->size))) {
+        esp_partition_munmap(handle);
+        return err;
+    }
+
+    store->mmap_handle = handle;
+    store->is_partition = true;
+
+    return dy_ok();
+#else
+    return dy_gfx_asset_open_file(store, label);
+#endif
+}
+
+void dy_gfx_asset_close(dy_gfx_asset_store_t *store) {
+    if (store->data == NULL) {
+        return;
+    }
+
+#if !defined(ESP_PLATFORM) || defined(CONFIG_IDF_TARGET_LINUX)
+    if (store->is_file) {
+        munmap((void *) store->data, store->mmap_handle);
+    }
+#endif
+
+#ifdef ESP_PLATFORM
+    if (store->is_partition) {
+        esp_partition_munmap(store->mmap_handle);
+    }
+#endif
+
+    memset(store, 0, sizeof(dy_gfx_asset_store_t));
+}
+
+dy_err_t dy_gfx_asset_find(const dy_gfx_asset_store_t *store, const char *name, dy_gfx_asset_type_t type,
+                           dy_gfx_asset_t *asset) {
+    // Names of exactly DY_GFX_ASSET_NAME_LEN bytes are not terminated, so longer names must not match them
+    if (strnlen(name, DY_GFX_ASSET_NAME_LEN + 1) > DY_GFX_ASSET_NAME_LEN) {
+        return dy_err(DY_ERR_NOT_FOUND, "asset %s not found", name);
+    }
+
+    for (uint32_t i = 0; i < store->n_entries; i++) {
+        const dy_gfx_asset_entry_t *e = &store->entries[i];
+        if (strncmp(e->name, name, DY_GFX_ASSET_NAME_LEN) == 0) {
+            return make_asset(store, e, type, asset);
+        }
+    }
+
+    return dy_err(DY_ERR_NOT_FOUND, "asset %s not found", name);
+}
+
+dy_err_t dy_gfx_asset_get(const dy_gfx_asset_store_t *store, uint16_t id, dy_gfx_asset_type_t type,
+                          dy_gfx_asset_t *asset) {
+    // Index is sorted by id
+    uint32_t lo = 0, hi = store->n_entries;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        const dy_gfx_asset_entry_t *e = &store->entries[mid];
+
+        if (e->id == id) {
+            return make_asset(store, e, type, asset);
+        } else if (e->id < id) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return dy_err(DY_ERR_NOT_FOUND, "asset %d not found", id);
+}
+
+dy_gfx_font_t dy_gfx_asset_font(const dy_gfx_asset_t *asset) {
+    const uint8_t *m = asset->entry->meta;
+
+    dy_gfx_font_t font = {
+        .ascii_offset = m[0],
+        .length = m[1],
+        .width = m[2],
+        .height = m[3],
+    };
+    font.content.c8 = asset->data;
+
+    return font;
+}
+
+dy_gfx_sprite_t dy_gfx_asset_sprite(const dy_gfx_asset_t *asset) {
+    const uint8_t *m = asset->entry->meta;
+
+    return (dy_gfx_sprite_t) {
+        .width = read_u16(m),
+        .height = read_u16(m + 2),
+        .data = (const dy_gfx_px_t *) asset->data,
+    };
+}
+
+dy_gfx_sprite_sheet_t dy_gfx_asset_sprite_sheet(const dy_gfx_asset_t *asset) {
+    const uint8_t *m = asset->entry->meta;
+
+    return (dy_gfx_sprite_sheet_t) {
+        .width = read_u16(m),
+        .height = read_u16(m + 2),
+        .n_frames = read_u16(m + 4),
+        .data = (const dy_gfx_px_t *) asset->data,
+    };
+}
+
+dy_gfx_csprite_t dy_gfx_asset_csprite(const dy_gfx_asset_t *asset) {
+    const uint8_t *m = asset->entry->meta;
+    uint16_t n_colors = read_u16(m + 4);
+    uint32_t palette_len = n_colors * sizeof(dy_gfx_px_t);
+
+    return (dy_gfx_csprite_t) {
+        .width = read_u16(m),
+        .height = read_u16(m + 2),
+        .n_colors = n_colors,
+        .encoding = m[6],
+        .bpp = m[7],
+        .palette = (const dy_gfx_px_t *) asset->data,
+        .data_len = asset->entry->size - palette_len,
+        .data = asset->data + palette_len,
+    };
+}
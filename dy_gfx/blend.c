@@ -0,0 +1,213 @@
+#include <string.h>
+
+#include "dy/gfx/gfx.h"
+
+// Clipped merge region.
+typedef struct {
+    dy_gfx_px_t *dst;
+    const dy_gfx_px_t *src;
+    const uint8_t *alpha_map;
+    int32_t width;
+    int32_t height;
+    uint16_t dst_stride;
+    uint16_t src_stride;
+} region_t;
+
+// Divides by 255 with rounding, for 0 <= v <= 255 * 255.
+static inline uint8_t div255(uint32_t v) {
+    v += 128;
+    return (v + (v >> 8)) >> 8;
+}
+
+static inline uint8_t add_sat(uint8_t a, uint8_t b) {
+    uint16_t v = a + b;
+    return v > 255 ? 255 : v;
+}
+
+static inline uint8_t mix(uint8_t s, uint8_t d, uint8_t a) {
+    return div255(s * a + d * (255 - a));
+}
+
+static void blend_copy(const region_t *r) {
+    for (int32_t y = 0; y < r->height; y++) {
+        memmove(r->dst + y * r->dst_stride, r->src + y * r->src_stride, r->width * sizeof(dy_gfx_px_t));
+    }
+}
+
+static void blend_key(const region_t *r) {
+    for (int32_t y = 0; y < r->height; y++) {
+        dy_gfx_px_t *d = r->dst + y * r->dst_stride;
+        const dy_gfx_px_t *s = r->src + y * r->src_stride;
+
+        for (int32_t x = 0; x < r->width; x++, d++, s++) {
+            if (s->r | s->g | s->b) {
+                *d = *s;
+            }
+        }
+    }
+}
+
+static void blend_add(const region_t *r) {
+    for (int32_t y = 0; y < r->height; y++) {
+        dy_gfx_px_t *d = r->dst + y * r->dst_stride;
+        const dy_gfx_px_t *s = r->src + y * r->src_stride;
+
+        for (int32_t x = 0; x < r->width; x++, d++, s++) {
+            d->r = add_sat(d->r, s->r);
+            d->g = add_sat(d->g, s->g);
+            d->b = add_sat(d->b, s->b);
+        }
+    }
+}
+
+static void blend_alpha(const region_t *r, uint8_t a) {
+    if (a == 0) {
+        return;
+    }
+    if (a == 255) {
+        blend_copy(r);
+        return;
+    }
+
+    for (int32_t y = 0; y < r->height; y++) {
+        dy_gfx_px_t *d = r->dst + y * r->dst_stride;
+        const dy_gfx_px_t *s = r->src + y * r->src_stride;
+
+        for (int32_t x = 0; x < r->width; x++, d++, s++) {
+            d->r = mix(s->r, d->r, a);
+            d->g = mix(s->g, d->g, a);
+            d->b = mix(s->b, d->b, a);
+        }
+    }
+}
+
+static void blend_alpha_map(const region_t *r) {
+    for (int32_t y = 0; y < r->height; y++) {
+        dy_gfx_px_t *d = r->dst + y * r->dst_stride;
+        const dy_gfx_px_t *s = r->src + y * r->src_stride;
+        const uint8_t *a = r->alpha_map + y * r->src_stride;
+
+        for (int32_t x = 0; x < r->width; x++, d++, s++, a++) {
+            if (*a == 0) {
+                continue;
+            }
+            if (*a == 255) {
+                *d = *s;
+                continue;
+            }
+            d->r = mix(s->r, d->r, *a);
+            d->g = mix(s->g, d->g, *a);
+            d->b = mix(s->b, d->b, *a);
+        }
+    }
+}
+
+static void blend_xor(const region_t *r) {
+    for (int32_t y = 0; y < r->height; y++) {
+        dy_gfx_px_t *d = r->dst + y * r->dst_stride;
+        const dy_gfx_px_t *s = r->src + y * r->src_stride;
+
+        for (int32_t x = 0; x < r->width; x++, d++, s++) {
+            d->r ^= s->r;
+            d->g ^= s->g;
+            d->b ^= s->b;
+        }
+    }
+}
+
+static dy_err_code_t merge(dy_gfx_buf_t *dst, const dy_gfx_buf_t *src, dy_gfx_point_t d_pos, dy_gfx_point_t s_pos,
+                           int64_t w, int64_t h, const dy_gfx_blend_t *blend) {
+    // Clipping is done in 64 bits, so that negating INT32_MIN or shifting one position by another can't overflow
+    int64_t dx = d_pos.x, dy = d_pos.y, sx = s_pos.x, sy = s_pos.y;
+
+    // Negative positions are clipped by shifting the opposite side
+    if (dx < 0) {
+        sx -= dx;
+        w += dx;
+        dx = 0;
+    }
+    if (dy < 0) {
+        sy -= dy;
+        h += dy;
+        dy = 0;
+    }
+    if (sx < 0) {
+        dx -= sx;
+        w += sx;
+        sx = 0;
+    }
+    if (sy < 0) {
+        dy -= sy;
+        h += sy;
+        sy = 0;
+    }
+
+    if (src->width - sx < w) {
+        w = src->width - sx;
+    }
+    if (src->height - sy < h) {
+        h = src->height - sy;
+    }
+    if (dst->width - dx < w) {
+        w = dst->width - dx;
+    }
+    if (dst->height - dy < h) {
+        h = dst->height - dy;
+    }
+    if (w <= 0 || h <= 0) {
+        return DY_OK;
+    }
+
+    uint32_t s_offset = dy_gfx_get_px_pos(src, sx, sy);
+
+    region_t r = {
+            .dst = dst->content + dy_gfx_get_px_pos(dst, dx, dy),
+            .src = src->content + s_offset,
+            .alpha_map = blend->alpha_map != NULL ? blend->alpha_map + s_offset : NULL,
+            .width = (int32_t) w,
+            .height = (int32_t) h,
+            .dst_stride = dst->width,
+            .src_stride = src->width,
+    };
+
+    switch (blend->mode) {
+        case DY_GFX_BLEND_COPY:
+            blend_copy(&r);
+            break;
+        case DY_GFX_BLEND_KEY:
+            blend_key(&r);
+            break;
+        case DY_GFX_BLEND_ADD:
+            blend_add(&r);
+            break;
+        case DY_GFX_BLEND_ALPHA:
+            if (r.alpha_map != NULL) {
+                blend_alpha_map(&r);
+            } else {
+                blend_alpha(&r, blend->alpha);
+            }
+            break;
+        case DY_GFX_BLEND_XOR:
+            blend_xor(&r);
+            break;
+        default:
+            return DY_ERR_INVALID_ARG;
+    }
+
+    return DY_OK;
+}
+
+dy_err_code_t dy_gfx_merge_blend(dy_gfx_buf_t *dst, const dy_gfx_buf_t *src, dy_gfx_point_t d_pos,
+                                 dy_gfx_point_t s_pos, const dy_gfx_blend_t *blend) {
+    if (s_pos.x >= src->width || s_pos.y >= src->height ||
+        d_pos.x >= dst->width || d_pos.y >= dst->height) {
+        return DY_ERR_INVALID_ARG;
+    }
+
+    return merge(dst, src, d_pos, s_pos, (int64_t) src->width - s_pos.x, (int64_t) src->height - s_pos.y, blend);
+}
+
+dy_err_code_t dy_gfx_merge_area(dy_gfx_buf_t *dst, const dy_gfx_buf_t *src, dy_gfx_point_t d_pos,
+                                dy_gfx_area_t s_area, const dy_gfx_blend_t *blend) {
+    return merge(dst, src, d_pos, (dy_gfx_point_t) {s_area.x, s_area.y}, s_area.width, s_area.height, blend);
+}
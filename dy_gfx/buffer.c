@@ -1,75 +1,63 @@
 #include <stdint.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#include "esp_log.h"
-
 #include "dy/error.h"
 #include "dy/gfx/gfx.h"
-#include "dy/gfx/sprite.h"
 
 static void print_bin(uint32_t v, uint8_t width) {
     for (uint8_t i = width; i > 0; i--) {
-        printf("%lu", (v >> (i - 1)) & 1);
+        printf("%" PRIu32, (v >> (i - 1)) & 1);
     }
 }
 
 dy_gfx_buf_t *dy_gfx_new_buf(uint16_t width, uint16_t height) {
-    dy_gfx_buf_t *buf = malloc(sizeof(dy_gfx_buf_t));
+    // The struct and its pixels are allocated as a single block
+    dy_gfx_buf_t *buf = calloc(1, sizeof(dy_gfx_buf_t) + width * height * sizeof(dy_gfx_px_t));
     if (!buf) {
         return NULL;
     }
 
     buf->width = width;
     buf->height = height;
-
-    buf->content = calloc(width * height, sizeof(dy_gfx_px_t));
-    if (!buf->content) {
-        free(buf);
-        return NULL;
-    }
+    buf->content = (dy_gfx_px_t *) (buf + 1);
 
     return buf;
 }
 
 void dy_gfx_free_buf(dy_gfx_buf_t *buf) {
-    free(buf->content);
     free(buf);
 }
 
-dy_gfx_buf_array_t *dy_gfx_make_buf_array(uint8_t length, uint16_t width, uint16_t height) {
-    dy_gfx_buf_array_t *buf_arr = malloc(sizeof(dy_gfx_buf_array_t));
+dy_gfx_buf_array_t *dy_gfx_make_buf_array(uint16_t length, uint16_t width, uint16_t height) {
+    size_t px_size = width * height * sizeof(dy_gfx_px_t);
+
+    // Layout: array struct, buffer pointers, buffer structs, pixels of all buffers
+    dy_gfx_buf_array_t *buf_arr = calloc(1, sizeof(dy_gfx_buf_array_t) +
+                                            length * (sizeof(dy_gfx_buf_t *) + sizeof(dy_gfx_buf_t) + px_size));
     if (!buf_arr) {
         return NULL;
     }
 
     buf_arr->len = length;
-    buf_arr->buffers = calloc(length, sizeof(dy_gfx_buf_t *));
+    buf_arr->buffers = (dy_gfx_buf_t **) (buf_arr + 1);
 
-    for (uint8_t i = 0; i < length; i++) {
-        dy_gfx_buf_t *b = dy_gfx_new_buf(width, height);
-        if (!b) {
-            for (uint8_t k = 0; k < i; k++) {
-                free(buf_arr->buffers[k]);
-            }
-            dy_gfx_free_buf(b);
-            free(buf_arr);
-            return NULL;
-        }
+    dy_gfx_buf_t *bufs = (dy_gfx_buf_t *) (buf_arr->buffers + length);
+    uint8_t *content = (uint8_t *) (bufs + length);
 
-        buf_arr->buffers[i] = b;
+    for (uint16_t i = 0; i < length; i++) {
+        bufs[i].width = width;
+        bufs[i].height = height;
+        bufs[i].content = (dy_gfx_px_t *) (content + i * px_size);
+        buf_arr->buffers[i] = &bufs[i];
     }
 
     return buf_arr;
 }
 
 void dy_gfx_free_buf_array(dy_gfx_buf_array_t *buf_arr) {
-    for (uint16_t i = 0; i < buf_arr->len; i++) {
-        dy_gfx_free_buf(buf_arr->buffers[i]);
-    }
-
-    free(buf_arr->buffers);
     free(buf_arr);
 }
 
@@ -103,35 +91,30 @@ dy_gfx_px_t dy_gfx_get_px(const dy_gfx_buf_t *buf, uint16_t x, uint16_t y) {
 }
 
 dy_err_code_t dy_gfx_merge(dy_gfx_buf_t *dst, const dy_gfx_buf_t *src, dy_gfx_point_t d_pos, dy_gfx_point_t s_pos) {
-    if (s_pos.x >= src->width || s_pos.y >= src->height ||
-        d_pos.x >= dst->width || d_pos.y >= dst->height) {
-        return DY_ERR_INVALID_ARG;
-    }
-
-    int32_t dst_x = d_pos.x;
-    for (int32_t src_x = s_pos.x; src_x < src->width && dst_x < dst->width; src_x++, dst_x++) {
-        int32_t dst_y = d_pos.y;
-        for (int32_t src_y = s_pos.y; src_y < src->height && dst_y < dst->height; src_y++, dst_y++) {
-            dy_gfx_set_px(dst, dst_x, dst_y, dy_gfx_get_px(src, src_x, src_y));
-        }
-    }
-
-    return DY_OK;
+    return dy_gfx_merge_blend(dst, src, d_pos, s_pos, &(dy_gfx_blend_t) {.mode = DY_GFX_BLEND_COPY});
 }
 
 dy_gfx_buf_array_t *dy_gfx_split(const dy_gfx_buf_t *src, uint8_t chunk_w, uint8_t chunk_h) {
-    uint8_t nx = src->width / chunk_w;
-    uint8_t ny = src->height / chunk_h;
+    if (chunk_w == 0 || chunk_h == 0) {
+        return NULL;
+    }
+
+    // Chunk counts are computed wide, since the array length can't hold more than UINT16_MAX buffers
+    uint32_t nx = src->width / chunk_w;
+    uint32_t ny = src->height / chunk_h;
+    if (nx * ny > UINT16_MAX) {
+        return NULL;
+    }
 
     dy_gfx_buf_array_t *dst = dy_gfx_make_buf_array(nx * ny, chunk_w, chunk_h);
     if (!dst) {
         return NULL;
     }
 
-    uint8_t i = 0;
-    for (uint8_t n_y = 0; n_y < ny; n_y++) {
-        for (uint8_t n_x = 0; n_x < nx; n_x++) {
-            dy_gfx_point_t src_pos = {n_x * chunk_w, n_y * chunk_h};
+    uint16_t i = 0;
+    for (uint32_t n_y = 0; n_y < ny; n_y++) {
+        for (uint32_t n_x = 0; n_x < nx; n_x++) {
+            dy_gfx_point_t src_pos = {(int32_t) (n_x * chunk_w), (int32_t) (n_y * chunk_h)};
             if (dy_gfx_merge(dst->buffers[i], src, (dy_gfx_point_t) {0, 0}, src_pos) != DY_OK) {
                 dy_gfx_free_buf_array(dst);
                 return NULL;
@@ -144,56 +127,34 @@ dy_gfx_buf_array_t *dy_gfx_split(const dy_gfx_buf_t *src, uint8_t chunk_w, uint8
 }
 
 dy_err_code_t dy_gfx_move(dy_gfx_buf_t *buf, dy_gfx_point_t pos) {
-    dy_err_code_t err;
-    dy_gfx_buf_t *tmp_buf = dy_gfx_new_buf(buf->width, buf->height);
-    if (!tmp_buf) {
-        return DY_ERR_UNKNOWN;
-    }
-
-    err = dy_gfx_merge(tmp_buf, buf, pos, (dy_gfx_point_t) {0, 0});
-    if (err) {
-        return err;
+    if (pos.x >= buf->width || pos.y >= buf->height) {
+        return DY_ERR_INVALID_ARG;
     }
 
-    dy_gfx_clear_buf(buf);
-
-    err = dy_gfx_merge(buf, tmp_buf, (dy_gfx_point_t) {0, 0}, (dy_gfx_point_t) {0, 0});
-    if (err) {
-        return err;
+    int32_t w = buf->width, h = buf->height;
+    if (pos.x <= -w || pos.y <= -h) {
+        dy_gfx_clear_buf(buf);
+        return DY_OK;
     }
 
-    dy_gfx_free_buf(tmp_buf);
+    int32_t src_x = pos.x < 0 ? -pos.x : 0, dst_x = pos.x > 0 ? pos.x : 0;
+    int32_t n = w - src_x - dst_x; // number of pixels kept in each row
 
-    return DY_OK;
-}
+    // The content is moved in place; rows are visited so that each source row is read before it is overwritten
+    for (int32_t i = 0; i < h; i++) {
+        int32_t y = pos.y > 0 ? h - 1 - i : i;
+        int32_t src_y = y - pos.y;
+        dy_gfx_px_t *row = &buf->content[y * w];
 
-void dy_gfx_colorize(dy_gfx_buf_t *buf, dy_gfx_px_t px) {
-    dy_gfx_px_t px0;
-
-    for (uint16_t x = 0; x < buf->width; x++) {
-        for (uint16_t y = 0; y < buf->height; y++) {
-            px0 = dy_gfx_get_px(buf, x, y);
-            if (px0.r == 0 && px0.g == 0 && px0.b == 0) {
-                continue; // skip black pixels
-            }
-            dy_gfx_set_px(buf, x, y, px);
+        if (src_y < 0 || src_y >= h) {
+            memset(row, 0, w * sizeof(dy_gfx_px_t));
+            continue;
         }
-    }
-}
 
-dy_err_t dy_gfx_write_sprite(dy_gfx_buf_t *buf, uint16_t bx, uint16_t by, const dy_gfx_sprite_t *sp) {
-    uint16_t sp_offset;
-    uint16_t max_offset = sp->width * sp->height - 1;
-
-    for (uint16_t x = 0; x < sp->width; x++) {
-        for (uint16_t y = 0; y < sp->height; y++) {
-            sp_offset = x + y * sp->height;
-            if (sp_offset > max_offset) {
-                return dy_err(DY_ERR_INVALID_ARG, "invalid sprite offset: %d", sp_offset);
-            }
-            buf->content[dy_gfx_get_px_pos(buf, bx + x, by + y)] = sp->data[sp_offset];
-        }
+        memmove(row + dst_x, &buf->content[src_y * w + src_x], n * sizeof(dy_gfx_px_t));
+        memset(row, 0, dst_x * sizeof(dy_gfx_px_t));
+        memset(row + dst_x + n, 0, (w - dst_x - n) * sizeof(dy_gfx_px_t));
     }
 
-    return dy_ok();
+    return DY_OK;
 }
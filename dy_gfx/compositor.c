@@ -0,0 +1,234 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "dy/gfx/compositor.h"
+
+static dy_gfx_area_t layer_area(const dy_gfx_layer_t *layer) {
+    return (dy_gfx_area_t) {layer->pos.x, layer->pos.y, layer->buf->width, layer->buf->height};
+}
+
+// Adds an area of the output buffer to the compositor's damage list.
+static void damage(dy_gfx_comp_t *comp, dy_gfx_area_t area) {
+    dy_gfx_area_t out = {0, 0, comp->out->width, comp->out->height};
+    dy_gfx_damage_add(&comp->damage, dy_gfx_area_intersect(area, out));
+}
+
+static void damage_layer(dy_gfx_layer_t *layer) {
+    if (layer->visible) {
+        damage(layer->comp, layer_area(layer));
+    }
+}
+
+dy_gfx_comp_t *dy_gfx_comp_new(uint16_t width, uint16_t height) {
+    dy_gfx_comp_t *comp = calloc(1, sizeof(dy_gfx_comp_t));
+    if (comp == NULL) {
+        return NULL;
+    }
+
+    comp->out = dy_gfx_new_buf(width, height);
+    if (comp->out == NULL) {
+        free(comp);
+        return NULL;
+    }
+
+    dy_gfx_comp_invalidate(comp);
+
+    return comp;
+}
+
+static void free_layer(dy_gfx_layer_t *layer) {
+    if (layer->own_buf) {
+        dy_gfx_free_buf(layer->buf);
+    }
+    free(layer);
+}
+
+void dy_gfx_comp_free(dy_gfx_comp_t *comp) {
+    for (uint8_t i = 0; i < comp->n_layers; i++) {
+        free_layer(comp->layers[i]);
+    }
+
+    dy_gfx_free_buf(comp->out);
+    free(comp);
+}
+
+// Inserts a layer into the z-ordered list; layers with equal z keep the order they were inserted in.
+static void insert_layer(dy_gfx_comp_t *comp, dy_gfx_layer_t *layer) {
+    uint8_t i = comp->n_layers++;
+    while (i > 0 && comp->layers[i - 1]->z > layer->z) {
+        comp->layers[i] = comp->layers[i - 1];
+        i--;
+    }
+    comp->layers[i] = layer;
+}
+
+static void unlink_layer(dy_gfx_comp_t *comp, dy_gfx_layer_t *layer) {
+    for (uint8_t i = 0; i < comp->n_layers; i++) {
+        if (comp->layers[i] == layer) {
+            memmove(&comp->layers[i], &comp->layers[i + 1], (comp->n_layers - i - 1) * sizeof(dy_gfx_layer_t *));
+            comp->n_layers--;
+            break;
+        }
+    }
+}
+
+static dy_gfx_layer_t *add_layer(dy_gfx_comp_t *comp, dy_gfx_buf_t *buf, dy_gfx_point_t pos, int8_t z) {
+    if (comp->n_layers == DY_GFX_COMP_LAYERS_MAX) {
+        return NULL;
+    }
+
+    dy_gfx_layer_t *layer = calloc(1, sizeof(dy_gfx_layer_t));
+    if (layer == NULL) {
+        return NULL;
+    }
+
+    layer->comp = comp;
+    layer->buf = buf;
+    layer->pos = pos;
+    layer->z = z;
+    layer->visible = true;
+    layer->blend = (dy_gfx_blend_t) {.mode = DY_GFX_BLEND_KEY};
+
+    insert_layer(comp, layer);
+
+    return layer;
+}
+
+dy_gfx_layer_t *dy_gfx_comp_add_buf_layer(dy_gfx_comp_t *comp, dy_gfx_buf_t *buf, dy_gfx_point_t pos, int8_t z) {
+    dy_gfx_layer_t *layer = add_layer(comp, buf, pos, z);
+    if (layer != NULL) {
+        damage_layer(layer);
+    }
+
+    return layer;
+}
+
+dy_gfx_layer_t *dy_gfx_comp_add_render_layer(dy_gfx_comp_t *comp, uint16_t width, uint16_t height,
+                                             dy_gfx_point_t pos, int8_t z, dy_gfx_layer_renderer_t renderer,
+                                             void *args) {
+    dy_gfx_buf_t *buf = dy_gfx_new_buf(width, height);
+    if (buf == NULL) {
+        return NULL;
+    }
+
+    dy_gfx_layer_t *layer = add_layer(comp, buf, pos, z);
+    if (layer == NULL) {
+        dy_gfx_free_buf(buf);
+        return NULL;
+    }
+
+    layer->own_buf = true;
+    layer->renderer = renderer;
+    layer->args = args;
+    dy_gfx_layer_invalidate(layer);
+
+    return layer;
+}
+
+void dy_gfx_comp_remove_layer(dy_gfx_layer_t *layer) {
+    dy_gfx_comp_t *comp = layer->comp;
+
+    damage_layer(layer);
+    unlink_layer(comp, layer);
+    free_layer(layer);
+}
+
+void dy_gfx_layer_set_pos(dy_gfx_layer_t *layer, dy_gfx_point_t pos) {
+    if (layer->pos.x == pos.x && layer->pos.y == pos.y) {
+        return;
+    }
+
+    damage_layer(layer);
+    layer->pos = pos;
+    damage_layer(layer);
+}
+
+void dy_gfx_layer_set_z(dy_gfx_layer_t *layer, int8_t z) {
+    // Only the layer's area is composited differently, whichever layers it now covers or uncovers
+    unlink_layer(layer->comp, layer);
+    layer->z = z;
+    insert_layer(layer->comp, layer);
+    damage_layer(layer);
+}
+
+void dy_gfx_layer_set_visible(dy_gfx_layer_t *layer, bool visible) {
+    if (layer->visible == visible) {
+        return;
+    }
+
+    // Damage is recorded while the layer is visible, i.e. before hiding or after showing it
+    damage_layer(layer);
+    layer->visible = visible;
+    damage_layer(layer);
+}
+
+void dy_gfx_layer_set_blend(dy_gfx_layer_t *layer, dy_gfx_blend_t blend) {
+    layer->blend = blend;
+    damage_layer(layer);
+}
+
+void dy_gfx_layer_invalidate(dy_gfx_layer_t *layer) {
+    layer->dirty = true;
+    damage_layer(layer);
+}
+
+void dy_gfx_layer_invalidate_area(dy_gfx_layer_t *layer, dy_gfx_area_t area) {
+    if (!layer->visible) {
+        return;
+    }
+
+    area.x += layer->pos.x;
+    area.y += layer->pos.y;
+    damage(layer->comp, dy_gfx_area_intersect(area, layer_area(layer)));
+}
+
+void dy_gfx_comp_invalidate(dy_gfx_comp_t *comp) {
+    damage(comp, (dy_gfx_area_t) {0, 0, comp->out->width, comp->out->height});
+}
+
+// Composites all visible layers within an area of the output buffer.
+static void composite(dy_gfx_comp_t *comp, dy_gfx_area_t area) {
+    for (int32_t y = area.y; y < area.y + area.height; y++) {
+        dy_gfx_px_t *p = &comp->out->content[dy_gfx_get_px_pos(comp->out, area.x, y)];
+        for (uint16_t n = 0; n < area.width; n++) {
+            *p++ = comp->background;
+        }
+    }
+
+    for (uint8_t i = 0; i < comp->n_layers; i++) {
+        dy_gfx_layer_t *layer = comp->layers[i];
+        if (!layer->visible) {
+            continue;
+        }
+
+        dy_gfx_area_t isect = dy_gfx_area_intersect(area, layer_area(layer));
+        if (isect.width == 0 || isect.height == 0) {
+            continue;
+        }
+
+        dy_gfx_area_t src = {isect.x - layer->pos.x, isect.y - layer->pos.y, isect.width, isect.height};
+        dy_gfx_merge_area(comp->out, layer->buf, (dy_gfx_point_t) {isect.x, isect.y}, src, &layer->blend);
+    }
+}
+
+dy_gfx_buf_t *dy_gfx_comp_render(dy_gfx_comp_t *comp, dy_gfx_damage_t *damage) {
+    for (uint8_t i = 0; i < comp->n_layers; i++) {
+        dy_gfx_layer_t *layer = comp->layers[i];
+        if (layer->dirty && layer->renderer != NULL) {
+            dy_gfx_clear_buf(layer->buf);
+            layer->renderer(layer->args, layer->buf);
+        }
+        layer->dirty = false;
+    }
+
+    for (uint8_t i = 0; i < comp->damage.len; i++) {
+        composite(comp, comp->damage.areas[i]);
+    }
+
+    if (damage != NULL) {
+        *damage = comp->damage;
+    }
+    dy_gfx_damage_reset(&comp->damage);
+
+    return comp->out;
+}
@@ -0,0 +1,116 @@
+#include "dy/gfx/csprite.h"
+
+// Blitting context.
+typedef struct {
+    dy_gfx_buf_t *buf;
+    dy_gfx_point_t pos;
+    const dy_gfx_csprite_t *sp;
+    bool flip_h;
+    bool flip_v;
+    bool keyed;
+} blit_t;
+
+// Writes a pixel given in sprite's coordinates, skipping invisible ones.
+static inline void put(const blit_t *b, int32_t x, int32_t y, uint8_t idx) {
+    if (idx >= b->sp->n_colors || (b->keyed && idx == 0)) {
+        return;
+    }
+
+    x = b->pos.x + (b->flip_h ? b->sp->width - 1 - x : x);
+    y = b->pos.y + (b->flip_v ? b->sp->height - 1 - y : y);
+    if (x < 0 || y < 0 || x >= b->buf->width || y >= b->buf->height) {
+        return;
+    }
+
+    b->buf->content[dy_gfx_get_px_pos(b->buf, x, y)] = b->sp->palette[idx];
+}
+
+static dy_err_t blit_packed(const blit_t *b) {
+    const dy_gfx_csprite_t *sp = b->sp;
+    uint8_t bpp = sp->bpp;
+
+    if (bpp != 1 && bpp != 2 && bpp != 4 && bpp != 8) {
+        return dy_err(DY_ERR_INVALID_ARG, "unsupported bpp: %d", bpp);
+    }
+
+    uint32_t stride = (sp->width * bpp + 7) / 8;
+    if (stride * sp->height > sp->data_len) {
+        return dy_err(DY_ERR_INVALID_ARG, "sprite data is too short");
+    }
+
+    uint8_t mask = (1 << bpp) - 1;
+    uint8_t per_byte = 8 / bpp;
+
+    for (int32_t y = 0; y < sp->height; y++) {
+        int32_t dy = b->pos.y + (b->flip_v ? sp->height - 1 - y : y);
+        if (dy < 0 || dy >= b->buf->height) {
+            continue; // rows are byte aligned, so invisible ones are skipped without decoding
+        }
+
+        const uint8_t *row = sp->data + y * stride;
+        for (int32_t x = 0; x < sp->width; x++) {
+            uint8_t shift = 8 - bpp * (x % per_byte + 1);
+            put(b, x, y, (row[x / per_byte] >> shift) & mask);
+        }
+    }
+
+    return dy_ok();
+}
+
+static dy_err_t blit_rle(const blit_t *b) {
+    const dy_gfx_csprite_t *sp = b->sp;
+    const uint8_t *p = sp->data, *end = sp->data + sp->data_len;
+    uint32_t n_px = sp->width * sp->height;
+    int32_t x = 0, y = 0;
+
+    for (uint32_t i = 0; i < n_px;) {
+        if (p >= end) {
+            return dy_err(DY_ERR_INVALID_ARG, "sprite data is too short");
+        }
+
+        uint8_t token = *p++;
+        uint8_t len = (token & 0x7F) + 1;
+        bool literal = token & 0x80;
+
+        if (p + (literal ? len : 1) > end || i + len > n_px) {
+            return dy_err(DY_ERR_INVALID_ARG, "malformed sprite data");
+        }
+
+        for (uint8_t n = 0; n < len; n++, i++) {
+            put(b, x, y, literal ? p[n] : *p);
+            if (++x == sp->width) {
+                x = 0;
+                y++;
+            }
+        }
+
+        p += literal ? len : 1;
+    }
+
+    return dy_ok();
+}
+
+dy_err_t dy_gfx_blit_csprite(dy_gfx_buf_t *buf, dy_gfx_point_t pos, const dy_gfx_csprite_t *sp, uint8_t flags) {
+    blit_t b = {
+            .buf = buf,
+            .pos = pos,
+            .sp = sp,
+            .flip_h = flags & DY_GFX_SPRITE_FLIP_H,
+            .flip_v = flags & DY_GFX_SPRITE_FLIP_V,
+            .keyed = flags & DY_GFX_SPRITE_KEY,
+    };
+
+    // Completely invisible sprites are not decoded at all
+    if (pos.x >= buf->width || pos.y >= buf->height || pos.x + sp->width <= 0 || pos.y + sp->height <= 0) {
+        return dy_ok();
+    }
+
+    switch (sp->encoding) {
+        case DY_GFX_CSPRITE_PACKED:
+            return blit_packed(&b);
+        case DY_GFX_CSPRITE_RLE:
+            return blit_rle(&b);
+        default:
+            return dy_err(DY_ERR_INVALID_ARG, "unsupported encoding: %d", sp->encoding);
+    }
+}
@@ -0,0 +1,95 @@
+#include "dy/gfx/damage.h"
+
+static int32_t min_i32(int32_t a, int32_t b) {
+    return a < b ? a : b;
+}
+
+static int32_t max_i32(int32_t a, int32_t b) {
+    return a > b ? a : b;
+}
+
+static int64_t area_size(dy_gfx_area_t a) {
+    return (int64_t) a.width * a.height;
+}
+
+// Checks whether two areas overlap or touch each other.
+static bool touches(dy_gfx_area_t a, dy_gfx_area_t b) {
+    return a.x <= b.x + b.width && b.x <= a.x + a.width &&
+           a.y <= b.y + b.height && b.y <= a.y + a.height;
+}
+
+dy_gfx_area_t dy_gfx_area_intersect(dy_gfx_area_t a, dy_gfx_area_t b) {
+    int32_t x1 = max_i32(a.x, b.x), y1 = max_i32(a.y, b.y);
+    int32_t x2 = min_i32(a.x + a.width, b.x + b.width), y2 = min_i32(a.y + a.height, b.y + b.height);
+
+    if (x2 <= x1 || y2 <= y1) {
+        return (dy_gfx_area_t) {x1, y1, 0, 0};
+    }
+
+    return (dy_gfx_area_t) {x1, y1, x2 - x1, y2 - y1};
+}
+
+dy_gfx_area_t dy_gfx_area_union(dy_gfx_area_t a, dy_gfx_area_t b) {
+    int32_t x1 = min_i32(a.x, b.x), y1 = min_i32(a.y, b.y);
+    int32_t x2 = max_i32(a.x + a.width, b.x + b.width), y2 = max_i32(a.y + a.height, b.y + b.height);
+
+    return (dy_gfx_area_t) {x1, y1, x2 - x1, y2 - y1};
+}
+
+void dy_gfx_damage_reset(dy_gfx_damage_t *dmg) {
+    dmg->len = 0;
+}
+
+static void remove_at(dy_gfx_damage_t *dmg, uint8_t i) {
+    dmg->areas[i] = dmg->areas[--dmg->len];
+}
+
+void dy_gfx_damage_add(dy_gfx_damage_t *dmg, dy_gfx_area_t area) {
+    if (area.width == 0 || area.height == 0) {
+        return;
+    }
+
+    // Coalesce with every touching area; the union may now touch other areas, so repeat until stable
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (uint8_t i = 0; i < dmg->len; i++) {
+            if (touches(dmg->areas[i], area)) {
+                area = dy_gfx_area_union(dmg->areas[i], area);
+                remove_at(dmg, i);
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    if (dmg->len < DY_GFX_DAMAGE_MAX) {
+        dmg->areas[dmg->len++] = area;
+        return;
+    }
+
+    // The list is full: merge into the area whose bounding box grows the least
+    uint8_t best = 0;
+    int64_t best_growth = INT64_MAX;
+    for (uint8_t i = 0; i < dmg->len; i++) {
+        int64_t growth = area_size(dy_gfx_area_union(dmg->areas[i], area)) - area_size(dmg->areas[i]);
+        if (growth < best_growth) {
+            best = i;
+            best_growth = growth;
+        }
+    }
+
+    area = dy_gfx_area_union(dmg->areas[best], area);
+    remove_at(dmg, best);
+    dy_gfx_damage_add(dmg, area);
+}
+
+void dy_gfx_damage_add_all(dy_gfx_damage_t *dmg, const dy_gfx_damage_t *src) {
+    for (uint8_t i = 0; i < src->len; i++) {
+        dy_gfx_damage_add(dmg, src->areas[i]);
+    }
+}
+
+bool dy_gfx_damage_is_empty(const dy_gfx_damage_t *dmg) {
+    return dmg->len == 0;
+}
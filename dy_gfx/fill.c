@@ -0,0 +1,174 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "dy/gfx/gfx.h"
+
+// Buffer content is processed as 32-bit words wherever its alignment allows, with bytewise heads and tails.
+
+#define WORD_SIZE sizeof(uint32_t)
+
+static size_t content_size(const dy_gfx_buf_t *buf) {
+    return buf->width * buf->height * sizeof(dy_gfx_px_t);
+}
+
+// Returns the number of bytes preceding the first word-aligned address, limited by n.
+static size_t head_len(const uint8_t *p, size_t n) {
+    size_t head = (WORD_SIZE - ((uintptr_t) p & (WORD_SIZE - 1))) & (WORD_SIZE - 1);
+    return head < n ? head : n;
+}
+
+void dy_gfx_fill(dy_gfx_buf_t *buf, dy_gfx_px_t px) {
+    uint8_t *p = (uint8_t *) buf->content;
+    size_t n = content_size(buf);
+    const uint8_t rgb[3] = {px.r, px.g, px.b};
+
+    if (px.r == px.g && px.g == px.b) {
+        memset(p, px.r, n);
+        return;
+    }
+
+    size_t head = head_len(p, n);
+    for (size_t i = 0; i < head; i++) {
+        *p++ = rgb[i % 3];
+    }
+    n -= head;
+
+    // Four pixels take three words; the pattern starts from the channel the head stopped at
+    uint8_t pattern[3 * WORD_SIZE];
+    for (size_t i = 0; i < sizeof(pattern); i++) {
+        pattern[i] = rgb[(head + i) % 3];
+    }
+
+    uint32_t w[3];
+    memcpy(w, pattern, sizeof(w));
+
+    uint32_t *wp = (uint32_t *) p;
+    for (; n >= sizeof(w); n -= sizeof(w)) {
+        *wp++ = w[0];
+        *wp++ = w[1];
+        *wp++ = w[2];
+    }
+
+    p = (uint8_t *) wp;
+    for (size_t i = 0; i < n; i++) {
+        *p++ = pattern[i];
+    }
+}
+
+// Sets the top bit of every byte of x which is not less than the same byte of l.
+static inline uint32_t bytes_ge(uint32_t x, uint32_t l) {
+    uint32_t d = (x | 0x80808080) - (l & 0x7F7F7F7F); // compares the low 7 bits without borrows between bytes
+    return ((x & ~l) | (~(x ^ l) & d)) & 0x80808080;
+}
+
+static inline void colorize_px(dy_gfx_px_t *p, dy_gfx_px_t px) {
+    if (p->r | p->g | p->b) {
+        *p = px;
+    }
+}
+
+static inline void threshold_px(dy_gfx_px_t *p, uint8_t level) {
+    if (p->r < level && p->g < level && p->b < level) {
+        *p = (dy_gfx_px_t) {0, 0, 0};
+    }
+}
+
+// Both kernels check groups of four pixels, which take three words, at once and go pixel by pixel only through
+// groups having lit pixels, so mostly black content, as on clock faces, is mostly processed a word at a time. Pixels
+// are 3 bytes long, so one of the first four starts a group at a word boundary.
+
+void dy_gfx_colorize(dy_gfx_buf_t *buf, dy_gfx_px_t px) {
+    dy_gfx_px_t *p = buf->content;
+    dy_gfx_px_t *end = p + buf->width * buf->height;
+
+    for (; p < end && ((uintptr_t) p & (WORD_SIZE - 1)) != 0; p++) {
+        colorize_px(p, px);
+    }
+
+    for (; end - p >= 4; p += 4) {
+        const uint32_t *wp = (const uint32_t *) p;
+        if ((wp[0] | wp[1] | wp[2]) != 0) {
+            colorize_px(p, px);
+            colorize_px(p + 1, px);
+            colorize_px(p + 2, px);
+            colorize_px(p + 3, px);
+        }
+    }
+
+    for (; p < end; p++) {
+        colorize_px(p, px);
+    }
+}
+
+void dy_gfx_invert(dy_gfx_buf_t *buf) {
+    uint8_t *p = (uint8_t *) buf->content;
+    size_t n = content_size(buf);
+
+    size_t head = head_len(p, n);
+    for (n -= head; head > 0; head--, p++) {
+        *p = ~*p;
+    }
+
+    uint32_t *wp = (uint32_t *) p;
+    for (; n >= WORD_SIZE; n -= WORD_SIZE, wp++) {
+        *wp = ~*wp;
+    }
+
+    for (p = (uint8_t *) wp; n > 0; n--, p++) {
+        *p = ~*p;
+    }
+}
+
+void dy_gfx_threshold(dy_gfx_buf_t *buf, uint8_t level) {
+    dy_gfx_px_t *p = buf->content;
+    dy_gfx_px_t *end = p + buf->width * buf->height;
+    uint32_t l = level * 0x01010101u;
+
+    for (; p < end && ((uintptr_t) p & (WORD_SIZE - 1)) != 0; p++) {
+        threshold_px(p, level);
+    }
+
+    for (; end - p >= 4; p += 4) {
+        uint32_t *wp = (uint32_t *) p;
+        if ((bytes_ge(wp[0], l) | bytes_ge(wp[1], l) | bytes_ge(wp[2], l)) == 0) {
+            wp[0] = wp[1] = wp[2] = 0;
+        } else {
+            threshold_px(p, level);
+            threshold_px(p + 1, level);
+            threshold_px(p + 2, level);
+            threshold_px(p + 3, level);
+        }
+    }
+
+    for (; p < end; p++) {
+        threshold_px(p, level);
+    }
+}
+
+void dy_gfx_scale(dy_gfx_buf_t *buf, uint8_t scale) {
+    uint8_t *p = (uint8_t *) buf->content;
+    size_t n = content_size(buf);
+    uint32_t s = scale + 1; // 1..256, so 255 keeps values intact
+
+    if (scale == 255) {
+        return;
+    }
+
+    size_t head = head_len(p, n);
+    for (n -= head; head > 0; head--, p++) {
+        *p = (*p * s) >> 8;
+    }
+
+    // Two 16-bit lanes per multiplication; a lane can not overflow since 255 * 256 < 65536
+    uint32_t *wp = (uint32_t *) p;
+    for (; n >= WORD_SIZE; n -= WORD_SIZE, wp++) {
+        uint32_t w = *wp;
+        uint32_t even = (((w & 0x00FF00FF) * s) >> 8) & 0x00FF00FF;
+        uint32_t odd = (((w >> 8) & 0x00FF00FF) * s) & 0xFF00FF00;
+        *wp = even | odd;
+    }
+
+    for (p = (uint8_t *) wp; n > 0; n--, p++) {
+        *p = (*p * s) >> 8;
+    }
+}
@@ -0,0 +1,249 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "dy/util/uthash.h"
+#include "dy/gfx/sprite.h"
+#include "dy/gfx/csprite.h"
+#include "dy/gfx/framecache.h"
+
+#define MAX_COLORS 256
+
+struct dy_gfx_fcache_item {
+    uint64_t key; // anim_id << 32 | frame_n
+    size_t size;  // total allocated size
+    uint16_t width;
+    uint16_t height;
+    uint8_t bpp;
+    bool keyable; // palette index 0 is black
+    uint16_t n_colors;
+    uint32_t data_len;
+    dy_gfx_px_t *palette;
+    uint8_t *data;
+    UT_hash_handle hh;
+};
+
+static inline uint64_t make_key(uint16_t anim_id, uint32_t frame_n) {
+    return (uint64_t) anim_id << 32 | frame_n;
+}
+
+static inline bool px_eq(dy_gfx_px_t a, dy_gfx_px_t b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+static void remove_item(dy_gfx_fcache_t *cache, dy_gfx_fcache_item_t *item) {
+    HASH_DELETE(hh, cache->items, item);
+    cache->stats.used -= item->size;
+    cache->stats.n_frames--;
+    free(item);
+}
+
+static void draw_item(const dy_gfx_fcache_item_t *item, dy_gfx_buf_t *buf, dy_gfx_point_t pos, uint8_t flags) {
+    if (!item->keyable) {
+        flags &= ~DY_GFX_SPRITE_KEY; // there is no black to key out
+    }
+
+    dy_gfx_csprite_t sp = {
+        .width = item->width,
+        .height = item->height,
+        .encoding = DY_GFX_CSPRITE_PACKED,
+        .bpp = item->bpp,
+        .n_colors = item->n_colors,
+        .palette = item->palette,
+        .data_len = item->data_len,
+        .data = item->data,
+    };
+
+    dy_gfx_blit_csprite(buf, pos, &sp, flags);
+}
+
+// Builds a palette of a frame; black, if present, gets index 0, so it can be keyed out.
+// Returns number of colours or 0 if there are more than MAX_COLORS or no pixels at all.
+static uint16_t make_palette(const dy_gfx_buf_t *buf, dy_gfx_px_t *palette) {
+    uint32_t n_px = buf->width * buf->height;
+    uint16_t n = 1, last = 0;
+
+    if (n_px == 0) {
+        return 0;
+    }
+
+    palette[0] = buf->content[0];
+    for (uint32_t i = 1; i < n_px; i++) {
+        dy_gfx_px_t px = buf->content[i];
+        if (px_eq(px, palette[last])) {
+            continue;
+        }
+
+        for (last = 0; last < n && !px_eq(px, palette[last]); last++);
+        if (last == n) {
+            if (n == MAX_COLORS) {
+                return 0;
+            }
+            palette[n++] = px;
+        }
+    }
+
+    for (uint16_t i = 1; i < n; i++) {
+        if (px_eq(palette[i], (dy_gfx_px_t) {0})) {
+            palette[i] = palette[0];
+            palette[0] = (dy_gfx_px_t) {0};
+            break;
+        }
+    }
+
+    return n;
+}
+
+// Encodes a frame into a new cache item.
+static dy_gfx_fcache_item_t *encode(const dy_gfx_buf_t *buf, uint64_t key) {
+    dy_gfx_px_t palette[MAX_COLORS];
+
+    uint16_t n_colors = make_palette(buf, palette);
+    if (n_colors == 0) {
+        return NULL;
+    }
+
+    uint8_t bpp = n_colors <= 2 ? 1 : n_colors <= 4 ? 2 : n_colors <= 16 ? 4 : 8;
+    uint32_t stride = (buf->width * bpp + 7) / 8;
+    uint32_t data_len = stride * buf->height;
+    size_t size = sizeof(dy_gfx_fcache_item_t) + n_colors * sizeof(dy_gfx_px_t) + data_len;
+
+    dy_gfx_fcache_item_t *item = calloc(1, size);
+    if (item == NULL) {
+        return NULL;
+    }
+
+    item->key = key;
+    item->size = size;
+    item->width = buf->width;
+    item->height = buf->height;
+    item->bpp = bpp;
+    item->keyable = px_eq(palette[0], (dy_gfx_px_t) {0});
+    item->n_colors = n_colors;
+    item->data_len = data_len;
+    item->palette = (dy_gfx_px_t *) (item + 1);
+    item->data = (uint8_t *) (item->palette + n_colors);
+    memcpy(item->palette, palette, n_colors * sizeof(dy_gfx_px_t));
+
+    uint8_t per_byte = 8 / bpp;
+    uint16_t idx = 0;
+    for (uint16_t y = 0; y < buf->height; y++) {
+        const dy_gfx_px_t *row = buf->content + y * buf->width;
+        uint8_t *dst = item->data + y * stride;
+
+        for (uint16_t x = 0; x < buf->width; x++) {
+            if (!px_eq(row[x], palette[idx])) {
+                for (idx = 0; !px_eq(row[x], palette[idx]); idx++);
+            }
+            dst[x / per_byte] |= idx << (8 - bpp * (x % per_byte + 1));
+        }
+    }
+
+    return item;
+}
+
+dy_gfx_fcache_t *dy_gfx_fcache_new(size_t capacity) {
+    dy_gfx_fcache_t *cache = calloc(1, sizeof(dy_gfx_fcache_t));
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    cache->stats.capacity = capacity;
+
+    return cache;
+}
+
+void dy_gfx_fcache_free(dy_gfx_fcache_t *cache) {
+    dy_gfx_fcache_item_t *item, *tmp;
+
+    HASH_ITER(hh, cache->items, item, tmp) {
+        remove_item(cache, item);
+    }
+
+    if (cache->scratch != NULL) {
+        dy_gfx_free_buf(cache->scratch);
+    }
+
+    free(cache);
+}
+
+dy_err_t dy_gfx_fcache_draw(dy_gfx_fcache_t *cache, dy_gfx_buf_t *buf, dy_gfx_point_t pos, uint16_t anim_id,
+                            uint32_t frame_n, uint16_t width, uint16_t height, dy_gfx_frame_renderer_t renderer,
+                            void *args, uint8_t flags) {
+    dy_gfx_fcache_item_t *item = NULL;
+    uint64_t key = make_key(anim_id, frame_n);
+
+    HASH_FIND(hh, cache->items, &key, sizeof(key), item);
+    if (item != NULL && item->width == width && item->height == height) {
+        // Re-insert to make the item most recently used
+        HASH_DELETE(hh, cache->items, item);
+        HASH_ADD(hh, cache->items, key, sizeof(key), item);
+
+        cache->stats.hits++;
+        draw_item(item, buf, pos, flags);
+
+        return dy_ok();
+    } else if (item != NULL) {
+        remove_item(cache, item); // frame size has changed
+    }
+
+    cache->stats.misses++;
+
+    // Render buffer
+    uint32_t n_px = (uint32_t) width * height;
+    if (cache->scratch == NULL || cache->scratch_len < n_px) {
+        if (cache->scratch != NULL) {
+            dy_gfx_free_buf(cache->scratch);
+        }
+        if ((cache->scratch = dy_gfx_new_buf(width, height)) == NULL) {
+            cache->scratch_len = 0;
+            return dy_err(DY_ERR_NO_MEM, "dy_gfx_new_buf failed");
+        }
+        cache->scratch_len = n_px;
+    }
+
+    // The buffer is allocated in a single block, so it can be reshaped within its capacity
+    dy_gfx_buf_t *scratch = cache->scratch;
+    scratch->width = width;
+    scratch->height = height;
+    dy_gfx_clear_buf(scratch);
+    renderer(args, scratch, frame_n);
+
+    item = encode(scratch, key);
+    if (item == NULL || item->size > cache->stats.capacity) {
+        free(item);
+        cache->stats.n_skipped++;
+
+        dy_gfx_sprite_t sp = {.width = width, .height = height, .data = scratch->content};
+        dy_gfx_blit_sprite(buf, pos, &sp, flags, (dy_gfx_px_t) {0});
+
+        return dy_ok();
+    }
+
+    // Evict least recently used frames
+    while (cache->stats.used + item->size > cache->stats.capacity) {
+        remove_item(cache, cache->items);
+        cache->stats.evictions++;
+    }
+
+    HASH_ADD(hh, cache->items, key, sizeof(key), item);
+    cache->stats.used += item->size;
+    cache->stats.n_frames++;
+
+    draw_item(item, buf, pos, flags);
+
+    return dy_ok();
+}
+
+void dy_gfx_fcache_drop(dy_gfx_fcache_t *cache, uint16_t anim_id) {
+    dy_gfx_fcache_item_t *item, *tmp;
+
+    HASH_ITER(hh, cache->items, item, tmp) {
+        if (item->key >> 32 == anim_id) {
+            remove_item(cache, item);
+        }
+    }
+}
+
+dy_gfx_fcache_stats_t dy_gfx_fcache_stats(const dy_gfx_fcache_t *cache) {
+    return cache->stats;
+}
@@ -1,41 +1,190 @@
+#include <stdbool.h>
 #include <stdlib.h>
 
 #include "dy/gfx/geometry.h"
 
-void dy_gfx_line(dy_gfx_buf_t *buf, const dy_gfx_line_t *line, dy_gfx_px_t color) {
-    uint16_t x1 = line->p1.x, x2 = line->p2.x, y1 = line->p1.y, y2 = line->p2.y;
+// Cohen–Sutherland outcodes
+#define OUT_LEFT 0x1
+#define OUT_RIGHT 0x2
+#define OUT_TOP 0x4
+#define OUT_BOTTOM 0x8
+
+static uint8_t outcode(const dy_gfx_buf_t *buf, int32_t x, int32_t y) {
+    uint8_t code = 0;
+
+    if (x < 0) {
+        code |= OUT_LEFT;
+    } else if (x >= buf->width) {
+        code |= OUT_RIGHT;
+    }
+
+    if (y < 0) {
+        code |= OUT_TOP;
+    } else if (y >= buf->height) {
+        code |= OUT_BOTTOM;
+    }
+
+    return code;
+}
+
+// Rounds a / b towards negative infinity; b must be positive.
+static int64_t div_floor(int64_t a, int64_t b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+// Divides 2 * m * n + c by 2 * d, rounding towards negative infinity, for 0 <= m, n < 2^32, |c| <= d and d > 0;
+// stores the non-negative remainder if rem is not NULL. 2 * m * n may not fit 64 bits for lines spanning the whole
+// coordinate range, so m * n = p * d + r is divided first, leaving (2 * r + c) / (2 * d).
+static int64_t div_wide(int64_t m, int64_t n, int64_t c, int64_t d, int64_t *rem) {
+    uint64_t mn = (uint64_t) m * (uint64_t) n;
+    int64_t r = 2 * (int64_t) (mn % (uint64_t) d) + c;
+    int64_t q = div_floor(r, 2 * d);
+
+    if (rem != NULL) {
+        *rem = r - q * 2 * d;
+    }
+
+    return (int64_t) (mn / (uint64_t) d) + q;
+}
 
+// Same as div_wide(), rounding towards positive infinity.
+static int64_t div_wide_ceil(int64_t m, int64_t n, int64_t c, int64_t d) {
+    int64_t rem;
+    int64_t q = div_wide(m, n, c, d, &rem);
+
+    return rem != 0 ? q + 1 : q;
+}
+
+static void swap_i32(int32_t *a, int32_t *b) {
+    int32_t t = *a;
+    *a = *b;
+    *b = t;
+}
+
+void dy_gfx_hline(dy_gfx_buf_t *buf, int32_t x1, int32_t x2, int32_t y, dy_gfx_px_t color) {
+    if (x1 > x2) {
+        swap_i32(&x1, &x2);
+    }
+
+    if (y < 0 || y >= buf->height || x2 < 0 || x1 >= buf->width) {
+        return;
+    }
+
+    if (x1 < 0) {
+        x1 = 0;
+    }
     if (x2 >= buf->width) {
         x2 = buf->width - 1;
     }
+
+    dy_gfx_px_t *p = &buf->content[y * buf->width + x1];
+    for (int32_t n = x2 - x1 + 1; n > 0; n--) {
+        *p++ = color;
+    }
+}
+
+void dy_gfx_vline(dy_gfx_buf_t *buf, int32_t x, int32_t y1, int32_t y2, dy_gfx_px_t color) {
+    if (y1 > y2) {
+        swap_i32(&y1, &y2);
+    }
+
+    if (x < 0 || x >= buf->width || y2 < 0 || y1 >= buf->height) {
+        return;
+    }
+
+    if (y1 < 0) {
+        y1 = 0;
+    }
     if (y2 >= buf->height) {
         y2 = buf->height - 1;
     }
 
-    float x = x1, y = y1, dx = x2 - x1, dy = y2 - y1;
-    uint16_t step, abs_dx = abs(dx), abs_dy = abs(dy);
+    dy_gfx_px_t *p = &buf->content[y1 * buf->width + x];
+    for (int32_t n = y2 - y1 + 1; n > 0; n--) {
+        *p = color;
+        p += buf->width;
+    }
+}
 
-    step = abs_dx >= abs_dy ? abs_dx : abs_dy;
-    dx /= step;
-    dy /= step;
+void dy_gfx_line(dy_gfx_buf_t *buf, const dy_gfx_line_t *line, dy_gfx_px_t color) {
+    int32_t x1 = line->p1.x, y1 = line->p1.y, x2 = line->p2.x, y2 = line->p2.y;
 
-    uint16_t i = 0;
-    while (i <= step) {
-        if (i == step) {
-            if (x < x2) {
-                x = x2;
-            }
-            if (y < y2) {
-                y = y2;
-            }
+    if (y1 == y2) {
+        dy_gfx_hline(buf, x1, x2, y1, color);
+        return;
+    }
+    if (x1 == x2) {
+        dy_gfx_vline(buf, x1, y1, y2, color);
+        return;
+    }
+
+    uint8_t oc1 = outcode(buf, x1, y1), oc2 = outcode(buf, x2, y2);
+    if (oc1 & oc2) {
+        return; // both ends lie on the same outer side of the buffer
+    }
+
+    int64_t dx = llabs((int64_t) x2 - x1), dy = llabs((int64_t) y2 - y1);
+    int32_t sx = x2 > x1 ? 1 : -1, sy = y2 > y1 ? 1 : -1;
+
+    // The line is traced along its major axis "a"; the minor axis "b" advances
+    // by q(k) = floor((2 * k * db + da) / (2 * da)) after k steps, k = 0..da.
+    bool x_major = dx >= dy;
+    int64_t da = x_major ? dx : dy, db = x_major ? dy : dx;
+    int32_t a0 = x_major ? x1 : y1, b0 = x_major ? y1 : x1;
+    int32_t sa = x_major ? sx : sy, sb = x_major ? sy : sx;
+    int32_t a_len = x_major ? buf->width : buf->height, b_len = x_major ? buf->height : buf->width;
+
+    int64_t k_lo = 0, k_hi = da;
+
+    // Clip against the buffer rectangle only if at least one end is outside of it
+    if (oc1 | oc2) {
+        // Major axis bounds translate to step indices directly
+        int64_t lo = sa > 0 ? -(int64_t) a0 : (int64_t) a0 - (a_len - 1);
+        int64_t hi = sa > 0 ? (int64_t) a_len - 1 - a0 : (int64_t) a0;
+        if (lo > k_lo) {
+            k_lo = lo;
+        }
+        if (hi < k_hi) {
+            k_hi = hi;
+        }
+
+        // Minor axis bounds are found by inverting q(k); q(k) stays within [0, db], so bounds outside of it
+        // don't limit k
+        int64_t q_lo = sb > 0 ? -(int64_t) b0 : (int64_t) b0 - (b_len - 1);
+        int64_t q_hi = sb > 0 ? (int64_t) b_len - 1 - b0 : (int64_t) b0;
+        if (q_lo > db || q_hi < 0) {
+            return;
+        }
+        if (q_lo > 0 && (lo = div_wide_ceil(da, q_lo, -da, db)) > k_lo) {
+            k_lo = lo;
         }
+        if (q_hi < db && (hi = div_wide_ceil(da, q_hi, da, db) - 1) < k_hi) {
+            k_hi = hi;
+        }
+
+        if (k_lo > k_hi) {
+            return;
+        }
+    }
 
-        dy_gfx_set_px(buf, abs(x), abs(y), color);
+    int64_t rem;
+    int64_t q = div_wide(k_lo, db, da, da, &rem);
+    int32_t a = (int32_t) (a0 + sa * k_lo), b = (int32_t) (b0 + sb * q); // both are within the buffer
 
-        x += dx;
-        y += dy;
+    int32_t x = x_major ? a : b, y = x_major ? b : a;
+    int32_t step_a = x_major ? sa : sa * buf->width;
+    int32_t step_b = x_major ? sb * buf->width : sb;
 
-        ++i;
+    dy_gfx_px_t *p = &buf->content[y * buf->width + x];
+    for (int64_t k = k_lo; k <= k_hi; k++) {
+        *p = color;
+        p += step_a;
+
+        rem += 2 * db;
+        if (rem >= 2 * da) {
+            rem -= 2 * da;
+            p += step_b;
+        }
     }
 }
 
@@ -54,17 +203,153 @@ void dy_gfx_poly(dy_gfx_buf_t *buf, const dy_gfx_poly_t *poly, dy_gfx_px_t color
 }
 
 void dy_gfx_rect(dy_gfx_buf_t *buf, dy_gfx_point_t p1, dy_gfx_point_t p2, dy_gfx_px_t color) {
-    dy_gfx_point_t points[4] = {
-            p1,
-            (dy_gfx_point_t) {p2.x, p1.y},
-            p2,
-            (dy_gfx_point_t) {p1.x, p2.y},
-    };
-
-    dy_gfx_poly(buf, &((dy_gfx_poly_t) {4, points}), color);
+    dy_gfx_hline(buf, p1.x, p2.x, p1.y, color);
+    dy_gfx_hline(buf, p1.x, p2.x, p2.y, color);
+    dy_gfx_vline(buf, p1.x, p1.y, p2.y, color);
+    dy_gfx_vline(buf, p2.x, p1.y, p2.y, color);
 }
 
 void dy_gfx_tri(dy_gfx_buf_t *buf, dy_gfx_point_t p1, dy_gfx_point_t p2, dy_gfx_point_t p3, dy_gfx_px_t color) {
     dy_gfx_point_t points[3] = {p1, p2, p3};
     dy_gfx_poly(buf, &((dy_gfx_poly_t) {3, points}), color);
 }
+
+void dy_gfx_fill_rect(dy_gfx_buf_t *buf, dy_gfx_point_t p1, dy_gfx_point_t p2, dy_gfx_px_t color) {
+    int32_t y1 = p1.y, y2 = p2.y;
+    if (y1 > y2) {
+        swap_i32(&y1, &y2);
+    }
+
+    if (y1 < 0) {
+        y1 = 0;
+    }
+    if (y2 >= buf->height) {
+        y2 = buf->height - 1;
+    }
+
+    for (int32_t y = y1; y <= y2; y++) {
+        dy_gfx_hline(buf, p1.x, p2.x, y, color);
+    }
+}
+
+void dy_gfx_fill_poly(dy_gfx_buf_t *buf, const dy_gfx_poly_t *poly, dy_gfx_px_t color) {
+    if (poly->n_corners == 0) {
+        return;
+    }
+
+    int32_t y_min = poly->edges[0].y, y_max = poly->edges[0].y;
+    for (uint8_t i = 1; i < poly->n_corners; i++) {
+        if (poly->edges[i].y < y_min) {
+            y_min = poly->edges[i].y;
+        }
+        if (poly->edges[i].y > y_max) {
+            y_max = poly->edges[i].y;
+        }
+    }
+
+    if (y_min < 0) {
+        y_min = 0;
+    }
+    if (y_max > buf->height) {
+        y_max = buf->height;
+    }
+
+    // Each scanline is crossed by every edge at most once
+    int32_t xs[poly->n_corners];
+
+    for (int32_t y = y_min; y < y_max; y++) {
+        uint8_t n = 0;
+
+        for (uint8_t i = 0; i < poly->n_corners; i++) {
+            dy_gfx_point_t a = poly->edges[i];
+            dy_gfx_point_t b = poly->edges[i + 1 < poly->n_corners ? i + 1 : 0];
+
+            // Top-inclusive, bottom-exclusive, so shared vertices are counted once
+            if (!((a.y <= y && y < b.y) || (b.y <= y && y < a.y))) {
+                continue;
+            }
+
+            int64_t ey = (int64_t) b.y - a.y, ex = (int64_t) b.x - a.x;
+            if (ey < 0) {
+                ey = -ey;
+                ex = -ex;
+                a = b;
+            }
+
+            // x = a.x + floor((2 * (y - a.y) * ex + ey) / (2 * ey)), which lies between a.x and b.x
+            int64_t t = (int64_t) y - a.y;
+            int64_t dx = ex >= 0 ? div_wide(t, ex, ey, ey, NULL) : -div_wide_ceil(t, -ex, -ey, ey);
+            int32_t x = (int32_t) (a.x + dx);
+
+            // Insertion sort: the number of crossings per scanline is small
+            uint8_t k = n++;
+            while (k > 0 && xs[k - 1] > x) {
+                xs[k] = xs[k - 1];
+                k--;
+            }
+            xs[k] = x;
+        }
+
+        // Even-odd rule, which handles both convex and concave polygons
+        for (uint8_t i = 0; i + 1 < n; i += 2) {
+            dy_gfx_hline(buf, xs[i], xs[i + 1], y, color);
+        }
+    }
+
+    // Scanlines sample the polygon's interior only, the outline completes the bottom and right edges
+    dy_gfx_poly(buf, poly, color);
+}
+
+void dy_gfx_fill_tri(dy_gfx_buf_t *buf, dy_gfx_point_t p1, dy_gfx_point_t p2, dy_gfx_point_t p3, dy_gfx_px_t color) {
+    dy_gfx_point_t points[3] = {p1, p2, p3};
+    dy_gfx_fill_poly(buf, &((dy_gfx_poly_t) {3, points}), color);
+}
+
+// Fills four quarter-circles of radius r centered at the corners of the (x1, y1)-(x2, y2) rectangle,
+// along with the horizontal spans connecting them.
+static void fill_quadrants(dy_gfx_buf_t *buf, int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t r,
+                           dy_gfx_px_t color) {
+    int64_t r2 = (int64_t) r * r + r;
+    int32_t w = r;
+
+    for (int32_t dy = 0; dy <= r; dy++) {
+        while (w > 0 && (int64_t) w * w + (int64_t) dy * dy > r2) {
+            w--;
+        }
+
+        dy_gfx_hline(buf, x1 - w, x2 + w, y1 - dy, color);
+        if (dy > 0 || y1 != y2) {
+            dy_gfx_hline(buf, x1 - w, x2 + w, y2 + dy, color);
+        }
+    }
+}
+
+void dy_gfx_fill_circle(dy_gfx_buf_t *buf, dy_gfx_point_t center, uint16_t radius, dy_gfx_px_t color) {
+    fill_quadrants(buf, center.x, center.y, center.x, center.y, radius, color);
+}
+
+void dy_gfx_fill_round_rect(dy_gfx_buf_t *buf, dy_gfx_point_t p1, dy_gfx_point_t p2, uint16_t radius,
+                            dy_gfx_px_t color) {
+    if (p1.x > p2.x) {
+        swap_i32(&p1.x, &p2.x);
+    }
+    if (p1.y > p2.y) {
+        swap_i32(&p1.y, &p2.y);
+    }
+
+    // Corners must not overlap; sides are 64-bit, as they may exceed the coordinate range
+    int64_t w = (int64_t) p2.x - p1.x, h = (int64_t) p2.y - p1.y;
+    int32_t r = radius;
+    if (2 * r > w) {
+        r = (int32_t) (w / 2);
+    }
+    if (2 * r > h) {
+        r = (int32_t) (h / 2);
+    }
+
+    fill_quadrants(buf, p1.x + r, p1.y + r, p2.x - r, p2.y - r, r, color);
+
+    if (h - 2 * r - 2 >= 0) {
+        dy_gfx_fill_rect(buf, (dy_gfx_point_t) {p1.x, p1.y + r + 1}, (dy_gfx_point_t) {p2.x, p2.y - r - 1}, color);
+    }
+}
@@ -0,0 +1,103 @@
+/**
+ * @brief Fragmentation-free allocators for graphics buffers.
+ *
+ * An arena hands out buffers from one pre-allocated block and releases all of them at once
+ * by `dy_gfx_arena_reset()`, which suits per-frame temporaries. A pool holds a fixed number of
+ * equally sized blocks, which suits long-lived buffers of bounded size.
+ *
+ * Buffers obtained from an arena or a pool must not be passed to `dy_gfx_free_buf()`.
+ *
+ * @warning It is NOT thread-safe.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "dy/gfx/gfx.h"
+
+/**
+ * Allocator statistics.
+ */
+typedef struct {
+    size_t capacity;   // total number of bytes (arena) or blocks (pool)
+    size_t used;       // currently used bytes (arena) or blocks (pool)
+    size_t high_water; // maximum of `used` since creation
+    uint32_t n_allocs; // number of successful allocations
+    uint32_t n_fails;  // number of failed allocations
+} dy_gfx_alloc_stats_t;
+
+/**
+ * Buffer arena.
+ */
+typedef struct {
+    uint8_t *mem;
+    dy_gfx_alloc_stats_t stats;
+} dy_gfx_arena_t;
+
+/**
+ * Buffer pool.
+ */
+typedef struct {
+    uint8_t *mem;
+    size_t block_size;
+    uint32_t max_px;   // maximum number of pixels per buffer
+    uint8_t *free_map; // one bit per block, set if the block is free
+    dy_gfx_alloc_stats_t stats;
+} dy_gfx_pool_t;
+
+/**
+ * Creates an arena of a given size in bytes; the arena and its memory are allocated as a single block.
+ */
+dy_gfx_arena_t *dy_gfx_arena_new(size_t size);
+
+/**
+ * Frees resources allocated by `dy_gfx_arena_new()`; all buffers allocated from the arena become invalid.
+ */
+void dy_gfx_arena_free(dy_gfx_arena_t *arena);
+
+/**
+ * Allocates a zeroed buffer from an arena.
+ *
+ * @return A buffer or NULL if the arena has not enough room.
+ */
+dy_gfx_buf_t *dy_gfx_arena_new_buf(dy_gfx_arena_t *arena, uint16_t width, uint16_t height);
+
+/**
+ * Releases all buffers allocated from an arena.
+ */
+void dy_gfx_arena_reset(dy_gfx_arena_t *arena);
+
+/**
+ * Returns arena statistics; sizes are in bytes.
+ */
+dy_gfx_alloc_stats_t dy_gfx_arena_stats(const dy_gfx_arena_t *arena);
+
+/**
+ * Creates a pool of `n_blocks` buffers of up to `max_width * max_height` pixels each.
+ *
+ * The pool and all its blocks are allocated as a single block.
+ */
+dy_gfx_pool_t *dy_gfx_pool_new(uint16_t n_blocks, uint16_t max_width, uint16_t max_height);
+
+/**
+ * Frees resources allocated by `dy_gfx_pool_new()`; all buffers allocated from the pool become invalid.
+ */
+void dy_gfx_pool_free(dy_gfx_pool_t *pool);
+
+/**
+ * Takes a zeroed buffer from a pool; its size must not exceed the pool's block size in pixels.
+ *
+ * @return A buffer or NULL if the pool is exhausted or the size is too large.
+ */
+dy_gfx_buf_t *dy_gfx_pool_new_buf(dy_gfx_pool_t *pool, uint16_t width, uint16_t height);
+
+/**
+ * Returns a buffer to a pool.
+ */
+void dy_gfx_pool_free_buf(dy_gfx_pool_t *pool, dy_gfx_buf_t *buf);
+
+/**
+ * Returns pool statistics; sizes are in blocks.
+ */
+dy_gfx_alloc_stats_t dy_gfx_pool_stats(const dy_gfx_pool_t *pool);
@@ -0,0 +1,167 @@
+/**
+ * @brief Asset store.
+ *
+ * Fonts, sprites and images are packed by `tools/asset_pack.py` into a container which is written to a dedicated
+ * flash partition. The partition is memory-mapped, so asset data is used right from flash without copying.
+ *
+ * Container layout, all numbers are little-endian:
+ *  - header: magic "DYA1", number of entries (uint32), total container size (uint32), reserved (uint32);
+ *  - index: dy_gfx_asset_entry_t per asset, sorted by id;
+ *  - data: asset contents, each aligned to 4 bytes.
+ *
+ * On host builds, including the ESP-IDF linux target, a container file can be opened with dy_gfx_asset_open_file().
+ *
+ * @warning Open and close are NOT thread-safe; lookups on an open store are.
+ */
+
+#pragma once
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "dy/error.h"
+#include "dy/gfx/gfx.h"
+#include "dy/gfx/text.h"
+#include "dy/gfx/sprite.h"
+#include "dy/gfx/csprite.h"
+
+#define DY_GFX_ASSET_NAME_LEN 24
+
+/**
+ * Asset types.
+ */
+typedef enum {
+    DY_GFX_ASSET_RAW,          // arbitrary data
+    DY_GFX_ASSET_FONT,         // meta: ascii_offset, length, width, height
+    DY_GFX_ASSET_SPRITE,       // meta: width, height (uint16); data: RGB888 pixels
+    DY_GFX_ASSET_SPRITE_SHEET, // meta: width, height, n_frames (uint16); data: RGB888 pixels
+    DY_GFX_ASSET_CSPRITE,      // meta: width, height, n_colors (uint16), encoding, bpp; data: palette, then indices
+    DY_GFX_ASSET_QOI,          // data: QOI image
+} dy_gfx_asset_type_t;
+
+/**
+ * Index entry, 48 bytes.
+ */
+typedef struct {
+    char name[DY_GFX_ASSET_NAME_LEN]; // zero padded; not terminated if exactly DY_GFX_ASSET_NAME_LEN long
+    uint16_t id;
+    uint8_t type;                     // dy_gfx_asset_type_t
+    uint8_t flags;                    // reserved
+    uint32_t offset;                  // from the beginning of the container
+    uint32_t size;
+    uint8_t meta[12];                 // type-specific properties
+} dy_gfx_asset_entry_t;
+
+/**
+ * Asset store.
+ */
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    uint32_t n_entries;
+    const dy_gfx_asset_entry_t *entries;
+    uint32_t mmap_handle; // esp_partition_mmap_handle_t, or size of the mapping of a file
+    bool is_file;         // mapped by dy_gfx_asset_open_file()
+    bool is_partition;    // mapped by dy_gfx_asset_open()
+} dy_gfx_asset_store_t;
+
+/**
+ * An asset located in a store.
+ */
+typedef struct {
+    const dy_gfx_asset_entry_t *entry;
+    const uint8_t *data;
+} dy_gfx_asset_t;
+
+/**
+ * @brief Opens a store located in a data partition.
+ *
+ * @param store  Store to initialize.
+ * @param label  Partition label; outside of ESP-IDF it is a path of a container file.
+ *
+ * @return
+ *  - DY_ERR_NOT_FOUND if there is no such partition.
+ *  - DY_ERR_FAILED if the partition cannot be mapped.
+ *  - Errors of dy_gfx_asset_open_mem().
+ *  - DY_OK on success.
+ */
+dy_err_t dy_gfx_asset_open(dy_gfx_asset_store_t *store, const char *label);
+
+/**
+ * @brief Opens a store located in memory.
+ *
+ * The memory must stay valid until the store is closed.
+ *
+ * @return
+ *  - DY_ERR_INVALID_ARG if the container is malformed.
+ *  - DY_ERR_INVALID_VERSION if the container's magic is not recognized.
+ *  - DY_OK on success.
+ */
+dy_err_t dy_gfx_asset_open_mem(dy_gfx_asset_store_t *store, const void *data, size_t size);
+
+#if !defined(ESP_PLATFORM) || defined(CONFIG_IDF_TARGET_LINUX)
+/**
+ * @brief Opens a store by memory-mapping a container file. Available on host builds only.
+ *
+ * @return
+ *  - DY_ERR_NOT_FOUND if the file cannot be opened.
+ *  - DY_ERR_FAILED if the file cannot be mapped.
+ *  - Errors of dy_gfx_asset_open_mem().
+ *  - DY_OK on success.
+ */
+dy_err_t dy_gfx_asset_open_file(dy_gfx_asset_store_t *store, const char *path);
+#endif
+
+/**
+ * Closes a store and unmaps its memory, unless it was opened by dy_gfx_asset_open_mem(). Assets obtained from the
+ * store must not be used after that.
+ */
+void dy_gfx_asset_close(dy_gfx_asset_store_t *store);
+
+/**
+ * @brief Looks up an asset by name.
+ *
+ * @param store  Store.
+ * @param name   Asset name.
+ * @param type   Expected asset type.
+ * @param asset  Where to store the result.
+ *
+ * @return
+ *  - DY_ERR_NOT_FOUND if there is no such asset.
+ *  - DY_ERR_INVALID_ARG if the asset has different type or its size does not match its properties.
+ *  - DY_OK on success.
+ */
+dy_err_t dy_gfx_asset_find(const dy_gfx_asset_store_t *store, const char *name, dy_gfx_asset_type_t type,
+                           dy_gfx_asset_t *asset);
+
+/**
+ * @brief Looks up an asset by id.
+ *
+ * @return Same as dy_gfx_asset_find().
+ */
+dy_err_t dy_gfx_asset_get(const dy_gfx_asset_store_t *store, uint16_t id, dy_gfx_asset_type_t type,
+                          dy_gfx_asset_t *asset);
+
+/**
+ * Returns a font referring to asset's data. The asset must be of DY_GFX_ASSET_FONT type.
+ */
+dy_gfx_font_t dy_gfx_asset_font(const dy_gfx_asset_t *asset);
+
+/**
+ * Returns a sprite referring to asset's data. The asset must be of DY_GFX_ASSET_SPRITE type.
+ */
+dy_gfx_sprite_t dy_gfx_asset_sprite(const dy_gfx_asset_t *asset);
+
+/**
+ * Returns a sprite sheet referring to asset's data. The asset must be of DY_GFX_ASSET_SPRITE_SHEET type.
+ */
+dy_gfx_sprite_sheet_t dy_gfx_asset_sprite_sheet(const dy_gfx_asset_t *asset);
+
+/**
+ * Returns a compressed sprite referring to asset's data. The asset must be of DY_GFX_ASSET_CSPRITE type.
+ */
+dy_gfx_csprite_t dy_gfx_asset_csprite(const dy_gfx_asset_t *asset);
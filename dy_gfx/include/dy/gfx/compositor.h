@@ -0,0 +1,130 @@
+/**
+ * @brief Layered frame compositor.
+ *
+ * Layers are stacked by their z-order and composited into an output buffer. Only areas changed since
+ * the previous dy_gfx_comp_render() call are re-composited, and those areas are reported back, so
+ * they can be passed on to display drivers supporting partial updates.
+ *
+ * @warning It is NOT thread-safe.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include "dy/gfx/gfx.h"
+#include "dy/gfx/damage.h"
+
+#define DY_GFX_COMP_LAYERS_MAX 8
+
+/**
+ * Layer render callback. Called by dy_gfx_comp_render() for invalidated layers;
+ * the layer's buffer is cleared before the call.
+ */
+typedef void (*dy_gfx_layer_renderer_t)(void *args, dy_gfx_buf_t *buf);
+
+typedef struct dy_gfx_comp dy_gfx_comp_t;
+
+/**
+ * Layer.
+ */
+typedef struct {
+    dy_gfx_comp_t *comp;
+    dy_gfx_buf_t *buf;
+    bool own_buf;
+    dy_gfx_layer_renderer_t renderer;
+    void *args;
+    dy_gfx_point_t pos;
+    int8_t z;
+    bool visible;
+    bool dirty;
+    dy_gfx_blend_t blend;
+} dy_gfx_layer_t;
+
+/**
+ * Compositor.
+ */
+struct dy_gfx_comp {
+    dy_gfx_buf_t *out;
+    dy_gfx_px_t background;
+    uint8_t n_layers;
+    dy_gfx_layer_t *layers[DY_GFX_COMP_LAYERS_MAX]; // sorted by z, bottom first
+    dy_gfx_damage_t damage;
+};
+
+/**
+ * Creates a compositor with an output buffer of a given size.
+ */
+dy_gfx_comp_t *dy_gfx_comp_new(uint16_t width, uint16_t height);
+
+/**
+ * Frees resources allocated by `dy_gfx_comp_new()`, including all layers.
+ */
+void dy_gfx_comp_free(dy_gfx_comp_t *comp);
+
+/**
+ * @brief Adds a layer showing a buffer.
+ *
+ * The buffer is owned by the caller; call `dy_gfx_layer_invalidate()` after changing its content.
+ *
+ * @return A layer or NULL if there is no room or memory for it.
+ */
+dy_gfx_layer_t *dy_gfx_comp_add_buf_layer(dy_gfx_comp_t *comp, dy_gfx_buf_t *buf, dy_gfx_point_t pos, int8_t z);
+
+/**
+ * @brief Adds a layer drawn by a callback into a buffer owned by the layer.
+ *
+ * @return A layer or NULL if there is no room or memory for it.
+ */
+dy_gfx_layer_t *dy_gfx_comp_add_render_layer(dy_gfx_comp_t *comp, uint16_t width, uint16_t height,
+                                             dy_gfx_point_t pos, int8_t z, dy_gfx_layer_renderer_t renderer,
+                                             void *args);
+
+/**
+ * Removes a layer and frees its resources.
+ */
+void dy_gfx_comp_remove_layer(dy_gfx_layer_t *layer);
+
+/**
+ * Moves a layer to a new position.
+ */
+void dy_gfx_layer_set_pos(dy_gfx_layer_t *layer, dy_gfx_point_t pos);
+
+/**
+ * Moves a layer to a new z-order; among layers of equal z it becomes the top one.
+ */
+void dy_gfx_layer_set_z(dy_gfx_layer_t *layer, int8_t z);
+
+/**
+ * Shows or hides a layer.
+ */
+void dy_gfx_layer_set_visible(dy_gfx_layer_t *layer, bool visible);
+
+/**
+ * Sets the blend mode used to composite a layer; the default one is DY_GFX_BLEND_KEY.
+ */
+void dy_gfx_layer_set_blend(dy_gfx_layer_t *layer, dy_gfx_blend_t blend);
+
+/**
+ * Marks a layer's content as changed; render layers are redrawn by the next `dy_gfx_comp_render()` call.
+ */
+void dy_gfx_layer_invalidate(dy_gfx_layer_t *layer);
+
+/**
+ * Marks an area of a layer's content as changed; the area is relative to the layer.
+ */
+void dy_gfx_layer_invalidate_area(dy_gfx_layer_t *layer, dy_gfx_area_t area);
+
+/**
+ * Marks the whole output as changed.
+ */
+void dy_gfx_comp_invalidate(dy_gfx_comp_t *comp);
+
+/**
+ * @brief Re-composites changed areas into the output buffer.
+ *
+ * @param comp    A compositor.
+ * @param damage  Receives the areas of the output buffer which have changed; may be NULL.
+ *
+ * @return The output buffer.
+ */
+dy_gfx_buf_t *dy_gfx_comp_render(dy_gfx_comp_t *comp, dy_gfx_damage_t *damage);
@@ -0,0 +1,53 @@
+/**
+ * @brief Palette-compressed sprites.
+ *
+ * Pixels are stored as palette indices, either bit-packed or run-length encoded, and decoded
+ * straight into a destination buffer, so sprite data can be read right from flash.
+ * Use `tools/csprite.py` to convert images into C headers.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "dy/gfx/gfx.h"
+#include "dy/gfx/sprite.h"
+
+/**
+ * Compressed sprite encodings.
+ */
+typedef enum {
+    // Indices are packed by `bpp` bits, most significant bits first; each row starts at a byte boundary.
+    DY_GFX_CSPRITE_PACKED,
+
+    // Stream of tokens; a token byte `t` is followed either by (t & 0x7F) + 1 index bytes if t & 0x80 is set,
+    // or by a single index byte repeated (t & 0x7F) + 1 times otherwise. Runs may continue on the next row.
+    DY_GFX_CSPRITE_RLE,
+} dy_gfx_csprite_encoding_t;
+
+/**
+ * Compressed sprite.
+ */
+typedef struct {
+    const uint16_t width;
+    const uint16_t height;
+    const uint8_t encoding; // dy_gfx_csprite_encoding_t
+    const uint8_t bpp;      // bits per index for DY_GFX_CSPRITE_PACKED: 1, 2, 4 or 8
+    const uint16_t n_colors;
+    const dy_gfx_px_t *palette;
+    const uint32_t data_len;
+    const uint8_t *data;
+} dy_gfx_csprite_t;
+
+/**
+ * @brief Draws a compressed sprite clipped by buffer's boundaries.
+ *
+ * @param buf    Destination buffer.
+ * @param pos    Position of sprite's top left corner; may lie outside of the buffer.
+ * @param sp     A sprite.
+ * @param flags  Combination of dy_gfx_sprite_flag_t values; DY_GFX_SPRITE_KEY makes palette index 0 transparent.
+ *
+ * @return
+ *  - DY_ERR_INVALID_ARG if the sprite is malformed.
+ *  - DY_OK on success.
+ */
+dy_err_t dy_gfx_blit_csprite(dy_gfx_buf_t *buf, dy_gfx_point_t pos, const dy_gfx_csprite_t *sp, uint8_t flags);
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdbool.h>
+#include "dy/gfx/gfx.h"
+
+#define DY_GFX_DAMAGE_MAX 8
+
+/**
+ * List of damaged (changed) buffer areas.
+ *
+ * Overlapping and adjacent areas are coalesced. When the list is full, a new area is merged
+ * into the one whose bounding box grows the least.
+ */
+typedef struct {
+    uint8_t len;
+    dy_gfx_area_t areas[DY_GFX_DAMAGE_MAX];
+} dy_gfx_damage_t;
+
+/**
+ * Returns an intersection of two areas; the result has zero size if the areas do not intersect.
+ */
+dy_gfx_area_t dy_gfx_area_intersect(dy_gfx_area_t a, dy_gfx_area_t b);
+
+/**
+ * Returns a bounding box of two areas.
+ */
+dy_gfx_area_t dy_gfx_area_union(dy_gfx_area_t a, dy_gfx_area_t b);
+
+/**
+ * Empties a damage list.
+ */
+void dy_gfx_damage_reset(dy_gfx_damage_t *dmg);
+
+/**
+ * Adds an area to a damage list.
+ */
+void dy_gfx_damage_add(dy_gfx_damage_t *dmg, dy_gfx_area_t area);
+
+/**
+ * Adds all areas of another damage list.
+ */
+void dy_gfx_damage_add_all(dy_gfx_damage_t *dmg, const dy_gfx_damage_t *src);
+
+/**
+ * Checks whether a damage list is empty.
+ */
+bool dy_gfx_damage_is_empty(const dy_gfx_damage_t *dmg);
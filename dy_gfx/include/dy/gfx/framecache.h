@@ -0,0 +1,89 @@
+/**
+ * @brief Cache of pre-rendered animation frames.
+ *
+ * Frames of deterministic animations, such as spinners or icon loops, are rendered once, stored as palette-indexed
+ * compressed sprites (1 bpp for two-colour frames) and blitted on subsequent loops. Frames are keyed by an
+ * animation id chosen by the caller and a frame number. The least recently used frames are evicted when the
+ * memory cap is reached.
+ *
+ * @warning It is NOT thread-safe.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "dy/error.h"
+#include "dy/gfx/gfx.h"
+
+/**
+ * Renders a frame into a buffer; the buffer is cleared before the call.
+ */
+typedef void (*dy_gfx_frame_renderer_t)(void *args, dy_gfx_buf_t *buf, uint32_t frame_n);
+
+/**
+ * Cache statistics.
+ */
+typedef struct {
+    size_t capacity;    // memory cap, bytes
+    size_t used;        // bytes used by cached frames
+    uint32_t n_frames;  // number of cached frames
+    uint32_t hits;      // frames blitted from the cache
+    uint32_t misses;    // frames rendered
+    uint32_t evictions; // frames evicted to free memory
+    uint32_t n_skipped; // rendered frames which could not be cached: more than 256 colours or larger than the cap
+} dy_gfx_fcache_stats_t;
+
+typedef struct dy_gfx_fcache_item dy_gfx_fcache_item_t;
+
+/**
+ * Frame cache.
+ */
+typedef struct {
+    dy_gfx_fcache_item_t *items; // hash table, ordered from least to most recently used
+    dy_gfx_buf_t *scratch;       // render buffer, grown on demand
+    uint32_t scratch_len;        // scratch buffer capacity, pixels
+    dy_gfx_fcache_stats_t stats;
+} dy_gfx_fcache_t;
+
+/**
+ * Creates a cache limited to `capacity` bytes.
+ */
+dy_gfx_fcache_t *dy_gfx_fcache_new(size_t capacity);
+
+/**
+ * Frees a cache and all its frames.
+ */
+void dy_gfx_fcache_free(dy_gfx_fcache_t *cache);
+
+/**
+ * @brief Draws an animation frame, either from the cache or by rendering and caching it.
+ *
+ * @param cache     Cache.
+ * @param buf       Destination buffer.
+ * @param pos       Position of frame's top left corner; may lie outside of the buffer.
+ * @param anim_id   Animation id.
+ * @param frame_n   Frame number.
+ * @param width     Frame width.
+ * @param height    Frame height.
+ * @param renderer  Called on cache misses to render the frame.
+ * @param args      Renderer's arguments.
+ * @param flags     Combination of dy_gfx_sprite_flag_t values; with DY_GFX_SPRITE_KEY black pixels are transparent.
+ *
+ * @return
+ *  - DY_ERR_NO_MEM if there is no memory for the render buffer.
+ *  - DY_OK on success.
+ */
+dy_err_t dy_gfx_fcache_draw(dy_gfx_fcache_t *cache, dy_gfx_buf_t *buf, dy_gfx_point_t pos, uint16_t anim_id,
+                            uint32_t frame_n, uint16_t width, uint16_t height, dy_gfx_frame_renderer_t renderer,
+                            void *args, uint8_t flags);
+
+/**
+ * Removes all frames of an animation, e.g. after its look has changed.
+ */
+void dy_gfx_fcache_drop(dy_gfx_fcache_t *cache, uint16_t anim_id);
+
+/**
+ * Returns cache statistics.
+ */
+dy_gfx_fcache_stats_t dy_gfx_fcache_stats(const dy_gfx_fcache_t *cache);
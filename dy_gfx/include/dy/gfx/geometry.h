@@ -19,7 +19,19 @@ typedef struct {
 } dy_gfx_poly_t;
 
 /**
- * Draws a line
+ * Draws a horizontal line between x1 and x2, inclusive.
+ */
+void dy_gfx_hline(dy_gfx_buf_t *buf, int32_t x1, int32_t x2, int32_t y, dy_gfx_px_t color);
+
+/**
+ * Draws a vertical line between y1 and y2, inclusive.
+ */
+void dy_gfx_vline(dy_gfx_buf_t *buf, int32_t x, int32_t y1, int32_t y2, dy_gfx_px_t color);
+
+/**
+ * Draws a line.
+ *
+ * Both ends are drawn. The line is clipped against the buffer, so the ends may lie outside of it.
  */
 void dy_gfx_line(dy_gfx_buf_t *buf, const dy_gfx_line_t *line, dy_gfx_px_t color);
 
@@ -37,3 +49,31 @@ void dy_gfx_rect(dy_gfx_buf_t *buf, dy_gfx_point_t p1, dy_gfx_point_t p2, dy_gfx
  * Draws a triangle.
  */
 void dy_gfx_tri(dy_gfx_buf_t *buf, dy_gfx_point_t p1, dy_gfx_point_t p2, dy_gfx_point_t p3, dy_gfx_px_t color);
+
+/**
+ * Draws a filled rectangle.
+ */
+void dy_gfx_fill_rect(dy_gfx_buf_t *buf, dy_gfx_point_t p1, dy_gfx_point_t p2, dy_gfx_px_t color);
+
+/**
+ * Draws a filled polygon.
+ *
+ * Both convex and concave polygons are supported; self-intersecting ones are filled using the even-odd rule.
+ */
+void dy_gfx_fill_poly(dy_gfx_buf_t *buf, const dy_gfx_poly_t *poly, dy_gfx_px_t color);
+
+/**
+ * Draws a filled triangle.
+ */
+void dy_gfx_fill_tri(dy_gfx_buf_t *buf, dy_gfx_point_t p1, dy_gfx_point_t p2, dy_gfx_point_t p3, dy_gfx_px_t color);
+
+/**
+ * Draws a filled circle.
+ */
+void dy_gfx_fill_circle(dy_gfx_buf_t *buf, dy_gfx_point_t center, uint16_t radius, dy_gfx_px_t color);
+
+/**
+ * Draws a filled rectangle with rounded corners.
+ */
+void dy_gfx_fill_round_rect(dy_gfx_buf_t *buf, dy_gfx_point_t p1, dy_gfx_point_t p2, uint16_t radius,
+                            dy_gfx_px_t color);
@@ -20,6 +20,16 @@ typedef struct {
     int32_t y;
 } dy_gfx_point_t;
 
+/**
+ * Rectangular area.
+ */
+typedef struct {
+    int32_t x;
+    int32_t y;
+    uint16_t width;
+    uint16_t height;
+} dy_gfx_area_t;
+
 /**
  * Buffer.
  */
@@ -37,6 +47,26 @@ typedef struct {
     dy_gfx_buf_t **buffers;
 } dy_gfx_buf_array_t;
 
+/**
+ * Buffer merge modes.
+ */
+typedef enum {
+    DY_GFX_BLEND_COPY,  // source pixels overwrite destination ones
+    DY_GFX_BLEND_KEY,   // same as copy, but black source pixels are transparent
+    DY_GFX_BLEND_ADD,   // channels are added, saturating at 255
+    DY_GFX_BLEND_ALPHA, // source is mixed with destination using global or per-pixel alpha
+    DY_GFX_BLEND_XOR,   // channels are XOR'ed; for on/off content it toggles destination pixels
+} dy_gfx_blend_mode_t;
+
+/**
+ * Buffer merge parameters.
+ */
+typedef struct {
+    dy_gfx_blend_mode_t mode;
+    uint8_t alpha;            // global alpha for DY_GFX_BLEND_ALPHA, 0 is transparent, 255 is opaque
+    const uint8_t *alpha_map; // optional per-pixel alpha, one byte per source pixel; overrides `alpha`
+} dy_gfx_blend_t;
+
 typedef enum {
     DY_GFX_COLOR_BLACK = 0,
     DY_GFX_COLOR_RED,
@@ -110,6 +140,8 @@ dy_gfx_px_t dy_gfx_px_to_rgb888(dy_gfx_px_t px);
 
 /**
  * Initializes a buffer.
+ *
+ * The buffer struct and its content are allocated as a single block.
  */
 dy_gfx_buf_t *dy_gfx_new_buf(uint16_t width, uint16_t height);
 
@@ -120,8 +152,10 @@ void dy_gfx_free_buf(dy_gfx_buf_t *buf);
 
 /**
  * Creates an array of buffers.
+ *
+ * The whole array is allocated as a single block, so its buffers must not be freed individually.
  */
-dy_gfx_buf_array_t *dy_gfx_make_buf_array(uint8_t length, uint16_t width, uint16_t height);
+dy_gfx_buf_array_t *dy_gfx_make_buf_array(uint16_t length, uint16_t width, uint16_t height);
 
 /**
  * Frees resources allocated by `dy_gfx_make_buf_array()`.
@@ -154,7 +188,41 @@ dy_gfx_px_t dy_gfx_get_px(const dy_gfx_buf_t *buf, uint16_t x, uint16_t y);
 dy_err_code_t dy_gfx_merge(dy_gfx_buf_t *dst, const dy_gfx_buf_t *src, dy_gfx_point_t d_pos, dy_gfx_point_t s_pos);
 
 /**
- * Splits a buffer,
+ * @brief Merges two buffers using a blend mode.
+ *
+ * The blend mode is resolved once per call, each mode has its own inner loop.
+ *
+ * @param dst    Destination buffer.
+ * @param src    Source buffer.
+ * @param d_pos  Position in the destination buffer.
+ * @param s_pos  Position in the source buffer.
+ * @param blend  Blend parameters.
+ *
+ * @return Result of the operation.
+ */
+dy_err_code_t dy_gfx_merge_blend(dy_gfx_buf_t *dst, const dy_gfx_buf_t *src, dy_gfx_point_t d_pos,
+                                 dy_gfx_point_t s_pos, const dy_gfx_blend_t *blend);
+
+/**
+ * @brief Merges an area of the source buffer into the destination buffer using a blend mode.
+ *
+ * Parts of the area lying outside of either buffer are skipped.
+ *
+ * @param dst     Destination buffer.
+ * @param src     Source buffer.
+ * @param d_pos   Position in the destination buffer.
+ * @param s_area  Area of the source buffer.
+ * @param blend   Blend parameters.
+ *
+ * @return Result of the operation.
+ */
+dy_err_code_t dy_gfx_merge_area(dy_gfx_buf_t *dst, const dy_gfx_buf_t *src, dy_gfx_point_t d_pos,
+                                dy_gfx_area_t s_area, const dy_gfx_blend_t *blend);
+
+/**
+ * @brief Splits a buffer into chunks, row by row; a remainder narrower or lower than a chunk is dropped.
+ *
+ * @return The chunks, or NULL if a chunk size is zero, there are more than UINT16_MAX chunks, or allocation failed.
  */
 dy_gfx_buf_array_t *dy_gfx_split(const dy_gfx_buf_t *src, uint8_t chunk_w, uint8_t chunk_h);
 
@@ -168,9 +236,36 @@ dy_gfx_buf_array_t *dy_gfx_split(const dy_gfx_buf_t *src, uint8_t chunk_w, uint8
  */
 dy_err_code_t dy_gfx_move(dy_gfx_buf_t *buf, dy_gfx_point_t pos);
 
+/**
+ * @brief Fills a buffer with a given pixel color.
+ * @param buf  A buffer to fill.
+ * @param px   A pixel color to fill with.
+ */
+void dy_gfx_fill(dy_gfx_buf_t *buf, dy_gfx_px_t px);
+
 /**
  * @brief Colorizes a buffer with a given pixel color.
  * @param buf  A buffer to colorize.
  * @param px   A pixel color to use for colorization.
  */
 void dy_gfx_colorize(dy_gfx_buf_t *buf, dy_gfx_px_t px);
+
+/**
+ * @brief Inverts all pixels of a buffer.
+ * @param buf  A buffer to invert.
+ */
+void dy_gfx_invert(dy_gfx_buf_t *buf);
+
+/**
+ * @brief Turns black all pixels whose brightest channel is lower than a given level.
+ * @param buf    A buffer to process.
+ * @param level  Threshold level.
+ */
+void dy_gfx_threshold(dy_gfx_buf_t *buf, uint8_t level);
+
+/**
+ * @brief Scales brightness of all pixels of a buffer.
+ * @param buf    A buffer to process.
+ * @param scale  Scale factor, where 255 keeps pixels intact and 0 makes them black.
+ */
+void dy_gfx_scale(dy_gfx_buf_t *buf, uint8_t scale);
@@ -0,0 +1,109 @@
+/**
+ * @brief Streaming QOI image decoder.
+ *
+ * Decodes images in the "Quite OK Image" format (https://qoiformat.org) straight into a buffer. Input can be fed
+ * in chunks of any size, e.g. as it is read from a file or received over network, and the working set is limited
+ * to the decoder structure itself, so images may be far larger than the available RAM. Images stored in a
+ * memory-mapped flash partition can be decoded in one call with dy_gfx_qoi_decode().
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "dy/error.h"
+#include "dy/gfx/gfx.h"
+
+#define DY_GFX_QOI_HEADER_LEN 14
+
+/**
+ * Image properties.
+ */
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint8_t channels; // 3 for RGB, 4 for RGBA
+} dy_gfx_qoi_info_t;
+
+/**
+ * Decoder state. Fields are private, use functions below.
+ */
+typedef struct {
+    dy_gfx_buf_t *buf;
+    dy_gfx_point_t pos;
+
+    dy_gfx_qoi_info_t info;
+    uint32_t n_px;    // total number of pixels
+    uint32_t px_done; // number of decoded pixels
+
+    uint8_t hdr[DY_GFX_QOI_HEADER_LEN];
+    uint8_t hdr_len;
+
+    uint8_t op[5];   // chunk being collected
+    uint8_t op_len;  // number of collected chunk bytes
+    uint8_t op_need; // total length of the chunk
+
+    uint8_t px[4];        // previous pixel, RGBA
+    uint8_t index[64][4]; // recently seen pixels, RGBA
+} dy_gfx_qoi_t;
+
+/**
+ * @brief Parses image header.
+ *
+ * @param data  Beginning of an image, at least DY_GFX_QOI_HEADER_LEN bytes.
+ * @param len   Length of data.
+ * @param info  Where to store image properties.
+ *
+ * @return
+ *  - DY_ERR_INVALID_SIZE if data is too short or the image is larger than 65535 pixels in any dimension.
+ *  - DY_ERR_INVALID_ARG if data is not a QOI image.
+ *  - DY_OK on success.
+ */
+dy_err_t dy_gfx_qoi_info(const uint8_t *data, size_t len, dy_gfx_qoi_info_t *info);
+
+/**
+ * @brief Prepares a decoder.
+ *
+ * @param dec  Decoder.
+ * @param buf  Destination buffer.
+ * @param pos  Position of image's top left corner in the buffer; pixels outside the buffer are skipped.
+ */
+void dy_gfx_qoi_init(dy_gfx_qoi_t *dec, dy_gfx_buf_t *buf, dy_gfx_point_t pos);
+
+/**
+ * @brief Feeds next chunk of an image to the decoder.
+ *
+ * Decoded rows are written to the buffer right away. Pixels with alpha below 128 are not drawn,
+ * so the buffer's content is kept under transparent parts of the image.
+ * Data following the last pixel, such as the end marker, is ignored.
+ *
+ * @param dec   Decoder.
+ * @param data  Image data.
+ * @param len   Length of data.
+ *
+ * @return
+ *  - Errors of dy_gfx_qoi_info() if the header is invalid.
+ *  - DY_OK on success.
+ */
+dy_err_t dy_gfx_qoi_feed(dy_gfx_qoi_t *dec, const uint8_t *data, size_t len);
+
+/**
+ * Checks whether all image pixels have been decoded.
+ */
+bool dy_gfx_qoi_done(const dy_gfx_qoi_t *dec);
+
+/**
+ * @brief Decodes an image located in memory, e.g. in a memory-mapped flash partition.
+ *
+ * @param buf   Destination buffer.
+ * @param pos   Position of image's top left corner in the buffer.
+ * @param data  Image data.
+ * @param len   Length of data.
+ *
+ * @return
+ *  - Errors of dy_gfx_qoi_feed().
+ *  - DY_ERR_INVALID_SIZE if data ends before the last pixel.
+ *  - DY_OK on success.
+ */
+dy_err_t dy_gfx_qoi_decode(dy_gfx_buf_t *buf, dy_gfx_point_t pos, const uint8_t *data, size_t len);
@@ -3,10 +3,53 @@
 #include <stdio.h>
 #include "dy/gfx/gfx.h"
 
+/**
+ * Sprite blitting flags.
+ */
+typedef enum {
+    DY_GFX_SPRITE_FLIP_H = 1 << 0, // mirror horizontally
+    DY_GFX_SPRITE_FLIP_V = 1 << 1, // mirror vertically
+    DY_GFX_SPRITE_KEY = 1 << 2,    // skip pixels matching the key color
+} dy_gfx_sprite_flag_t;
+
+/**
+ * Sprite; pixels are stored row by row.
+ */
 typedef struct {
     const uint16_t width;
     const uint16_t height;
     const dy_gfx_px_t *data;
 } dy_gfx_sprite_t;
 
-dy_err_t dy_gfx_write_sprite(dy_gfx_buf_t *buf, uint16_t bx, uint16_t by, const dy_gfx_sprite_t *sp);
\ No newline at end of file
+/**
+ * Sprite sheet; equally sized frames are stored one after another, each row by row.
+ */
+typedef struct {
+    const uint16_t width;    // frame width
+    const uint16_t height;   // frame height
+    const uint16_t n_frames;
+    const dy_gfx_px_t *data;
+} dy_gfx_sprite_sheet_t;
+
+/**
+ * Writes a sprite into a buffer.
+ */
+dy_err_t dy_gfx_write_sprite(dy_gfx_buf_t *buf, uint16_t bx, uint16_t by, const dy_gfx_sprite_t *sp);
+
+/**
+ * @brief Draws a sprite clipped by buffer's boundaries.
+ *
+ * @param buf    Destination buffer.
+ * @param pos    Position of sprite's top left corner; may lie outside of the buffer.
+ * @param sp     A sprite.
+ * @param flags  Combination of dy_gfx_sprite_flag_t values.
+ * @param key    Transparent color, used with DY_GFX_SPRITE_KEY.
+ */
+void dy_gfx_blit_sprite(dy_gfx_buf_t *buf, dy_gfx_point_t pos, const dy_gfx_sprite_t *sp, uint8_t flags,
+                        dy_gfx_px_t key);
+
+/**
+ * Returns a frame of a sprite sheet; frame numbers wrap around, so animation frame numbers can be used directly.
+ * A sheet without frames gives an empty sprite, which draws nothing.
+ */
+dy_gfx_sprite_t dy_gfx_sprite_sheet_frame(const dy_gfx_sprite_sheet_t *sheet, uint32_t n);
@@ -0,0 +1,131 @@
+/**
+ * @brief Tweens and timelines.
+ *
+ * A tween interpolates a value between two states over a number of frames using an easing curve. A timeline
+ * groups tweens and is driven frame by frame by the animation scheduler, see dy_gfx_timeline_animator().
+ *
+ * All the math is done in Q16.16 fixed point, so a frame costs a few integer multiplications per tween.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dy/error.h"
+#include "dy/gfx/gfx.h"
+#include "dy/gfx/animation.h"
+#include "dy/gfx/compositor.h"
+
+#define DY_GFX_TWEEN_ONE 0x10000 // 1.0 in Q16.16
+#define DY_GFX_TIMELINE_MAX 16
+
+/**
+ * Easing curves.
+ */
+typedef enum {
+    DY_GFX_EASE_LINEAR,
+    DY_GFX_EASE_IN_QUAD,
+    DY_GFX_EASE_OUT_QUAD,
+    DY_GFX_EASE_IN_OUT_QUAD,
+    DY_GFX_EASE_IN_CUBIC,
+    DY_GFX_EASE_OUT_CUBIC,
+    DY_GFX_EASE_IN_OUT_CUBIC,
+    DY_GFX_EASE_SMOOTH,     // smoothstep, 3t^2 - 2t^3
+    DY_GFX_EASE_OUT_BACK,   // overshoots the target by up to 10% and comes back
+    DY_GFX_EASE_OUT_BOUNCE, // bounces off the target
+} dy_gfx_ease_t;
+
+/**
+ * Tween target kinds.
+ */
+typedef enum {
+    DY_GFX_TWEEN_I32,         // target is int32_t *
+    DY_GFX_TWEEN_U8,          // target is uint8_t *, e.g. display brightness; clamped to 0..255
+    DY_GFX_TWEEN_POINT,       // target is dy_gfx_point_t *
+    DY_GFX_TWEEN_PX,          // target is dy_gfx_px_t *; each channel is clamped to 0..255
+    DY_GFX_TWEEN_LAYER_POS,   // target is dy_gfx_layer_t *, moved by dy_gfx_layer_set_pos(); uses `point` values
+    DY_GFX_TWEEN_LAYER_ALPHA, // target is dy_gfx_layer_t *, blended by DY_GFX_BLEND_ALPHA; uses `u8` values
+} dy_gfx_tween_kind_t;
+
+/**
+ * Tween value.
+ */
+typedef union {
+    int32_t i32;
+    uint8_t u8;
+    dy_gfx_point_t point;
+    dy_gfx_px_t px;
+} dy_gfx_tween_value_t;
+
+/**
+ * Tween callback.
+ */
+typedef void (*dy_gfx_tween_cb_t)(void *args);
+
+/**
+ * Tween.
+ */
+typedef struct {
+    dy_gfx_tween_kind_t kind;
+    dy_gfx_ease_t ease;
+    uint32_t start;    // first frame, relative to the beginning of a timeline
+    uint32_t duration; // number of frames; the target reaches `to` at frame `start + duration`
+    void *target;
+    dy_gfx_tween_value_t from;
+    dy_gfx_tween_value_t to;
+    dy_gfx_tween_cb_t on_update; // optional; called when the target has changed, e.g. to invalidate a layer
+    void *args;
+} dy_gfx_tween_t;
+
+/**
+ * Timeline.
+ */
+typedef struct {
+    bool loop;                  // restart after the last tween completes
+    uint32_t duration;          // number of frames, maintained by dy_gfx_timeline_add()
+    dy_gfx_tween_cb_t on_frame; // optional; called after tweens have been applied, e.g. to render and flush
+    void *args;
+    uint8_t len;
+    dy_gfx_tween_t tweens[DY_GFX_TIMELINE_MAX];
+} dy_gfx_timeline_t;
+
+/**
+ * @brief Applies an easing curve.
+ *
+ * @param ease  Easing curve.
+ * @param t     Progress in Q16.16, from 0 to DY_GFX_TWEEN_ONE.
+ *
+ * @return Eased progress in Q16.16; may slightly exceed 0..DY_GFX_TWEEN_ONE for overshooting curves.
+ */
+int32_t dy_gfx_ease(dy_gfx_ease_t ease, int32_t t);
+
+/**
+ * @brief Sets tween's target to the state at a given frame.
+ *
+ * Frames outside of `start .. start + duration` are ignored, so several tweens may animate the same target
+ * one after another.
+ *
+ * @return Whether the target has changed.
+ */
+bool dy_gfx_tween_apply(const dy_gfx_tween_t *tween, uint32_t frame_n);
+
+/**
+ * Initializes an empty timeline.
+ */
+void dy_gfx_timeline_init(dy_gfx_timeline_t *tl, bool loop, dy_gfx_tween_cb_t on_frame, void *args);
+
+/**
+ * @brief Adds a tween to a timeline.
+ *
+ * @return
+ *  - DY_ERR_NO_MEM if the timeline is full.
+ *  - DY_OK on success.
+ */
+dy_err_t dy_gfx_timeline_add(dy_gfx_timeline_t *tl, dy_gfx_tween_t tween);
+
+/**
+ * @brief Animation callback driving a timeline passed as `args`.
+ *
+ * Usage: `dy_gfx_animate(dy_gfx_timeline_animator, &timeline, fps)`.
+ */
+dy_gfx_anim_state_t dy_gfx_timeline_animator(void *args, uint32_t frame_n);
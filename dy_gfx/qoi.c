@@ -0,0 +1,218 @@
+#include <string.h>
+#include "dy/gfx/qoi.h"
+
+#define OP_INDEX 0x00
+#define OP_DIFF  0x40
+#define OP_LUMA  0x80
+#define OP_RUN   0xC0
+#define OP_RGB   0xFE
+#define OP_RGBA  0xFF
+#define OP_MASK  0xC0
+
+static inline uint32_t read_u32(const uint8_t *p) {
+    return (uint32_t) p[0] << 24 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 8 | p[3];
+}
+
+static inline uint8_t hash(const uint8_t *px) {
+    return (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+}
+
+// Returns total length of a chunk by its first byte.
+static inline uint8_t op_len(uint8_t b) {
+    if (b == OP_RGB) {
+        return 4;
+    } else if (b == OP_RGBA) {
+        return 5;
+    } else if ((b & OP_MASK) == OP_LUMA) {
+        return 2;
+    }
+
+    return 1;
+}
+
+// Writes `n` copies of the current pixel starting at the current position.
+static void emit(dy_gfx_qoi_t *dec, uint32_t n) {
+    if (n > dec->n_px - dec->px_done) {
+        n = dec->n_px - dec->px_done;
+    }
+
+    if (dec->px[3] < 128) {
+        dec->px_done += n;
+        return;
+    }
+
+    dy_gfx_buf_t *buf = dec->buf;
+    dy_gfx_px_t color = {.r = dec->px[0], .g = dec->px[1], .b = dec->px[2]};
+
+    while (n > 0) {
+        uint32_t x = dec->px_done % dec->info.width;
+        uint32_t y = dec->px_done / dec->info.width;
+        uint32_t len = dec->info.width - x; // pixels left in the row
+        if (len > n) {
+            len = n;
+        }
+
+        int32_t by = dec->pos.y + (int32_t) y;
+        if (by >= 0 && by < buf->height) {
+            int32_t bx1 = dec->pos.x + (int32_t) x;
+            int32_t bx2 = bx1 + (int32_t) len - 1;
+            if (bx1 < 0) {
+                bx1 = 0;
+            }
+            if (bx2 >= buf->width) {
+                bx2 = buf->width - 1;
+            }
+
+            dy_gfx_px_t *dst = buf->content + by * buf->width;
+            for (int32_t bx = bx1; bx <= bx2; bx++) {
+                dst[bx] = color;
+            }
+        }
+
+        dec->px_done += len;
+        n -= len;
+    }
+}
+
+// Applies a complete chunk.
+static void apply(dy_gfx_qoi_t *dec) {
+    const uint8_t *op = dec->op;
+    uint8_t *px = dec->px;
+    uint32_t run = 1;
+
+    if (op[0] == OP_RGB) {
+        memcpy(px, op + 1, 3);
+    } else if (op[0] == OP_RGBA) {
+        memcpy(px, op + 1, 4);
+    } else {
+        switch (op[0] & OP_MASK) {
+            case OP_INDEX:
+                memcpy(px, dec->index[op[0]], 4);
+                break;
+            case OP_DIFF:
+                px[0] += ((op[0] >> 4) & 0x03) - 2;
+                px[1] += ((op[0] >> 2) & 0x03) - 2;
+                px[2] += (op[0] & 0x03) - 2;
+                break;
+            case OP_LUMA: {
+                int dg = (op[0] & 0x3F) - 32;
+                px[0] += dg - 8 + ((op[1] >> 4) & 0x0F);
+                px[1] += dg;
+                px[2] += dg - 8 + (op[1] & 0x0F);
+                break;
+            }
+            case OP_RUN:
+                run = (op[0] & 0x3F) + 1;
+                break;
+        }
+    }
+
+    memcpy(dec->index[hash(px)], px, 4);
+    emit(dec, run);
+}
+
+dy_err_t dy_gfx_qoi_info(const uint8_t *data, size_t len, dy_gfx_qoi_info_t *info) {
+    if (len < DY_GFX_QOI_HEADER_LEN) {
+        return dy_err(DY_ERR_INVALID_SIZE, "header is too short");
+    }
+
+    if (memcmp(data, "qoif", 4) != 0) {
+        return dy_err(DY_ERR_INVALID_ARG, "invalid magic");
+    }
+
+    uint32_t width = read_u32(data + 4);
+    uint32_t height = read_u32(data + 8);
+    if (width == 0 || height == 0 || width > UINT16_MAX || height > UINT16_MAX) {
+        return dy_err(DY_ERR_INVALID_SIZE, "unsupported image size: %ux%u", width, height);
+    }
+
+    uint8_t channels = data[12];
+    if (channels != 3 && channels != 4) {
+        return dy_err(DY_ERR_INVALID_ARG, "invalid number of channels: %d", channels);
+    }
+
+    info->width = width;
+    info->height = height;
+    info->channels = channels;
+
+    return dy_ok();
+}
+
+void dy_gfx_qoi_init(dy_gfx_qoi_t *dec, dy_gfx_buf_t *buf, dy_gfx_point_t pos) {
+    memset(dec, 0, sizeof(dy_gfx_qoi_t));
+    dec->buf = buf;
+    dec->pos = pos;
+    dec->px[3] = 255;
+}
+
+dy_err_t dy_gfx_qoi_feed(dy_gfx_qoi_t *dec, const uint8_t *data, size_t len) {
+    dy_err_t err;
+
+    // Header
+    if (dec->hdr_len < DY_GFX_QOI_HEADER_LEN) {
+        size_t n = DY_GFX_QOI_HEADER_LEN - dec->hdr_len;
+        if (n > len) {
+            n = len;
+        }
+
+        memcpy(dec->hdr + dec->hdr_len, data, n);
+        dec->hdr_len += n;
+        data += n;
+        len -= n;
+
+        if (dec->hdr_len < DY_GFX_QOI_HEADER_LEN) {
+            return dy_ok();
+        }
+
+        if (dy_is_err(err = dy_gfx_qoi_info(dec->hdr, dec->hdr_len, &dec->info))) {
+            return err;
+        }
+
+        dec->n_px = (uint32_t) dec->info.width * dec->info.height;
+    }
+
+    while (len > 0 && dec->px_done < dec->n_px) {
+        // Fast path for chunks which are entirely in the input
+        if (dec->op_len == 0) {
+            uint8_t need = op_len(*data);
+            if (need <= len) {
+                memcpy(dec->op, data, need);
+                data += need;
+                len -= need;
+                apply(dec);
+                continue;
+            }
+            dec->op_need = need;
+        }
+
+        // Chunk split between inputs
+        dec->op[dec->op_len++] = *data++;
+        len--;
+        if (dec->op_len == dec->op_need) {
+            apply(dec);
+            dec->op_len = 0;
+        }
+    }
+
+    return dy_ok();
+}
+
+bool dy_gfx_qoi_done(const dy_gfx_qoi_t *dec) {
+    return dec->hdr_len == DY_GFX_QOI_HEADER_LEN && dec->px_done == dec->n_px;
+}
+
+dy_err_t dy_gfx_qoi_decode(dy_gfx_buf_t *buf, dy_gfx_point_t pos, const uint8_t *data, size_t len) {
+    dy_err_t err;
+    dy_gfx_qoi_t dec;
+
+    dy_gfx_qoi_init(&dec, buf, pos);
+    if (dy_is_err(err = dy_gfx_qoi_feed(&dec, data, len))) {
+        return err;
+    }
+
+    if (!dy_gfx_qoi_done(&dec)) {
+        return dy_err(DY_ERR_INVALID_SIZE, "unexpected end of data");
+    }
+
+    return dy_ok();
+}
@@ -0,0 +1,67 @@
+#include <string.h>
+
+#include "dy/gfx/sprite.h"
+
+static inline bool is_key(const dy_gfx_px_t *px, dy_gfx_px_t key) {
+    return px->r == key.r && px->g == key.g && px->b == key.b;
+}
+
+dy_err_t dy_gfx_write_sprite(dy_gfx_buf_t *buf, uint16_t bx, uint16_t by, const dy_gfx_sprite_t *sp) {
+    dy_gfx_blit_sprite(buf, (dy_gfx_point_t) {bx, by}, sp, 0, DY_GFX_PX_BLACK);
+    return dy_ok();
+}
+
+void dy_gfx_blit_sprite(dy_gfx_buf_t *buf, dy_gfx_point_t pos, const dy_gfx_sprite_t *sp, uint8_t flags,
+                        dy_gfx_px_t key) {
+    // Visible part of the sprite, in sprite coordinates
+    int32_t x0 = pos.x < 0 ? -pos.x : 0, y0 = pos.y < 0 ? -pos.y : 0;
+    int32_t x1 = sp->width, y1 = sp->height;
+    if (pos.x + x1 > buf->width) {
+        x1 = buf->width - pos.x;
+    }
+    if (pos.y + y1 > buf->height) {
+        y1 = buf->height - pos.y;
+    }
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    bool flip_h = flags & DY_GFX_SPRITE_FLIP_H, flip_v = flags & DY_GFX_SPRITE_FLIP_V, keyed = flags & DY_GFX_SPRITE_KEY;
+    int32_t w = x1 - x0;
+    int32_t step = flip_h ? -1 : 1;
+
+    for (int32_t y = y0; y < y1; y++) {
+        int32_t sy = flip_v ? sp->height - 1 - y : y;
+        int32_t sx = flip_h ? sp->width - 1 - x0 : x0;
+        const dy_gfx_px_t *s = &sp->data[sy * sp->width + sx];
+        dy_gfx_px_t *d = &buf->content[dy_gfx_get_px_pos(buf, pos.x + x0, pos.y + y)];
+
+        if (!flip_h && !keyed) {
+            memcpy(d, s, w * sizeof(dy_gfx_px_t));
+        } else if (!keyed) {
+            for (int32_t n = w; n > 0; n--, d++, s += step) {
+                *d = *s;
+            }
+        } else {
+            for (int32_t n = w; n > 0; n--, d++, s += step) {
+                if (!is_key(s, key)) {
+                    *d = *s;
+                }
+            }
+        }
+    }
+}
+
+dy_gfx_sprite_t dy_gfx_sprite_sheet_frame(const dy_gfx_sprite_sheet_t *sheet, uint32_t n) {
+    if (sheet->n_frames == 0) {
+        return (dy_gfx_sprite_t) {.width = 0, .height = 0, .data = sheet->data};
+    }
+
+    n %= sheet->n_frames;
+
+    return (dy_gfx_sprite_t) {
+            .width = sheet->width,
+            .height = sheet->height,
+            .data = sheet->data + n * sheet->width * sheet->height,
+    };
+}
@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+"""
+Packs fonts, sprites and images into a dy_gfx asset container (see dy/gfx/asset.h).
+
+Usage:
+    asset_pack.py -o assets.bin [--header assets.h] ASSET...
+
+Each ASSET is given as `[name=]path[:type[:frames]]`. The name defaults to the file name without extension,
+types are detected by extension when omitted:
+    font     font header like dy/gfx/font/8x8v1.h (*.h)
+    qoi      QOI image, stored as is (*.qoi)
+    csprite  PNG or PPM image, palette-compressed (*.png, *.ppm)
+    sprite   PNG or PPM image, RGB888
+    sheet    PNG or PPM image with `frames` equally sized frames stacked vertically, RGB888
+    raw      any file (anything else)
+
+Ids are assigned in the order of arguments starting from 1; --header writes them as C macros.
+The container can be flashed to a data partition, e.g. with `parttool.py write_partition`.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import csprite  # noqa: E402
+
+TYPES = {'raw': 0, 'font': 1, 'sprite': 2, 'sheet': 3, 'csprite': 4, 'qoi': 5}
+EXTENSIONS = {'.h': 'font', '.qoi': 'qoi', '.png': 'csprite', '.ppm': 'csprite'}
+NAME_LEN = 24
+HEADER_LEN = 16
+ENTRY_LEN = 48
+
+
+def pack_font(path):
+    with open(path) as f:
+        src = re.sub(r'//[^\n]*|/\*.*?\*/', '', f.read(), flags=re.S)
+
+    fields = {}
+    for field in ('ascii_offset', 'length', 'width', 'height'):
+        m = re.search(r'\.%s\s*=\s*(\w+)' % field, src)
+        if m is None:
+            raise ValueError('%s: font field .%s not found' % (path, field))
+        fields[field] = m.group(1)
+    width = 16 if fields['width'].endswith('16') else 8 if fields['width'].endswith('8') else int(fields['width'])
+
+    m = re.search(r'\[\]\s*=\s*\{(.*?)\}\s*;', src, re.S)
+    values = [int(v, 0) for v in re.findall(r'0[xX][0-9a-fA-F]+|\d+', m.group(1))]
+    data = struct.pack('<%d%s' % (len(values), 'B' if width == 8 else 'H'), *values)
+    meta = struct.pack('<BBBB', int(fields['ascii_offset'], 0), int(fields['length'], 0), width,
+                       int(fields['height'], 0))
+
+    return data, meta
+
+
+def rgb(pixels):
+    return b''.join(bytes(p if p is not csprite.TRANSPARENT else (0, 0, 0)) for p in pixels)
+
+
+def pack_sprite(path):
+    width, height, pixels = csprite.read_image(path)
+    return rgb(pixels), struct.pack('<HH', width, height)
+
+
+def pack_sheet(path, frames):
+    width, height, pixels = csprite.read_image(path)
+    if frames < 1 or height % frames != 0:
+        raise ValueError('%s: height %d is not divisible by %d frames' % (path, height, frames))
+    return rgb(pixels), struct.pack('<HHH', width, height // frames, frames)
+
+
+def pack_csprite(path):
+    width, height, pixels = csprite.read_image(path)
+    palette, indices, _ = csprite.make_palette(pixels)
+
+    bpp, packed = csprite.encode_packed(width, height, indices, len(palette))
+    rle = csprite.encode_rle(indices)
+    if len(rle) < len(packed):
+        encoding, bpp, data = 1, 8, rle
+    else:
+        encoding, data = 0, packed
+
+    return b''.join(bytes(c) for c in palette) + data, struct.pack('<HHHBB', width, height, len(palette),
+                                                                      encoding, bpp)
+
+
+def pack(spec):
+    name, _, rest = spec.rpartition('=')
+    parts = rest.split(':')
+    path = parts[0]
+    kind = parts[1] if len(parts) > 1 else EXTENSIONS.get(os.path.splitext(path)[1].lower(), 'raw')
+    name = name or os.path.splitext(os.path.basename(path))[0]
+
+    if kind not in TYPES:
+        raise ValueError('%s: unknown type %s' % (spec, kind))
+    if len(name.encode()) > NAME_LEN:
+        raise ValueError('%s: name is longer than %d bytes' % (spec, NAME_LEN))
+
+    if kind == 'font':
+        data, meta = pack_font(path)
+    elif kind == 'sprite':
+        data, meta = pack_sprite(path)
+    elif kind == 'sheet':
+        data, meta = pack_sheet(path, int(parts[2]) if len(parts) > 2 else 1)
+    elif kind == 'csprite':
+        data, meta = pack_csprite(path)
+    else:
+        with open(path, 'rb') as f:
+            data, meta = f.read(), b''
+
+    return name, kind, data, meta
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Packs assets into a dy_gfx asset container.')
+    parser.add_argument('assets', nargs='+', metavar='ASSET')
+    parser.add_argument('-o', '--output', required=True, help='container file')
+    parser.add_argument('--header', help='C header with asset ids')
+    parser.add_argument('--prefix', default='ASSET_', help='prefix of macros in the header')
+    args = parser.parse_args()
+
+    assets = [pack(spec) for spec in args.assets]
+    names = [a[0] for a in assets]
+    if len(set(names)) != len(names):
+        parser.error('asset names must be unique')
+
+    offset = HEADER_LEN + ENTRY_LEN * len(assets)
+    index, blob = b'', b''
+    for asset_id, (name, kind, data, meta) in enumerate(assets, 1):
+        pad = -(offset + len(blob)) % 4
+        blob += b'\0' * pad
+        index += struct.pack('<24sHBBII12s', name.encode(), asset_id, TYPES[kind], 0, offset + len(blob), len(data),
+                             meta)
+        blob += data
+        sys.stderr.write('%3d %-24s %-8s %7d bytes\n' % (asset_id, name, kind, len(data)))
+
+    total = offset + len(blob)
+    with open(args.output, 'wb') as f:
+        f.write(struct.pack('<4sIII', b'DYA1', len(assets), total, 0) + index + blob)
+    sys.stderr.write('total: %d bytes\n' % total)
+
+    if args.header:
+        with open(args.header, 'w') as f:
+            f.write('#pragma once\n\n// Generated by asset_pack.py\n\n')
+            for asset_id, name in enumerate(names, 1):
+                f.write('#define %s%s %d\n' % (args.prefix, re.sub(r'\W', '_', name).upper(), asset_id))
+
+
+if __name__ == '__main__':
+    main()
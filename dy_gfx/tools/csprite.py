@@ -0,0 +1,235 @@
+#!/usr/bin/env python3
+"""
+Converts images into palette-compressed dy_gfx sprites (see dy/gfx/csprite.h).
+
+Supported inputs are 8-bit non-interlaced PNG (grayscale, RGB, palette, RGBA) and binary PPM (P6).
+Pixels with alpha below 128 are mapped to palette index 0, draw such sprites with DY_GFX_SPRITE_KEY.
+
+Usage:
+    csprite.py [--name NAME] [--encoding auto|packed|rle] [-o OUTPUT] IMAGE...
+
+Several images are written into a single header. Sizes of raw and compressed data are reported to stderr.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+import zlib
+
+TRANSPARENT = None
+
+
+def read_png(data):
+    if data[:8] != b'\x89PNG\r\n\x1a\n':
+        raise ValueError('not a PNG file')
+
+    pos, idat, plte, trns = 8, b'', None, None
+    width = height = depth = ctype = interlace = None
+    while pos < len(data):
+        length, kind = struct.unpack('>I4s', data[pos:pos + 8])
+        chunk = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if kind == b'IHDR':
+            width, height, depth, ctype, _, _, interlace = struct.unpack('>IIBBBBB', chunk)
+        elif kind == b'PLTE':
+            plte = [tuple(chunk[i:i + 3]) for i in range(0, len(chunk), 3)]
+        elif kind == b'tRNS':
+            trns = chunk
+        elif kind == b'IDAT':
+            idat += chunk
+        elif kind == b'IEND':
+            break
+
+    if depth != 8 or interlace != 0:
+        raise ValueError('only 8-bit non-interlaced PNG files are supported')
+
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[ctype]
+    stride = width * channels
+    raw = zlib.decompress(idat)
+    rows, prev = [], bytearray(stride)
+
+    for y in range(height):
+        f = raw[y * (stride + 1)]
+        line = bytearray(raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)])
+        for i in range(stride):
+            a = line[i - channels] if i >= channels else 0
+            b = prev[i]
+            c = prev[i - channels] if i >= channels else 0
+            if f == 1:
+                line[i] = (line[i] + a) & 0xFF
+            elif f == 2:
+                line[i] = (line[i] + b) & 0xFF
+            elif f == 3:
+                line[i] = (line[i] + (a + b) // 2) & 0xFF
+            elif f == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                pr = a if pa <= pb and pa <= pc else b if pb <= pc else c
+                line[i] = (line[i] + pr) & 0xFF
+        rows.append(line)
+        prev = line
+
+    pixels = []
+    for line in rows:
+        for x in range(width):
+            px = line[x * channels:(x + 1) * channels]
+            if ctype == 0:
+                pixels.append((px[0], px[0], px[0]))
+            elif ctype == 2:
+                pixels.append(tuple(px))
+            elif ctype == 3:
+                alpha = trns[px[0]] if trns is not None and px[0] < len(trns) else 255
+                pixels.append(plte[px[0]] if alpha >= 128 else TRANSPARENT)
+            elif ctype == 4:
+                pixels.append((px[0], px[0], px[0]) if px[1] >= 128 else TRANSPARENT)
+            else:
+                pixels.append(tuple(px[:3]) if px[3] >= 128 else TRANSPARENT)
+
+    return width, height, pixels
+
+
+def read_ppm(data):
+    tokens, pos = [], 2
+    while len(tokens) < 3:
+        m = re.compile(rb'\s*(#[^\n]*\n\s*)*(\d+)').match(data, pos)
+        tokens.append(int(m.group(2)))
+        pos = m.end()
+    width, height, maxval = tokens
+    if maxval != 255:
+        raise ValueError('only 8-bit PPM files are supported')
+    raw = data[pos + 1:pos + 1 + width * height * 3]
+    return width, height, [tuple(raw[i:i + 3]) for i in range(0, len(raw), 3)]
+
+
+def read_image(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:2] == b'P6':
+        return read_ppm(data)
+    return read_png(data)
+
+
+def make_palette(pixels):
+    colors = sorted(set(p for p in pixels if p is not TRANSPARENT))
+    has_key = TRANSPARENT in pixels
+    palette = ([(0, 0, 0)] if has_key else []) + colors
+    if len(palette) > 256:
+        raise ValueError('image has more than 256 colors')
+    index = {c: i + (1 if has_key else 0) for i, c in enumerate(colors)}
+    index[TRANSPARENT] = 0
+    return palette, [index[p] for p in pixels], has_key
+
+
+def encode_packed(width, height, indices, n_colors):
+    bpp = next(b for b in (1, 2, 4, 8) if n_colors <= 1 << b)
+    per_byte = 8 // bpp
+    out = bytearray()
+    for y in range(height):
+        row = indices[y * width:(y + 1) * width]
+        for i in range(0, width, per_byte):
+            byte = 0
+            for n, idx in enumerate(row[i:i + per_byte]):
+                byte |= idx << (8 - bpp * (n + 1))
+            out.append(byte)
+    return bpp, bytes(out)
+
+
+def encode_rle(indices):
+    out, literals, i = bytearray(), [], 0
+
+    def flush():
+        while literals:
+            chunk = literals[:128]
+            del literals[:128]
+            out.append(0x80 | (len(chunk) - 1))
+            out.extend(chunk)
+
+    while i < len(indices):
+        run = 1
+        while i + run < len(indices) and indices[i + run] == indices[i] and run < 128:
+            run += 1
+        if run >= 3:
+            flush()
+            out.append(run - 1)
+            out.append(indices[i])
+            i += run
+        else:
+            literals.append(indices[i])
+            i += 1
+    flush()
+
+    return bytes(out)
+
+
+def c_bytes(data, indent='    '):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append(indent + ', '.join('0x%02X' % b for b in data[i:i + 16]) + ',')
+    return '\n'.join(lines)
+
+
+def convert(path, name, encoding):
+    width, height, pixels = read_image(path)
+    palette, indices, has_key = make_palette(pixels)
+
+    bpp, packed = encode_packed(width, height, indices, len(palette))
+    rle = encode_rle(indices)
+
+    if encoding == 'auto':
+        encoding = 'rle' if len(rle) < len(packed) else 'packed'
+    data = rle if encoding == 'rle' else packed
+
+    raw_size = width * height * 3
+    size = len(data) + len(palette) * 3
+    sys.stderr.write('%s: %dx%d, %d colors, raw %d bytes, %s %d bytes (%.1f%%)\n' % (
+        name, width, height, len(palette), raw_size, encoding, size, 100.0 * size / raw_size))
+
+    out = '// %s%s\n' % (os.path.basename(path), ', index 0 is transparent' if has_key else '')
+    out += 'static const dy_gfx_px_t %s_palette[] = {\n' % name
+    out += '\n'.join('    {0x%02X, 0x%02X, 0x%02X},' % c for c in palette) + '\n};\n\n'
+    out += 'static const uint8_t %s_data[] = {\n%s\n};\n\n' % (name, c_bytes(data))
+    out += 'static const dy_gfx_csprite_t %s = {\n' % name
+    out += '    .width = %d,\n    .height = %d,\n' % (width, height)
+    out += '    .encoding = %s,\n' % ('DY_GFX_CSPRITE_RLE' if encoding == 'rle' else 'DY_GFX_CSPRITE_PACKED')
+    out += '    .bpp = %d,\n' % (bpp if encoding == 'packed' else 8)
+    out += '    .n_colors = %d,\n    .palette = %s_palette,\n' % (len(palette), name)
+    out += '    .data_len = sizeof(%s_data),\n    .data = %s_data,\n};\n' % (name, name)
+
+    return out, raw_size, size
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Converts images into dy_gfx compressed sprites.')
+    parser.add_argument('images', nargs='+')
+    parser.add_argument('--name', help='C identifier; defaults to the image file name')
+    parser.add_argument('--encoding', choices=('auto', 'packed', 'rle'), default='auto')
+    parser.add_argument('-o', '--output', help='output header; defaults to stdout')
+    args = parser.parse_args()
+
+    if args.name and len(args.images) > 1:
+        parser.error('--name can be used with a single image only')
+
+    out = '#pragma once\n\n#include "dy/gfx/csprite.h"\n'
+    total_raw = total = 0
+    for path in args.images:
+        name = args.name or re.sub(r'\W', '_', os.path.splitext(os.path.basename(path))[0])
+        code, raw_size, size = convert(path, name, args.encoding)
+        out += '\n' + code
+        total_raw += raw_size
+        total += size
+
+    if len(args.images) > 1:
+        sys.stderr.write('total: raw %d bytes, compressed %d bytes (%.1f%%)\n' % (
+            total_raw, total, 100.0 * total / total_raw))
+
+    if args.output:
+        with open(args.output, 'w') as f:
+            f.write(out)
+    else:
+        sys.stdout.write(out)
+
+
+if __name__ == '__main__':
+    main()
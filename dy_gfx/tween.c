@@ -0,0 +1,187 @@
+#include "dy/gfx/tween.h"
+
+#define ONE DY_GFX_TWEEN_ONE
+#define HALF (DY_GFX_TWEEN_ONE / 2)
+
+// Multiplies two Q16.16 numbers.
+static inline int32_t mul(int32_t a, int32_t b) {
+    return (int32_t) (((int64_t) a * b) >> 16);
+}
+
+// The distance between two int32_t values only fits in 64 bits, and so may an overshooting result.
+static inline int32_t interpolate(int32_t from, int32_t to, int32_t p) {
+    int64_t v = from + ((((int64_t) to - from) * p + HALF) >> 16);
+    return v < INT32_MIN ? INT32_MIN : v > INT32_MAX ? INT32_MAX : (int32_t) v;
+}
+
+static inline uint8_t clamp_u8(int32_t v) {
+    return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+static int32_t out_bounce(int32_t t) {
+    const int32_t n1 = 495616; // 7.5625
+
+    if (t < 23831) {        // 1 / 2.75
+        return mul(n1, mul(t, t));
+    } else if (t < 47663) { // 2 / 2.75
+        t -= 35747;
+        return mul(n1, mul(t, t)) + 49152;
+    } else if (t < 59578) { // 2.5 / 2.75
+        t -= 53620;
+        return mul(n1, mul(t, t)) + 61440;
+    }
+
+    t -= 62557;
+    return mul(n1, mul(t, t)) + 64512;
+}
+
+int32_t dy_gfx_ease(dy_gfx_ease_t ease, int32_t t) {
+    int32_t u = ONE - t;
+
+    if (t <= 0) {
+        return 0;
+    } else if (t >= ONE) {
+        return ONE;
+    }
+
+    switch (ease) {
+        case DY_GFX_EASE_IN_QUAD:
+            return mul(t, t);
+        case DY_GFX_EASE_OUT_QUAD:
+            return ONE - mul(u, u);
+        case DY_GFX_EASE_IN_OUT_QUAD:
+            return t < HALF ? 2 * mul(t, t) : ONE - 2 * mul(u, u);
+        case DY_GFX_EASE_IN_CUBIC:
+            return mul(mul(t, t), t);
+        case DY_GFX_EASE_OUT_CUBIC:
+            return ONE - mul(mul(u, u), u);
+        case DY_GFX_EASE_IN_OUT_CUBIC:
+            return t < HALF ? 4 * mul(mul(t, t), t) : ONE - 4 * mul(mul(u, u), u);
+        case DY_GFX_EASE_SMOOTH:
+            // Rounding t^2 first would make the curve step back here and there
+            return (int32_t) (((int64_t) t * t * (3 * ONE - 2 * t)) >> 32);
+        case DY_GFX_EASE_OUT_BACK: {
+            const int32_t c1 = 111514; // 1.70158
+            const int32_t c3 = c1 + ONE;
+            int32_t u2 = mul(u, u);
+            return ONE - mul(c3, mul(u2, u)) + mul(c1, u2);
+        }
+        case DY_GFX_EASE_OUT_BOUNCE:
+            return out_bounce(t);
+        default:
+            return t;
+    }
+}
+
+bool dy_gfx_tween_apply(const dy_gfx_tween_t *tween, uint32_t frame_n) {
+    if (frame_n < tween->start || frame_n - tween->start > tween->duration) {
+        return false;
+    }
+
+    int32_t p = ONE;
+    if (tween->duration > 0) {
+        p = dy_gfx_ease(tween->ease, (int32_t) (((uint64_t) (frame_n - tween->start) << 16) / tween->duration));
+    }
+
+    const dy_gfx_tween_value_t *from = &tween->from, *to = &tween->to;
+    bool changed = false;
+
+    switch (tween->kind) {
+        case DY_GFX_TWEEN_I32: {
+            int32_t *v = tween->target, nv = interpolate(from->i32, to->i32, p);
+            changed = *v != nv;
+            *v = nv;
+            break;
+        }
+        case DY_GFX_TWEEN_U8: {
+            uint8_t *v = tween->target, nv = clamp_u8(interpolate(from->u8, to->u8, p));
+            changed = *v != nv;
+            *v = nv;
+            break;
+        }
+        case DY_GFX_TWEEN_POINT: {
+            dy_gfx_point_t *v = tween->target, nv = {
+                .x = interpolate(from->point.x, to->point.x, p),
+                .y = interpolate(from->point.y, to->point.y, p),
+            };
+            changed = v->x != nv.x || v->y != nv.y;
+            *v = nv;
+            break;
+        }
+        case DY_GFX_TWEEN_PX: {
+            dy_gfx_px_t *v = tween->target, nv = {
+                .r = clamp_u8(interpolate(from->px.r, to->px.r, p)),
+                .g = clamp_u8(interpolate(from->px.g, to->px.g, p)),
+                .b = clamp_u8(interpolate(from->px.b, to->px.b, p)),
+            };
+            changed = v->r != nv.r || v->g != nv.g || v->b != nv.b;
+            *v = nv;
+            break;
+        }
+        case DY_GFX_TWEEN_LAYER_POS: {
+            dy_gfx_layer_t *layer = tween->target;
+            dy_gfx_point_t nv = {
+                .x = interpolate(from->point.x, to->point.x, p),
+                .y = interpolate(from->point.y, to->point.y, p),
+            };
+            changed = layer->pos.x != nv.x || layer->pos.y != nv.y;
+            dy_gfx_layer_set_pos(layer, nv);
+            break;
+        }
+        case DY_GFX_TWEEN_LAYER_ALPHA: {
+            dy_gfx_layer_t *layer = tween->target;
+            uint8_t alpha = clamp_u8(interpolate(from->u8, to->u8, p));
+            changed = layer->blend.mode != DY_GFX_BLEND_ALPHA || layer->blend.alpha != alpha;
+            if (changed) {
+                dy_gfx_layer_set_blend(layer, (dy_gfx_blend_t) {.mode = DY_GFX_BLEND_ALPHA, .alpha = alpha});
+            }
+            break;
+        }
+    }
+
+    if (changed && tween->on_update != NULL) {
+        tween->on_update(tween->args);
+    }
+
+    return changed;
+}
+
+void dy_gfx_timeline_init(dy_gfx_timeline_t *tl, bool loop, dy_gfx_tween_cb_t on_frame, void *args) {
+    tl->loop = loop;
+    tl->duration = 0;
+    tl->on_frame = on_frame;
+    tl->args = args;
+    tl->len = 0;
+}
+
+dy_err_t dy_gfx_timeline_add(dy_gfx_timeline_t *tl, dy_gfx_tween_t tween) {
+    if (tl->len == DY_GFX_TIMELINE_MAX) {
+        return dy_err(DY_ERR_NO_MEM, "timeline is full");
+    }
+
+    tl->tweens[tl->len++] = tween;
+
+    if (tween.start + tween.duration > tl->duration) {
+        tl->duration = tween.start + tween.duration;
+    }
+
+    return dy_ok();
+}
+
+dy_gfx_anim_state_t dy_gfx_timeline_animator(void *args, uint32_t frame_n) {
+    dy_gfx_timeline_t *tl = args;
+
+    for (uint8_t i = 0; i < tl->len; i++) {
+        dy_gfx_tween_apply(&tl->tweens[i], frame_n);
+    }
+
+    if (tl->on_frame != NULL) {
+        tl->on_frame(tl->args);
+    }
+
+    if (frame_n < tl->duration) {
+        return DY_GFX_ANIM_CONTINUE;
+    }
+
+    return tl->loop ? DY_GFX_ANIM_RESTART : DY_GFX_ANIM_STOP;
+}
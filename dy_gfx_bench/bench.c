@@ -0,0 +1,563 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <alloca.h>
+#include "dy/error.h"
+#include "dy/gfx/gfx.h"
+#include "dy/gfx/geometry.h"
+#include "dy/gfx/csprite.h"
+#include "dy/gfx/qoi.h"
+#include "dy/gfx/sprite.h"
+#include "dy/gfx/text.h"
+#include "dy/display.h"
+#include "dy/gfx_bench.h"
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#if defined(ESP_PLATFORM) && !defined(CONFIG_IDF_TARGET_LINUX)
+#include "esp_timer.h"
+#define PLATFORM CONFIG_IDF_TARGET
+#else
+#include <time.h>
+#define PLATFORM "host"
+#endif
+
+#define NOINLINE __attribute__((noinline))
+#define DEFAULT_MIN_TIME_US 100000
+#define MAX_ITERATIONS (1 << 24)
+#define STACK_PROBE_LEN 2048
+#define STACK_PATTERN 0xA5
+
+// Benchmark case context.
+typedef struct {
+    const dy_gfx_bench_config_t *cfg;
+    dy_gfx_buf_t *buf; // destination
+    dy_gfx_buf_t *src; // source with some content
+    uint8_t *data;     // encoded input made by the case's `prepare`, freed after the case
+    uint32_t data_len;
+    dy_err_t err;
+} ctx_t;
+
+typedef void (*case_fn_t)(ctx_t *ctx);
+
+typedef struct {
+    const char *name;
+    case_fn_t fn;
+    case_fn_t prepare; // optional, runs once per size before measuring
+} bench_case_t;
+
+// Digits and a colon; all glyphs look like zero, which is enough for timing.
+static const uint8_t font_data[] = {
+    5, 0x70, 0x88, 0x98, 0xA8, 0xC8, 0x88, 0x70, 0x00,
+    5, 0x70, 0x88, 0x98, 0xA8, 0xC8, 0x88, 0x70, 0x00,
+    5, 0x70, 0x88, 0x98, 0xA8, 0xC8, 0x88, 0x70, 0x00,
+    5, 0x70, 0x88, 0x98, 0xA8, 0xC8, 0x88, 0x70, 0x00,
+    5, 0x70, 0x88, 0x98, 0xA8, 0xC8, 0x88, 0x70, 0x00,
+    5, 0x70, 0x88, 0x98, 0xA8, 0xC8, 0x88, 0x70, 0x00,
+    5, 0x70, 0x88, 0x98, 0xA8, 0xC8, 0x88, 0x70, 0x00,
+    5, 0x70, 0x88, 0x98, 0xA8, 0xC8, 0x88, 0x70, 0x00,
+    5, 0x70, 0x88, 0x98, 0xA8, 0xC8, 0x88, 0x70, 0x00,
+    5, 0x70, 0x88, 0x98, 0xA8, 0xC8, 0x88, 0x70, 0x00,
+    1, 0x00, 0x00, 0x80, 0x00, 0x00, 0x80, 0x00, 0x00,
+};
+
+static const dy_gfx_font_t font = {
+    .ascii_offset = '0',
+    .length = 11,
+    .width = DY_GFX_FONT_SYMBOL_WIDTH_8,
+    .height = 8,
+    .content.c8 = font_data,
+};
+
+static const uint16_t sizes[][2] = {{8, 8}, {32, 16}, {64, 32}, {128, 64}};
+
+static const dy_gfx_px_t csprite_palette[16] = {
+    {0, 0, 0}, {255, 255, 255}, {255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {255, 255, 0}, {0, 255, 255}, {255, 0, 255},
+    {128, 0, 0}, {0, 128, 0}, {0, 0, 128}, {128, 128, 0}, {0, 128, 128}, {128, 0, 128}, {128, 128, 128}, {64, 64, 64},
+};
+
+static volatile uint32_t n_allocs;
+
+#ifdef CONFIG_DY_GFX_BENCH_COUNT_ALLOCS
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    n_allocs++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+    n_allocs++;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    n_allocs++;
+    return __real_realloc(ptr, size);
+}
+#endif
+
+static uint64_t now_ns() {
+#if defined(ESP_PLATFORM) && !defined(CONFIG_IDF_TARGET_LINUX)
+    return (uint64_t) esp_timer_get_time() * 1000;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+static void bench_fill(ctx_t *ctx) {
+    dy_gfx_fill(ctx->buf, dy_gfx_new_px(1, 2, 3));
+}
+
+static void bench_colorize(ctx_t *ctx) {
+    dy_gfx_colorize(ctx->buf, dy_gfx_new_px(3, 2, 1));
+}
+
+static void bench_invert(ctx_t *ctx) {
+    dy_gfx_invert(ctx->buf);
+}
+
+static void bench_threshold(ctx_t *ctx) {
+    dy_gfx_threshold(ctx->buf, 128);
+}
+
+static void bench_scale(ctx_t *ctx) {
+    dy_gfx_scale(ctx->buf, 200);
+}
+
+static void bench_merge(ctx_t *ctx) {
+    dy_gfx_merge(ctx->buf, ctx->src, (dy_gfx_point_t) {0, 0}, (dy_gfx_point_t) {0, 0});
+}
+
+static void bench_merge_alpha(ctx_t *ctx) {
+    dy_gfx_blend_t blend = {.mode = DY_GFX_BLEND_ALPHA, .alpha = 128};
+    dy_gfx_merge_blend(ctx->buf, ctx->src, (dy_gfx_point_t) {0, 0}, (dy_gfx_point_t) {0, 0}, &blend);
+}
+
+static void bench_split(ctx_t *ctx) {
+    dy_gfx_free_buf_array(dy_gfx_split(ctx->src, 8, 8));
+}
+
+static void bench_move(ctx_t *ctx) {
+    dy_gfx_move(ctx->buf, (dy_gfx_point_t) {1, 1});
+}
+
+static void bench_puts(ctx_t *ctx) {
+    dy_gfx_puts(ctx->buf, &font, (dy_gfx_point_t) {0, 0}, "12:34", dy_gfx_new_px(255, 0, 0), 1);
+}
+
+static void bench_line(ctx_t *ctx) {
+    dy_gfx_line_t line = {{0, 0}, {ctx->buf->width - 1, ctx->buf->height - 1}};
+    dy_gfx_line(ctx->buf, &line, dy_gfx_new_px(0, 255, 0));
+}
+
+static void bench_fill_rect(ctx_t *ctx) {
+    dy_gfx_point_t p2 = {ctx->buf->width - 1, ctx->buf->height - 1};
+    dy_gfx_fill_rect(ctx->buf, (dy_gfx_point_t) {0, 0}, p2, dy_gfx_new_px(0, 0, 255));
+}
+
+static void bench_fill_circle(ctx_t *ctx) {
+    dy_gfx_point_t center = {ctx->buf->width / 2, ctx->buf->height / 2};
+    uint16_t radius = (ctx->buf->width < ctx->buf->height ? ctx->buf->width : ctx->buf->height) / 2;
+    dy_gfx_fill_circle(ctx->buf, center, radius, dy_gfx_new_px(255, 255, 0));
+}
+
+static void bench_fill_poly(ctx_t *ctx) {
+    // Concave arrow spanning the buffer
+    int32_t w = ctx->buf->width - 1, h = ctx->buf->height - 1;
+    dy_gfx_point_t pts[] = {{0, h / 2}, {w / 2, 0}, {w / 2, h / 4}, {w, h / 4}, {w, h * 3 / 4}, {w / 2, h * 3 / 4},
+                            {w / 2, h}};
+    dy_gfx_fill_poly(ctx->buf, &(dy_gfx_poly_t) {7, pts}, dy_gfx_new_px(0, 255, 255));
+}
+
+static void bench_fill_round_rect(ctx_t *ctx) {
+    dy_gfx_point_t p2 = {ctx->buf->width - 1, ctx->buf->height - 1};
+    dy_gfx_fill_round_rect(ctx->buf, (dy_gfx_point_t) {0, 0}, p2, ctx->buf->height / 4, dy_gfx_new_px(255, 0, 255));
+}
+
+// Baselines of the fills: the same shapes drawn by a dy_gfx_line() per row, as callers emulated fills before.
+
+static void bench_fill_rect_lines(ctx_t *ctx) {
+    for (int32_t y = 0; y < ctx->buf->height; y++) {
+        dy_gfx_line_t line = {{0, y}, {ctx->buf->width - 1, y}};
+        dy_gfx_line(ctx->buf, &line, dy_gfx_new_px(0, 0, 255));
+    }
+}
+
+static void bench_fill_circle_lines(ctx_t *ctx) {
+    int32_t cx = ctx->buf->width / 2, cy = ctx->buf->height / 2;
+    int32_t r = (ctx->buf->width < ctx->buf->height ? ctx->buf->width : ctx->buf->height) / 2;
+
+    // Half-width of the row dy away from the center, walked down as dy grows
+    int32_t x = r;
+    for (int32_t dy = 0; dy <= r; dy++) {
+        while (x * x + dy * dy > r * r) {
+            x--;
+        }
+
+        dy_gfx_line_t top = {{cx - x, cy - dy}, {cx + x, cy - dy}};
+        dy_gfx_line(ctx->buf, &top, dy_gfx_new_px(255, 255, 0));
+        if (dy > 0) {
+            dy_gfx_line_t bottom = {{cx - x, cy + dy}, {cx + x, cy + dy}};
+            dy_gfx_line(ctx->buf, &bottom, dy_gfx_new_px(255, 255, 0));
+        }
+    }
+}
+
+static void bench_blit_sprite(ctx_t *ctx) {
+    dy_gfx_sprite_t sp = {.width = ctx->src->width, .height = ctx->src->height, .data = ctx->src->content};
+    dy_gfx_blit_sprite(ctx->buf, (dy_gfx_point_t) {0, 0}, &sp, DY_GFX_SPRITE_KEY, dy_gfx_new_px(0, 0, 0));
+}
+
+// Palette index of a compressed sprite pixel: horizontal runs of 1 to 6 pixels, as in typical icons.
+static uint8_t csprite_index(uint32_t x, uint32_t y) {
+    return ((x / (1 + y % 6)) * 5 + y) % 16;
+}
+
+static void prepare_csprite_packed(ctx_t *ctx) {
+    uint16_t w = ctx->buf->width, h = ctx->buf->height;
+    uint32_t stride = (w + 1) / 2;
+
+    ctx->data_len = stride * h;
+    if ((ctx->data = calloc(1, ctx->data_len)) == NULL) {
+        ctx->err = dy_err(DY_ERR_NO_MEM, "calloc failed");
+        return;
+    }
+
+    for (uint32_t y = 0; y < h; y++) {
+        for (uint32_t x = 0; x < w; x++) {
+            ctx->data[y * stride + x / 2] |= csprite_index(x, y) << (x % 2 == 0 ? 4 : 0);
+        }
+    }
+}
+
+static void prepare_csprite_rle(ctx_t *ctx) {
+    uint32_t w = ctx->buf->width, n_px = w * ctx->buf->height;
+
+    // There is at most a token and an index per pixel
+    if ((ctx->data = malloc(2 * n_px)) == NULL) {
+        ctx->err = dy_err(DY_ERR_NO_MEM, "malloc failed");
+        return;
+    }
+
+    // Runs of 3 and more pixels become run tokens, everything else goes into literal ones, like tools/csprite.py does
+    uint32_t len = 0, lit = 0; // `lit` is the position of the open literal token, 0 if there is none
+    for (uint32_t i = 0; i < n_px;) {
+        uint8_t idx = csprite_index(i % w, i / w);
+        uint32_t run = 1;
+        while (i + run < n_px && run < 128 && csprite_index((i + run) % w, (i + run) / w) == idx) {
+            run++;
+        }
+
+        if (run >= 3) {
+            ctx->data[len++] = run - 1;
+            ctx->data[len++] = idx;
+            lit = 0;
+            i += run;
+            continue;
+        }
+
+        if (lit == 0 || ctx->data[lit - 1] == 0xFF) {
+            ctx->data[len++] = 0x80;
+            lit = len;
+        } else {
+            ctx->data[lit - 1]++;
+        }
+        ctx->data[len++] = idx;
+        i++;
+    }
+    ctx->data_len = len;
+}
+
+static void blit_csprite(ctx_t *ctx, uint8_t encoding) {
+    const dy_gfx_csprite_t sp = {
+        .width = ctx->buf->width,
+        .height = ctx->buf->height,
+        .encoding = encoding,
+        .bpp = encoding == DY_GFX_CSPRITE_PACKED ? 4 : 8,
+        .n_colors = 16,
+        .palette = csprite_palette,
+        .data_len = ctx->data_len,
+        .data = ctx->data,
+    };
+
+    dy_err_t err = dy_gfx_blit_csprite(ctx->buf, (dy_gfx_point_t) {0, 0}, &sp, DY_GFX_SPRITE_KEY);
+    if (dy_is_err(err)) {
+        ctx->err = err;
+    }
+}
+
+static void bench_blit_csprite_packed(ctx_t *ctx) {
+    blit_csprite(ctx, DY_GFX_CSPRITE_PACKED);
+}
+
+static void bench_blit_csprite_rle(ctx_t *ctx) {
+    blit_csprite(ctx, DY_GFX_CSPRITE_RLE);
+}
+
+// Encodes the source as a QOI image, with every op but RGBA, since the source is opaque.
+static void prepare_qoi(ctx_t *ctx) {
+    const dy_gfx_buf_t *src = ctx->src;
+    uint32_t n_px = src->width * src->height;
+    uint8_t index[64][3] = {0}, prev[3] = {0, 0, 0}, run = 0;
+
+    // At most 4 bytes per pixel, the header and the end marker
+    uint8_t *p = ctx->data = malloc(DY_GFX_QOI_HEADER_LEN + 4 * n_px + 8);
+    if (p == NULL) {
+        ctx->err = dy_err(DY_ERR_NO_MEM, "malloc failed");
+        return;
+    }
+
+    const uint8_t header[DY_GFX_QOI_HEADER_LEN] = {'q', 'o', 'i', 'f', 0, 0, src->width >> 8, src->width, 0, 0,
+                                                   src->height >> 8, src->height, 3, 0};
+    memcpy(p, header, sizeof(header));
+    p += sizeof(header);
+
+    for (uint32_t i = 0; i < n_px; i++) {
+        const uint8_t px[3] = {src->content[i].r, src->content[i].g, src->content[i].b};
+        uint8_t h = (px[0] * 3 + px[1] * 5 + px[2] * 7 + 255 * 11) % 64;
+
+        if (memcmp(px, prev, 3) == 0) {
+            if (++run == 62 || i == n_px - 1) {
+                *p++ = 0xC0 | (run - 1);
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0) {
+            *p++ = 0xC0 | (run - 1);
+            run = 0;
+        }
+
+        int8_t dr = px[0] - prev[0], dg = px[1] - prev[1], db = px[2] - prev[2];
+        if (memcmp(index[h], px, 3) == 0) {
+            *p++ = h;
+        } else if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+            *p++ = 0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2);
+        } else if (dg >= -32 && dg <= 31 && dr - dg >= -8 && dr - dg <= 7 && db - dg >= -8 && db - dg <= 7) {
+            *p++ = 0x80 | (dg + 32);
+            *p++ = (dr - dg + 8) << 4 | (db - dg + 8);
+        } else {
+            *p++ = 0xFE;
+            memcpy(p, px, 3);
+            p += 3;
+        }
+
+        memcpy(index[h], px, 3);
+        memcpy(prev, px, 3);
+    }
+
+    memcpy(p, (const uint8_t[]) {0, 0, 0, 0, 0, 0, 0, 1}, 8);
+    ctx->data_len = p + 8 - ctx->data;
+}
+
+static void bench_qoi(ctx_t *ctx) {
+    dy_err_t err = dy_gfx_qoi_decode(ctx->buf, (dy_gfx_point_t) {0, 0}, ctx->data, ctx->data_len);
+    if (dy_is_err(err)) {
+        ctx->err = err;
+    }
+}
+
+static void bench_display_write(ctx_t *ctx) {
+    dy_err_t err = dy_display_write(ctx->cfg->display_id, ctx->src);
+    if (dy_is_err(err)) {
+        ctx->err = err;
+    }
+}
+
+static const bench_case_t cases[] = {
+    {"fill", bench_fill},
+    {"colorize", bench_colorize},
+    {"invert", bench_invert},
+    {"threshold", bench_threshold},
+    {"scale", bench_scale},
+    {"merge", bench_merge},
+    {"merge_alpha", bench_merge_alpha},
+    {"split", bench_split},
+    {"move", bench_move},
+    {"puts", bench_puts},
+    {"line", bench_line},
+    {"fill_rect", bench_fill_rect},
+    {"fill_rect_lines", bench_fill_rect_lines},
+    {"fill_circle", bench_fill_circle},
+    {"fill_circle_lines", bench_fill_circle_lines},
+    {"fill_poly", bench_fill_poly},
+    {"fill_round_rect", bench_fill_round_rect},
+    {"blit_sprite", bench_blit_sprite},
+    {"blit_csprite_packed", bench_blit_csprite_packed, prepare_csprite_packed},
+    {"blit_csprite_rle", bench_blit_csprite_rle, prepare_csprite_rle},
+    {"qoi", bench_qoi, prepare_qoi},
+    {"display_write", bench_display_write},
+};
+
+// Fills the stack area below the caller's frame with a pattern.
+static NOINLINE void paint_stack() {
+    volatile uint8_t *probe = alloca(STACK_PROBE_LEN);
+
+    for (uint32_t i = 0; i < STACK_PROBE_LEN; i++) {
+        probe[i] = STACK_PATTERN;
+    }
+}
+
+// Returns the size of the stack area below the caller's frame which has been overwritten since paint_stack().
+static NOINLINE uint32_t stack_used() {
+    volatile uint8_t *probe = alloca(STACK_PROBE_LEN);
+    uint32_t i = 0;
+
+    // The stack grows down, so the deepest untouched bytes are at the lowest addresses
+    while (i < STACK_PROBE_LEN && probe[i] == STACK_PATTERN) {
+        i++;
+    }
+
+    return STACK_PROBE_LEN - i;
+}
+
+static NOINLINE uint32_t measure_stack(case_fn_t fn, ctx_t *ctx) {
+    paint_stack();
+    fn(ctx);
+    return stack_used();
+}
+
+static void fill_source(dy_gfx_buf_t *buf) {
+    for (uint32_t i = 0; i < buf->width * buf->height; i++) {
+        buf->content[i] = dy_gfx_new_px(i * 7, i * 13, i % 3 == 0 ? 0 : i * 5);
+    }
+}
+
+static dy_err_t run_case(const bench_case_t *c, uint16_t width, uint16_t height, ctx_t *ctx, uint64_t min_ns,
+                         dy_gfx_bench_result_t *res) {
+    uint32_t n = 1;
+    uint64_t elapsed;
+    uint32_t allocs;
+
+    for (;;) {
+        allocs = n_allocs;
+        uint64_t start = now_ns();
+        for (uint32_t i = 0; i < n; i++) {
+            c->fn(ctx);
+        }
+        elapsed = now_ns() - start;
+        allocs = n_allocs - allocs;
+
+        if (dy_is_err(ctx->err)) {
+            return ctx->err;
+        }
+
+        if (elapsed >= min_ns || n >= MAX_ITERATIONS) {
+            break;
+        }
+
+        // Aim slightly above the minimum time to avoid another round
+        uint64_t next = elapsed > 0 ? min_ns * 5 / 4 * n / elapsed : (uint64_t) n * 16;
+        n = next <= n ? n * 2 : next > MAX_ITERATIONS ? MAX_ITERATIONS : next;
+    }
+
+    res->name = c->name;
+    res->width = width;
+    res->height = height;
+    res->iterations = n;
+    res->ns_per_call = elapsed / n;
+    res->ps_per_px = elapsed * 1000 / ((uint64_t) n * width * height);
+    res->allocs_per_call = (uint64_t) allocs * 1000 / n;
+    res->stack_bytes = measure_stack(c->fn, ctx);
+
+    return dy_ok();
+}
+
+static void print_result(const dy_gfx_bench_config_t *cfg, const dy_gfx_bench_result_t *r, bool first) {
+    // Allocations are left empty, or null in JSON, unless they are counted
+    char allocs[24] = "";
+#ifdef CONFIG_DY_GFX_BENCH_COUNT_ALLOCS
+    snprintf(allocs, sizeof(allocs), "%lu.%03lu", (unsigned long) r->allocs_per_call / 1000,
+             (unsigned long) r->allocs_per_call % 1000);
+#else
+    if (cfg->format == DY_GFX_BENCH_JSON) {
+        strcpy(allocs, "null");
+    }
+#endif
+
+    if (cfg->format == DY_GFX_BENCH_CSV) {
+        fprintf(cfg->out, "%s,%u,%u,%lu,%llu,%lu.%03lu,%s,%lu\n",
+                r->name, r->width, r->height, (unsigned long) r->iterations, (unsigned long long) r->ns_per_call,
+                (unsigned long) r->ps_per_px / 1000, (unsigned long) r->ps_per_px % 1000, allocs,
+                (unsigned long) r->stack_bytes);
+        return;
+    }
+
+    fprintf(cfg->out, "%s\n    {\"name\": \"%s\", \"width\": %u, \"height\": %u, \"iterations\": %lu, "
+                      "\"ns_per_call\": %llu, \"ns_per_px\": %lu.%03lu, \"allocs_per_call\": %s, "
+                      "\"stack_bytes\": %lu}",
+            first ? "" : ",", r->name, r->width, r->height, (unsigned long) r->iterations,
+            (unsigned long long) r->ns_per_call, (unsigned long) r->ps_per_px / 1000,
+            (unsigned long) r->ps_per_px % 1000, allocs, (unsigned long) r->stack_bytes);
+}
+
+dy_err_t dy_gfx_bench_run(const dy_gfx_bench_config_t *cfg) {
+    dy_err_t err = dy_ok();
+    uint64_t min_ns = (uint64_t) (cfg->min_time_us > 0 ? cfg->min_time_us : DEFAULT_MIN_TIME_US) * 1000;
+    bool first = true;
+
+    if (cfg->format == DY_GFX_BENCH_CSV) {
+        fprintf(cfg->out, "name,width,height,iterations,ns_per_call,ns_per_px,allocs_per_call,stack_bytes\n");
+    } else {
+        fprintf(cfg->out, "{\n  \"platform\": \"%s\",\n  \"results\": [", PLATFORM);
+    }
+
+    for (uint8_t i = 0; i < sizeof(cases) / sizeof(cases[0]) && !dy_is_err(err); i++) {
+        const bench_case_t *c = &cases[i];
+
+        if (cfg->filter != NULL && strstr(c->name, cfg->filter) == NULL) {
+            continue;
+        }
+        if (c->fn == bench_display_write && !cfg->with_display) {
+            continue;
+        }
+
+        for (uint8_t j = 0; j < sizeof(sizes) / sizeof(sizes[0]) && !dy_is_err(err); j++) {
+            dy_gfx_bench_result_t res = {0};
+            ctx_t ctx = {
+                .cfg = cfg,
+                .buf = dy_gfx_new_buf(sizes[j][0], sizes[j][1]),
+                .src = dy_gfx_new_buf(sizes[j][0], sizes[j][1]),
+                .err = dy_ok(),
+            };
+
+            if (ctx.buf == NULL || ctx.src == NULL) {
+                err = dy_err(DY_ERR_NO_MEM, "dy_gfx_new_buf failed");
+            } else {
+                fill_source(ctx.src);
+                if (c->prepare != NULL) {
+                    c->prepare(&ctx);
+                    err = ctx.err;
+                }
+                if (!dy_is_err(err) && !dy_is_err(err = run_case(c, sizes[j][0], sizes[j][1], &ctx, min_ns, &res))) {
+                    print_result(cfg, &res, first);
+                    first = false;
+                }
+            }
+
+            free(ctx.data);
+
+            if (ctx.buf != NULL) {
+                dy_gfx_free_buf(ctx.buf);
+            }
+            if (ctx.src != NULL) {
+                dy_gfx_free_buf(ctx.src);
+            }
+        }
+    }
+
+    if (cfg->format == DY_GFX_BENCH_JSON) {
+        fprintf(cfg->out, "\n  ]\n}\n");
+    }
+
+    return err;
+}
@@ -0,0 +1,61 @@
+/**
+ * @brief Graphics pipeline benchmarks.
+ *
+ * Runs dy_gfx primitives at several buffer sizes and reports time per call and per pixel, allocations per call
+ * and stack usage as CSV or JSON. Time is measured by esp_timer on device and by clock_gettime() on the host.
+ * Reports of two runs can be compared by `tools/bench_compare.py`.
+ *
+ * Allocations are only counted if CONFIG_DY_GFX_BENCH_COUNT_ALLOCS is enabled, which wraps malloc(), calloc() and
+ * realloc() of the whole application at link time.
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "dy/error.h"
+
+/**
+ * Report formats.
+ */
+typedef enum {
+    DY_GFX_BENCH_CSV,
+    DY_GFX_BENCH_JSON,
+} dy_gfx_bench_format_t;
+
+/**
+ * Benchmark configuration.
+ */
+typedef struct {
+    dy_gfx_bench_format_t format;
+    FILE *out;              // where to write the report
+    uint32_t min_time_us;   // minimum measuring time per case; 0 means 100 ms
+    const char *filter;     // run cases whose names contain this string; NULL runs all
+    bool with_display;      // benchmark dy_display_write() on `display_id` as well
+    uint8_t display_id;
+} dy_gfx_bench_config_t;
+
+/**
+ * Result of a benchmark case.
+ */
+typedef struct {
+    const char *name;
+    uint16_t width;
+    uint16_t height;
+    uint32_t iterations;
+    uint64_t ns_per_call;
+    uint32_t ps_per_px;       // picoseconds per pixel, to keep the precision without floats
+    uint32_t allocs_per_call; // allocations per call, multiplied by 1000; 0 unless they are counted
+    uint32_t stack_bytes;     // approximate stack usage of a call
+} dy_gfx_bench_result_t;
+
+/**
+ * @brief Runs benchmarks and writes the report.
+ *
+ * @return
+ *  - DY_ERR_NO_MEM if there is no memory for benchmark buffers.
+ *  - Errors of dy_display_write() if `with_display` is set.
+ *  - DY_OK on success.
+ */
+dy_err_t dy_gfx_bench_run(const dy_gfx_bench_config_t *cfg);
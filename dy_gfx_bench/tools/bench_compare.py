@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+"""
+Compares two dy_gfx_bench reports and flags regressions.
+
+Usage:
+    bench_compare.py BASE NEW [--threshold PERCENT] [--stack-threshold BYTES]
+
+Reports may be CSV or JSON, as written by dy_gfx_bench_run(). A case regresses if its time per pixel grows
+by more than the threshold, if it allocates more per call, or if its stack usage grows by more than the stack
+threshold. Allocations are only compared if both reports count them. The exit code is 1 if there are regressions.
+"""
+
+import argparse
+import csv
+import json
+import sys
+
+FIELDS = ('ns_per_px', 'allocs_per_call', 'stack_bytes')
+
+
+def load(path):
+    with open(path) as f:
+        text = f.read()
+
+    if text.lstrip().startswith('{'):
+        rows = json.loads(text)['results']
+    else:
+        rows = list(csv.DictReader(text.splitlines()))
+
+    # Allocations are empty or null if they were not counted
+    return {(r['name'], int(r['width']), int(r['height'])): {k: None if r[k] in (None, '') else float(r[k])
+                                                             for k in FIELDS} for r in rows}
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compares two dy_gfx_bench reports.')
+    parser.add_argument('base')
+    parser.add_argument('new')
+    parser.add_argument('--threshold', type=float, default=10.0, help='allowed slowdown, percent')
+    parser.add_argument('--stack-threshold', type=int, default=32, help='allowed stack growth, bytes')
+    args = parser.parse_args()
+
+    base, new = load(args.base), load(args.new)
+    regressions = 0
+
+    print('%-16s %9s %12s %12s %8s %7s %7s' % ('case', 'size', 'base ns/px', 'new ns/px', 'change', 'allocs', 'stack'))
+    for key in sorted(base.keys() & new.keys()):
+        b, n = base[key], new[key]
+        change = (n['ns_per_px'] - b['ns_per_px']) / b['ns_per_px'] * 100 if b['ns_per_px'] > 0 else 0.0
+
+        flags = []
+        if change > args.threshold:
+            flags.append('SLOWER')
+        if None not in (n['allocs_per_call'], b['allocs_per_call']) and n['allocs_per_call'] > b['allocs_per_call']:
+            flags.append('ALLOCS')
+        if n['stack_bytes'] - b['stack_bytes'] > args.stack_threshold:
+            flags.append('STACK')
+        regressions += bool(flags)
+
+        allocs = '-' if n['allocs_per_call'] is None else '%.3f' % n['allocs_per_call']
+        print('%-16s %9s %12.3f %12.3f %+7.1f%% %7s %7d %s' % (
+            key[0], '%dx%d' % key[1:], b['ns_per_px'], n['ns_per_px'], change, allocs, n['stack_bytes'],
+            ' '.join(flags)))
+
+    for key in sorted(base.keys() - new.keys()):
+        print('%-16s %9s missing in %s' % (key[0], '%dx%d' % key[1:], args.new))
+
+    print('\n%d regression(s)' % regressions)
+    sys.exit(1 if regressions else 0)
+
+
+if __name__ == '__main__':
+    main()
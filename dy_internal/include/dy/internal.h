@@ -1,3 +1,5 @@
 #pragma once
 
 #define DY_INTERNAL_CFG_ID_NET_CONFIGURED 0xF001 // dy_net
+#define DY_INTERNAL_CFG_ID_CLOUD_WEATHER 0xF002  // dy_cloud
+#define DY_INTERNAL_CFG_ID_CLOUD_TIME 0xF003     // dy_cloud
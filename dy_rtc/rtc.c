@@ -100,6 +100,17 @@ static void cloud_update_handler(void *arg, esp_event_base_t base, int32_t id, v
     }
 
     setenv("TZ", dt->tzd, true);
+    tzset();
+
+    // Stale time was saved before the reboot, so only its timezone is useful; DS3231 keeps local time, so it must be
+    // read again in the right timezone
+    if (dt->stale) {
+        ESP_LOGI(LTAG, "timezone set from stored cloud data: %s", dt->tzd);
+        if (ds3231 != NULL) {
+            localtime_from_ds3231();
+        }
+        return;
+    }
 
     int c_err;
     struct timespec ts = {.tv_sec = dt->ts};
@@ -0,0 +1,100 @@
+/**
+ * @brief Builder of DYD1 patches for the cloud tests; see delta.h for the format.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include "mbedtls/sha256.h"
+#include "delta.h"
+
+#define OP_COPY 0x01
+#define OP_ADD 0x02
+#define OP_INSERT 0x03
+
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    size_t cap;
+} patch_ops_t;
+
+static void sha256(const void *data, size_t len, uint8_t *digest) {
+    mbedtls_sha256_context ctx;
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+    mbedtls_sha256_update(&ctx, data, len);
+    mbedtls_sha256_finish(&ctx, digest);
+    mbedtls_sha256_free(&ctx);
+}
+
+static void put_bytes(patch_ops_t *ops, const void *src, size_t len) {
+    if (len == 0) {
+        return;
+    }
+    if (ops->len + len > ops->cap) {
+        ops->cap = (ops->len + len) * 2;
+        ops->data = realloc(ops->data, ops->cap);
+    }
+    memcpy(ops->data + ops->len, src, len);
+    ops->len += len;
+}
+
+static void put_u32(patch_ops_t *ops, uint32_t v) {
+    uint8_t le[4] = {v, v >> 8, v >> 16, v >> 24};
+    put_bytes(ops, le, 4);
+}
+
+static void patch_copy(patch_ops_t *ops, uint32_t offset, uint32_t len) {
+    put_bytes(ops, &(uint8_t) {OP_COPY}, 1);
+    put_u32(ops, offset);
+    put_u32(ops, len);
+}
+
+static void patch_add(patch_ops_t *ops, uint32_t offset, const uint8_t *diff, uint32_t len) {
+    put_bytes(ops, &(uint8_t) {OP_ADD}, 1);
+    put_u32(ops, offset);
+    put_u32(ops, len);
+    put_bytes(ops, diff, len);
+}
+
+static void patch_insert(patch_ops_t *ops, const uint8_t *data, uint32_t len) {
+    put_bytes(ops, &(uint8_t) {OP_INSERT}, 1);
+    put_u32(ops, len);
+    put_bytes(ops, data, len);
+}
+
+// Makes a patch of the ops, which are freed, with the header of the given images; the result is to be freed.
+static uint8_t *patch_make(patch_ops_t *ops, const uint8_t *base, uint32_t base_len, const uint8_t *target,
+                           uint32_t target_len, size_t *len) {
+    patch_ops_t out = {0};
+    uint8_t digest[32];
+
+    put_bytes(&out, DY_CLOUD_DELTA_MAGIC, 4);
+    put_u32(&out, base_len);
+    sha256(base, base_len, digest);
+    put_bytes(&out, digest, 32);
+    put_u32(&out, target_len);
+    sha256(target, target_len, digest);
+    put_bytes(&out, digest, 32);
+
+    // Raw deflate, as the ROM inflates it
+    z_stream z = {0};
+    deflateInit2(&z, 9, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+    uLong bound = deflateBound(&z, ops->len);
+    out.data = realloc(out.data, out.len + bound);
+    z.next_in = ops->data;
+    z.avail_in = ops->len;
+    z.next_out = out.data + out.len;
+    z.avail_out = bound;
+    deflate(&z, Z_FINISH);
+    out.len += z.total_out;
+    deflateEnd(&z);
+
+    free(ops->data);
+    *ops = (patch_ops_t) {0};
+    *len = out.len;
+
+    return out.data;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+typedef const char *esp_event_base_t;
+
+esp_err_t esp_event_post(esp_event_base_t base, int32_t id, const void *data, size_t len, TickType_t wait);
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+typedef enum {
+    HTTP_METHOD_GET,
+} esp_http_client_method_t;
+
+typedef struct esp_http_client *esp_http_client_handle_t;
+
+typedef enum {
+    HTTP_EVENT_ON_CONNECTED,
+    HTTP_EVENT_ON_HEADER,
+    HTTP_EVENT_ON_DATA,
+    HTTP_EVENT_DISCONNECTED,
+} esp_http_client_event_id_t;
+
+typedef struct {
+    esp_http_client_event_id_t event_id;
+    esp_http_client_handle_t client;
+    void *data;
+    int data_len;
+    void *user_data;
+    char *header_key;
+    char *header_value;
+} esp_http_client_event_t;
+
+typedef struct {
+    const char *url;
+    const char *user_agent;
+    esp_http_client_method_t method;
+    int timeout_ms;
+    bool keep_alive_enable;
+    esp_err_t (*crt_bundle_attach)(void *conf);
+    int buffer_size_tx;
+    esp_err_t (*event_handler)(esp_http_client_event_t *evt);
+    void *user_data;
+} esp_http_client_config_t;
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *cfg);
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t cli, const char *key, const char *value);
+esp_err_t esp_http_client_open(esp_http_client_handle_t cli, int write_len);
+int64_t esp_http_client_fetch_headers(esp_http_client_handle_t cli);
+int esp_http_client_get_status_code(esp_http_client_handle_t cli);
+esp_err_t esp_http_client_get_header(esp_http_client_handle_t cli, const char *key, char **value);
+int esp_http_client_read(esp_http_client_handle_t cli, char *buf, int len);
+esp_err_t esp_http_client_close(esp_http_client_handle_t cli);
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t cli);
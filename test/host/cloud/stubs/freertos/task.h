@@ -0,0 +1,7 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+void vTaskDelay(TickType_t ticks);
+
+#define taskYIELD() ((void) 0)
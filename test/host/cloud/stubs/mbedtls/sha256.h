@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t len;
+    uint8_t block[64];
+} mbedtls_sha256_context;
+
+void mbedtls_sha256_init(mbedtls_sha256_context *ctx);
+int mbedtls_sha256_starts(mbedtls_sha256_context *ctx, int is224);
+int mbedtls_sha256_update(mbedtls_sha256_context *ctx, const unsigned char *data, size_t len);
+int mbedtls_sha256_finish(mbedtls_sha256_context *ctx, unsigned char *digest);
+void mbedtls_sha256_free(mbedtls_sha256_context *ctx);
@@ -0,0 +1,67 @@
+#pragma once
+
+// The subset of the ROM's tinfl API which delta.c uses, over zlib's raw inflate.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <zlib.h>
+
+#define TINFL_LZ_DICT_SIZE 32768
+#define TINFL_FLAG_HAS_MORE_INPUT 2
+
+typedef enum {
+    TINFL_STATUS_FAILED = -1,
+    TINFL_STATUS_DONE = 0,
+    TINFL_STATUS_NEEDS_MORE_INPUT = 1,
+    TINFL_STATUS_HAS_MORE_OUTPUT = 2,
+} tinfl_status;
+
+// delta.c frees the decompressor with free(), so zlib allocates its state and window from the decompressor itself
+typedef struct {
+    z_stream z;
+    size_t used;
+    _Alignas(16) uint8_t arena[48 * 1024];
+} tinfl_decompressor;
+
+static inline voidpf tinfl_zalloc(voidpf opaque, uInt items, uInt size) {
+    tinfl_decompressor *r = opaque;
+    size_t len = ((size_t) items * size + 15) & ~(size_t) 15;
+
+    if (r->used + len > sizeof(r->arena)) {
+        return Z_NULL;
+    }
+    r->used += len;
+
+    return r->arena + r->used - len;
+}
+
+static inline void tinfl_zfree(voidpf opaque, voidpf ptr) {}
+
+#define tinfl_init(r) do { \
+    memset((r), 0, sizeof(tinfl_decompressor)); \
+    (r)->z.zalloc = tinfl_zalloc; \
+    (r)->z.zfree = tinfl_zfree; \
+    (r)->z.opaque = (r); \
+    inflateInit2(&(r)->z, -15); \
+} while (0)
+
+static inline tinfl_status tinfl_decompress(tinfl_decompressor *r, const uint8_t *in, size_t *in_len,
+                                            uint8_t *out_start, uint8_t *out_next, size_t *out_len, uint32_t flags) {
+    r->z.next_in = (uint8_t *) in;
+    r->z.avail_in = *in_len;
+    r->z.next_out = out_next;
+    r->z.avail_out = *out_len;
+
+    int ret = inflate(&r->z, Z_NO_FLUSH);
+    *in_len -= r->z.avail_in;
+    *out_len -= r->z.avail_out;
+
+    if (ret == Z_STREAM_END) {
+        return TINFL_STATUS_DONE;
+    } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+        return TINFL_STATUS_FAILED;
+    }
+
+    return r->z.avail_out == 0 ? TINFL_STATUS_HAS_MORE_OUTPUT : TINFL_STATUS_NEEDS_MORE_INPUT;
+}
@@ -0,0 +1,296 @@
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "http_client.h"
+#include "scheduler.h"
+#include "test.h"
+
+extern char **environ;
+
+static pid_t mock_pid;
+static int mock_port;
+static char api_url[64];
+static char last_url[1024];
+
+// Fakes of the rest of dy_cloud which batch.c needs.
+
+const char *dy_cloud_get_api_url() {
+    return api_url;
+}
+
+// Connects to the mock, sends a request and reads the response up to the server closing the connection.
+static char *fetch(const char *url, size_t *len) {
+    const char *path = strchr(url + strlen("http://"), '/');
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(mock_port)};
+    char req[1200];
+    size_t cap = 4096;
+    char *resp = malloc(cap);
+    ssize_t n;
+
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+        close(fd);
+        free(resp);
+        return NULL;
+    }
+
+    int req_len = snprintf(req, sizeof(req), "GET %s HTTP/1.1\r\nHost: 127.0.0.1:%d\r\nConnection: close\r\n\r\n",
+                           path, mock_port);
+    if (write(fd, req, req_len) != req_len) {
+        close(fd);
+        free(resp);
+        return NULL;
+    }
+
+    *len = 0;
+    while ((n = read(fd, resp + *len, cap - *len - 1)) > 0) {
+        *len += n;
+        if (*len == cap - 1) {
+            resp = realloc(resp, cap *= 2);
+        }
+    }
+    resp[*len] = '\0';
+    close(fd);
+
+    return resp;
+}
+
+// Plain GET of a JSON document. Bodies in chunked encoding are fed to the extractor in the chunks they arrive in,
+// others byte by byte, so values are split across feeds at every position.
+dy_err_t http_get_json(const char *url, dy_cloud_http_validators_t *validators, dy_cloud_json_cb_t cb, void *args) {
+    dy_err_t err = dy_ok();
+    dy_cloud_json_t p;
+    size_t len;
+
+    snprintf(last_url, sizeof(last_url), "%s", url);
+
+    char *resp = fetch(url, &len);
+    char *body = resp != NULL ? strstr(resp, "\r\n\r\n") : NULL;
+    if (body == NULL) {
+        free(resp);
+        return dy_err(DY_ERR_FAILED, "no response");
+    }
+    *body = '\0';
+    body += 4;
+
+    int status = atoi(resp + strlen("HTTP/1.x "));
+    if (status != 200) {
+        free(resp);
+        return status == 404 ? dy_err(DY_ERR_NOT_FOUND, "not found") : dy_err(DY_ERR_FAILED, "status %d", status);
+    }
+
+    dy_cloud_json_init(&p, cb, args);
+    if (strstr(resp, "Transfer-Encoding: chunked") != NULL) {
+        char *end;
+        size_t size;
+        while (!dy_is_err(err) && (size = strtoul(body, &end, 16)) > 0) {
+            if (end + 2 + size > resp + len) {
+                err = dy_err(DY_ERR_FAILED, "truncated chunk");
+                break;
+            }
+            err = dy_cloud_json_feed(&p, end + 2, size);
+            body = end + 2 + size + 2;
+        }
+    } else {
+        for (; !dy_is_err(err) && body < resp + len; body++) {
+            err = dy_cloud_json_feed(&p, body, 1);
+        }
+    }
+
+    free(resp);
+
+    return dy_is_err(err) ? err : dy_cloud_json_done(&p);
+}
+
+// Runs mock_cloud.py with the given options, up to 6, on a port of its own and waits for it to accept connections.
+static bool mock_start(const char *const *opts) {
+    char port[8];
+    char *argv[12] = {PYTHON, MOCK_CLOUD, "--port", port};
+    posix_spawn_file_actions_t actions;
+
+    mock_port = mock_port == 0 ? 20000 + getpid() % 20000 : mock_port + 1;
+    snprintf(port, sizeof(port), "%d", mock_port);
+    snprintf(api_url, sizeof(api_url), "http://127.0.0.1:%d/v2", mock_port);
+
+    // The server logs every request
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+    for (int i = 0; opts[i] != NULL && i < 6; i++) {
+        argv[4 + i] = (char *) opts[i];
+    }
+    int res = posix_spawn(&mock_pid, PYTHON, &actions, NULL, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (res != 0) {
+        fprintf(stderr, "can't run %s: %s\n", MOCK_CLOUD, strerror(res));
+        return false;
+    }
+
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(mock_port)};
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    for (int i = 0; i < 200 && waitpid(mock_pid, NULL, WNOHANG) == 0; i++) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        bool up = connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0;
+        close(fd);
+        if (up) {
+            return true;
+        }
+        usleep(50000);
+    }
+
+    fprintf(stderr, "%s didn't start on port %d\n", MOCK_CLOUD, mock_port);
+    return false;
+}
+
+static void mock_stop() {
+    kill(mock_pid, SIGTERM);
+    waitpid(mock_pid, NULL, 0);
+}
+
+// Jobs record what their batch handlers get; "tim" is unknown to the server and must not take values of "time".
+
+typedef struct {
+    char values[1024]; // "path=value;" for each value
+    int begins;
+    int ends;
+    bool found;
+} rec_t;
+
+static void on_value(void *args, const char *path, dy_cloud_json_type_t type, const char *value) {
+    rec_t *rec = args;
+    size_t len = strlen(rec->values);
+    snprintf(rec->values + len, sizeof(rec->values) - len, "%s=%s;", path, value);
+}
+
+#define JOB(var, job_name, job_query) \
+    static rec_t var##_rec; \
+    static const char *var##_query() { return job_query; } \
+    static void var##_begin() { var##_rec.begins++; } \
+    static dy_err_t var##_end(bool found) { var##_rec.ends++; var##_rec.found = found; return dy_ok(); } \
+    static const dy_cloud_batch_handler_t var##_handler = {var##_query, var##_begin, on_value, &var##_rec, var##_end}; \
+    static dy_cloud_job_t var = {.name = job_name, .batch = &var##_handler}
+
+JOB(tim, "tim", "lat=1.50000");
+JOB(time_job, "time", "lat=1.50000&lng=2.25000");
+JOB(weather, "weather", "lat=1.50000&lng=2.25000");
+JOB(firmware, "firmware", "app=x&to_alpha=0");
+
+static dy_cloud_job_t *jobs[] = {&tim, &time_job, &weather, &firmware};
+
+static dy_err_t run() {
+    dy_err_t results[4];
+
+    memset(&tim_rec, 0, sizeof(rec_t));
+    memset(&time_job_rec, 0, sizeof(rec_t));
+    memset(&weather_rec, 0, sizeof(rec_t));
+    memset(&firmware_rec, 0, sizeof(rec_t));
+
+    dy_err_t err = batch_run(jobs, 4, results);
+    for (int i = 0; i < 4 && !dy_is_err(err); i++) {
+        CHECK(!dy_is_err(results[i]));
+    }
+
+    return err;
+}
+
+// Every job gets its own resource with relative paths; the firmware update is either present or null.
+static void check_batch(bool has_firmware) {
+    char url[256];
+    dy_err_t err = run();
+
+    CHECK(!dy_is_err(err));
+    if (dy_is_err(err)) {
+        fprintf(stderr, "    %s\n", dy_err_str(err));
+        return;
+    }
+
+    // Parameters shared by jobs are sent once
+    snprintf(url, sizeof(url), "%s/batch?include=tim,time,weather,firmware&lat=1.50000&lng=2.25000&app=x&to_alpha=0",
+             api_url);
+    CHECK(strcmp(last_url, url) == 0);
+
+    CHECK(!tim_rec.found);
+    CHECK(strcmp(tim_rec.values, "") == 0);
+
+    CHECK(time_job_rec.found);
+    CHECK(strstr(time_job_rec.values, "tz=Europe/Amsterdam;tz_data=CET-1CEST,M3.5.0,M10.5.0/3;value=") ==
+          time_job_rec.values);
+
+    CHECK(weather_rec.found);
+    CHECK(strcmp(weather_rec.values, "id=2;title=Partly cloudy;is_day=true;temp=17;feels_like=15;lat=1.5;lng=2.25;") ==
+          0);
+
+    CHECK(firmware_rec.found == has_firmware);
+    if (has_firmware) {
+        CHECK(strcmp(firmware_rec.values, "url=http://fw/a.bin;sha256=abcd;size=3;") == 0);
+    } else {
+        CHECK(strcmp(firmware_rec.values, "") == 0);
+    }
+
+    // Each handler is called once
+    for (int i = 0; i < 4; i++) {
+        const rec_t *rec = jobs[i]->batch->args;
+        CHECK_INT(rec->begins, 1);
+        CHECK_INT(rec->ends, 1);
+    }
+}
+
+static void test_batch() {
+    if (mock_start((const char *[]) {NULL})) {
+        check_batch(false);
+        mock_stop();
+    } else {
+        test_failures++;
+    }
+}
+
+static void test_chunked() {
+    if (mock_start((const char *[]) {"--chunk", "7", NULL})) {
+        check_batch(false);
+        mock_stop();
+    } else {
+        test_failures++;
+    }
+}
+
+static void test_firmware() {
+    if (mock_start((const char *[]) {"--firmware-url", "http://fw/a.bin", "--firmware-sha256", "abcd",
+                                     "--firmware-size", "3", NULL})) {
+        check_batch(true);
+        mock_stop();
+    } else {
+        test_failures++;
+    }
+}
+
+// Without the batch endpoint, the scheduler is told to fall back to separate requests and no job is finished.
+static void test_no_batch() {
+    if (mock_start((const char *[]) {"--no-batch", NULL})) {
+        CHECK_INT(run()->code, DY_ERR_NOT_FOUND);
+        for (int i = 0; i < 4; i++) {
+            const rec_t *rec = jobs[i]->batch->args;
+            CHECK_INT(rec->ends, 0);
+        }
+        mock_stop();
+    } else {
+        test_failures++;
+    }
+}
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);
+
+    TEST_RUN(test_batch);
+    TEST_RUN(test_chunked);
+    TEST_RUN(test_firmware);
+    TEST_RUN(test_no_batch);
+    TEST_EXIT();
+}
@@ -0,0 +1,411 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+#include "patch.h"
+
+#define MAX_IMAGE 32768
+#define MAX_TARGET (2 * MAX_IMAGE)
+
+// An applied patch: the base it reads and the target it writes.
+typedef struct {
+    const uint8_t *base;
+    uint32_t base_len;
+    uint8_t *out;
+    uint32_t out_len;
+    uint32_t target_len; // from the header
+    bool begun;
+} apply_t;
+
+static dy_err_t on_begin(void *args, const dy_cloud_delta_header_t *hdr) {
+    apply_t *a = args;
+    uint8_t digest[32];
+
+    sha256(a->base, a->base_len, digest);
+    if (hdr->base_size != a->base_len || memcmp(digest, hdr->base_sha256, 32) != 0) {
+        return dy_err(DY_ERR_INVALID_ARG, "another base");
+    }
+    a->out = malloc(hdr->target_size + 1);
+    a->target_len = hdr->target_size;
+    a->begun = true;
+
+    return dy_ok();
+}
+
+// Bounds are checked by delta.c, so going out of them is a failure of the test rather than an error.
+static dy_err_t on_read_base(void *args, uint32_t offset, void *dst, size_t len) {
+    apply_t *a = args;
+
+    CHECK(offset <= a->base_len && len <= a->base_len - offset);
+    if (offset > a->base_len || len > a->base_len - offset) {
+        return dy_err(DY_ERR_INVALID_SIZE, "outside the base");
+    }
+    memcpy(dst, a->base + offset, len);
+
+    return dy_ok();
+}
+
+static dy_err_t on_write(void *args, const void *src, size_t len) {
+    apply_t *a = args;
+
+    CHECK(a->begun && len <= a->target_len - a->out_len);
+    if (!a->begun || len > a->target_len - a->out_len) {
+        return dy_err(DY_ERR_INVALID_SIZE, "outside the target");
+    }
+    memcpy(a->out + a->out_len, src, len);
+    a->out_len += len;
+
+    return dy_ok();
+}
+
+// Applies a patch fed in chunks of random sizes up to `max_chunk`; the output is to be freed.
+static dy_err_t apply(apply_t *a, const uint8_t *patch, size_t len, size_t max_chunk, bool *done) {
+    static const dy_cloud_delta_io_t io = {.begin = on_begin, .read_base = on_read_base, .write = on_write};
+    dy_cloud_delta_t *d = malloc(sizeof(dy_cloud_delta_t));
+    dy_cloud_delta_io_t a_io = io;
+    dy_err_t err;
+
+    a_io.args = a;
+    a->out = NULL;
+    a->out_len = 0;
+    a->begun = false;
+
+    if (!dy_is_err(err = delta_begin(d, &a_io))) {
+        for (size_t pos = 0; pos < len && !dy_is_err(err);) {
+            size_t n = 1 + test_rand() % max_chunk;
+            n = n < len - pos ? n : len - pos;
+            err = delta_feed(d, patch + pos, n);
+            pos += n;
+        }
+        *done = delta_done(d);
+        delta_end(d);
+    }
+    free(d);
+
+    return err;
+}
+
+// Applies a patch in many ways and checks that the target comes out each time.
+static bool check_apply(const uint8_t *base, uint32_t base_len, const uint8_t *patch, size_t patch_len,
+                        const uint8_t *target, uint32_t target_len) {
+    static const size_t max_chunks[] = {1, 7, 100, 1024, 100000};
+    bool ok = true;
+
+    for (size_t i = 0; i < sizeof(max_chunks) / sizeof(max_chunks[0]); i++) {
+        apply_t a = {.base = base, .base_len = base_len};
+        bool done = false;
+        dy_err_t err = apply(&a, patch, patch_len, max_chunks[i], &done);
+
+        if (dy_is_err(err) || !done || a.out_len != target_len || memcmp(a.out, target, target_len) != 0) {
+            fprintf(stderr, "    chunks up to %zu: %s; done %d; %u of %u bytes\n", max_chunks[i], dy_err_str(err), done,
+                    a.out_len, target_len);
+            ok = false;
+        }
+        free(a.out);
+    }
+
+    return ok;
+}
+
+static void make_image(uint8_t *dst, uint32_t len) {
+    for (uint32_t i = 0; i < len; i++) {
+        dst[i] = test_rand() % 4 == 0 ? test_rand() : i / 16; // code-like: partly random, partly regular
+    }
+}
+
+static uint8_t base[MAX_IMAGE], target[MAX_TARGET];
+
+// Every op, including empty ones, at the start, middle and end of the target.
+static void test_ops() {
+    patch_ops_t ops = {0};
+    uint8_t diff[3000], ins[500];
+
+    make_image(base, 20000);
+    make_image(ins, sizeof(ins));
+    for (int i = 0; i < 3000; i++) {
+        diff[i] = i % 50 == 0 ? 0xFC : 0; // -4
+    }
+
+    patch_insert(&ops, ins, 100);
+    patch_copy(&ops, 5000, 1000);
+    patch_insert(&ops, ins, 0);
+    patch_add(&ops, 18000, diff, 2000); // ends at the end of the base
+    patch_copy(&ops, 0, 0);
+    patch_add(&ops, 0, diff, 3000);
+    patch_copy(&ops, 0, 20000);
+    patch_insert(&ops, ins, sizeof(ins));
+
+    uint32_t len = 0;
+    memcpy(target, ins, 100);
+    len += 100;
+    memcpy(target + len, base + 5000, 1000);
+    len += 1000;
+    for (int i = 0; i < 2000; i++) {
+        target[len++] = base[18000 + i] + diff[i];
+    }
+    for (int i = 0; i < 3000; i++) {
+        target[len++] = base[i] + diff[i];
+    }
+    memcpy(target + len, base, 20000);
+    len += 20000;
+    memcpy(target + len, ins, sizeof(ins));
+    len += sizeof(ins);
+
+    size_t patch_len;
+    uint8_t *patch = patch_make(&ops, base, 20000, target, len, &patch_len);
+    CHECK(check_apply(base, 20000, patch, patch_len, target, len));
+    free(patch);
+
+    // An empty target
+    patch = patch_make(&ops, base, 20000, target, 0, &patch_len);
+    CHECK(check_apply(base, 20000, patch, patch_len, target, 0));
+    free(patch);
+}
+
+// Makes a patch of the ops of the given target and applies it; expects the given error code.
+static void check_error(patch_ops_t *ops, uint32_t target_len, dy_err_code_t code) {
+    size_t patch_len;
+    uint8_t *patch = patch_make(ops, base, 1000, target, target_len, &patch_len);
+    apply_t a = {.base = base, .base_len = 1000};
+    bool done;
+
+    CHECK_INT(apply(&a, patch, patch_len, 1000, &done)->code, code);
+    free(a.out);
+    free(patch);
+}
+
+static void test_malformed() {
+    patch_ops_t ops = {0};
+    make_image(base, 1000);
+
+    patch_copy(&ops, 999, 2);
+    check_error(&ops, 2, DY_ERR_INVALID_SIZE); // outside the base
+
+    patch_add(&ops, 1001, base, 0);
+    check_error(&ops, 2, DY_ERR_INVALID_SIZE);
+
+    patch_copy(&ops, 0, 0xFFFFFFFF);
+    check_error(&ops, 2, DY_ERR_INVALID_SIZE);
+
+    patch_copy(&ops, 0, 10);
+    check_error(&ops, 9, DY_ERR_INVALID_SIZE); // beyond the target
+
+    patch_insert(&ops, base, 10);
+    check_error(&ops, 9, DY_ERR_INVALID_SIZE);
+
+    patch_copy(&ops, 0, 10);
+    patch_copy(&ops, 0, 0);
+    check_error(&ops, 10, DY_ERR_FAILED); // ops after the end
+
+    put_bytes(&ops, &(uint8_t) {0x04}, 1);
+    check_error(&ops, 10, DY_ERR_FAILED); // unknown op
+
+    size_t patch_len;
+    apply_t a = {.base = base, .base_len = 1000};
+    bool done;
+
+    // Incomplete patches aren't errors until the end, when they aren't done
+    patch_copy(&ops, 0, 10);
+    uint8_t *patch = patch_make(&ops, base, 1000, target, 20, &patch_len);
+    CHECK(!dy_is_err(apply(&a, patch, patch_len, 1000, &done)));
+    CHECK(!done);
+    free(a.out);
+    free(patch);
+
+    patch_copy(&ops, 0, 10);
+    patch = patch_make(&ops, base, 1000, target, 10, &patch_len);
+    CHECK(!dy_is_err(apply(&a, patch, patch_len - 1, 1000, &done)));
+    CHECK(!done);
+    free(a.out);
+
+    // Data after the deflate stream
+    uint8_t *longer = malloc(patch_len + 1);
+    memcpy(longer, patch, patch_len);
+    longer[patch_len] = 0;
+    CHECK_INT(apply(&a, longer, patch_len + 1, 1000, &done)->code, DY_ERR_FAILED);
+    free(a.out);
+    free(longer);
+
+    // Another format, another base, and a broken deflate stream
+    patch[0] = 'X';
+    CHECK_INT(apply(&a, patch, patch_len, 1000, &done)->code, DY_ERR_INVALID_VERSION);
+    free(a.out);
+    patch[0] = 'D';
+    patch[8] ^= 1;
+    CHECK_INT(apply(&a, patch, patch_len, 1000, &done)->code, DY_ERR_INVALID_ARG);
+    free(a.out);
+    patch[8] ^= 1;
+    patch[DY_CLOUD_DELTA_HEADER_LEN] = 0xFF; // reserved block type
+    CHECK_INT(apply(&a, patch, patch_len, 1000, &done)->code, DY_ERR_FAILED);
+    free(a.out);
+    free(patch);
+}
+
+// Random changes of valid patches; under the sanitizers this checks that nothing is accessed out of bounds.
+static void test_fuzz() {
+    patch_ops_t ops = {0};
+    uint8_t data[300];
+
+    make_image(base, 4000);
+    for (int i = 0; i < 3000; i++) {
+        // Random ops, including ones reaching past the base and the target, as the raw op stream
+        for (int n = test_rand() % 8; n > 0; n--) {
+            uint32_t off = test_rand() % 4200, len = test_rand() % 300;
+            make_image(data, len);
+            switch (test_rand() % 4) {
+                case 0:
+                    patch_copy(&ops, off, len);
+                    break;
+                case 1:
+                    patch_add(&ops, off, data, len);
+                    break;
+                case 2:
+                    patch_insert(&ops, data, len);
+                    break;
+                default:
+                    put_bytes(&ops, data, len % 20);
+            }
+        }
+
+        size_t patch_len;
+        uint8_t *patch = patch_make(&ops, base, 4000, target, test_rand() % 2000, &patch_len);
+        for (int n = test_rand() % 3; n > 0; n--) {
+            patch[DY_CLOUD_DELTA_HEADER_LEN + test_rand() % (patch_len - DY_CLOUD_DELTA_HEADER_LEN)] = test_rand();
+        }
+
+        apply_t a = {.base = base, .base_len = 4000};
+        bool done;
+        apply(&a, patch, patch_len, 64, &done);
+        CHECK(a.out_len <= a.target_len);
+        free(a.out);
+        free(patch);
+    }
+}
+
+#ifdef TEST_DELTA_TOOL
+
+static bool write_file(const char *path, const uint8_t *data, size_t len) {
+    FILE *f = fopen(path, "wb");
+    bool ok = f != NULL && fwrite(data, 1, len, f) == len;
+    if (f != NULL) {
+        fclose(f);
+    }
+    return ok;
+}
+
+static uint8_t *read_file(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    uint8_t *data = NULL;
+
+    if (f != NULL && fseek(f, 0, SEEK_END) == 0) {
+        *len = ftell(f);
+        data = malloc(*len + 1);
+        rewind(f);
+        if (fread(data, 1, *len, f) != *len) {
+            free(data);
+            data = NULL;
+        }
+    }
+    if (f != NULL) {
+        fclose(f);
+    }
+
+    return data;
+}
+
+// Edits a copy of the base the way a new build changes it: code inserted, removed and shifted, constants changed.
+static uint32_t edit(uint8_t *dst, const uint8_t *src, uint32_t len) {
+    uint32_t out = 0;
+
+    for (uint32_t pos = 0; pos < len;) {
+        uint32_t n = test_rand() % 3000;
+        n = n < len - pos ? n : len - pos;
+        switch (test_rand() % 6) {
+            case 0: // new code
+                if (out + n / 4 + len - pos <= MAX_TARGET) {
+                    make_image(dst + out, n / 4);
+                    out += n / 4;
+                }
+                break;
+            case 1: // removed code
+                pos += n;
+                break;
+            case 2: // shifted addresses
+                for (uint32_t i = 0; i < n; i++) {
+                    dst[out++] = src[pos++] + (i % 16 == 0 ? 8 : 0);
+                }
+                break;
+            case 3: // a changed byte
+                memcpy(dst + out, src + pos, n);
+                dst[out + n / 2] ^= n > 0 ? 0x55 : 0;
+                out += n;
+                pos += n;
+                break;
+            default:
+                memcpy(dst + out, src + pos, n);
+                out += n;
+                pos += n;
+        }
+    }
+
+    return out;
+}
+
+// Patches made by tools/make_delta.py from random edits are applied by delta.c back to the exact target.
+static void test_tool() {
+    char dir[] = "/tmp/dy_delta_XXXXXX", cmd[1024], base_path[64], target_path[64], patch_path[64];
+
+    CHECK(mkdtemp(dir) != NULL);
+    snprintf(base_path, sizeof(base_path), "%s/base.bin", dir);
+    snprintf(target_path, sizeof(target_path), "%s/target.bin", dir);
+    snprintf(patch_path, sizeof(patch_path), "%s/patch.dyd", dir);
+    snprintf(cmd, sizeof(cmd), "'%s' '%s' make %s %s %s > /dev/null", PYTHON, MAKE_DELTA, base_path, target_path,
+             patch_path);
+
+    for (int i = 0; i < 16; i++) {
+        uint32_t base_len = 1 + test_rand() % MAX_IMAGE, target_len;
+        make_image(base, base_len);
+        if (i == 0) {
+            target_len = base_len; // unchanged
+            memcpy(target, base, base_len);
+        } else if (i == 1) {
+            target_len = 5000; // unrelated
+            make_image(target, target_len);
+        } else {
+            target_len = edit(target, base, base_len);
+        }
+
+        size_t patch_len;
+        uint8_t *patch = NULL;
+        if (!write_file(base_path, base, base_len) || !write_file(target_path, target, target_len) ||
+            system(cmd) != 0 || (patch = read_file(patch_path, &patch_len)) == NULL) {
+            fprintf(stderr, "%s:%d: can't make patch %d with %s\n", __FILE__, __LINE__, i, MAKE_DELTA);
+            test_failures++;
+            break;
+        }
+
+        if (!check_apply(base, base_len, patch, patch_len, target, target_len)) {
+            fprintf(stderr, "%s:%d: patch %d of %zu bytes, %u to %u bytes, differs\n", __FILE__, __LINE__, i,
+                    patch_len, base_len, target_len);
+            test_failures++;
+        }
+        free(patch);
+    }
+
+    unlink(base_path);
+    unlink(target_path);
+    unlink(patch_path);
+    rmdir(dir);
+}
+
+#endif
+
+int main() {
+    TEST_RUN(test_ops);
+    TEST_RUN(test_malformed);
+    TEST_RUN(test_fuzz);
+#ifdef TEST_DELTA_TOOL
+    TEST_RUN(test_tool);
+#endif
+    TEST_EXIT();
+}
@@ -0,0 +1,583 @@
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+#include "patch.h"
+
+#ifndef HAVE_STRLCPY
+// newlib has it, glibc only since 2.38
+static size_t strlcpy(char *dst, const char *src, size_t size) {
+    size_t len = strlen(src);
+    if (size > 0) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
+
+// The unit under test, with its static functions
+#include "fwupdate.c"
+
+#define PART_SIZE (96 * 1024)
+#define IMAGE_SIZE 50000
+#define MAX_REQUESTS 16
+
+// Fake flash: the running partition holds the base image, the next one gets the update.
+
+static uint8_t running_data[PART_SIZE];
+static uint8_t flash[PART_SIZE];
+static const esp_partition_t running = {.address = 0x10000, .size = PART_SIZE, .label = "ota_0"};
+static const esp_partition_t next = {.address = 0x110000, .size = PART_SIZE, .label = "ota_1"};
+
+static struct {
+    bool open;
+    uint32_t written;
+    int begins;
+    int aborts;
+    uint32_t aborted_at; // bytes written before the last abort
+    int ends;
+    const esp_partition_t *boot;
+} ota;
+
+esp_err_t esp_partition_read(const esp_partition_t *part, size_t offset, void *dst, size_t len) {
+    CHECK(part == &running && offset + len <= PART_SIZE);
+    memcpy(dst, running_data + offset, len);
+    return ESP_OK;
+}
+
+const esp_partition_t *esp_ota_get_running_partition() {
+    return &running;
+}
+
+const esp_partition_t *esp_ota_get_boot_partition() {
+    return ota.boot != NULL ? ota.boot : &running;
+}
+
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start) {
+    return &next;
+}
+
+esp_err_t esp_ota_begin(const esp_partition_t *part, size_t size, esp_ota_handle_t *handle) {
+    CHECK(!ota.open && part == &next && size == OTA_WITH_SEQUENTIAL_WRITES);
+    ota.open = true;
+    ota.written = 0;
+    ota.begins++;
+    *handle = 1;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void *data, size_t len) {
+    CHECK(ota.open);
+    if (ota.written + len > PART_SIZE) {
+        return ESP_FAIL;
+    }
+    memcpy(flash + ota.written, data, len);
+    ota.written += len;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle) {
+    CHECK(ota.open);
+    ota.open = false;
+    ota.ends++;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_abort(esp_ota_handle_t handle) {
+    CHECK(ota.open);
+    ota.open = false;
+    ota.aborts++;
+    ota.aborted_at = ota.written;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *part) {
+    ota.boot = part;
+    return ESP_OK;
+}
+
+void esp_restart() {
+    abort();
+}
+
+// Fake HTTP server, serving resources from memory with Range support; responses can be cut to lose connections.
+
+typedef struct {
+    const char *url;
+    const uint8_t *data;
+    uint32_t len;
+} resource_t;
+
+static struct {
+    resource_t res[2];
+    uint32_t cut_after; // bytes of a response before the connection is lost; 0 for whole responses
+    int cuts;           // responses to cut; -1 for all
+    bool no_range;      // ignore Range, as some servers do
+    int requests;
+    const resource_t *urls[MAX_REQUESTS];
+    uint32_t ranges[MAX_REQUESTS]; // first byte asked by each request
+} server;
+
+struct esp_http_client {
+    const resource_t *res;
+    esp_err_t (*event_handler)(esp_http_client_event_t *evt);
+    void *user_data;
+    char range_hdr[32]; // request header
+    uint32_t range;
+    uint32_t pos;
+    uint32_t end;
+    int status;
+};
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *cfg) {
+    struct esp_http_client *cli = calloc(1, sizeof(struct esp_http_client));
+    cli->event_handler = cfg->event_handler;
+    cli->user_data = cfg->user_data;
+    for (int i = 0; i < 2; i++) {
+        if (server.res[i].url != NULL && strcmp(server.res[i].url, cfg->url) == 0) {
+            cli->res = &server.res[i];
+        }
+    }
+    return cli;
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t cli, const char *key, const char *value) {
+    if (strcmp(key, "Range") == 0) {
+        CHECK(sscanf(value, "bytes=%u-", &cli->range) == 1);
+        snprintf(cli->range_hdr, sizeof(cli->range_hdr), "%s", value);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_open(esp_http_client_handle_t cli, int write_len) {
+    CHECK(server.requests < MAX_REQUESTS);
+    if (server.requests < MAX_REQUESTS) {
+        server.urls[server.requests] = cli->res;
+        server.ranges[server.requests] = cli->range;
+    }
+    server.requests++;
+    return ESP_OK;
+}
+
+// Passes a response header to the event handler, as the client does while it reads the headers.
+static void send_header(esp_http_client_handle_t cli, const char *key, const char *value) {
+    char k[32], v[64];
+    esp_http_client_event_t evt = {
+            .event_id = HTTP_EVENT_ON_HEADER,
+            .client = cli,
+            .user_data = cli->user_data,
+            .header_key = k,
+            .header_value = v,
+    };
+
+    snprintf(k, sizeof(k), "%s", key);
+    snprintf(v, sizeof(v), "%s", value);
+    if (cli->event_handler != NULL) {
+        cli->event_handler(&evt);
+    }
+}
+
+int64_t esp_http_client_fetch_headers(esp_http_client_handle_t cli) {
+    if (cli->res == NULL) {
+        cli->status = 404;
+        return 0;
+    }
+
+    if (cli->range > 0 && cli->range < cli->res->len && !server.no_range) {
+        cli->status = 206;
+        cli->pos = cli->range;
+        send_header(cli, "content-type", "application/octet-stream");
+        char content_range[64];
+        snprintf(content_range, sizeof(content_range), "bytes %u-%u/%u", cli->range, cli->res->len - 1, cli->res->len);
+        send_header(cli, "content-range", content_range);
+    } else {
+        cli->status = 200;
+        cli->pos = 0;
+    }
+
+    cli->end = cli->res->len;
+    if (server.cut_after > 0 && server.cuts != 0 && cli->pos + server.cut_after < cli->end) {
+        cli->end = cli->pos + server.cut_after;
+        server.cuts -= server.cuts > 0;
+    }
+
+    return cli->res->len - cli->pos;
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t cli) {
+    return cli->status;
+}
+
+// Looks up request headers only, as the client does.
+esp_err_t esp_http_client_get_header(esp_http_client_handle_t cli, const char *key, char **value) {
+    *value = strcasecmp(key, "Range") == 0 && cli->range_hdr[0] != '\0' ? cli->range_hdr : NULL;
+    return ESP_OK;
+}
+
+int esp_http_client_read(esp_http_client_handle_t cli, char *buf, int len) {
+    uint32_t n = cli->end - cli->pos < (uint32_t) len ? cli->end - cli->pos : (uint32_t) len;
+    memcpy(buf, cli->res->data + cli->pos, n);
+    cli->pos += n;
+    return (int) n;
+}
+
+esp_err_t esp_http_client_close(esp_http_client_handle_t cli) {
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t cli) {
+    free(cli);
+    return ESP_OK;
+}
+
+esp_err_t esp_crt_bundle_attach(void *conf) {
+    return ESP_OK;
+}
+
+// Fake clock and events: every reading of the clock is 1 ms later.
+
+static int64_t now;
+static int delays;
+static int n_progress;
+static dy_cloud_fw_progress_t last_progress;
+
+int64_t esp_timer_get_time() {
+    return now += 1000;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    delays++;
+}
+
+esp_err_t esp_event_post(esp_event_base_t base, int32_t id, const void *data, size_t len, TickType_t wait) {
+    if (strcmp(base, DY_CLOUD_EV_BASE) == 0 && id == DY_CLOUD_EV_FW_PROGRESS) {
+        CHECK_INT(len, sizeof(dy_cloud_fw_progress_t));
+        memcpy(&last_progress, data, sizeof(dy_cloud_fw_progress_t));
+        n_progress++;
+    }
+    return ESP_OK;
+}
+
+// Fakes of the rest of dy_cloud and the app.
+
+dy_err_t dy_appinfo_get(dy_appinfo_info_t *ai) {
+    static char id[] = "test";
+    ai->id = id;
+    return dy_ok();
+}
+
+const char *dy_cloud_get_api_url() {
+    return "http://api/v2";
+}
+
+dy_err_t http_get_json(const char *url, dy_cloud_http_validators_t *validators, dy_cloud_json_cb_t cb, void *args) {
+    return dy_err(DY_ERR_NOT_FOUND, "not found");
+}
+
+dy_err_t scheduler_add_job(dy_cloud_job_t *j) {
+    return dy_ok();
+}
+
+void scheduler_continue_in_task(dy_cloud_job_t *j, dy_err_t (*fn)(), uint32_t stack_size) {
+}
+
+// Images and advertised updates.
+
+static uint8_t image[IMAGE_SIZE];
+
+static void make_image(uint8_t *dst, uint32_t len) {
+    for (uint32_t i = 0; i < len; i++) {
+        dst[i] = test_rand() % 4 == 0 ? test_rand() : i / 16; // code-like: partly random, partly regular
+    }
+}
+
+static dy_cloud_resp_fw_update_t advertise(const uint8_t *img, uint32_t len) {
+    dy_cloud_resp_fw_update_t res = {.size = len};
+    uint8_t digest[32];
+
+    strcpy(res.url, "http://fw/a.bin");
+    sha256(img, len, digest);
+    sha256_hex(digest, res.sha256);
+    server.res[0] = (resource_t) {.url = "http://fw/a.bin", .data = img, .len = len};
+
+    return res;
+}
+
+static void advertise_delta(dy_cloud_resp_fw_update_t *res, const uint8_t *patch, uint32_t len) {
+    strcpy(res->delta_url, "http://fw/a.dyd");
+    res->delta_size = len;
+    server.res[1] = (resource_t) {.url = "http://fw/a.dyd", .data = patch, .len = len};
+}
+
+static void reset() {
+    if (dl.active) {
+        download_abort();
+    }
+    memset(&ota, 0, sizeof(ota));
+    memset(&server, 0, sizeof(server));
+    memset(flash, 0, sizeof(flash));
+    delays = 0;
+    n_progress = 0;
+}
+
+static bool installed(const uint8_t *img, uint32_t len) {
+    return ota.ends == 1 && !ota.open && ota.boot == &next && ota.written == len && memcmp(flash, img, len) == 0;
+}
+
+static void test_full() {
+    reset();
+    dy_cloud_resp_fw_update_t res = advertise(image, IMAGE_SIZE);
+
+    CHECK(!dy_is_err(perform(&res)));
+    CHECK(installed(image, IMAGE_SIZE));
+    CHECK_INT(server.requests, 1);
+    CHECK_INT(ota.aborts, 0);
+
+    // The first report is at the start, the last one at the end; the clock runs 1 ms per reading
+    CHECK(n_progress >= 2);
+    CHECK_INT(last_progress.received, IMAGE_SIZE);
+    CHECK_INT(last_progress.total, IMAGE_SIZE);
+    CHECK(last_progress.rate > 0);
+}
+
+// Lost connections are resumed by Range requests, up to the attempts of a run, into the same OTA write.
+static void test_resume() {
+    reset();
+    dy_cloud_resp_fw_update_t res = advertise(image, IMAGE_SIZE);
+    server.cut_after = 12000;
+    server.cuts = -1;
+
+    CHECK(!dy_is_err(perform(&res)));
+    CHECK(installed(image, IMAGE_SIZE));
+    CHECK_INT(server.requests, 5);
+    for (int i = 0; i < 5; i++) {
+        CHECK_INT(server.ranges[i], i * 12000);
+    }
+    CHECK_INT(ota.begins, 1);
+    CHECK_INT(delays, 4);
+}
+
+// A download which runs out of attempts is kept for the next job run, which resumes it.
+static void test_resume_next_run() {
+    reset();
+    dy_cloud_resp_fw_update_t res = advertise(image, IMAGE_SIZE);
+    server.cut_after = 6000;
+    server.cuts = -1;
+
+    CHECK_INT(perform(&res)->code, DY_ERR_FAILED);
+    CHECK(dl.active && ota.open);
+    CHECK_INT(dl.received, 5 * 6000);
+    CHECK_INT(ota.aborts, 0);
+
+    server.cut_after = 0;
+    CHECK(!dy_is_err(perform(&res)));
+    CHECK(installed(image, IMAGE_SIZE));
+    CHECK_INT(server.requests, 6);
+    CHECK_INT(server.ranges[5], 5 * 6000);
+    CHECK_INT(ota.begins, 1);
+}
+
+// A server ignoring Range sends the whole image again; bytes already written are skipped.
+static void test_no_range() {
+    reset();
+    dy_cloud_resp_fw_update_t res = advertise(image, IMAGE_SIZE);
+    server.no_range = true;
+    server.cut_after = 20000;
+    server.cuts = 1;
+
+    CHECK(!dy_is_err(perform(&res)));
+    CHECK(installed(image, IMAGE_SIZE));
+    CHECK_INT(server.requests, 2);
+    CHECK_INT(server.ranges[1], 20000);
+}
+
+static void test_unverified() {
+    reset();
+    dy_cloud_resp_fw_update_t res = advertise(image, IMAGE_SIZE);
+
+    dy_cloud_resp_fw_update_t no_size = res;
+    no_size.size = 0;
+    CHECK_INT(perform(&no_size)->code, DY_ERR_INVALID_ARG);
+
+    dy_cloud_resp_fw_update_t no_sha = res;
+    no_sha.sha256[0] = '\0';
+    CHECK_INT(perform(&no_sha)->code, DY_ERR_INVALID_ARG);
+
+    dy_cloud_resp_fw_update_t bad_sha = res;
+    bad_sha.sha256[10] = 'z';
+    CHECK_INT(perform(&bad_sha)->code, DY_ERR_INVALID_ARG);
+
+    CHECK_INT(server.requests, 0);
+    CHECK_INT(ota.begins, 0);
+}
+
+// Images not matching the advertisement are never booted.
+static void test_mismatch() {
+    reset();
+    dy_cloud_resp_fw_update_t res = advertise(image, IMAGE_SIZE);
+    res.sha256[0] = res.sha256[0] == '0' ? '1' : '0';
+
+    CHECK_INT(perform(&res)->code, DY_ERR_FAILED);
+    CHECK_INT(ota.aborts, 1);
+    CHECK(!ota.open && !dl.active && ota.boot == NULL);
+
+    reset();
+    res = advertise(image, IMAGE_SIZE);
+    res.size = IMAGE_SIZE - 1;
+    CHECK_INT(perform(&res)->code, DY_ERR_INVALID_SIZE);
+    CHECK_INT(ota.aborts, 1);
+    CHECK(!ota.open && !dl.active && ota.boot == NULL);
+
+    reset();
+    res = advertise(image, IMAGE_SIZE);
+    res.size = PART_SIZE + 1;
+    CHECK_INT(perform(&res)->code, DY_ERR_INVALID_SIZE);
+    CHECK_INT(ota.begins, 0);
+}
+
+// Makes the target of a patch against the running image, and the patch: a changed region, an inserted one and
+// the rest copied.
+static uint8_t *make_delta(uint8_t *target, const uint8_t *base, size_t *len) {
+    patch_ops_t ops = {0};
+    uint8_t diff[4000], ins[600];
+
+    for (int i = 0; i < 4000; i++) {
+        diff[i] = i % 97 == 0 ? 4 : 0; // shifted addresses
+    }
+    make_image(ins, sizeof(ins));
+
+    patch_copy(&ops, 0, 10000);
+    patch_add(&ops, 10000, diff, 4000);
+    patch_insert(&ops, ins, sizeof(ins));
+    patch_copy(&ops, 14000, IMAGE_SIZE - 14000);
+
+    memcpy(target, base, 10000);
+    for (int i = 0; i < 4000; i++) {
+        target[10000 + i] = base[10000 + i] + diff[i];
+    }
+    memcpy(target + 14000, ins, sizeof(ins));
+    memcpy(target + 14000 + sizeof(ins), base + 14000, IMAGE_SIZE - 14000);
+
+    return patch_make(&ops, base, IMAGE_SIZE, target, IMAGE_SIZE + sizeof(ins), len);
+}
+
+static void test_delta() {
+    static uint8_t target[IMAGE_SIZE + 600];
+    size_t patch_len;
+
+    reset();
+    memcpy(running_data, image, IMAGE_SIZE);
+    uint8_t *patch = make_delta(target, image, &patch_len);
+    dy_cloud_resp_fw_update_t res = advertise(target, sizeof(target));
+    advertise_delta(&res, patch, patch_len);
+
+    // Only the patch is downloaded, resumed like an image; the inflater keeps its state across connections
+    server.cut_after = patch_len / 4 + 1;
+    server.cuts = -1;
+    CHECK(patch_len < sizeof(target) / 10);
+    CHECK(!dy_is_err(perform(&res)));
+    CHECK(installed(target, sizeof(target)));
+    CHECK_INT(server.requests, 4);
+    for (int i = 0; i < server.requests; i++) {
+        CHECK(server.urls[i] == &server.res[1]);
+    }
+    CHECK_INT(last_progress.received, patch_len);
+    CHECK_INT(last_progress.total, patch_len);
+
+    free(patch);
+}
+
+// A patch which can't be applied falls back to the full image.
+static void test_delta_fallback() {
+    static uint8_t target[IMAGE_SIZE + 600];
+    size_t patch_len;
+
+    reset();
+    memcpy(running_data, image, IMAGE_SIZE);
+    uint8_t *patch = make_delta(target, image, &patch_len);
+    running_data[5] ^= 1; // another base image is running
+    dy_cloud_resp_fw_update_t res = advertise(target, sizeof(target));
+    advertise_delta(&res, patch, patch_len);
+
+    CHECK(!dy_is_err(perform(&res)));
+    CHECK(installed(target, sizeof(target)));
+    CHECK_INT(server.requests, 2);
+    CHECK(server.urls[0] == &server.res[1] && server.urls[1] == &server.res[0]);
+    CHECK_INT(ota.begins, 2);
+    CHECK_INT(ota.aborts, 1);
+    CHECK_INT(ota.aborted_at, 0); // refused by the header
+
+    // A patch making another image is refused the same way
+    reset();
+    memcpy(running_data, image, IMAGE_SIZE);
+    res = advertise(image, IMAGE_SIZE);
+    advertise_delta(&res, patch, patch_len);
+    CHECK(!dy_is_err(perform(&res)));
+    CHECK(installed(image, IMAGE_SIZE));
+    CHECK_INT(ota.aborts, 1);
+    CHECK_INT(ota.aborted_at, 0);
+
+    free(patch);
+}
+
+// A full download in progress is finished rather than replaced by a patch advertised later.
+static void test_delta_after_full() {
+    static uint8_t target[IMAGE_SIZE + 600];
+    size_t patch_len;
+
+    reset();
+    memcpy(running_data, image, IMAGE_SIZE);
+    uint8_t *patch = make_delta(target, image, &patch_len);
+    dy_cloud_resp_fw_update_t res = advertise(target, sizeof(target));
+    server.cut_after = 2000;
+    server.cuts = -1;
+    CHECK(dy_is_err(perform(&res)));
+
+    server.cut_after = 0;
+    advertise_delta(&res, patch, patch_len);
+    CHECK(!dy_is_err(perform(&res)));
+    CHECK(installed(target, sizeof(target)));
+    CHECK(server.urls[server.requests - 1] == &server.res[0]);
+    CHECK_INT(ota.begins, 1);
+
+    free(patch);
+}
+
+// A withdrawn update drops the download in progress, and another image starts over.
+static void test_withdrawn() {
+    reset();
+    dy_cloud_resp_fw_update_t res = advertise(image, IMAGE_SIZE);
+    server.cut_after = 1000;
+    server.cuts = -1;
+    CHECK(dy_is_err(perform(&res)));
+    CHECK(dl.active);
+
+    CHECK(!dy_is_err(end(false)));
+    CHECK(!dl.active && !ota.open);
+    CHECK_INT(ota.aborts, 1);
+
+    static uint8_t other[IMAGE_SIZE];
+    make_image(other, IMAGE_SIZE);
+    server.cut_after = 0;
+    res = advertise(other, IMAGE_SIZE);
+    CHECK(!dy_is_err(perform(&res)));
+    CHECK(installed(other, IMAGE_SIZE));
+    CHECK_INT(server.ranges[server.requests - 1], 0);
+}
+
+int main() {
+    make_image(image, IMAGE_SIZE);
+
+    TEST_RUN(test_full);
+    TEST_RUN(test_resume);
+    TEST_RUN(test_resume_next_run);
+    TEST_RUN(test_no_range);
+    TEST_RUN(test_unverified);
+    TEST_RUN(test_mismatch);
+    TEST_RUN(test_delta);
+    TEST_RUN(test_delta_fallback);
+    TEST_RUN(test_delta_after_full);
+    TEST_RUN(test_withdrawn);
+    TEST_EXIT();
+}
@@ -0,0 +1,179 @@
+#include "retry.h"
+#include "test.h"
+
+#define S 1000000LL // us
+
+// Random sources: a fixed value, or the test generator.
+static uint32_t rand_value;
+
+static uint32_t rand_fixed() {
+    return rand_value;
+}
+
+// A failed run at `now`, as the scheduler does it.
+static void fail(dy_cloud_retry_state_t *st, const dy_cloud_retry_policy_t *p, int64_t now, dy_cloud_rand_t rnd) {
+    retry_on_run(st);
+    retry_on_failure(st, p, now, rnd);
+    CHECK_INT(st->next_due, now + (int64_t) st->delay * 1000);
+}
+
+// Delays are random within [1 s, cap], where the cap doubles from `base` up to `max`.
+static void test_jitter() {
+    const dy_cloud_retry_policy_t p = {.base = 10, .max = 900, .breaker_threshold = 0};
+    static const uint32_t caps[] = {10, 20, 40, 80, 160, 320, 640, 900, 900, 900};
+
+    for (int i = 0; i < 10; i++) {
+        uint32_t min = UINT32_MAX, max = 0;
+
+        // The same number of failures, sampled many times from a fresh state
+        for (int n = 0; n < 2000; n++) {
+            dy_cloud_retry_state_t st = {0};
+            st.failures = i;
+            fail(&st, &p, 5 * S, test_rand);
+            min = st.delay < min ? st.delay : min;
+            max = st.delay > max ? st.delay : max;
+        }
+
+        CHECK(min >= 1000);
+        CHECK(max <= caps[i] * 1000);
+        // The whole range is used, so devices don't retry in lockstep
+        CHECK(max > caps[i] * 1000 * 9 / 10);
+        CHECK(min < caps[i] * 1000 / 10 || min == 1000);
+    }
+}
+
+// A zero jitter is raised to 1 s, so a job can't turn into a busy loop.
+static void test_floor() {
+    const dy_cloud_retry_policy_t p = DY_CLOUD_RETRY_POLICY_DEFAULT;
+    dy_cloud_retry_state_t st = {0};
+
+    rand_value = 0;
+    fail(&st, &p, 0, rand_fixed);
+    CHECK_INT(st.delay, 1000);
+    CHECK_INT(st.next_due, 1 * S);
+
+    rand_value = 999;
+    fail(&st, &p, 7 * S, rand_fixed);
+    CHECK_INT(st.delay, 1000);
+}
+
+// The cap stops at `max`, also after a very long run of failures, and is reached exactly.
+static void test_cap() {
+    const dy_cloud_retry_policy_t p = {.base = 10, .max = 900, .breaker_threshold = 0};
+    dy_cloud_retry_state_t st = {0};
+
+    rand_value = 900 * 1000;
+    for (int i = 0; i < 20; i++) {
+        fail(&st, &p, 0, rand_fixed);
+    }
+    CHECK_INT(st.delay, 900 * 1000);
+
+    st.failures = UINT32_MAX - 1;
+    fail(&st, &p, 0, rand_fixed);
+    CHECK_INT(st.failures, UINT32_MAX);
+    fail(&st, &p, 0, rand_fixed);
+    CHECK_INT(st.failures, UINT32_MAX); // saturates
+    CHECK_INT(st.delay, 900 * 1000);
+    CHECK_INT(st.breaker, DY_CLOUD_BREAKER_CLOSED);
+
+    // The largest valid policy doesn't overflow the delay in ms
+    const dy_cloud_retry_policy_t big = {.base = 1, .max = UINT32_MAX / 1000};
+    CHECK(retry_policy_valid(&big));
+    rand_value = UINT32_MAX;
+    fail(&st, &big, 0, rand_fixed);
+    CHECK(st.delay <= big.max * 1000);
+}
+
+// The breaker opens on the threshold-th consecutive failure, for the timeout randomized down to a half of it.
+static void test_breaker() {
+    const dy_cloud_retry_policy_t p = DY_CLOUD_RETRY_POLICY_DEFAULT;
+    dy_cloud_retry_state_t st = {0};
+    int64_t now = 0;
+
+    for (uint32_t i = 1; i < p.breaker_threshold; i++) {
+        fail(&st, &p, now, test_rand);
+        CHECK_INT(st.breaker, DY_CLOUD_BREAKER_CLOSED);
+        now = st.next_due;
+    }
+
+    rand_value = 0;
+    fail(&st, &p, now, rand_fixed);
+    CHECK_INT(st.breaker, DY_CLOUD_BREAKER_OPEN);
+    CHECK_INT(st.delay, 3600 * 1000);
+
+    // Both ends of the randomized timeout
+    dy_cloud_retry_state_t st2 = {.failures = p.breaker_threshold - 1};
+    rand_value = 1800 * 1000;
+    fail(&st2, &p, now, rand_fixed);
+    CHECK_INT(st2.delay, 1800 * 1000);
+    for (int i = 0; i < 1000; i++) {
+        dy_cloud_retry_state_t st3 = {.failures = p.breaker_threshold - 1};
+        fail(&st3, &p, now, test_rand);
+        CHECK(st3.delay >= 1800 * 1000 && st3.delay <= 3600 * 1000);
+    }
+
+    // A threshold of 0 disables the breaker
+    const dy_cloud_retry_policy_t off = {.base = 10, .max = 900, .breaker_threshold = 0, .breaker_timeout = 3600};
+    dy_cloud_retry_state_t st4 = {0};
+    for (int i = 0; i < 100; i++) {
+        fail(&st4, &off, 0, test_rand);
+    }
+    CHECK_INT(st4.breaker, DY_CLOUD_BREAKER_CLOSED);
+}
+
+// After the timeout a single trial run goes: it closes the breaker on success, or opens it again on failure.
+static void test_half_open() {
+    const dy_cloud_retry_policy_t p = DY_CLOUD_RETRY_POLICY_DEFAULT;
+    dy_cloud_retry_state_t st = {0};
+    int64_t now = 0;
+
+    while (st.breaker != DY_CLOUD_BREAKER_OPEN) {
+        fail(&st, &p, now, test_rand);
+        now = st.next_due;
+    }
+    CHECK_INT(st.runs, p.breaker_threshold);
+
+    // Trial failed: opened again, for the full randomized timeout rather than a backoff delay
+    retry_on_run(&st);
+    CHECK_INT(st.breaker, DY_CLOUD_BREAKER_HALF_OPEN);
+    retry_on_failure(&st, &p, now, test_rand);
+    CHECK_INT(st.breaker, DY_CLOUD_BREAKER_OPEN);
+    CHECK(st.delay >= 1800 * 1000 && st.delay <= 3600 * 1000);
+    CHECK_INT(st.failures, p.breaker_threshold + 1);
+    now = st.next_due;
+
+    // Trial succeeded: closed, and the next failure starts the backoff over
+    retry_on_run(&st);
+    CHECK_INT(st.breaker, DY_CLOUD_BREAKER_HALF_OPEN);
+    retry_on_success(&st, 900, now);
+    CHECK_INT(st.breaker, DY_CLOUD_BREAKER_CLOSED);
+    CHECK_INT(st.failures, 0);
+    CHECK_INT(st.delay, 0);
+    CHECK_INT(st.next_due, now + 900 * S);
+    CHECK_INT(st.runs, p.breaker_threshold + 2);
+
+    now = st.next_due;
+    rand_value = UINT32_MAX;
+    fail(&st, &p, now, rand_fixed);
+    CHECK_INT(st.breaker, DY_CLOUD_BREAKER_CLOSED);
+    CHECK(st.delay <= 10 * 1000);
+}
+
+static void test_policy() {
+    CHECK(retry_policy_valid(&DY_CLOUD_RETRY_POLICY_DEFAULT));
+    CHECK(!retry_policy_valid(&(dy_cloud_retry_policy_t) {.base = 0, .max = 10}));
+    CHECK(!retry_policy_valid(&(dy_cloud_retry_policy_t) {.base = 10, .max = 5}));
+    CHECK(!retry_policy_valid(&(dy_cloud_retry_policy_t) {.base = 10, .max = UINT32_MAX / 1000 + 1}));
+    CHECK(!retry_policy_valid(&(dy_cloud_retry_policy_t) {.base = 10, .max = 10,
+                                                          .breaker_timeout = UINT32_MAX / 1000 + 1}));
+}
+
+int main() {
+    TEST_RUN(test_jitter);
+    TEST_RUN(test_floor);
+    TEST_RUN(test_cap);
+    TEST_RUN(test_breaker);
+    TEST_RUN(test_half_open);
+    TEST_RUN(test_policy);
+    TEST_EXIT();
+}
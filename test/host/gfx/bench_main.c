@@ -0,0 +1,22 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "dy/error.h"
+#include "dy/gfx_bench.h"
+
+// Runs dy_gfx_bench on the host: gfx_bench [MIN_TIME_US [FILTER]] > report.json
+int main(int argc, char **argv) {
+    dy_gfx_bench_config_t cfg = {
+        .format = DY_GFX_BENCH_JSON,
+        .out = stdout,
+        .min_time_us = argc > 1 ? strtoul(argv[1], NULL, 10) : 0,
+        .filter = argc > 2 ? argv[2] : NULL,
+    };
+
+    dy_err_t err = dy_gfx_bench_run(&cfg);
+    if (dy_is_err(err)) {
+        fprintf(stderr, "dy_gfx_bench_run: %s\n", dy_err_str(err));
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,62 @@
+/**
+ * @brief Reference bitmaps for gfx host tests.
+ *
+ * A picture is an array of strings, one per row: '#' is a pixel of the drawn colour and '.' is a black one.
+ */
+
+#pragma once
+
+#include <string.h>
+#include "dy/gfx/gfx.h"
+#include "test.h"
+
+#define PIC_PX dy_gfx_new_px(255, 255, 255)
+
+static bool px_eq(dy_gfx_px_t a, dy_gfx_px_t b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+static void print_buf(const dy_gfx_buf_t *buf) {
+    for (uint16_t y = 0; y < buf->height; y++) {
+        fprintf(stderr, "    \"");
+        for (uint16_t x = 0; x < buf->width; x++) {
+            fputc(px_eq(buf->content[y * buf->width + x], PIC_PX) ? '#' : '.', stderr);
+        }
+        fprintf(stderr, "\",\n");
+    }
+}
+
+// Compares a buffer with a picture and prints the buffer if they differ.
+#define CHECK_PICTURE(buf, ...) do { \
+    const char *rows_[] = {__VA_ARGS__}; \
+    if (!picture_eq(buf, rows_, sizeof(rows_) / sizeof(rows_[0]))) { \
+        fprintf(stderr, "%s:%d: %s differs from the picture:\n", __FILE__, __LINE__, #buf); \
+        print_buf(buf); \
+        test_failures++; \
+    } \
+} while (0)
+
+static bool picture_eq(const dy_gfx_buf_t *buf, const char **rows, uint16_t n_rows) {
+    if (n_rows != buf->height) {
+        return false;
+    }
+
+    for (uint16_t y = 0; y < buf->height; y++) {
+        if (strlen(rows[y]) != buf->width) {
+            return false;
+        }
+        for (uint16_t x = 0; x < buf->width; x++) {
+            dy_gfx_px_t px = buf->content[y * buf->width + x];
+            if (!px_eq(px, rows[y][x] == '#' ? PIC_PX : (dy_gfx_px_t) {0})) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static bool buf_eq(const dy_gfx_buf_t *a, const dy_gfx_buf_t *b) {
+    return a->width == b->width && a->height == b->height &&
+           memcmp(a->content, b->content, (size_t) a->width * a->height * sizeof(dy_gfx_px_t)) == 0;
+}
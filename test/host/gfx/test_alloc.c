@@ -0,0 +1,194 @@
+#include <stdlib.h>
+#include <string.h>
+#include "dy/gfx/gfx.h"
+#include "dy/gfx/alloc.h"
+#include "test.h"
+
+#ifdef __SANITIZE_ADDRESS__
+size_t __sanitizer_get_current_allocated_bytes(void);
+#define heap_used() __sanitizer_get_current_allocated_bytes()
+#else
+// mallinfo() counts chunks cached by glibc as used, so leaks are only checked with the sanitizers
+#define heap_used() ((size_t) 0)
+#endif
+
+#define CYCLES 20000
+#define POOL_BLOCKS 37
+#define POOL_W 12
+#define POOL_H 9
+
+// Fills a buffer with a pattern derived from a tag, so overlapping buffers are detected when checked.
+static void stamp(dy_gfx_buf_t *buf, uint8_t tag) {
+    for (uint32_t i = 0; i < (uint32_t) buf->width * buf->height; i++) {
+        buf->content[i] = (dy_gfx_px_t) {tag, (uint8_t) i, (uint8_t) (tag ^ i)};
+    }
+}
+
+static bool stamp_ok(const dy_gfx_buf_t *buf, uint8_t tag) {
+    for (uint32_t i = 0; i < (uint32_t) buf->width * buf->height; i++) {
+        dy_gfx_px_t px = buf->content[i];
+        if (px.r != tag || px.g != (uint8_t) i || px.b != (uint8_t) (tag ^ i)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool is_zero(const dy_gfx_buf_t *buf) {
+    for (uint32_t i = 0; i < (uint32_t) buf->width * buf->height; i++) {
+        if (buf->content[i].r || buf->content[i].g || buf->content[i].b) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Heap buffers of random sizes are created, split, moved and freed; the heap use must return to where it started.
+static void test_heap_soak() {
+    size_t before = heap_used();
+
+    for (int i = 0; i < CYCLES; i++) {
+        uint16_t w = 1 + test_rand() % 40, h = 1 + test_rand() % 20;
+
+        dy_gfx_buf_t *buf = dy_gfx_new_buf(w, h);
+        CHECK(buf != NULL && is_zero(buf));
+        stamp(buf, i);
+
+        dy_gfx_move(buf, (dy_gfx_point_t) {(int32_t) (test_rand() % 5) - 2, (int32_t) (test_rand() % 5) - 2});
+
+        // Chunks of 1x1 make up to 800 buffers, more than the uint8_t length split used to truncate to
+        uint8_t cw = 1 + test_rand() % 8, ch = 1 + test_rand() % 8;
+        dy_gfx_buf_array_t *arr = dy_gfx_split(buf, cw, ch);
+        CHECK(arr != NULL);
+        CHECK_INT(arr->len, (w / cw) * (h / ch));
+        dy_gfx_free_buf_array(arr);
+
+        arr = dy_gfx_make_buf_array(1 + test_rand() % 6, w, h);
+        CHECK(arr != NULL);
+        for (uint16_t j = 0; j < arr->len; j++) {
+            stamp(arr->buffers[j], j);
+        }
+        for (uint16_t j = 0; j < arr->len; j++) {
+            CHECK(stamp_ok(arr->buffers[j], j));
+        }
+        dy_gfx_free_buf_array(arr);
+
+        dy_gfx_free_buf(buf);
+    }
+
+    CHECK_INT(heap_used(), before);
+}
+
+static void test_pool_soak() {
+    size_t before = heap_used();
+    dy_gfx_pool_t *pool = dy_gfx_pool_new(POOL_BLOCKS, POOL_W, POOL_H);
+    dy_gfx_buf_t *held[POOL_BLOCKS] = {0};
+    uint8_t tags[POOL_BLOCKS];
+    uint32_t n_held = 0, max_held = 0;
+
+    CHECK(pool != NULL);
+
+    for (int i = 0; i < CYCLES; i++) {
+        uint32_t slot = test_rand() % POOL_BLOCKS;
+
+        if (held[slot] != NULL) {
+            CHECK(stamp_ok(held[slot], tags[slot]));
+            dy_gfx_pool_free_buf(pool, held[slot]);
+            if (test_rand() % 8 == 0) {
+                dy_gfx_pool_free_buf(pool, held[slot]); // double frees are ignored
+            }
+            held[slot] = NULL;
+            n_held--;
+        } else {
+            uint16_t w = 1 + test_rand() % POOL_W, h = 1 + test_rand() % POOL_H;
+            held[slot] = dy_gfx_pool_new_buf(pool, w, h);
+            CHECK(held[slot] != NULL && is_zero(held[slot]));
+            tags[slot] = i;
+            stamp(held[slot], tags[slot]);
+            n_held++;
+            max_held = n_held > max_held ? n_held : max_held;
+        }
+
+        // Too large buffers are refused without taking a block
+        if (test_rand() % 64 == 0) {
+            CHECK(dy_gfx_pool_new_buf(pool, POOL_W + 1, POOL_H) == NULL);
+        }
+
+        CHECK_INT(dy_gfx_pool_stats(pool).used, n_held);
+    }
+
+    for (uint32_t i = 0; i < POOL_BLOCKS; i++) {
+        if (held[i] != NULL) {
+            CHECK(stamp_ok(held[i], tags[i]));
+            dy_gfx_pool_free_buf(pool, held[i]);
+            held[i] = NULL;
+        }
+    }
+
+    // Empty: every block is free again and can be taken at full size, after which the pool is exhausted
+    dy_gfx_alloc_stats_t st = dy_gfx_pool_stats(pool);
+    CHECK_INT(st.used, 0);
+    CHECK_INT(st.high_water, max_held);
+    for (uint32_t i = 0; i < POOL_BLOCKS; i++) {
+        held[i] = dy_gfx_pool_new_buf(pool, POOL_W, POOL_H);
+        CHECK(held[i] != NULL);
+        stamp(held[i], i);
+    }
+    CHECK(dy_gfx_pool_new_buf(pool, 1, 1) == NULL);
+    for (uint32_t i = 0; i < POOL_BLOCKS; i++) {
+        CHECK(stamp_ok(held[i], i));
+        dy_gfx_pool_free_buf(pool, held[i]);
+    }
+    CHECK_INT(dy_gfx_pool_stats(pool).used, 0);
+
+    dy_gfx_pool_free(pool);
+    CHECK_INT(heap_used(), before);
+}
+
+static void test_arena_soak() {
+    size_t before = heap_used();
+    dy_gfx_arena_t *arena = dy_gfx_arena_new(4096);
+    dy_gfx_buf_t *held[256];
+    uint32_t n_resets = 0;
+
+    CHECK(arena != NULL);
+
+    for (int i = 0; i < CYCLES / 50; i++) {
+        // Allocate until the arena is full
+        uint32_t n = 0;
+        dy_gfx_buf_t *buf;
+        while (n < 256 && (buf = dy_gfx_arena_new_buf(arena, 1 + test_rand() % 16, 1 + test_rand() % 8)) != NULL) {
+            CHECK(is_zero(buf));
+            stamp(buf, n);
+            held[n++] = buf;
+        }
+        for (uint32_t j = 0; j < n; j++) {
+            CHECK(stamp_ok(held[j], j));
+        }
+        CHECK(dy_gfx_arena_stats(arena).used <= dy_gfx_arena_stats(arena).capacity);
+
+        dy_gfx_arena_reset(arena);
+        n_resets++;
+        CHECK_INT(dy_gfx_arena_stats(arena).used, 0);
+    }
+
+    // Empty and unfragmented: a single buffer filling the whole arena fits after a reset
+    dy_gfx_alloc_stats_t st = dy_gfx_arena_stats(arena);
+    uint32_t max_px = (st.capacity - sizeof(dy_gfx_buf_t)) / sizeof(dy_gfx_px_t);
+    dy_gfx_buf_t *buf = dy_gfx_arena_new_buf(arena, max_px, 1);
+    CHECK(buf != NULL);
+    CHECK(dy_gfx_arena_new_buf(arena, 1, 1) == NULL);
+    CHECK(st.n_fails >= n_resets);
+
+    dy_gfx_arena_free(arena);
+    CHECK_INT(heap_used(), before);
+}
+
+int main() {
+    TEST_RUN(test_heap_soak);
+    TEST_RUN(test_pool_soak);
+    TEST_RUN(test_arena_soak);
+    TEST_EXIT();
+}
@@ -0,0 +1,338 @@
+#include <stdlib.h>
+#include "dy/gfx/gfx.h"
+#include "dy/gfx/asset.h"
+#include "dy/gfx/qoi.h"
+#include "picture.h"
+
+#ifdef TEST_ASSET_PACK
+#include "dy/gfx/font/8x8v1.h"
+#include "assets.h"
+#endif
+
+#define ENTRY_LEN sizeof(dy_gfx_asset_entry_t)
+#define MAX_CONTAINER 512
+
+typedef struct {
+    uint8_t data[MAX_CONTAINER];
+    uint32_t len;
+    uint32_t n_entries;
+} container_t;
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+// Starts a container with room for n entries; entries are then appended in the order of their ids.
+static void container_init(container_t *c, uint32_t n) {
+    memset(c, 0, sizeof(container_t));
+    memcpy(c->data, "DYA1", 4);
+    c->len = 16 + n * ENTRY_LEN;
+}
+
+static dy_gfx_asset_entry_t *container_add(container_t *c, const char *name, uint16_t id, uint8_t type,
+                                           const void *meta, size_t meta_len, const void *data, uint32_t size) {
+    dy_gfx_asset_entry_t *e = (dy_gfx_asset_entry_t *) (c->data + 16) + c->n_entries++;
+
+    c->len = (c->len + 3) & ~3u;
+    strncpy(e->name, name, DY_GFX_ASSET_NAME_LEN);
+    e->id = id;
+    e->type = type;
+    e->offset = c->len;
+    e->size = size;
+    memcpy(e->meta, meta, meta_len);
+    memcpy(c->data + c->len, data, size);
+    c->len += size;
+
+    put_u32(c->data + 4, c->n_entries);
+    put_u32(c->data + 8, c->len);
+
+    return e;
+}
+
+// A container with a 2x1 sprite, a 1-frame sheet of it and a compressed 2x1 sprite.
+static void make_sample(container_t *c) {
+    static const uint8_t px[] = {1, 2, 3, 4, 5, 6};
+    static const uint8_t cs[] = {0, 0, 0, 255, 255, 255, 0x40}; // palette of 2, then packed 1 bpp indices 0 and 1
+
+    container_init(c, 3);
+    container_add(c, "sprite", 3, DY_GFX_ASSET_SPRITE, (uint8_t[]) {2, 0, 1, 0}, 4, px, sizeof(px));
+    container_add(c, "sheet", 5, DY_GFX_ASSET_SPRITE_SHEET, (uint8_t[]) {2, 0, 1, 0, 1, 0}, 6, px, sizeof(px));
+    container_add(c, "csprite", 9, DY_GFX_ASSET_CSPRITE,
+                  (uint8_t[]) {2, 0, 1, 0, 2, 0, DY_GFX_CSPRITE_PACKED, 1}, 8, cs, sizeof(cs));
+}
+
+static void test_lookup() {
+    container_t c;
+    dy_gfx_asset_store_t store;
+    dy_gfx_asset_t a;
+
+    make_sample(&c);
+    CHECK(!dy_is_err(dy_gfx_asset_open_mem(&store, c.data, c.len)));
+    CHECK_INT(store.n_entries, 3);
+
+    // By id, hitting both halves of the binary search and missing between and around the ids
+    CHECK(!dy_is_err(dy_gfx_asset_get(&store, 3, DY_GFX_ASSET_SPRITE, &a)));
+    CHECK(!dy_is_err(dy_gfx_asset_get(&store, 5, DY_GFX_ASSET_SPRITE_SHEET, &a)));
+    CHECK(!dy_is_err(dy_gfx_asset_get(&store, 9, DY_GFX_ASSET_CSPRITE, &a)));
+    CHECK_INT(dy_gfx_asset_get(&store, 1, DY_GFX_ASSET_SPRITE, &a)->code, DY_ERR_NOT_FOUND);
+    CHECK_INT(dy_gfx_asset_get(&store, 4, DY_GFX_ASSET_SPRITE, &a)->code, DY_ERR_NOT_FOUND);
+    CHECK_INT(dy_gfx_asset_get(&store, 10, DY_GFX_ASSET_SPRITE, &a)->code, DY_ERR_NOT_FOUND);
+
+    // By name, with the type checked
+    CHECK(!dy_is_err(dy_gfx_asset_find(&store, "sheet", DY_GFX_ASSET_SPRITE_SHEET, &a)));
+    CHECK_INT(a.entry->id, 5);
+    CHECK(a.data == c.data + a.entry->offset);
+    CHECK_INT(dy_gfx_asset_find(&store, "sheet", DY_GFX_ASSET_SPRITE, &a)->code, DY_ERR_INVALID_ARG);
+    CHECK_INT(dy_gfx_asset_find(&store, "she", DY_GFX_ASSET_SPRITE_SHEET, &a)->code, DY_ERR_NOT_FOUND);
+    CHECK_INT(dy_gfx_asset_find(&store, "sheets", DY_GFX_ASSET_SPRITE_SHEET, &a)->code, DY_ERR_NOT_FOUND);
+
+    // Views refer to the container's memory
+    CHECK(!dy_is_err(dy_gfx_asset_find(&store, "csprite", DY_GFX_ASSET_CSPRITE, &a)));
+    dy_gfx_csprite_t cs = dy_gfx_asset_csprite(&a);
+    CHECK_INT(cs.width, 2);
+    CHECK_INT(cs.n_colors, 2);
+    CHECK_INT(cs.data_len, 1);
+    CHECK(cs.data == a.data + 6);
+
+    dy_gfx_buf_t *buf = dy_gfx_new_buf(2, 1);
+    CHECK(!dy_is_err(dy_gfx_blit_csprite(buf, (dy_gfx_point_t) {0, 0}, &cs, 0)));
+    CHECK_PICTURE(buf, ".#");
+    dy_gfx_free_buf(buf);
+
+    dy_gfx_asset_close(&store);
+}
+
+// Names of exactly DY_GFX_ASSET_NAME_LEN bytes are not terminated, and longer names must not match them.
+static void test_long_name() {
+    container_t c;
+    dy_gfx_asset_store_t store;
+    dy_gfx_asset_t a;
+    static const char name[] = "abcdefghijklmnopqrstuvwx";
+
+    container_init(&c, 1);
+    container_add(&c, name, 1, DY_GFX_ASSET_RAW, "", 0, "x", 1);
+    CHECK(!dy_is_err(dy_gfx_asset_open_mem(&store, c.data, c.len)));
+
+    CHECK(!dy_is_err(dy_gfx_asset_find(&store, name, DY_GFX_ASSET_RAW, &a)));
+    CHECK_INT(dy_gfx_asset_find(&store, "abcdefghijklmnopqrstuvwxyz", DY_GFX_ASSET_RAW, &a)->code, DY_ERR_NOT_FOUND);
+
+    dy_gfx_asset_close(&store);
+}
+
+static void test_malformed() {
+    container_t c;
+    dy_gfx_asset_store_t store;
+    dy_gfx_asset_t a;
+
+    make_sample(&c);
+    CHECK_INT(dy_gfx_asset_open_mem(&store, c.data, 15)->code, DY_ERR_INVALID_ARG);
+    CHECK_INT(dy_gfx_asset_open_mem(&store, c.data, c.len - 1)->code, DY_ERR_INVALID_ARG);
+
+    make_sample(&c);
+    c.data[3] = '2';
+    CHECK_INT(dy_gfx_asset_open_mem(&store, c.data, c.len)->code, DY_ERR_INVALID_VERSION);
+
+    // More entries than fit before the end of the container
+    make_sample(&c);
+    put_u32(c.data + 4, (c.len - 16) / ENTRY_LEN + 1);
+    CHECK_INT(dy_gfx_asset_open_mem(&store, c.data, c.len)->code, DY_ERR_INVALID_ARG);
+
+    dy_gfx_asset_entry_t *e = (dy_gfx_asset_entry_t *) (c.data + 16);
+
+    make_sample(&c);
+    e[1].id = 3; // duplicate of the first one
+    CHECK_INT(dy_gfx_asset_open_mem(&store, c.data, c.len)->code, DY_ERR_INVALID_ARG);
+
+    make_sample(&c);
+    e[2].offset += 2;
+    CHECK_INT(dy_gfx_asset_open_mem(&store, c.data, c.len)->code, DY_ERR_INVALID_ARG);
+
+    make_sample(&c);
+    e[2].size += 4;
+    CHECK_INT(dy_gfx_asset_open_mem(&store, c.data, c.len)->code, DY_ERR_INVALID_ARG);
+
+    make_sample(&c);
+    e[2].offset = 0xFFFFFFFC; // the sum with the size wraps around
+    CHECK_INT(dy_gfx_asset_open_mem(&store, c.data, c.len)->code, DY_ERR_INVALID_ARG);
+
+    // Properties larger than the data are refused on lookup
+    make_sample(&c);
+    e[0].meta[0] = 3;
+    CHECK(!dy_is_err(dy_gfx_asset_open_mem(&store, c.data, c.len)));
+    CHECK_INT(dy_gfx_asset_get(&store, 3, DY_GFX_ASSET_SPRITE, &a)->code, DY_ERR_INVALID_ARG);
+
+    make_sample(&c);
+    e[1].meta[4] = 2;
+    CHECK(!dy_is_err(dy_gfx_asset_open_mem(&store, c.data, c.len)));
+    CHECK_INT(dy_gfx_asset_get(&store, 5, DY_GFX_ASSET_SPRITE_SHEET, &a)->code, DY_ERR_INVALID_ARG);
+
+    make_sample(&c);
+    e[1].meta[4] = 0; // a sheet without frames
+    CHECK(!dy_is_err(dy_gfx_asset_open_mem(&store, c.data, c.len)));
+    CHECK_INT(dy_gfx_asset_get(&store, 5, DY_GFX_ASSET_SPRITE_SHEET, &a)->code, DY_ERR_INVALID_ARG);
+
+    make_sample(&c);
+    e[2].meta[4] = 3;
+    CHECK(!dy_is_err(dy_gfx_asset_open_mem(&store, c.data, c.len)));
+    CHECK_INT(dy_gfx_asset_get(&store, 9, DY_GFX_ASSET_CSPRITE, &a)->code, DY_ERR_INVALID_ARG);
+}
+
+// Random bytes of the sample are flipped; whatever opens and looks up fine must be usable within its bounds.
+static void test_fuzz() {
+    container_t c;
+    static const uint8_t types[] = {DY_GFX_ASSET_SPRITE, DY_GFX_ASSET_SPRITE_SHEET, DY_GFX_ASSET_CSPRITE};
+    dy_gfx_buf_t *buf = dy_gfx_new_buf(8, 8);
+
+    for (int i = 0; i < 20000; i++) {
+        make_sample(&c);
+        for (int n = 1 + test_rand() % 4; n > 0; n--) {
+            c.data[test_rand() % c.len] ^= 1 << (test_rand() % 8);
+        }
+
+        // Exact size, so ASan catches reads past the end
+        uint8_t *data = malloc(c.len);
+        memcpy(data, c.data, c.len);
+
+        dy_gfx_asset_store_t store;
+        if (!dy_is_err(dy_gfx_asset_open_mem(&store, data, c.len))) {
+            for (uint32_t j = 0; j < store.n_entries; j++) {
+                for (int t = 0; t < 3; t++) {
+                    dy_gfx_asset_t a;
+                    if (dy_is_err(dy_gfx_asset_get(&store, store.entries[j].id, types[t], &a))) {
+                        continue;
+                    }
+
+                    if (types[t] == DY_GFX_ASSET_SPRITE) {
+                        dy_gfx_sprite_t sp = dy_gfx_asset_sprite(&a);
+                        dy_gfx_blit_sprite(buf, (dy_gfx_point_t) {0, 0}, &sp, 0, DY_GFX_PX_BLACK);
+                    } else if (types[t] == DY_GFX_ASSET_SPRITE_SHEET) {
+                        dy_gfx_sprite_sheet_t sheet = dy_gfx_asset_sprite_sheet(&a);
+                        dy_gfx_sprite_t sp = dy_gfx_sprite_sheet_frame(&sheet, test_rand());
+                        dy_gfx_blit_sprite(buf, (dy_gfx_point_t) {0, 0}, &sp, 0, DY_GFX_PX_BLACK);
+                    } else {
+                        dy_gfx_csprite_t cs = dy_gfx_asset_csprite(&a);
+                        dy_gfx_blit_csprite(buf, (dy_gfx_point_t) {0, 0}, &cs, 0);
+                    }
+                }
+            }
+        }
+
+        free(data);
+    }
+
+    dy_gfx_free_buf(buf);
+}
+
+#ifdef TEST_ASSET_PACK
+
+static void *read_file(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+
+    fseek(f, 0, SEEK_END);
+    *len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    void *data = malloc(*len);
+    if (fread(data, 1, *len, f) != *len) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+
+    return data;
+}
+
+#define PPM_HEADER_LEN 36
+
+// Pixels of gfx/data/csprite.ppm.
+static const dy_gfx_px_t *ppm_pixels(const uint8_t *ppm) {
+    return (const dy_gfx_px_t *) (ppm + PPM_HEADER_LEN);
+}
+
+// A container made by tools/asset_pack.py must give back what was packed.
+static void test_pack() {
+    dy_gfx_asset_store_t store;
+    dy_gfx_asset_t a;
+    size_t ppm_len, qoi_len;
+    uint8_t *ppm = read_file("gfx/data/csprite.ppm", &ppm_len);
+    uint8_t *qoi = read_file("gfx/data/ops.qoi", &qoi_len);
+    const uint32_t n_px = 13 * 6;
+
+    CHECK(ppm != NULL && qoi != NULL && ppm_len == PPM_HEADER_LEN + n_px * 3);
+    CHECK(!dy_is_err(dy_gfx_asset_open_file(&store, ASSETS_FILE)));
+    if (ppm == NULL || qoi == NULL || store.data == NULL) {
+        return;
+    }
+
+    // The font is the compiled-in one
+    CHECK(!dy_is_err(dy_gfx_asset_get(&store, ASSET_FONT, DY_GFX_ASSET_FONT, &a)));
+    dy_gfx_font_t font = dy_gfx_asset_font(&a);
+    CHECK_INT(font.ascii_offset, dy_gfx_font_8x8v1.ascii_offset);
+    CHECK_INT(font.length, dy_gfx_font_8x8v1.length);
+    CHECK_INT(font.width, dy_gfx_font_8x8v1.width);
+    CHECK_INT(font.height, dy_gfx_font_8x8v1.height);
+    CHECK_INT(a.entry->size, sizeof(data));
+    CHECK(memcmp(font.content.c8, data, sizeof(data)) == 0);
+
+    CHECK(!dy_is_err(dy_gfx_asset_get(&store, ASSET_SPRITE, DY_GFX_ASSET_SPRITE, &a)));
+    dy_gfx_sprite_t sp = dy_gfx_asset_sprite(&a);
+    CHECK_INT(sp.width, 13);
+    CHECK_INT(sp.height, 6);
+    CHECK(memcmp(sp.data, ppm_pixels(ppm), n_px * 3) == 0);
+
+    CHECK(!dy_is_err(dy_gfx_asset_get(&store, ASSET_SHEET, DY_GFX_ASSET_SPRITE_SHEET, &a)));
+    dy_gfx_sprite_sheet_t sheet = dy_gfx_asset_sprite_sheet(&a);
+    CHECK_INT(sheet.n_frames, 3);
+    CHECK_INT(sheet.height, 2);
+    CHECK(dy_gfx_sprite_sheet_frame(&sheet, 2).data == sheet.data + 2 * 13 * 2);
+    CHECK(memcmp(sheet.data, ppm_pixels(ppm), n_px * 3) == 0);
+
+    CHECK(!dy_is_err(dy_gfx_asset_find(&store, "csprite", DY_GFX_ASSET_CSPRITE, &a)));
+    dy_gfx_csprite_t cs = dy_gfx_asset_csprite(&a);
+    dy_gfx_buf_t *buf = dy_gfx_new_buf(13, 6);
+    CHECK(!dy_is_err(dy_gfx_blit_csprite(buf, (dy_gfx_point_t) {0, 0}, &cs, 0)));
+    CHECK(memcmp(buf->content, ppm_pixels(ppm), n_px * 3) == 0);
+
+    // The QOI image of test_qoi.c
+    CHECK(!dy_is_err(dy_gfx_asset_get(&store, ASSET_OPS, DY_GFX_ASSET_QOI, &a)));
+    CHECK_INT(a.entry->size, qoi_len);
+    dy_gfx_buf_t *img = dy_gfx_new_buf(4, 2);
+    CHECK(!dy_is_err(dy_gfx_qoi_decode(img, (dy_gfx_point_t) {0, 0}, a.data, a.entry->size)));
+    CHECK(px_eq(img->content[7], dy_gfx_new_px(200, 100, 50)));
+    dy_gfx_free_buf(img);
+
+    CHECK(!dy_is_err(dy_gfx_asset_find(&store, "abcdefghijklmnopqrstuvwx", DY_GFX_ASSET_RAW, &a)));
+    CHECK_INT(a.entry->id, ASSET_ABCDEFGHIJKLMNOPQRSTUVWX);
+    CHECK_INT(a.entry->size, ppm_len);
+    CHECK(memcmp(a.data, ppm, ppm_len) == 0);
+
+    // Every asset starts 4 byte aligned, so 16-bit fonts can be used in place
+    for (uint32_t i = 0; i < store.n_entries; i++) {
+        CHECK_INT(((uintptr_t) store.data + store.entries[i].offset) % 4, 0);
+    }
+
+    dy_gfx_free_buf(buf);
+    dy_gfx_asset_close(&store);
+    CHECK(store.data == NULL);
+    free(ppm);
+    free(qoi);
+}
+
+#endif
+
+int main() {
+    TEST_RUN(test_lookup);
+    TEST_RUN(test_long_name);
+    TEST_RUN(test_malformed);
+    TEST_RUN(test_fuzz);
+#ifdef TEST_ASSET_PACK
+    TEST_RUN(test_pack);
+#endif
+    TEST_EXIT();
+}
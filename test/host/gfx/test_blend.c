@@ -0,0 +1,261 @@
+#include <stdlib.h>
+#include "dy/gfx/gfx.h"
+#include "picture.h"
+
+#define N_MODES 5
+
+static uint8_t ref_add(uint8_t d, uint8_t s) {
+    return d + s > 255 ? 255 : d + s;
+}
+
+static uint8_t ref_mix(uint8_t d, uint8_t s, uint8_t a) {
+    // 255 is odd, so a quotient is never halfway between two integers
+    return (s * a + d * (255 - a) + 127) / 255;
+}
+
+// Per-pixel reference of merge(), written from the documentation: every pixel of the w x h area at `s_pos` which
+// lands inside of both buffers is blended into the destination.
+static void ref_merge(dy_gfx_buf_t *dst, const dy_gfx_buf_t *src, dy_gfx_point_t d_pos, dy_gfx_point_t s_pos,
+                      int32_t w, int32_t h, const dy_gfx_blend_t *blend) {
+    for (int32_t y = 0; y < h; y++) {
+        for (int32_t x = 0; x < w; x++) {
+            int32_t sx = s_pos.x + x, sy = s_pos.y + y, dx = d_pos.x + x, dy = d_pos.y + y;
+            if (sx < 0 || sy < 0 || sx >= src->width || sy >= src->height ||
+                dx < 0 || dy < 0 || dx >= dst->width || dy >= dst->height) {
+                continue;
+            }
+
+            dy_gfx_px_t s = src->content[sy * src->width + sx];
+            dy_gfx_px_t *d = &dst->content[dy * dst->width + dx];
+            uint8_t a = blend->alpha_map != NULL ? blend->alpha_map[sy * src->width + sx] : blend->alpha;
+            switch (blend->mode) {
+                case DY_GFX_BLEND_COPY:
+                    *d = s;
+                    break;
+                case DY_GFX_BLEND_KEY:
+                    if (!px_eq(s, (dy_gfx_px_t) {0})) {
+                        *d = s;
+                    }
+                    break;
+                case DY_GFX_BLEND_ADD:
+                    *d = dy_gfx_new_px(ref_add(d->r, s.r), ref_add(d->g, s.g), ref_add(d->b, s.b));
+                    break;
+                case DY_GFX_BLEND_ALPHA:
+                    *d = dy_gfx_new_px(ref_mix(d->r, s.r, a), ref_mix(d->g, s.g, a), ref_mix(d->b, s.b, a));
+                    break;
+                case DY_GFX_BLEND_XOR:
+                    *d = dy_gfx_new_px(d->r ^ s.r, d->g ^ s.g, d->b ^ s.b);
+                    break;
+            }
+        }
+    }
+}
+
+// Random content, with runs of black pixels for the key mode and extreme channels for saturation and mixing.
+static void fill_random(dy_gfx_buf_t *buf) {
+    static const uint8_t extremes[] = {0, 1, 254, 255};
+
+    for (uint32_t i = 0; i < buf->width * buf->height; i++) {
+        switch (test_rand() % 4) {
+            case 0:
+                buf->content[i] = (dy_gfx_px_t) {0};
+                break;
+            case 1:
+                buf->content[i] = dy_gfx_new_px(extremes[test_rand() % 4], extremes[test_rand() % 4],
+                                                extremes[test_rand() % 4]);
+                break;
+            default:
+                buf->content[i] = dy_gfx_new_px(test_rand(), test_rand(), test_rand());
+        }
+    }
+}
+
+static void test_modes() {
+    dy_gfx_buf_t *dst = dy_gfx_new_buf(2, 1), *src = dy_gfx_new_buf(2, 1);
+    src->content[0] = dy_gfx_new_px(0, 0, 0);
+    src->content[1] = dy_gfx_new_px(200, 100, 255);
+
+    const struct {
+        dy_gfx_blend_t blend;
+        dy_gfx_px_t expected[2];
+    } cases[] = {
+        {{.mode = DY_GFX_BLEND_COPY}, {{0, 0, 0}, {200, 100, 255}}},
+        {{.mode = DY_GFX_BLEND_KEY}, {{100, 200, 0}, {200, 100, 255}}},
+        {{.mode = DY_GFX_BLEND_ADD}, {{100, 200, 0}, {255, 255, 255}}},
+        {{.mode = DY_GFX_BLEND_ALPHA, .alpha = 0}, {{100, 200, 0}, {100, 200, 0}}},
+        {{.mode = DY_GFX_BLEND_ALPHA, .alpha = 128}, {{50, 100, 0}, {150, 150, 128}}},
+        {{.mode = DY_GFX_BLEND_ALPHA, .alpha = 255}, {{0, 0, 0}, {200, 100, 255}}},
+        {{.mode = DY_GFX_BLEND_ALPHA, .alpha = 0, .alpha_map = (const uint8_t[]) {255, 51}},
+         {{0, 0, 0}, {120, 180, 51}}},
+        {{.mode = DY_GFX_BLEND_XOR}, {{100, 200, 0}, {200 ^ 100, 100 ^ 200, 255}}},
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        dy_gfx_fill(dst, dy_gfx_new_px(100, 200, 0));
+        CHECK_INT(dy_gfx_merge_blend(dst, src, (dy_gfx_point_t) {0, 0}, (dy_gfx_point_t) {0, 0}, &cases[i].blend),
+                  DY_OK);
+        for (int x = 0; x < 2; x++) {
+            if (!px_eq(dst->content[x], cases[i].expected[x])) {
+                fprintf(stderr, "%s:%d: case %zu, pixel %d is %d,%d,%d\n", __FILE__, __LINE__, i, x,
+                        dst->content[x].r, dst->content[x].g, dst->content[x].b);
+                test_failures++;
+            }
+        }
+    }
+
+    CHECK_INT(dy_gfx_merge_blend(dst, src, (dy_gfx_point_t) {0, 0}, (dy_gfx_point_t) {0, 0},
+                                 &(dy_gfx_blend_t) {.mode = N_MODES}), DY_ERR_INVALID_ARG);
+
+    dy_gfx_free_buf(dst);
+    dy_gfx_free_buf(src);
+}
+
+static void test_edges() {
+    dy_gfx_buf_t *dst = dy_gfx_new_buf(5, 5), *src = dy_gfx_new_buf(3, 3);
+    const dy_gfx_blend_t copy = {.mode = DY_GFX_BLEND_COPY};
+    dy_gfx_fill(src, PIC_PX);
+
+    dy_gfx_merge_blend(dst, src, (dy_gfx_point_t) {-1, 1}, (dy_gfx_point_t) {0, 0}, &copy);
+    CHECK_PICTURE(dst,
+                  ".....",
+                  "##...",
+                  "##...",
+                  "##...",
+                  ".....");
+
+    dy_gfx_clear_buf(dst);
+    dy_gfx_merge_blend(dst, src, (dy_gfx_point_t) {3, 1}, (dy_gfx_point_t) {0, 0}, &copy);
+    CHECK_PICTURE(dst,
+                  ".....",
+                  "...##",
+                  "...##",
+                  "...##",
+                  ".....");
+
+    dy_gfx_clear_buf(dst);
+    dy_gfx_merge_area(dst, src, (dy_gfx_point_t) {1, -1}, (dy_gfx_area_t) {0, 0, 3, 3}, &copy);
+    CHECK_PICTURE(dst,
+                  ".###.",
+                  ".###.",
+                  ".....",
+                  ".....",
+                  ".....");
+
+    dy_gfx_clear_buf(dst);
+    dy_gfx_merge_area(dst, src, (dy_gfx_point_t) {1, 3}, (dy_gfx_area_t) {0, 0, 3, 3}, &copy);
+    CHECK_PICTURE(dst,
+                  ".....",
+                  ".....",
+                  ".....",
+                  ".###.",
+                  ".###.");
+
+    // A negative source position shifts the destination instead
+    dy_gfx_clear_buf(dst);
+    dy_gfx_merge_area(dst, src, (dy_gfx_point_t) {0, 0}, (dy_gfx_area_t) {-2, -1, 4, 4}, &copy);
+    CHECK_PICTURE(dst,
+                  ".....",
+                  "..##.",
+                  "..##.",
+                  "..##.",
+                  ".....");
+
+    dy_gfx_free_buf(dst);
+    dy_gfx_free_buf(src);
+}
+
+// Random areas are merged at random positions, mostly partly or fully clipped, in every mode.
+static void test_random() {
+    uint8_t alpha_map[12 * 9];
+
+    for (int i = 0; i < 20000; i++) {
+        dy_gfx_buf_t *src = dy_gfx_new_buf(1 + test_rand() % 12, 1 + test_rand() % 9);
+        dy_gfx_buf_t *dst = dy_gfx_new_buf(1 + test_rand() % 10, 1 + test_rand() % 8);
+        dy_gfx_buf_t *ref = dy_gfx_new_buf(dst->width, dst->height);
+        fill_random(src);
+        fill_random(dst);
+        memcpy(ref->content, dst->content, dst->width * dst->height * sizeof(dy_gfx_px_t));
+        for (int j = 0; j < src->width * src->height; j++) {
+            alpha_map[j] = test_rand() % 3 == 0 ? (test_rand() % 2) * 255 : test_rand();
+        }
+
+        dy_gfx_blend_t blend = {.mode = test_rand() % N_MODES, .alpha = test_rand()};
+        if (blend.mode == DY_GFX_BLEND_ALPHA && test_rand() % 2) {
+            blend.alpha_map = alpha_map;
+        }
+        dy_gfx_point_t d_pos = {(int32_t) (test_rand() % 30) - 14, (int32_t) (test_rand() % 20) - 10};
+        dy_gfx_point_t s_pos = {(int32_t) (test_rand() % 24) - 12, (int32_t) (test_rand() % 18) - 9};
+
+        int32_t w, h;
+        dy_err_code_t err, ref_err = DY_OK;
+        if (test_rand() % 2) {
+            dy_gfx_area_t area = {s_pos.x, s_pos.y, test_rand() % 16, test_rand() % 12};
+            w = area.width;
+            h = area.height;
+            err = dy_gfx_merge_area(dst, src, d_pos, area, &blend);
+        } else {
+            w = src->width - s_pos.x;
+            h = src->height - s_pos.y;
+            if (s_pos.x >= src->width || s_pos.y >= src->height || d_pos.x >= dst->width || d_pos.y >= dst->height) {
+                ref_err = DY_ERR_INVALID_ARG;
+            }
+            err = dy_gfx_merge_blend(dst, src, d_pos, s_pos, &blend);
+        }
+        if (ref_err == DY_OK) {
+            ref_merge(ref, src, d_pos, s_pos, w, h, &blend);
+        }
+
+        if (err != ref_err || !buf_eq(dst, ref)) {
+            fprintf(stderr, "%s:%d: mode %d%s, %dx%d at %ld,%ld of %dx%d into %dx%d at %ld,%ld differs\n",
+                    __FILE__, __LINE__, blend.mode, blend.alpha_map != NULL ? " (alpha map)" : "", w, h,
+                    (long) s_pos.x, (long) s_pos.y, src->width, src->height, dst->width, dst->height,
+                    (long) d_pos.x, (long) d_pos.y);
+            test_failures++;
+        }
+
+        dy_gfx_free_buf(src);
+        dy_gfx_free_buf(dst);
+        dy_gfx_free_buf(ref);
+    }
+}
+
+// Positions far out of range merge nothing, and must not overflow while being clipped.
+static void test_extremes() {
+    dy_gfx_buf_t *dst = dy_gfx_new_buf(4, 4), *src = dy_gfx_new_buf(4, 4);
+    const dy_gfx_blend_t copy = {.mode = DY_GFX_BLEND_COPY};
+    dy_gfx_fill(src, PIC_PX);
+
+    const dy_gfx_point_t far[] = {
+        {INT32_MIN, 0}, {0, INT32_MIN}, {INT32_MIN, INT32_MIN}, {INT32_MAX, 0}, {0, INT32_MAX},
+        {INT32_MIN + 1, INT32_MAX},
+    };
+    for (size_t i = 0; i < sizeof(far) / sizeof(far[0]); i++) {
+        for (size_t j = 0; j < sizeof(far) / sizeof(far[0]); j++) {
+            dy_gfx_area_t area = {far[j].x, far[j].y, UINT16_MAX, UINT16_MAX};
+            CHECK_INT(dy_gfx_merge_area(dst, src, far[i], area, &copy), DY_OK);
+            CHECK_INT(dy_gfx_merge_area(dst, src, (dy_gfx_point_t) {0, 0}, area, &copy), DY_OK);
+            CHECK_INT(dy_gfx_merge_area(dst, src, far[i], (dy_gfx_area_t) {0, 0, 4, 4}, &copy), DY_OK);
+        }
+        if (far[i].x < 0 && far[i].y < 0) {
+            CHECK_INT(dy_gfx_merge_blend(dst, src, far[i], (dy_gfx_point_t) {0, 0}, &copy), DY_OK);
+            CHECK_INT(dy_gfx_merge_blend(dst, src, (dy_gfx_point_t) {0, 0}, far[i], &copy), DY_OK);
+        }
+    }
+    CHECK_PICTURE(dst, "....", "....", "....", "....");
+
+    // Both positions equally far out line up again, since a merge reaches to the end of the source
+    CHECK_INT(dy_gfx_merge_blend(dst, src, (dy_gfx_point_t) {INT32_MIN, -1}, (dy_gfx_point_t) {INT32_MIN, -2}, &copy),
+              DY_OK);
+    CHECK_PICTURE(dst, "....", "####", "####", "####");
+
+    dy_gfx_free_buf(dst);
+    dy_gfx_free_buf(src);
+}
+
+int main() {
+    TEST_RUN(test_modes);
+    TEST_RUN(test_edges);
+    TEST_RUN(test_random);
+    TEST_RUN(test_extremes);
+    TEST_EXIT();
+}
@@ -0,0 +1,324 @@
+#include "dy/gfx/gfx.h"
+#include "dy/gfx/damage.h"
+#include "dy/gfx/compositor.h"
+#include "picture.h"
+
+static bool area_eq(dy_gfx_area_t a, dy_gfx_area_t b) {
+    return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+}
+
+static bool area_contains(dy_gfx_area_t a, int32_t x, int32_t y) {
+    return x >= a.x && y >= a.y && x < a.x + a.width && y < a.y + a.height;
+}
+
+static bool damage_contains(const dy_gfx_damage_t *dmg, int32_t x, int32_t y) {
+    for (uint8_t i = 0; i < dmg->len; i++) {
+        if (area_contains(dmg->areas[i], x, y)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#define CHECK_AREA(actual, ...) do { \
+    dy_gfx_area_t a_ = (actual), e_ = (dy_gfx_area_t) {__VA_ARGS__}; \
+    if (!area_eq(a_, e_)) { \
+        fprintf(stderr, "%s:%d: %s is %ld,%ld %ux%u, expected %ld,%ld %ux%u\n", __FILE__, __LINE__, #actual, \
+                (long) a_.x, (long) a_.y, a_.width, a_.height, (long) e_.x, (long) e_.y, e_.width, e_.height); \
+        test_failures++; \
+    } \
+} while (0)
+
+static void test_area_ops() {
+    dy_gfx_area_t a = {0, 0, 4, 3}, b = {2, 1, 4, 4};
+
+    CHECK_AREA(dy_gfx_area_intersect(a, b), 2, 1, 2, 2);
+    CHECK_AREA(dy_gfx_area_union(a, b), 0, 0, 6, 5);
+    CHECK_INT(dy_gfx_area_intersect(a, (dy_gfx_area_t) {4, 0, 2, 2}).width, 0); // adjacent ones don't intersect
+    CHECK_INT(dy_gfx_area_intersect(a, (dy_gfx_area_t) {-5, -5, 2, 2}).height, 0);
+    CHECK_AREA(dy_gfx_area_intersect((dy_gfx_area_t) {-3, -2, 5, 5}, a), 0, 0, 2, 3);
+}
+
+static void test_coalesce() {
+    dy_gfx_damage_t dmg;
+    dy_gfx_damage_reset(&dmg);
+    CHECK(dy_gfx_damage_is_empty(&dmg));
+
+    // Empty areas are ignored
+    dy_gfx_damage_add(&dmg, (dy_gfx_area_t) {1, 1, 0, 5});
+    CHECK(dy_gfx_damage_is_empty(&dmg));
+
+    // Overlapping ones are merged, and so are adjacent ones
+    dy_gfx_damage_add(&dmg, (dy_gfx_area_t) {0, 0, 2, 2});
+    dy_gfx_damage_add(&dmg, (dy_gfx_area_t) {1, 1, 2, 2});
+    CHECK_INT(dmg.len, 1);
+    CHECK_AREA(dmg.areas[0], 0, 0, 3, 3);
+    dy_gfx_damage_add(&dmg, (dy_gfx_area_t) {3, 0, 1, 1});
+    CHECK_INT(dmg.len, 1);
+    CHECK_AREA(dmg.areas[0], 0, 0, 4, 3);
+
+    // A distant one is kept apart
+    dy_gfx_damage_add(&dmg, (dy_gfx_area_t) {10, 10, 1, 1});
+    CHECK_INT(dmg.len, 2);
+
+    // One bridging both merges them; the union touches the other area only once it has grown
+    dy_gfx_damage_add(&dmg, (dy_gfx_area_t) {4, 3, 6, 7});
+    CHECK_INT(dmg.len, 1);
+    CHECK_AREA(dmg.areas[0], 0, 0, 11, 11);
+
+    // Adding another list works the same way
+    dy_gfx_damage_t other;
+    dy_gfx_damage_reset(&other);
+    dy_gfx_damage_add(&other, (dy_gfx_area_t) {20, 0, 2, 2});
+    dy_gfx_damage_add(&other, (dy_gfx_area_t) {11, 0, 1, 1});
+    dy_gfx_damage_add_all(&dmg, &other);
+    CHECK_INT(dmg.len, 2);
+    CHECK(damage_contains(&dmg, 11, 0) && damage_contains(&dmg, 21, 1));
+}
+
+static void test_overflow() {
+    dy_gfx_damage_t dmg;
+    dy_gfx_damage_reset(&dmg);
+
+    // Single pixels 3 apart along a row, then one more below the first
+    for (int i = 0; i < DY_GFX_DAMAGE_MAX; i++) {
+        dy_gfx_damage_add(&dmg, (dy_gfx_area_t) {i * 3, 0, 1, 1});
+    }
+    CHECK_INT(dmg.len, DY_GFX_DAMAGE_MAX);
+    dy_gfx_damage_add(&dmg, (dy_gfx_area_t) {1, 2, 1, 1});
+
+    // It joins the pixel whose bounding box grows the least, then the list has room again
+    CHECK_INT(dmg.len, DY_GFX_DAMAGE_MAX);
+    bool found = false;
+    for (uint8_t i = 0; i < dmg.len; i++) {
+        found |= area_eq(dmg.areas[i], (dy_gfx_area_t) {0, 0, 2, 3});
+    }
+    CHECK(found);
+
+    // A grown bounding box which touches others is coalesced with them too
+    dy_gfx_damage_reset(&dmg);
+    dy_gfx_damage_add(&dmg, (dy_gfx_area_t) {0, 0, 1, 1});
+    dy_gfx_damage_add(&dmg, (dy_gfx_area_t) {2, 0, 1, 1});
+    for (int i = 2; i < DY_GFX_DAMAGE_MAX; i++) {
+        dy_gfx_damage_add(&dmg, (dy_gfx_area_t) {i * 3, 0, 1, 1});
+    }
+    dy_gfx_damage_add(&dmg, (dy_gfx_area_t) {1, 3, 1, 1});
+    CHECK_INT(dmg.len, DY_GFX_DAMAGE_MAX - 1);
+    CHECK(damage_contains(&dmg, 0, 0) && damage_contains(&dmg, 2, 3) && !damage_contains(&dmg, 3, 0));
+
+    // Whatever gets merged, every damaged pixel stays covered and no two areas touch
+    for (int round = 0; round < 2000; round++) {
+        dy_gfx_area_t added[40];
+        int n = 1 + test_rand() % 40;
+        dy_gfx_damage_reset(&dmg);
+        for (int i = 0; i < n; i++) {
+            added[i] = (dy_gfx_area_t) {(int32_t) (test_rand() % 64) - 8, (int32_t) (test_rand() % 32) - 8,
+                                        test_rand() % 5, test_rand() % 5};
+            dy_gfx_damage_add(&dmg, added[i]);
+        }
+
+        CHECK(dmg.len <= DY_GFX_DAMAGE_MAX);
+        for (int i = 0; i < n; i++) {
+            for (int32_t y = added[i].y; y < added[i].y + added[i].height; y++) {
+                for (int32_t x = added[i].x; x < added[i].x + added[i].width; x++) {
+                    if (!damage_contains(&dmg, x, y)) {
+                        fprintf(stderr, "%s:%d: round %d: %ld,%ld is not covered\n", __FILE__, __LINE__, round,
+                                (long) x, (long) y);
+                        test_failures++;
+                    }
+                }
+            }
+        }
+        for (uint8_t i = 0; i < dmg.len; i++) {
+            CHECK(dmg.areas[i].width > 0 && dmg.areas[i].height > 0);
+            for (uint8_t j = i + 1; j < dmg.len; j++) {
+                dy_gfx_area_t a = dmg.areas[i], b = dmg.areas[j];
+                CHECK(a.x > b.x + b.width || b.x > a.x + a.width || a.y > b.y + b.height || b.y > a.y + a.height);
+            }
+        }
+    }
+}
+
+#define RED dy_gfx_new_px(255, 0, 0)
+#define BLUE dy_gfx_new_px(0, 0, 255)
+
+static int n_renders;
+
+static void render_white(void *args, dy_gfx_buf_t *buf) {
+    n_renders++;
+    dy_gfx_fill(buf, PIC_PX);
+}
+
+static void test_z_order() {
+    dy_gfx_comp_t *comp = dy_gfx_comp_new(6, 2);
+    dy_gfx_buf_t *red = dy_gfx_new_buf(3, 2), *blue = dy_gfx_new_buf(3, 2);
+    dy_gfx_fill(red, RED);
+    dy_gfx_fill(blue, BLUE);
+
+    // Added out of z-order, rendered bottom first
+    dy_gfx_layer_t *top = dy_gfx_comp_add_buf_layer(comp, blue, (dy_gfx_point_t) {2, 0}, 5);
+    dy_gfx_layer_t *bottom = dy_gfx_comp_add_buf_layer(comp, red, (dy_gfx_point_t) {1, 0}, -1);
+    dy_gfx_damage_t dmg;
+    dy_gfx_buf_t *out = dy_gfx_comp_render(comp, &dmg);
+    CHECK_INT(dmg.len, 1);
+    CHECK_AREA(dmg.areas[0], 0, 0, 6, 2);
+    CHECK(px_eq(dy_gfx_get_px(out, 0, 0), (dy_gfx_px_t) {0}));
+    CHECK(px_eq(dy_gfx_get_px(out, 1, 0), RED));
+    CHECK(px_eq(dy_gfx_get_px(out, 2, 0), BLUE));
+    CHECK(px_eq(dy_gfx_get_px(out, 4, 1), BLUE));
+    CHECK(px_eq(dy_gfx_get_px(out, 5, 1), (dy_gfx_px_t) {0}));
+
+    // Nothing changed, nothing to do
+    dy_gfx_comp_render(comp, &dmg);
+    CHECK(dy_gfx_damage_is_empty(&dmg));
+
+    // Raising the bottom layer damages just its area, where it now covers the other one
+    dy_gfx_layer_set_z(bottom, 6);
+    CHECK_INT(comp->layers[1] == bottom, 1);
+    dy_gfx_comp_render(comp, &dmg);
+    CHECK_INT(dmg.len, 1);
+    CHECK_AREA(dmg.areas[0], 1, 0, 3, 2);
+    CHECK(px_eq(dy_gfx_get_px(out, 2, 1), RED));
+    CHECK(px_eq(dy_gfx_get_px(out, 3, 1), RED));
+    CHECK(px_eq(dy_gfx_get_px(out, 4, 1), BLUE));
+
+    // A layer set to an existing z goes above those already there
+    dy_gfx_layer_set_z(top, 6);
+    CHECK_INT(comp->layers[1] == top, 1);
+    dy_gfx_comp_render(comp, &dmg);
+    CHECK(px_eq(dy_gfx_get_px(out, 2, 1), BLUE));
+
+    // A hidden layer doesn't damage anything by changing its z
+    dy_gfx_layer_set_visible(top, false);
+    dy_gfx_comp_render(comp, &dmg);
+    dy_gfx_layer_set_z(top, -3);
+    CHECK(dy_gfx_damage_is_empty(&comp->damage));
+
+    dy_gfx_comp_free(comp);
+    dy_gfx_free_buf(red);
+    dy_gfx_free_buf(blue);
+}
+
+static void test_dirty() {
+    dy_gfx_comp_t *comp = dy_gfx_comp_new(8, 4);
+    n_renders = 0;
+
+    // Partly off the output; its damage is clipped to the output
+    dy_gfx_layer_t *layer = dy_gfx_comp_add_render_layer(comp, 4, 3, (dy_gfx_point_t) {-2, 2}, 0, render_white,
+                                                         NULL);
+    dy_gfx_damage_t dmg;
+    dy_gfx_comp_render(comp, &dmg);
+    CHECK_INT(n_renders, 1);
+    CHECK_PICTURE(comp->out,
+                  "........",
+                  "........",
+                  "##......",
+                  "##......");
+
+    // Only invalidated layers are redrawn
+    dy_gfx_comp_render(comp, &dmg);
+    CHECK_INT(n_renders, 1);
+    dy_gfx_layer_invalidate(layer);
+    dy_gfx_comp_render(comp, &dmg);
+    CHECK_INT(n_renders, 2);
+    CHECK_INT(dmg.len, 1);
+    CHECK_AREA(dmg.areas[0], 0, 2, 2, 2);
+
+    // Moving damages both the old and the new area, each clipped to the output
+    dy_gfx_layer_set_pos(layer, (dy_gfx_point_t) {6, -1});
+    dy_gfx_comp_render(comp, &dmg);
+    CHECK_INT(n_renders, 2);
+    CHECK_INT(dmg.len, 2);
+    CHECK(damage_contains(&dmg, 0, 3) && damage_contains(&dmg, 7, 1) && !damage_contains(&dmg, 4, 0));
+    CHECK_PICTURE(comp->out,
+                  "......##",
+                  "......##",
+                  "........",
+                  "........");
+
+    // An invalidated area is relative to the layer, and clipped to both the layer and the output
+    dy_gfx_layer_invalidate_area(layer, (dy_gfx_area_t) {-1, 0, 2, 9});
+    CHECK_INT(comp->damage.len, 1);
+    CHECK_AREA(comp->damage.areas[0], 6, 0, 1, 2);
+
+    // Off the output entirely, nothing is damaged
+    dy_gfx_comp_render(comp, &dmg);
+    dy_gfx_layer_set_pos(layer, (dy_gfx_point_t) {100, 100});
+    dy_gfx_layer_set_pos(layer, (dy_gfx_point_t) {-100, 0});
+    CHECK_INT(comp->damage.len, 1);
+    CHECK_AREA(comp->damage.areas[0], 6, 0, 2, 2);
+
+    dy_gfx_comp_free(comp);
+}
+
+// Random layer changes: the incremental output always equals a full redraw, and it only changes in reported areas.
+static void test_random() {
+    dy_gfx_comp_t *comp = dy_gfx_comp_new(16, 8);
+    dy_gfx_buf_t *bufs[4];
+    dy_gfx_layer_t *layers[4];
+    for (int i = 0; i < 4; i++) {
+        bufs[i] = dy_gfx_new_buf(1 + test_rand() % 8, 1 + test_rand() % 6);
+        for (uint32_t j = 0; j < bufs[i]->width * bufs[i]->height; j++) {
+            bufs[i]->content[j] = test_rand() % 4 == 0 ? (dy_gfx_px_t) {0} : dy_gfx_new_px(i * 60 + 10, j, 1);
+        }
+        layers[i] = dy_gfx_comp_add_buf_layer(comp, bufs[i], (dy_gfx_point_t) {0, 0}, 0);
+    }
+    dy_gfx_buf_t *prev = dy_gfx_new_buf(16, 8);
+    dy_gfx_comp_render(comp, NULL);
+
+    for (int round = 0; round < 3000; round++) {
+        dy_gfx_layer_t *layer = layers[test_rand() % 4];
+        switch (test_rand() % 4) {
+            case 0:
+                dy_gfx_layer_set_pos(layer, (dy_gfx_point_t) {(int32_t) (test_rand() % 24) - 6,
+                                                              (int32_t) (test_rand() % 14) - 4});
+                break;
+            case 1:
+                dy_gfx_layer_set_z(layer, (int8_t) (test_rand() % 5) - 2);
+                break;
+            case 2:
+                dy_gfx_layer_set_visible(layer, test_rand() % 3 != 0);
+                break;
+            case 3:
+                dy_gfx_layer_set_blend(layer, (dy_gfx_blend_t) {.mode = test_rand() % 5, .alpha = test_rand()});
+                break;
+        }
+
+        memcpy(prev->content, comp->out->content, 16 * 8 * sizeof(dy_gfx_px_t));
+        dy_gfx_damage_t dmg;
+        dy_gfx_buf_t *out = dy_gfx_comp_render(comp, &dmg);
+        for (uint16_t y = 0; y < 8; y++) {
+            for (uint16_t x = 0; x < 16; x++) {
+                if (!px_eq(dy_gfx_get_px(out, x, y), dy_gfx_get_px(prev, x, y)) && !damage_contains(&dmg, x, y)) {
+                    fprintf(stderr, "%s:%d: round %d: %d,%d changed outside of the damage\n", __FILE__, __LINE__,
+                            round, x, y);
+                    test_failures++;
+                }
+            }
+        }
+
+        memcpy(prev->content, out->content, 16 * 8 * sizeof(dy_gfx_px_t));
+        dy_gfx_comp_invalidate(comp);
+        dy_gfx_comp_render(comp, NULL);
+        if (!buf_eq(out, prev)) {
+            fprintf(stderr, "%s:%d: round %d: the output differs from a full redraw\n", __FILE__, __LINE__, round);
+            test_failures++;
+        }
+    }
+
+    dy_gfx_free_buf(prev);
+    dy_gfx_comp_free(comp);
+    for (int i = 0; i < 4; i++) {
+        dy_gfx_free_buf(bufs[i]);
+    }
+}
+
+int main() {
+    TEST_RUN(test_area_ops);
+    TEST_RUN(test_coalesce);
+    TEST_RUN(test_overflow);
+    TEST_RUN(test_z_order);
+    TEST_RUN(test_dirty);
+    TEST_RUN(test_random);
+    TEST_EXIT();
+}
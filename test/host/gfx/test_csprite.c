@@ -0,0 +1,263 @@
+#include <stdlib.h>
+#include "dy/gfx/gfx.h"
+#include "dy/gfx/csprite.h"
+#include "picture.h"
+
+#ifdef TEST_CSPRITE_TOOL
+#include "csprite_packed.h"
+#include "csprite_rle.h"
+#endif
+
+#define MAX_W 40
+#define MAX_H 12
+#define MAX_DATA (MAX_W * MAX_H * 2)
+
+static dy_gfx_px_t palette[256];
+
+// Per-pixel reference of dy_gfx_blit_csprite() over decoded palette indices, written from its documentation.
+static void ref_blit(dy_gfx_buf_t *buf, dy_gfx_point_t pos, const dy_gfx_csprite_t *sp, const uint8_t *indices,
+                     uint8_t flags) {
+    for (int32_t y = 0; y < sp->height; y++) {
+        for (int32_t x = 0; x < sp->width; x++) {
+            int32_t sx = flags & DY_GFX_SPRITE_FLIP_H ? sp->width - 1 - x : x;
+            int32_t sy = flags & DY_GFX_SPRITE_FLIP_V ? sp->height - 1 - y : y;
+            uint8_t idx = indices[sy * sp->width + sx];
+            int32_t bx = pos.x + x, by = pos.y + y;
+            if (idx >= sp->n_colors || ((flags & DY_GFX_SPRITE_KEY) && idx == 0)) {
+                continue;
+            }
+            if (bx >= 0 && by >= 0 && bx < buf->width && by < buf->height) {
+                buf->content[by * buf->width + bx] = sp->palette[idx];
+            }
+        }
+    }
+}
+
+// Encoders of both formats, as described in csprite.h; tokens are chosen randomly to cover every length.
+
+static uint32_t encode_packed(const uint8_t *indices, uint16_t w, uint16_t h, uint8_t bpp, uint8_t *out) {
+    uint32_t len = 0;
+
+    for (uint16_t y = 0; y < h; y++) {
+        for (uint16_t x = 0; x < w; x++) {
+            if (x % (8 / bpp) == 0) {
+                out[len++] = 0;
+            }
+            out[len - 1] |= indices[y * w + x] << (8 - bpp * (x % (8 / bpp) + 1));
+        }
+    }
+
+    return len;
+}
+
+static uint32_t encode_rle(const uint8_t *indices, uint32_t n_px, uint8_t *out) {
+    uint32_t len = 0;
+
+    for (uint32_t i = 0; i < n_px;) {
+        uint32_t n = 1 + test_rand() % (n_px - i < 128 ? n_px - i : 128);
+        uint32_t run = 1;
+        while (run < n && indices[i + run] == indices[i]) {
+            run++;
+        }
+
+        if (run == n && test_rand() % 4 != 0) {
+            out[len++] = n - 1;
+            out[len++] = indices[i];
+        } else {
+            out[len++] = 0x80 | (n - 1);
+            memcpy(out + len, indices + i, n);
+            len += n;
+        }
+        i += n;
+    }
+
+    return len;
+}
+
+// Makes random indices in runs, so RLE runs occur and continue across rows.
+static void make_indices(uint8_t *indices, uint32_t n_px, uint16_t n_values) {
+    for (uint32_t i = 0; i < n_px;) {
+        uint8_t idx = test_rand() % n_values;
+        for (uint32_t n = 1 + test_rand() % 20; n > 0 && i < n_px; n--) {
+            indices[i++] = idx;
+        }
+    }
+}
+
+static bool check_blit(const dy_gfx_csprite_t *sp, const uint8_t *indices) {
+    dy_gfx_buf_t *buf = dy_gfx_new_buf(1 + test_rand() % 30, 1 + test_rand() % 10);
+    dy_gfx_buf_t *ref = dy_gfx_new_buf(buf->width, buf->height);
+    dy_gfx_point_t pos = {(int32_t) (test_rand() % 50) - 35, (int32_t) (test_rand() % 20) - 11};
+    uint8_t flags = test_rand() % 8;
+
+    dy_gfx_fill(buf, dy_gfx_new_px(9, 9, 9));
+    dy_gfx_fill(ref, dy_gfx_new_px(9, 9, 9));
+
+    dy_err_t err = dy_gfx_blit_csprite(buf, pos, sp, flags);
+    ref_blit(ref, pos, sp, indices, flags);
+
+    bool ok = !dy_is_err(err) && buf_eq(buf, ref);
+    if (!ok) {
+        fprintf(stderr, "%dx%d sprite, encoding %d, bpp %d, at %ld,%ld, flags %d: %s\n", sp->width, sp->height,
+                sp->encoding, sp->bpp, (long) pos.x, (long) pos.y, flags, dy_err_str(err));
+    }
+
+    dy_gfx_free_buf(buf);
+    dy_gfx_free_buf(ref);
+
+    return ok;
+}
+
+// Random images are encoded, then blitted at random positions with random flags and compared with the reference.
+static void test_round_trip() {
+    static const uint8_t bpps[] = {1, 2, 4, 8};
+    uint8_t indices[MAX_W * MAX_H], data[MAX_DATA];
+
+    for (int i = 0; i < 4000; i++) {
+        uint16_t w = 1 + test_rand() % MAX_W, h = 1 + test_rand() % MAX_H;
+        uint8_t bpp = bpps[test_rand() % 4];
+        uint16_t n_colors = 1 + test_rand() % (1 << bpp);
+        bool rle = test_rand() % 2;
+
+        // Indices past the palette are valid input and must not be drawn
+        make_indices(indices, w * h, test_rand() % 8 == 0 ? 1 << bpp : n_colors);
+        uint32_t len = rle ? encode_rle(indices, w * h, data) : encode_packed(indices, w, h, bpp, data);
+
+        const dy_gfx_csprite_t sp = {
+                .width = w,
+                .height = h,
+                .encoding = rle ? DY_GFX_CSPRITE_RLE : DY_GFX_CSPRITE_PACKED,
+                .bpp = rle ? 8 : bpp,
+                .n_colors = n_colors,
+                .palette = palette,
+                .data_len = len,
+                .data = data,
+        };
+        if (!check_blit(&sp, indices)) {
+            test_failures++;
+        }
+    }
+}
+
+static void test_malformed() {
+    static const uint8_t data[] = {0x80, 1, 0x05, 2};
+    dy_gfx_buf_t *buf = dy_gfx_new_buf(4, 4);
+
+    // The run of 6 exceeds the 3 pixels left after the literal
+    dy_gfx_csprite_t short_sp = {.width = 4, .height = 1, .encoding = DY_GFX_CSPRITE_RLE, .bpp = 8, .n_colors = 4,
+                                 .palette = palette, .data_len = sizeof(data), .data = data};
+    CHECK_INT(dy_gfx_blit_csprite(buf, (dy_gfx_point_t) {0, 0}, &short_sp, 0)->code, DY_ERR_INVALID_ARG);
+
+    // Data ends after 7 of 16 pixels
+    dy_gfx_csprite_t long_sp = {.width = 4, .height = 4, .encoding = DY_GFX_CSPRITE_RLE, .bpp = 8, .n_colors = 4,
+                                .palette = palette, .data_len = sizeof(data), .data = data};
+    CHECK_INT(dy_gfx_blit_csprite(buf, (dy_gfx_point_t) {0, 0}, &long_sp, 0)->code, DY_ERR_INVALID_ARG);
+
+    // Packed rows are 1 byte at 2 bpp, so 4 rows don't fit in 4 bytes less one
+    dy_gfx_csprite_t packed = {.width = 4, .height = 4, .encoding = DY_GFX_CSPRITE_PACKED, .bpp = 2, .n_colors = 4,
+                               .palette = palette, .data_len = sizeof(data) - 1, .data = data};
+    CHECK_INT(dy_gfx_blit_csprite(buf, (dy_gfx_point_t) {0, 0}, &packed, 0)->code, DY_ERR_INVALID_ARG);
+
+    dy_gfx_csprite_t bad_bpp = {.width = 4, .height = 1, .encoding = DY_GFX_CSPRITE_PACKED, .bpp = 3, .n_colors = 4,
+                                .palette = palette, .data_len = sizeof(data), .data = data};
+    CHECK_INT(dy_gfx_blit_csprite(buf, (dy_gfx_point_t) {0, 0}, &bad_bpp, 0)->code, DY_ERR_INVALID_ARG);
+
+    dy_gfx_csprite_t bad_enc = {.width = 4, .height = 1, .encoding = 7, .bpp = 8, .n_colors = 4,
+                                .palette = palette, .data_len = sizeof(data), .data = data};
+    CHECK_INT(dy_gfx_blit_csprite(buf, (dy_gfx_point_t) {0, 0}, &bad_enc, 0)->code, DY_ERR_INVALID_ARG);
+
+    // Invisible sprites are not decoded, so they are not validated either
+    CHECK(!dy_is_err(dy_gfx_blit_csprite(buf, (dy_gfx_point_t) {4, 0}, &bad_enc, 0)));
+
+    dy_gfx_free_buf(buf);
+}
+
+// Random bytes are decoded as sprites; under the sanitizers this checks that nothing is read or written out of bounds.
+static void test_fuzz() {
+    for (int i = 0; i < 20000; i++) {
+        uint32_t len = test_rand() % 64;
+        uint8_t *data = malloc(len); // exact size, so ASan catches reads past the end
+        for (uint32_t j = 0; j < len; j++) {
+            data[j] = test_rand();
+        }
+
+        const dy_gfx_csprite_t sp = {
+                .width = 1 + test_rand() % 24,
+                .height = 1 + test_rand() % 8,
+                .encoding = test_rand() % 3,
+                .bpp = test_rand() % 10,
+                .n_colors = test_rand() % 300,
+                .palette = palette,
+                .data_len = len,
+                .data = data,
+        };
+        dy_gfx_buf_t *buf = dy_gfx_new_buf(1 + test_rand() % 16, 1 + test_rand() % 8);
+        dy_gfx_point_t pos = {(int32_t) (test_rand() % 40) - 20, (int32_t) (test_rand() % 16) - 8};
+
+        dy_err_t err = dy_gfx_blit_csprite(buf, pos, &sp, test_rand() % 8);
+        CHECK(err->code == DY_OK || err->code == DY_ERR_INVALID_ARG);
+
+        dy_gfx_free_buf(buf);
+        free(data);
+    }
+}
+
+#ifdef TEST_CSPRITE_TOOL
+
+// Reads a binary PPM as written for the tests: a comment line after the magic and no other comments.
+static dy_gfx_buf_t *read_ppm(const char *path) {
+    FILE *f = fopen(path, "rb");
+    unsigned w, h, max;
+    dy_gfx_buf_t *buf = NULL;
+
+    if (f != NULL && fscanf(f, "P6\n#%*[^\n]\n%u %u\n%u", &w, &h, &max) == 3 && fgetc(f) == '\n') {
+        buf = dy_gfx_new_buf(w, h);
+        if (fread(buf->content, sizeof(dy_gfx_px_t), w * h, f) != w * h) {
+            dy_gfx_free_buf(buf);
+            buf = NULL;
+        }
+    }
+    if (f != NULL) {
+        fclose(f);
+    }
+
+    return buf;
+}
+
+// Headers made by tools/csprite.py from the same image must draw it back exactly.
+static void test_tool() {
+    dy_gfx_buf_t *img = read_ppm("gfx/data/csprite.ppm");
+    CHECK(img != NULL);
+    if (img == NULL) {
+        return;
+    }
+
+    const dy_gfx_csprite_t *sprites[] = {&img_packed, &img_rle};
+    for (int i = 0; i < 2; i++) {
+        dy_gfx_buf_t *buf = dy_gfx_new_buf(img->width, img->height);
+        CHECK(!dy_is_err(dy_gfx_blit_csprite(buf, (dy_gfx_point_t) {0, 0}, sprites[i], 0)));
+        CHECK(buf_eq(buf, img));
+        dy_gfx_free_buf(buf);
+    }
+    CHECK_INT(img_packed.encoding, DY_GFX_CSPRITE_PACKED);
+    CHECK_INT(img_packed.bpp, 4);
+    CHECK_INT(img_rle.encoding, DY_GFX_CSPRITE_RLE);
+
+    dy_gfx_free_buf(img);
+}
+
+#endif
+
+int main() {
+    for (int i = 0; i < 256; i++) {
+        palette[i] = dy_gfx_new_px(i, 255 - i, i * 7);
+    }
+
+    TEST_RUN(test_round_trip);
+    TEST_RUN(test_malformed);
+    TEST_RUN(test_fuzz);
+#ifdef TEST_CSPRITE_TOOL
+    TEST_RUN(test_tool);
+#endif
+    TEST_EXIT();
+}
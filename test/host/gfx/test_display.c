@@ -0,0 +1,45 @@
+#include "dy/gfx/gfx.h"
+#include "dy/gfx/geometry.h"
+#include "dy/display.h"
+#include "dy/display_driver_vfb.h"
+#include "gfx/picture.h"
+
+#define ID 0
+
+static void test_flush_writes_reported_damage_only() {
+    dy_gfx_buf_t *buf = dy_gfx_new_buf(8, 4);
+    CHECK(!dy_is_err(dy_display_driver_vfb_init(ID, 8, 4, NULL)));
+    CHECK(!dy_is_err(dy_display_set_brightness(ID, DY_DISPLAY_BRI_MAX)));
+
+    // The first flush writes the whole buffer
+    dy_gfx_fill_rect(buf, (dy_gfx_point_t) {0, 0}, (dy_gfx_point_t) {1, 3}, PIC_PX);
+    CHECK(!dy_is_err(dy_display_flush(ID, buf)));
+    CHECK(buf_eq(dy_display_driver_vfb_get_frame(ID), buf));
+    CHECK_INT(dy_display_driver_vfb_get_stats(ID).n_writes, 1);
+
+    // Drawing reports no damage by itself: only the reported rectangle reaches the display
+    dy_gfx_fill_rect(buf, (dy_gfx_point_t) {3, 0}, (dy_gfx_point_t) {4, 1}, PIC_PX);
+    dy_gfx_fill_rect(buf, (dy_gfx_point_t) {6, 2}, (dy_gfx_point_t) {7, 3}, PIC_PX);
+    CHECK(!dy_is_err(dy_display_damage(ID, (dy_gfx_area_t) {3, 0, 2, 2})));
+    CHECK(!dy_is_err(dy_display_flush(ID, buf)));
+    CHECK_PICTURE(dy_display_driver_vfb_get_frame(ID),
+                  "##.##...",
+                  "##.##...",
+                  "##......",
+                  "##......");
+    CHECK_INT(dy_display_driver_vfb_get_stats(ID).n_region_writes, 1);
+
+    // Damage is reset by the flush
+    dy_gfx_damage_t dmg = {0};
+    dy_gfx_damage_add(&dmg, (dy_gfx_area_t) {6, 2, 2, 2});
+    CHECK(!dy_is_err(dy_display_damage_list(ID, &dmg)));
+    CHECK(!dy_is_err(dy_display_flush(ID, buf)));
+    CHECK(buf_eq(dy_display_driver_vfb_get_frame(ID), buf));
+
+    dy_gfx_free_buf(buf);
+}
+
+int main() {
+    TEST_RUN(test_flush_writes_reported_damage_only);
+    TEST_EXIT();
+}
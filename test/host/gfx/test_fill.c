@@ -0,0 +1,147 @@
+#include <string.h>
+#include "dy/gfx/gfx.h"
+#include "test.h"
+
+// Pixel runs are placed at every offset from a word boundary, so the word loops get all possible heads and tails
+#define MAX_PX 67
+#define GUARD 8
+#define GUARD_BYTE 0x5A
+#define N_LEVELS 6
+
+static const uint8_t levels[N_LEVELS] = {0, 1, 127, 128, 254, 255};
+
+typedef struct {
+    _Alignas(4) uint8_t mem[GUARD + MAX_PX * 3 + GUARD];
+    dy_gfx_buf_t buf;
+} area_t;
+
+// Makes a 1-row buffer of n random pixels starting `off` bytes after a word boundary, surrounded by guard bytes.
+static void make_area(area_t *a, uint8_t off, uint16_t n) {
+    memset(a->mem, GUARD_BYTE, sizeof(a->mem));
+    a->buf = (dy_gfx_buf_t) {.width = n, .height = 1, .content = (dy_gfx_px_t *) (a->mem + GUARD + off)};
+
+    uint8_t *p = (uint8_t *) a->buf.content;
+    for (uint32_t i = 0; i < n * 3u; i++) {
+        // Mostly extremes and threshold neighbours, which is where lane arithmetic goes wrong
+        uint32_t r = test_rand();
+        p[i] = r & 1 ? levels[(r >> 1) % N_LEVELS] : (uint8_t) (r >> 8);
+    }
+
+    // Runs of black pixels, as on mostly black screens
+    for (uint16_t i = 0; i < n; i += 1 + test_rand() % 8) {
+        if (test_rand() % 2 == 0) {
+            uint16_t len = test_rand() % 12;
+            memset(p + i * 3, 0, (n - i < len ? n - i : len) * 3u);
+        }
+    }
+}
+
+static bool areas_eq(const area_t *a, const area_t *b) {
+    return memcmp(a->mem, b->mem, sizeof(a->mem)) == 0;
+}
+
+// Scalar references, written from the API documentation.
+
+static void ref_fill(dy_gfx_buf_t *buf, dy_gfx_px_t px) {
+    for (uint32_t i = 0; i < buf->width; i++) {
+        buf->content[i] = px;
+    }
+}
+
+static void ref_colorize(dy_gfx_buf_t *buf, dy_gfx_px_t px) {
+    for (uint32_t i = 0; i < buf->width; i++) {
+        dy_gfx_px_t *p = &buf->content[i];
+        if (p->r != 0 || p->g != 0 || p->b != 0) {
+            *p = px;
+        }
+    }
+}
+
+static void ref_invert(dy_gfx_buf_t *buf) {
+    for (uint32_t i = 0; i < buf->width; i++) {
+        dy_gfx_px_t *p = &buf->content[i];
+        *p = (dy_gfx_px_t) {255 - p->r, 255 - p->g, 255 - p->b};
+    }
+}
+
+static void ref_threshold(dy_gfx_buf_t *buf, uint8_t level) {
+    for (uint32_t i = 0; i < buf->width; i++) {
+        dy_gfx_px_t *p = &buf->content[i];
+        uint8_t max = p->r > p->g ? p->r : p->g;
+        max = max > p->b ? max : p->b;
+        if (max < level) {
+            *p = (dy_gfx_px_t) {0, 0, 0};
+        }
+    }
+}
+
+static void ref_scale(dy_gfx_buf_t *buf, uint8_t scale) {
+    for (uint32_t i = 0; i < buf->width; i++) {
+        dy_gfx_px_t *p = &buf->content[i];
+        p->r = p->r * (scale + 1) / 256;
+        p->g = p->g * (scale + 1) / 256;
+        p->b = p->b * (scale + 1) / 256;
+    }
+}
+
+// Runs an operation and its reference on the same random content for every offset and length.
+#define CHECK_EQUIVALENT(op, ref, ...) do { \
+    for (uint8_t off_ = 0; off_ < 4; off_++) { \
+        for (uint16_t n_ = 0; n_ <= MAX_PX; n_++) { \
+            area_t a_, b_; \
+            uint32_t seed_ = test_rand(); \
+            test_rand_state = seed_; \
+            make_area(&a_, off_, n_); \
+            test_rand_state = seed_; \
+            make_area(&b_, off_, n_); \
+            op(&a_.buf, ##__VA_ARGS__); \
+            ref(&b_.buf, ##__VA_ARGS__); \
+            if (!areas_eq(&a_, &b_)) { \
+                fprintf(stderr, "%s:%d: %s differs at offset %d, %d px\n", __FILE__, __LINE__, #op, off_, n_); \
+                test_failures++; \
+            } \
+        } \
+    } \
+} while (0)
+
+static void test_fill() {
+    for (int i = 0; i < 20; i++) {
+        uint32_t r = test_rand();
+        dy_gfx_px_t px = {r, r >> 8, r >> 16};
+        CHECK_EQUIVALENT(dy_gfx_fill, ref_fill, px);
+    }
+
+    // Gray takes the memset path
+    CHECK_EQUIVALENT(dy_gfx_fill, ref_fill, ((dy_gfx_px_t) {7, 7, 7}));
+}
+
+static void test_colorize() {
+    CHECK_EQUIVALENT(dy_gfx_colorize, ref_colorize, ((dy_gfx_px_t) {1, 2, 3}));
+    CHECK_EQUIVALENT(dy_gfx_colorize, ref_colorize, ((dy_gfx_px_t) {0, 0, 0}));
+}
+
+static void test_invert() {
+    CHECK_EQUIVALENT(dy_gfx_invert, ref_invert);
+}
+
+static void test_threshold() {
+    for (int i = 0; i < N_LEVELS; i++) {
+        CHECK_EQUIVALENT(dy_gfx_threshold, ref_threshold, levels[i]);
+        CHECK_EQUIVALENT(dy_gfx_threshold, ref_threshold, (uint8_t) (levels[i] + 1));
+    }
+}
+
+static void test_scale() {
+    for (int scale = 0; scale < 256; scale++) {
+        CHECK_EQUIVALENT(dy_gfx_scale, ref_scale, scale);
+    }
+}
+
+int main() {
+    TEST_RUN(test_fill);
+    TEST_RUN(test_colorize);
+    TEST_RUN(test_invert);
+    TEST_RUN(test_threshold);
+    TEST_RUN(test_scale);
+    TEST_EXIT();
+}
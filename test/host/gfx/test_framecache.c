@@ -0,0 +1,98 @@
+#include "dy/gfx/gfx.h"
+#include "dy/gfx/framecache.h"
+#include "dy/gfx/sprite.h"
+#include "gfx/picture.h"
+
+typedef struct {
+    uint32_t calls;
+    uint8_t n_colors; // colours of rendered frames, up to 256 plus black
+} render_args_t;
+
+// Renders a pattern which depends on the frame number, using up to `n_colors` colours.
+static void render(void *args, dy_gfx_buf_t *buf, uint32_t frame_n) {
+    render_args_t *a = args;
+    a->calls++;
+
+    for (uint32_t i = 0; i < (uint32_t) buf->width * buf->height; i++) {
+        uint32_t c = (i * 7 + frame_n) % a->n_colors;
+        buf->content[i] = c == 0 ? (dy_gfx_px_t) {0} : dy_gfx_new_px(c, 255 - c, frame_n);
+    }
+}
+
+static void test_cached_frames_match_rendered() {
+    uint8_t n_colors[] = {2, 3, 5, 17};
+
+    for (uint8_t i = 0; i < sizeof(n_colors); i++) {
+        render_args_t args = {.n_colors = n_colors[i]};
+        dy_gfx_fcache_t *cache = dy_gfx_fcache_new(64 * 1024);
+        dy_gfx_buf_t *buf = dy_gfx_new_buf(13, 7), *ref = dy_gfx_new_buf(13, 7);
+
+        for (uint32_t frame = 0; frame < 4; frame++) {
+            render(&args, ref, frame);
+            for (int pass = 0; pass < 2; pass++) {
+                dy_gfx_clear_buf(buf);
+                CHECK(!dy_is_err(dy_gfx_fcache_draw(cache, buf, (dy_gfx_point_t) {0, 0}, 1, frame, 13, 7, render,
+                                                    &args, 0)));
+                CHECK(buf_eq(buf, ref));
+            }
+        }
+
+        dy_gfx_fcache_stats_t st = dy_gfx_fcache_stats(cache);
+        CHECK_INT(st.misses, 4);
+        CHECK_INT(st.hits, 4);
+        CHECK_INT(st.n_frames, 4);
+        CHECK_INT(args.calls, 4 + 4); // the reference renders as well
+
+        dy_gfx_fcache_free(cache);
+        dy_gfx_free_buf(buf);
+        dy_gfx_free_buf(ref);
+    }
+}
+
+static void test_eviction() {
+    render_args_t args = {.n_colors = 2};
+    dy_gfx_fcache_t *cache = dy_gfx_fcache_new(256);
+    dy_gfx_buf_t *buf = dy_gfx_new_buf(16, 16);
+
+    for (uint32_t frame = 0; frame < 16; frame++) {
+        CHECK(!dy_is_err(dy_gfx_fcache_draw(cache, buf, (dy_gfx_point_t) {0, 0}, 1, frame, 16, 16, render, &args,
+                                            0)));
+    }
+
+    dy_gfx_fcache_stats_t st = dy_gfx_fcache_stats(cache);
+    CHECK(st.used <= st.capacity);
+    CHECK(st.evictions > 0);
+    CHECK_INT(st.n_frames + st.evictions, 16);
+
+    dy_gfx_fcache_drop(cache, 1);
+    st = dy_gfx_fcache_stats(cache);
+    CHECK_INT(st.n_frames, 0);
+    CHECK_INT(st.used, 0);
+
+    dy_gfx_fcache_free(cache);
+    dy_gfx_free_buf(buf);
+}
+
+// Frames with no pixels have nothing to encode; the palette used to be built from a pixel past the buffer
+static void test_empty_frame() {
+    render_args_t args = {.n_colors = 2};
+    dy_gfx_fcache_t *cache = dy_gfx_fcache_new(1024);
+    dy_gfx_buf_t *buf = dy_gfx_new_buf(4, 4);
+
+    CHECK(!dy_is_err(dy_gfx_fcache_draw(cache, buf, (dy_gfx_point_t) {0, 0}, 1, 0, 0, 5, render, &args, 0)));
+    CHECK(!dy_is_err(dy_gfx_fcache_draw(cache, buf, (dy_gfx_point_t) {0, 0}, 1, 1, 5, 0, render, &args, 0)));
+
+    dy_gfx_fcache_stats_t st = dy_gfx_fcache_stats(cache);
+    CHECK_INT(st.n_frames, 0);
+    CHECK_INT(st.n_skipped, 2);
+
+    dy_gfx_fcache_free(cache);
+    dy_gfx_free_buf(buf);
+}
+
+int main() {
+    TEST_RUN(test_cached_frames_match_rendered);
+    TEST_RUN(test_eviction);
+    TEST_RUN(test_empty_frame);
+    TEST_EXIT();
+}
@@ -0,0 +1,336 @@
+#include <stdlib.h>
+#include "dy/gfx/gfx.h"
+#include "dy/gfx/geometry.h"
+#include "gfx/picture.h"
+
+#define P(x, y) ((dy_gfx_point_t) {(x), (y)})
+
+// Reference line: q(k) of the major axis is evaluated for every pixel of the buffer along it, in 128 bits, so any
+// coordinates are handled without clipping.
+static void ref_line(dy_gfx_buf_t *buf, int32_t x1, int32_t y1, int32_t x2, int32_t y2) {
+    __int128 dx = llabs((long long) x2 - x1), dy = llabs((long long) y2 - y1);
+    bool x_major = dx >= dy;
+    __int128 da = x_major ? dx : dy, db = x_major ? dy : dx;
+    int32_t a0 = x_major ? x1 : y1, b0 = x_major ? y1 : x1;
+    int32_t sa = (x_major ? x2 > x1 : y2 > y1) ? 1 : -1, sb = (x_major ? y2 > y1 : x2 > x1) ? 1 : -1;
+    int32_t a_len = x_major ? buf->width : buf->height, b_len = x_major ? buf->height : buf->width;
+
+    for (int32_t a = 0; a < a_len; a++) {
+        __int128 k = ((__int128) a - a0) * sa;
+        if (k < 0 || k > da) {
+            continue;
+        }
+        __int128 b = b0 + sb * (da == 0 ? 0 : (2 * k * db + da) / (2 * da));
+        if (b >= 0 && b < b_len) {
+            dy_gfx_set_px(buf, x_major ? a : b, x_major ? b : a, PIC_PX);
+        }
+    }
+}
+
+// Reference polygon fill: even-odd spans between edge crossings rounded to the nearest pixel, evaluated in 128 bits,
+// plus the outline.
+static void ref_fill_poly(dy_gfx_buf_t *buf, const dy_gfx_point_t *pts, uint8_t n) {
+    for (int32_t y = 0; y < buf->height; y++) {
+        __int128 xs[n];
+        uint8_t n_xs = 0;
+
+        for (uint8_t i = 0; i < n; i++) {
+            dy_gfx_point_t a = pts[i], b = pts[(i + 1) % n];
+            if (!((a.y <= y && y < b.y) || (b.y <= y && y < a.y))) {
+                continue;
+            }
+            if (a.y > b.y) {
+                dy_gfx_point_t t = a;
+                a = b;
+                b = t;
+            }
+            __int128 num = 2 * ((__int128) y - a.y) * ((__int128) b.x - a.x) + ((__int128) b.y - a.y);
+            __int128 den = 2 * ((__int128) b.y - a.y);
+            __int128 q = num / den - (num % den != 0 && num < 0);
+            xs[n_xs++] = a.x + q;
+        }
+
+        for (uint8_t i = 1; i < n_xs; i++) {
+            for (uint8_t k = i; k > 0 && xs[k - 1] > xs[k]; k--) {
+                __int128 t = xs[k];
+                xs[k] = xs[k - 1];
+                xs[k - 1] = t;
+            }
+        }
+
+        for (uint8_t i = 0; i + 1 < n_xs; i += 2) {
+            for (__int128 x = xs[i] < 0 ? 0 : xs[i]; x <= xs[i + 1] && x < buf->width; x++) {
+                dy_gfx_set_px(buf, x, y, PIC_PX);
+            }
+        }
+    }
+
+    for (uint8_t i = 0; i < n; i++) {
+        ref_line(buf, pts[i].x, pts[i].y, pts[(i + 1) % n].x, pts[(i + 1) % n].y);
+    }
+}
+
+static int32_t rand_coord(int32_t size) {
+    switch (test_rand() % 4) {
+        case 0:
+            return (int32_t) test_rand(); // anywhere in the coordinate range
+        case 1:
+            return test_rand() % 2 ? INT32_MIN + (int32_t) (test_rand() % 4) : INT32_MAX - (int32_t) (test_rand() % 4);
+        default:
+            return (int32_t) (test_rand() % (3 * size)) - size; // around the buffer
+    }
+}
+
+static void test_line() {
+    dy_gfx_buf_t *buf = dy_gfx_new_buf(10, 6);
+
+    dy_gfx_line(buf, &(dy_gfx_line_t) {P(0, 0), P(9, 3)}, PIC_PX);
+    dy_gfx_line(buf, &(dy_gfx_line_t) {P(9, 5), P(6, 0)}, PIC_PX);
+    dy_gfx_line(buf, &(dy_gfx_line_t) {P(0, 5), P(4, 1)}, PIC_PX);
+    CHECK_PICTURE(buf,
+                  "##....#...",
+                  "..###..#..",
+                  "...#.###..",
+                  "..#.....##",
+                  ".#......#.",
+                  "#........#");
+
+    // Ends outside of the buffer
+    dy_gfx_clear_buf(buf);
+    dy_gfx_line(buf, &(dy_gfx_line_t) {P(-4, -2), P(14, 7)}, PIC_PX);
+    dy_gfx_line(buf, &(dy_gfx_line_t) {P(-3, 9), P(3, -9)}, PIC_PX);
+    CHECK_PICTURE(buf,
+                  "#.........",
+                  "###.......",
+                  "...##.....",
+                  ".....##...",
+                  ".......##.",
+                  ".........#");
+
+    dy_gfx_free_buf(buf);
+}
+
+// Lines with random ends, including ones at the limits of the coordinate range, where 2 * da * q overflowed 64 bits.
+static void test_line_ref() {
+    dy_gfx_buf_t *buf = dy_gfx_new_buf(17, 11), *ref = dy_gfx_new_buf(17, 11);
+
+    for (int i = 0; i < 20000; i++) {
+        int32_t x1 = rand_coord(buf->width), y1 = rand_coord(buf->height);
+        int32_t x2 = rand_coord(buf->width), y2 = rand_coord(buf->height);
+
+        dy_gfx_clear_buf(buf);
+        dy_gfx_clear_buf(ref);
+        dy_gfx_line(buf, &(dy_gfx_line_t) {P(x1, y1), P(x2, y2)}, PIC_PX);
+        ref_line(ref, x1, y1, x2, y2);
+
+        if (!buf_eq(buf, ref)) {
+            fprintf(stderr, "line (%ld, %ld)-(%ld, %ld) differs from the reference\n", (long) x1, (long) y1,
+                    (long) x2, (long) y2);
+            test_failures++;
+            break;
+        }
+    }
+
+    dy_gfx_free_buf(buf);
+    dy_gfx_free_buf(ref);
+}
+
+static void test_fill_rect() {
+    dy_gfx_buf_t *buf = dy_gfx_new_buf(8, 5);
+
+    dy_gfx_fill_rect(buf, P(5, 3), P(1, 1), PIC_PX);
+    CHECK_PICTURE(buf,
+                  "........",
+                  ".#####..",
+                  ".#####..",
+                  ".#####..",
+                  "........");
+
+    dy_gfx_clear_buf(buf);
+    dy_gfx_fill_rect(buf, P(INT32_MIN, 3), P(INT32_MAX, INT32_MAX), PIC_PX);
+    CHECK_PICTURE(buf,
+                  "........",
+                  "........",
+                  "........",
+                  "########",
+                  "########");
+
+    dy_gfx_free_buf(buf);
+}
+
+static void test_fill_circle() {
+    dy_gfx_buf_t *buf = dy_gfx_new_buf(15, 7);
+
+    dy_gfx_fill_circle(buf, P(1, 1), 0, PIC_PX);
+    dy_gfx_fill_circle(buf, P(4, 1), 1, PIC_PX);
+    dy_gfx_fill_circle(buf, P(10, 3), 3, PIC_PX);
+    dy_gfx_fill_circle(buf, P(2, 6), 2, PIC_PX);
+    CHECK_PICTURE(buf,
+                  "...###...###...",
+                  ".#.###..#####..",
+                  "...###.#######.",
+                  ".......#######.",
+                  ".###...#######.",
+                  "#####...#####..",
+                  "#####....###...");
+
+    dy_gfx_free_buf(buf);
+}
+
+static void test_fill_poly() {
+    dy_gfx_buf_t *buf = dy_gfx_new_buf(12, 9);
+
+    // Concave
+    dy_gfx_point_t arrow[] = {P(0, 4), P(5, 0), P(5, 2), P(11, 2), P(11, 6), P(5, 6), P(5, 8)};
+    dy_gfx_fill_poly(buf, &(dy_gfx_poly_t) {7, arrow}, PIC_PX);
+    CHECK_PICTURE(buf,
+                  ".....#......",
+                  "....##......",
+                  "..##########",
+                  ".###########",
+                  "############",
+                  ".###########",
+                  "..##########",
+                  "....##......",
+                  ".....#......");
+
+    // Self-intersecting: the even-odd rule leaves the inner pentagon empty
+    dy_gfx_clear_buf(buf);
+    dy_gfx_point_t star[] = {P(6, 0), P(9, 8), P(1, 3), P(11, 3), P(3, 8)};
+    dy_gfx_fill_poly(buf, &(dy_gfx_poly_t) {5, star}, PIC_PX);
+    CHECK_PICTURE(buf,
+                  "......#.....",
+                  "......#.....",
+                  ".....###....",
+                  ".###########",
+                  "..####..###.",
+                  "....##..#...",
+                  "....#####...",
+                  "...###.###..",
+                  "...#.....#..");
+
+    dy_gfx_clear_buf(buf);
+    dy_gfx_fill_tri(buf, P(1, 1), P(10, 4), P(3, 8), PIC_PX);
+    CHECK_PICTURE(buf,
+                  "............",
+                  ".##.........",
+                  ".#####......",
+                  "..#######...",
+                  "..#########.",
+                  "..########..",
+                  "..######....",
+                  "...###......",
+                  "...#........");
+
+    dy_gfx_free_buf(buf);
+}
+
+static void test_fill_poly_props() {
+    dy_gfx_buf_t *buf = dy_gfx_new_buf(16, 12), *ref = dy_gfx_new_buf(16, 12);
+
+    // A rectangle fills the same pixels as dy_gfx_fill_rect()
+    dy_gfx_point_t rect[] = {P(2, 3), P(13, 3), P(13, 9), P(2, 9)};
+    dy_gfx_fill_poly(buf, &(dy_gfx_poly_t) {4, rect}, PIC_PX);
+    dy_gfx_fill_rect(ref, P(2, 3), P(13, 9), PIC_PX);
+    CHECK(buf_eq(buf, ref));
+
+    // The fill covers the outline and doesn't depend on the starting corner
+    for (int i = 0; i < 500; i++) {
+        dy_gfx_point_t pts[3], rot[3];
+        for (int j = 0; j < 3; j++) {
+            pts[j] = P((int32_t) (test_rand() % 24) - 4, (int32_t) (test_rand() % 20) - 4);
+        }
+        for (int j = 0; j < 3; j++) {
+            rot[j] = pts[(j + i) % 3];
+        }
+
+        dy_gfx_clear_buf(buf);
+        dy_gfx_clear_buf(ref);
+        dy_gfx_fill_poly(buf, &(dy_gfx_poly_t) {3, pts}, PIC_PX);
+        dy_gfx_fill_poly(ref, &(dy_gfx_poly_t) {3, rot}, PIC_PX);
+        if (!buf_eq(buf, ref)) {
+            fprintf(stderr, "triangle #%d depends on the order of corners\n", i);
+            test_failures++;
+            break;
+        }
+
+        dy_gfx_poly(ref, &(dy_gfx_poly_t) {3, pts}, PIC_PX);
+        if (!buf_eq(buf, ref)) {
+            fprintf(stderr, "triangle #%d doesn't cover its outline\n", i);
+            test_failures++;
+            break;
+        }
+    }
+
+    // Edges spanning the whole coordinate range, where 2 * (y - a.y) * ex overflowed; the buffer is inside
+    dy_gfx_point_t huge[] = {P(INT32_MIN, INT32_MIN), P(INT32_MAX, 0), P(INT32_MIN, INT32_MAX)};
+    dy_gfx_clear_buf(buf);
+    dy_gfx_fill_poly(buf, &(dy_gfx_poly_t) {3, huge}, PIC_PX);
+    dy_gfx_fill_rect(ref, P(0, 0), P(15, 11), PIC_PX);
+    CHECK(buf_eq(buf, ref));
+
+    for (int i = 0; i < 5000; i++) {
+        dy_gfx_point_t pts[4];
+        for (int j = 0; j < 4; j++) {
+            pts[j] = P(rand_coord(buf->width), rand_coord(buf->height));
+        }
+
+        dy_gfx_clear_buf(buf);
+        dy_gfx_clear_buf(ref);
+        dy_gfx_fill_poly(buf, &(dy_gfx_poly_t) {4, pts}, PIC_PX);
+        ref_fill_poly(ref, pts, 4);
+        if (!buf_eq(buf, ref)) {
+            fprintf(stderr, "polygon #%d differs from the reference\n", i);
+            test_failures++;
+            break;
+        }
+    }
+
+    dy_gfx_free_buf(buf);
+    dy_gfx_free_buf(ref);
+}
+
+static void test_fill_round_rect() {
+    dy_gfx_buf_t *buf = dy_gfx_new_buf(16, 8);
+
+    dy_gfx_fill_round_rect(buf, P(0, 0), P(6, 4), 2, PIC_PX);
+    dy_gfx_fill_round_rect(buf, P(15, 0), P(8, 7), 3, PIC_PX);
+    // The radius is limited by the smaller side
+    dy_gfx_fill_round_rect(buf, P(0, 6), P(6, 7), 5, PIC_PX);
+    CHECK_PICTURE(buf,
+                  ".#####....####..",
+                  "#######..######.",
+                  "#######.########",
+                  "#######.########",
+                  ".#####..########",
+                  "........########",
+                  "#######..######.",
+                  "#######...####..");
+
+    // No radius makes a plain rectangle
+    dy_gfx_buf_t *ref = dy_gfx_new_buf(16, 8);
+    dy_gfx_clear_buf(buf);
+    dy_gfx_fill_round_rect(buf, P(-3, 2), P(9, 20), 0, PIC_PX);
+    dy_gfx_fill_rect(ref, P(-3, 2), P(9, 20), PIC_PX);
+    CHECK(buf_eq(buf, ref));
+
+    // Corners are far away
+    dy_gfx_clear_buf(buf);
+    dy_gfx_fill_round_rect(buf, P(INT32_MIN, INT32_MIN), P(INT32_MAX, INT32_MAX), 100, PIC_PX);
+    dy_gfx_fill_rect(ref, P(0, 0), P(15, 7), PIC_PX);
+    CHECK(buf_eq(buf, ref));
+
+    dy_gfx_free_buf(buf);
+    dy_gfx_free_buf(ref);
+}
+
+int main() {
+    TEST_RUN(test_line);
+    TEST_RUN(test_line_ref);
+    TEST_RUN(test_fill_rect);
+    TEST_RUN(test_fill_circle);
+    TEST_RUN(test_fill_poly);
+    TEST_RUN(test_fill_poly_props);
+    TEST_RUN(test_fill_round_rect);
+    TEST_EXIT();
+}
@@ -0,0 +1,184 @@
+#include "dy/gfx/gfx.h"
+#include "dy/gfx/qoi.h"
+#include "picture.h"
+
+#define BG dy_gfx_new_px(9, 9, 9)
+
+#define HEADER(w, h, channels) 'q', 'o', 'i', 'f', 0, 0, 0, w, 0, 0, 0, h, channels, 0
+#define END_MARKER 0, 0, 0, 0, 0, 0, 0, 1
+
+// Every op in a 4x2 image, pixels computed by hand from the specification:
+//
+//   A = RGB (10, 20, 30)
+//   B = DIFF of A by (+1, -2, 0)                       = (11, 18, 30)
+//   B B B = RUN of 3, crossing the row boundary
+//   C = LUMA of B by dg +5, dr - dg -3, db - dg +2       = (13, 23, 37)
+//   A = INDEX 9, the hash of A: (10*3 + 20*5 + 30*7 + 255*11) % 64
+//   D = RGBA (200, 100, 50, 255)
+static const uint8_t all_ops[] = {
+    HEADER(4, 2, 3),
+    0xFE, 10, 20, 30,
+    0x72,
+    0xC2,
+    0xA5, 0x5A,
+    0x09,
+    0xFF, 200, 100, 50, 255,
+    END_MARKER,
+};
+
+static const dy_gfx_px_t all_ops_px[] = {
+    {10, 20, 30}, {11, 18, 30}, {11, 18, 30}, {11, 18, 30},
+    {11, 18, 30}, {13, 23, 37}, {10, 20, 30}, {200, 100, 50},
+};
+
+static bool content_eq(const dy_gfx_buf_t *buf, const dy_gfx_px_t *expected) {
+    for (uint32_t i = 0; i < (uint32_t) buf->width * buf->height; i++) {
+        if (!px_eq(buf->content[i], expected[i])) {
+            fprintf(stderr, "    pixel %u is {%d, %d, %d}, expected {%d, %d, %d}\n", i, buf->content[i].r,
+                    buf->content[i].g, buf->content[i].b, expected[i].r, expected[i].g, expected[i].b);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void test_ops() {
+    dy_gfx_buf_t *buf = dy_gfx_new_buf(4, 2);
+    dy_gfx_qoi_info_t info;
+
+    CHECK(!dy_is_err(dy_gfx_qoi_info(all_ops, sizeof(all_ops), &info)));
+    CHECK_INT(info.width, 4);
+    CHECK_INT(info.height, 2);
+    CHECK_INT(info.channels, 3);
+
+    CHECK(!dy_is_err(dy_gfx_qoi_decode(buf, (dy_gfx_point_t) {0, 0}, all_ops, sizeof(all_ops))));
+    CHECK(content_eq(buf, all_ops_px));
+
+    dy_gfx_free_buf(buf);
+}
+
+// Channels wrap around modulo 256, starting from the initial previous pixel (0, 0, 0, 255).
+static void test_wrap() {
+    static const uint8_t data[] = {
+        HEADER(2, 1, 3),
+        0x40,       // DIFF by (-2, -2, -2)                    = (254, 254, 254)
+        0xBF, 0xF0, // LUMA by dg +31, dr - dg +7, db - dg -8  = (36, 29, 21)
+        END_MARKER,
+    };
+    static const dy_gfx_px_t expected[] = {{254, 254, 254}, {36, 29, 21}};
+    dy_gfx_buf_t *buf = dy_gfx_new_buf(2, 1);
+
+    CHECK(!dy_is_err(dy_gfx_qoi_decode(buf, (dy_gfx_point_t) {0, 0}, data, sizeof(data))));
+    CHECK(content_eq(buf, expected));
+
+    dy_gfx_free_buf(buf);
+}
+
+// Pixels with alpha below 128 keep the buffer's content, including ones repeated by a run.
+static void test_alpha() {
+    static const uint8_t data[] = {
+        HEADER(4, 1, 4),
+        0xFF, 50, 60, 70, 127,
+        0xC0,
+        0xFF, 1, 2, 3, 128,
+        0x00, // INDEX of an unset slot, which is (0, 0, 0, 0)
+        END_MARKER,
+    };
+    static const dy_gfx_px_t expected[] = {{9, 9, 9}, {9, 9, 9}, {1, 2, 3}, {9, 9, 9}};
+    dy_gfx_buf_t *buf = dy_gfx_new_buf(4, 1);
+
+    dy_gfx_fill(buf, BG);
+    CHECK(!dy_is_err(dy_gfx_qoi_decode(buf, (dy_gfx_point_t) {0, 0}, data, sizeof(data))));
+    CHECK(content_eq(buf, expected));
+
+    dy_gfx_free_buf(buf);
+}
+
+// Feeding any split of the data, down to single bytes, gives the same image.
+static void test_chunks() {
+    for (size_t chunk = 1; chunk <= sizeof(all_ops); chunk++) {
+        dy_gfx_buf_t *buf = dy_gfx_new_buf(4, 2);
+        dy_gfx_qoi_t dec;
+
+        dy_gfx_qoi_init(&dec, buf, (dy_gfx_point_t) {0, 0});
+        for (size_t pos = 0; pos < sizeof(all_ops); pos += chunk) {
+            size_t n = sizeof(all_ops) - pos < chunk ? sizeof(all_ops) - pos : chunk;
+            CHECK(!dy_is_err(dy_gfx_qoi_feed(&dec, all_ops + pos, n)));
+        }
+        CHECK(dy_gfx_qoi_done(&dec));
+        if (!content_eq(buf, all_ops_px)) {
+            fprintf(stderr, "%s:%d: chunks of %zu differ\n", __FILE__, __LINE__, chunk);
+            test_failures++;
+        }
+
+        dy_gfx_free_buf(buf);
+    }
+}
+
+// The image is clipped by the buffer, rows keep their pixels even where the run crosses the row boundary.
+static void test_clip() {
+    static const dy_gfx_px_t A = {10, 20, 30}, B = {11, 18, 30}, C = {13, 23, 37}, D = {200, 100, 50},
+            X = {9, 9, 9};
+    static const dy_gfx_px_t expected[] = {
+        X, X, X,
+        B, B, B,
+        C, A, D,
+    };
+    dy_gfx_buf_t *buf = dy_gfx_new_buf(3, 3);
+
+    dy_gfx_fill(buf, BG);
+    CHECK(!dy_is_err(dy_gfx_qoi_decode(buf, (dy_gfx_point_t) {-1, 1}, all_ops, sizeof(all_ops))));
+    CHECK(content_eq(buf, expected));
+
+    dy_gfx_free_buf(buf);
+}
+
+// Data ending before the last pixel is reported, wherever it is cut; the end marker itself is optional.
+static void test_truncated() {
+    size_t len_px = sizeof(all_ops) - 8; // without the end marker
+
+    for (size_t len = 0; len < len_px; len++) {
+        dy_gfx_buf_t *buf = dy_gfx_new_buf(4, 2);
+        dy_err_t err = dy_gfx_qoi_decode(buf, (dy_gfx_point_t) {0, 0}, all_ops, len);
+        if (err->code != DY_ERR_INVALID_SIZE) {
+            fprintf(stderr, "%s:%d: %zu bytes: %s\n", __FILE__, __LINE__, len, dy_err_str(err));
+            test_failures++;
+        }
+        dy_gfx_free_buf(buf);
+    }
+
+    dy_gfx_buf_t *buf = dy_gfx_new_buf(4, 2);
+    CHECK(!dy_is_err(dy_gfx_qoi_decode(buf, (dy_gfx_point_t) {0, 0}, all_ops, len_px)));
+    CHECK(content_eq(buf, all_ops_px));
+    dy_gfx_free_buf(buf);
+}
+
+static void test_header() {
+    dy_gfx_qoi_info_t info;
+
+    static const uint8_t magic[] = {'q', 'o', 'i', 'x', 0, 0, 0, 1, 0, 0, 0, 1, 3, 0};
+    CHECK_INT(dy_gfx_qoi_info(magic, sizeof(magic), &info)->code, DY_ERR_INVALID_ARG);
+
+    static const uint8_t channels[] = {HEADER(1, 1, 5)};
+    CHECK_INT(dy_gfx_qoi_info(channels, sizeof(channels), &info)->code, DY_ERR_INVALID_ARG);
+
+    static const uint8_t empty[] = {HEADER(0, 1, 3)};
+    CHECK_INT(dy_gfx_qoi_info(empty, sizeof(empty), &info)->code, DY_ERR_INVALID_SIZE);
+
+    static const uint8_t wide[] = {'q', 'o', 'i', 'f', 0, 1, 0, 0, 0, 0, 0, 1, 3, 0};
+    CHECK_INT(dy_gfx_qoi_info(wide, sizeof(wide), &info)->code, DY_ERR_INVALID_SIZE);
+
+    CHECK_INT(dy_gfx_qoi_info(all_ops, DY_GFX_QOI_HEADER_LEN - 1, &info)->code, DY_ERR_INVALID_SIZE);
+}
+
+int main() {
+    TEST_RUN(test_ops);
+    TEST_RUN(test_wrap);
+    TEST_RUN(test_alpha);
+    TEST_RUN(test_chunks);
+    TEST_RUN(test_clip);
+    TEST_RUN(test_truncated);
+    TEST_RUN(test_header);
+    TEST_EXIT();
+}
@@ -0,0 +1,109 @@
+#include "dy/gfx/gfx.h"
+#include "dy/gfx/sprite.h"
+#include "picture.h"
+
+#define KEY dy_gfx_new_px(1, 2, 3)
+
+// Per-pixel reference of dy_gfx_blit_sprite(), written from its documentation.
+static void ref_blit(dy_gfx_buf_t *buf, dy_gfx_point_t pos, const dy_gfx_sprite_t *sp, uint8_t flags) {
+    for (int32_t y = 0; y < sp->height; y++) {
+        for (int32_t x = 0; x < sp->width; x++) {
+            int32_t sx = flags & DY_GFX_SPRITE_FLIP_H ? sp->width - 1 - x : x;
+            int32_t sy = flags & DY_GFX_SPRITE_FLIP_V ? sp->height - 1 - y : y;
+            dy_gfx_px_t px = sp->data[sy * sp->width + sx];
+            int32_t bx = pos.x + x, by = pos.y + y;
+            if ((flags & DY_GFX_SPRITE_KEY) && px_eq(px, KEY)) {
+                continue;
+            }
+            if (bx >= 0 && by >= 0 && bx < buf->width && by < buf->height) {
+                buf->content[by * buf->width + bx] = px;
+            }
+        }
+    }
+}
+
+static void test_flips() {
+    static const dy_gfx_px_t W = {255, 255, 255}, K = {1, 2, 3};
+    static const dy_gfx_px_t data[] = {
+        W, W, W,
+        W, K, K,
+    };
+    const dy_gfx_sprite_t sp = {.width = 3, .height = 2, .data = data};
+    dy_gfx_buf_t *buf = dy_gfx_new_buf(5, 4);
+
+    dy_gfx_blit_sprite(buf, (dy_gfx_point_t) {1, 1}, &sp, DY_GFX_SPRITE_FLIP_H | DY_GFX_SPRITE_KEY, KEY);
+    CHECK_PICTURE(buf,
+                  ".....",
+                  ".###.",
+                  "...#.",
+                  ".....");
+
+    dy_gfx_clear_buf(buf);
+    dy_gfx_blit_sprite(buf, (dy_gfx_point_t) {-1, 2}, &sp, DY_GFX_SPRITE_FLIP_V | DY_GFX_SPRITE_KEY, KEY);
+    CHECK_PICTURE(buf,
+                  ".....",
+                  ".....",
+                  ".....",
+                  "##...");
+
+    dy_gfx_free_buf(buf);
+}
+
+// Random sprites are blitted at random positions, mostly partly or fully clipped, with every combination of flags.
+static void test_random() {
+    dy_gfx_px_t data[12 * 9];
+
+    for (int i = 0; i < 5000; i++) {
+        uint16_t w = 1 + test_rand() % 12, h = 1 + test_rand() % 9;
+        for (int j = 0; j < w * h; j++) {
+            data[j] = test_rand() % 3 == 0 ? KEY : dy_gfx_new_px(test_rand(), test_rand(), test_rand());
+        }
+        const dy_gfx_sprite_t sp = {.width = w, .height = h, .data = data};
+        dy_gfx_point_t pos = {(int32_t) (test_rand() % 30) - 14, (int32_t) (test_rand() % 20) - 10};
+        uint8_t flags = test_rand() % 8;
+
+        dy_gfx_buf_t *buf = dy_gfx_new_buf(1 + test_rand() % 10, 1 + test_rand() % 8);
+        dy_gfx_buf_t *ref = dy_gfx_new_buf(buf->width, buf->height);
+        dy_gfx_fill(buf, dy_gfx_new_px(9, 9, 9));
+        dy_gfx_fill(ref, dy_gfx_new_px(9, 9, 9));
+
+        dy_gfx_blit_sprite(buf, pos, &sp, flags, KEY);
+        ref_blit(ref, pos, &sp, flags);
+        if (!buf_eq(buf, ref)) {
+            fprintf(stderr, "%s:%d: %dx%d sprite at %ld,%ld with flags %d differs\n", __FILE__, __LINE__, w, h,
+                    (long) pos.x, (long) pos.y, flags);
+            test_failures++;
+        }
+
+        dy_gfx_free_buf(buf);
+        dy_gfx_free_buf(ref);
+    }
+}
+
+static void test_sheet() {
+    static const dy_gfx_px_t data[2 * 1 * 3] = {{1}, {2}, {3}, {4}, {5}, {6}};
+    const dy_gfx_sprite_sheet_t sheet = {.width = 2, .height = 1, .n_frames = 3, .data = data};
+
+    CHECK(dy_gfx_sprite_sheet_frame(&sheet, 0).data == data);
+    CHECK(dy_gfx_sprite_sheet_frame(&sheet, 2).data == data + 4);
+    CHECK(dy_gfx_sprite_sheet_frame(&sheet, 4).data == data + 2); // frame numbers wrap around
+    CHECK_INT(dy_gfx_sprite_sheet_frame(&sheet, 1).width, 2);
+    CHECK_INT(dy_gfx_sprite_sheet_frame(&sheet, 1).height, 1);
+
+    // No frames, no pixels to refer to
+    const dy_gfx_sprite_sheet_t empty = {.width = 2, .height = 1, .n_frames = 0, .data = data};
+    dy_gfx_sprite_t sp = dy_gfx_sprite_sheet_frame(&empty, 7);
+    CHECK_INT(sp.width, 0);
+    CHECK_INT(sp.height, 0);
+    dy_gfx_buf_t *buf = dy_gfx_new_buf(2, 2);
+    dy_gfx_blit_sprite(buf, (dy_gfx_point_t) {0, 0}, &sp, 0, KEY);
+    CHECK_PICTURE(buf, "..", "..");
+    dy_gfx_free_buf(buf);
+}
+
+int main() {
+    TEST_RUN(test_flips);
+    TEST_RUN(test_random);
+    TEST_RUN(test_sheet);
+    TEST_EXIT();
+}
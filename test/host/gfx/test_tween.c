@@ -0,0 +1,215 @@
+#include "dy/gfx/tween.h"
+#include "test.h"
+
+#define ONE DY_GFX_TWEEN_ONE
+#define N_EASES (DY_GFX_EASE_OUT_BOUNCE + 1)
+#define UNTOUCHED 12345
+
+static bool is_monotonic(dy_gfx_ease_t ease) {
+    return ease != DY_GFX_EASE_OUT_BACK && ease != DY_GFX_EASE_OUT_BOUNCE;
+}
+
+static void test_ease_endpoints() {
+    for (dy_gfx_ease_t e = 0; e < N_EASES; e++) {
+        CHECK_INT(dy_gfx_ease(e, 0), 0);
+        CHECK_INT(dy_gfx_ease(e, ONE), ONE);
+        CHECK_INT(dy_gfx_ease(e, -1), 0);
+        CHECK_INT(dy_gfx_ease(e, ONE + 1), ONE);
+
+        // The curves themselves end there too, not just the clamping around them
+        CHECK(dy_gfx_ease(e, 1) <= 16);
+        CHECK(dy_gfx_ease(e, ONE - 1) >= ONE - 16);
+    }
+}
+
+static void test_ease_shape() {
+    for (dy_gfx_ease_t e = 0; e < N_EASES; e++) {
+        int32_t prev = 0, lo = 0, hi = 0;
+        for (int32_t t = 0; t <= ONE; t++) {
+            int32_t v = dy_gfx_ease(e, t);
+            if (is_monotonic(e) && v < prev) {
+                fprintf(stderr, "%s:%d: ease %d decreases at %ld\n", __FILE__, __LINE__, e, (long) t);
+                test_failures++;
+                break;
+            }
+            prev = v;
+            lo = v < lo ? v : lo;
+            hi = v > hi ? v : hi;
+        }
+
+        CHECK_INT(lo, 0);
+        if (e == DY_GFX_EASE_OUT_BACK) {
+            CHECK(hi > ONE && hi <= ONE * 11 / 10 + 16); // 10%, give or take fixed-point rounding
+        } else {
+            CHECK_INT(hi, ONE);
+        }
+    }
+
+    // Halfway through, the symmetric curves are halfway there
+    CHECK_INT(dy_gfx_ease(DY_GFX_EASE_LINEAR, ONE / 2), ONE / 2);
+    CHECK_INT(dy_gfx_ease(DY_GFX_EASE_IN_OUT_QUAD, ONE / 2), ONE / 2);
+    CHECK_INT(dy_gfx_ease(DY_GFX_EASE_IN_OUT_CUBIC, ONE / 2), ONE / 2);
+    CHECK_INT(dy_gfx_ease(DY_GFX_EASE_SMOOTH, ONE / 2), ONE / 2);
+}
+
+static void test_tween_endpoints() {
+    static const int32_t values[][2] = {
+        {0, 100}, {100, 0}, {-7, 3}, {INT32_MIN, INT32_MAX}, {INT32_MAX, INT32_MIN}, {INT32_MAX, INT32_MAX - 1},
+    };
+
+    for (dy_gfx_ease_t e = 0; e < N_EASES; e++) {
+        for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+            for (uint32_t duration = 0; duration < 4; duration++) {
+                int32_t v = UNTOUCHED;
+                dy_gfx_tween_t tw = {.kind = DY_GFX_TWEEN_I32, .ease = e, .start = 3, .duration = duration,
+                                     .target = &v, .from.i32 = values[i][0], .to.i32 = values[i][1]};
+
+                // With no frames to get there, the first one is already at `to`
+                dy_gfx_tween_apply(&tw, 3);
+                CHECK_INT(v, duration == 0 ? values[i][1] : values[i][0]);
+                dy_gfx_tween_apply(&tw, 3 + duration);
+                CHECK_INT(v, values[i][1]);
+            }
+        }
+
+        dy_gfx_px_t px = {0};
+        dy_gfx_point_t pt = {0};
+        uint8_t u8 = 0;
+        dy_gfx_tween_t px_tw = {.kind = DY_GFX_TWEEN_PX, .ease = e, .duration = 10, .target = &px,
+                                .from.px = {255, 0, 7}, .to.px = {0, 255, 200}};
+        dy_gfx_tween_t pt_tw = {.kind = DY_GFX_TWEEN_POINT, .ease = e, .duration = 10, .target = &pt,
+                                .from.point = {-5, 9}, .to.point = {30, -30}};
+        dy_gfx_tween_t u8_tw = {.kind = DY_GFX_TWEEN_U8, .ease = e, .duration = 10, .target = &u8,
+                                .from.u8 = 255, .to.u8 = 0};
+        dy_gfx_tween_apply(&px_tw, 0);
+        dy_gfx_tween_apply(&pt_tw, 0);
+        dy_gfx_tween_apply(&u8_tw, 0);
+        CHECK(px.r == 255 && px.g == 0 && px.b == 7);
+        CHECK(pt.x == -5 && pt.y == 9);
+        CHECK_INT(u8, 255);
+        dy_gfx_tween_apply(&px_tw, 10);
+        dy_gfx_tween_apply(&pt_tw, 10);
+        dy_gfx_tween_apply(&u8_tw, 10);
+        CHECK(px.r == 0 && px.g == 255 && px.b == 200);
+        CHECK(pt.x == 30 && pt.y == -30);
+        CHECK_INT(u8, 0);
+    }
+}
+
+static void test_tween_range() {
+    // The distance between the extremes of int32_t doesn't fit into one
+    int32_t v = UNTOUCHED;
+    dy_gfx_tween_t tw = {.kind = DY_GFX_TWEEN_I32, .ease = DY_GFX_EASE_LINEAR, .duration = 4, .target = &v,
+                         .from.i32 = INT32_MIN, .to.i32 = INT32_MAX};
+    dy_gfx_tween_apply(&tw, 2);
+    CHECK_INT(v, 0);
+    dy_gfx_tween_apply(&tw, 1);
+    CHECK_INT(v, INT32_MIN / 2);
+
+    // Overshooting saturates, and an 8-bit target is clamped
+    tw = (dy_gfx_tween_t) {.kind = DY_GFX_TWEEN_I32, .ease = DY_GFX_EASE_OUT_BACK, .duration = 100, .target = &v,
+                           .from.i32 = 0, .to.i32 = INT32_MAX};
+    bool saturated = false;
+    for (uint32_t f = 0; f <= 100; f++) {
+        dy_gfx_tween_apply(&tw, f);
+        CHECK(v >= 0);
+        saturated |= v == INT32_MAX && f < 100;
+    }
+    CHECK(saturated);
+
+    uint8_t u8 = 0, max_u8 = 0;
+    dy_gfx_tween_t u8_tw = {.kind = DY_GFX_TWEEN_U8, .ease = DY_GFX_EASE_OUT_BACK, .duration = 100, .target = &u8,
+                            .from.u8 = 0, .to.u8 = 255};
+    for (uint32_t f = 0; f <= 100; f++) {
+        dy_gfx_tween_apply(&u8_tw, f);
+        max_u8 = u8 > max_u8 ? u8 : max_u8;
+        CHECK(f < 30 || u8 > 200); // it would wrap around to small values without clamping
+    }
+    CHECK_INT(max_u8, 255);
+}
+
+static int n_updates;
+
+static void count_update(void *args) {
+    n_updates++;
+}
+
+static void test_tween_outside() {
+    int32_t v = UNTOUCHED;
+    dy_gfx_tween_t tw = {.kind = DY_GFX_TWEEN_I32, .ease = DY_GFX_EASE_IN_QUAD, .start = 10, .duration = 5,
+                         .target = &v, .from.i32 = 0, .to.i32 = 50, .on_update = count_update};
+    n_updates = 0;
+
+    static const uint32_t outside[] = {0, 9, 16, 100, UINT32_MAX};
+    for (size_t i = 0; i < sizeof(outside) / sizeof(outside[0]); i++) {
+        CHECK(!dy_gfx_tween_apply(&tw, outside[i]));
+        CHECK_INT(v, UNTOUCHED);
+    }
+    CHECK_INT(n_updates, 0);
+
+    // Inside, the target changes once per changed value
+    CHECK(dy_gfx_tween_apply(&tw, 10));
+    CHECK_INT(v, 0);
+    CHECK(!dy_gfx_tween_apply(&tw, 10));
+    CHECK(dy_gfx_tween_apply(&tw, 15));
+    CHECK_INT(v, 50);
+    CHECK_INT(n_updates, 2);
+}
+
+static int n_frames;
+
+static void count_frame(void *args) {
+    n_frames++;
+}
+
+static void test_timeline() {
+    int32_t a = UNTOUCHED, b = UNTOUCHED;
+    dy_gfx_timeline_t tl;
+
+    for (int loop = 0; loop < 2; loop++) {
+        a = b = UNTOUCHED;
+        n_frames = 0;
+        dy_gfx_timeline_init(&tl, loop, count_frame, NULL);
+        CHECK(!dy_is_err(dy_gfx_timeline_add(&tl, (dy_gfx_tween_t) {
+            .kind = DY_GFX_TWEEN_I32, .start = 0, .duration = 4, .target = &a, .from.i32 = 0, .to.i32 = 40})));
+        CHECK(!dy_is_err(dy_gfx_timeline_add(&tl, (dy_gfx_tween_t) {
+            .kind = DY_GFX_TWEEN_I32, .start = 6, .duration = 2, .target = &b, .from.i32 = 100, .to.i32 = 0})));
+        CHECK_INT(tl.duration, 8);
+
+        for (uint32_t f = 0; f < 8; f++) {
+            CHECK_INT(dy_gfx_timeline_animator(&tl, f), DY_GFX_ANIM_CONTINUE);
+            if (f == 2) {
+                CHECK_INT(a, 20);
+            } else if (f == 5) {
+                // Between the tweens, the first one's target stays at its end, the second one's isn't touched yet
+                CHECK_INT(a, 40);
+                CHECK_INT(b, UNTOUCHED);
+            } else if (f == 7) {
+                CHECK_INT(b, 50);
+            }
+        }
+        CHECK_INT(dy_gfx_timeline_animator(&tl, 8), loop ? DY_GFX_ANIM_RESTART : DY_GFX_ANIM_STOP);
+        CHECK_INT(b, 0);
+        CHECK_INT(n_frames, 9);
+    }
+
+    // An empty timeline ends at once
+    dy_gfx_timeline_init(&tl, false, NULL, NULL);
+    CHECK_INT(dy_gfx_timeline_animator(&tl, 0), DY_GFX_ANIM_STOP);
+
+    for (int i = 0; i < DY_GFX_TIMELINE_MAX; i++) {
+        CHECK(!dy_is_err(dy_gfx_timeline_add(&tl, (dy_gfx_tween_t) {.kind = DY_GFX_TWEEN_I32, .target = &a})));
+    }
+    dy_err_t err = dy_gfx_timeline_add(&tl, (dy_gfx_tween_t) {.kind = DY_GFX_TWEEN_I32, .target = &a});
+    CHECK(dy_is_err(err) && err->code == DY_ERR_NO_MEM);
+}
+
+int main() {
+    TEST_RUN(test_ease_endpoints);
+    TEST_RUN(test_ease_shape);
+    TEST_RUN(test_tween_endpoints);
+    TEST_RUN(test_tween_range);
+    TEST_RUN(test_tween_outside);
+    TEST_RUN(test_timeline);
+    TEST_EXIT();
+}
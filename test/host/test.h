@@ -0,0 +1,48 @@
+/**
+ * @brief Minimal test helpers for host tests.
+ *
+ * Each test is an executable of its own: checks report failures and keep going, and TEST_EXIT() makes the exit
+ * code, which is what ctest looks at.
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+static int test_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        test_failures++; \
+    } \
+} while (0)
+
+#define CHECK_INT(actual, expected) do { \
+    long long a_ = (long long) (actual), e_ = (long long) (expected); \
+    if (a_ != e_) { \
+        fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, a_, e_); \
+        test_failures++; \
+    } \
+} while (0)
+
+#define TEST_RUN(fn) do { \
+    int before_ = test_failures; \
+    fn(); \
+    printf("%s %s\n", test_failures == before_ ? "ok  " : "FAIL", #fn); \
+} while (0)
+
+#define TEST_EXIT() return test_failures > 0 ? 1 : 0
+
+// xorshift32; tests use it instead of rand() to be reproducible across C libraries
+static uint32_t test_rand_state = 2463534242u;
+
+static uint32_t test_rand() {
+    uint32_t x = test_rand_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return test_rand_state = x;
+}